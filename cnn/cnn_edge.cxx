@@ -34,6 +34,7 @@ using std::runtime_error;
 
 #include <string>
 using std::string;
+using std::to_string;
 
 #include <vector>
 using std::vector;
@@ -72,6 +73,9 @@ CNN_Edge::CNN_Edge() {
 
     needs_initialization = true;
 
+    timing = false;
+    reset_times();
+
     weights = NULL;
     weight_updates = NULL;
     best_weights = NULL;
@@ -101,6 +105,9 @@ CNN_Edge::CNN_Edge(CNN_Node* _input_node, CNN_Node* _output_node, bool _fixed, i
     reverse_filter_y = false;
     needs_initialization = true;
 
+    timing = false;
+    reset_times();
+
     scale = 1.0;
     best_scale = 1.0;
     previous_velocity_scale = 0.0;
@@ -210,10 +217,71 @@ void parse_vector_2d(vector<vector<float> >& output, istringstream& iss, int fil
     }
 }
 
+string CNN_Edge::get_database_columns() {
+    return "exact_id, genome_id, type, innovation_number, input_node_innovation_number, "
+           "output_node_innovation_number, batch_size, filter_x, filter_y, fixed, disabled, forward_visited, "
+           "reverse_visited, reverse_filter_x, reverse_filter_y, needs_initialization, weights, best_weights, "
+           "scale_values";
+}
+
+string CNN_Edge::get_database_values(int database_exact_id, string database_genome_id) const {
+    ostringstream values;
+
+    values << database_exact_id << ", " << database_genome_id << ", " << type << ", " << innovation_number << ", "
+           << input_node_innovation_number << ", " << output_node_innovation_number << ", " << batch_size << ", "
+           << filter_x << ", " << filter_y << ", " << fixed << ", " << disabled << ", " << forward_visited << ", "
+           << reverse_visited << ", " << reverse_filter_x << ", " << reverse_filter_y << ", " << needs_initialization
+           << ", '";
+
+    int current = 0;
+    for (int32_t y = 0; y < filter_y; y++) {
+        for (int32_t x = 0; x < filter_x; x++) {
+            if (x != 0) {
+                values << " ";
+            }
+            write_hexfloat(values, weights[current]);
+            current++;
+        }
+        if (y != filter_y - 1) {
+            values << "\n";
+        }
+    }
+
+    values << "', '";
+    current = 0;
+    for (int32_t y = 0; y < filter_y; y++) {
+        for (int32_t x = 0; x < filter_x; x++) {
+            if (x != 0) {
+                values << " ";
+            }
+            write_hexfloat(values, best_weights[current]);
+            current++;
+        }
+        if (y != filter_y - 1) {
+            values << "\n";
+        }
+    }
+
+    values << "', '";
+    write_hexfloat(values, scale);
+    values << " ";
+    write_hexfloat(values, best_scale);
+    values << " ";
+    write_hexfloat(values, previous_velocity_scale);
+    values << " ";
+    write_hexfloat(values, best_velocity_scale);
+    values << "'";
+
+    return values.str();
+}
+
 #ifdef _MYSQL_
 CNN_Edge::CNN_Edge(int _edge_id) {
     edge_id = _edge_id;
 
+    timing = false;
+    reset_times();
+
     ostringstream query;
     query << "SELECT * FROM cnn_edge WHERE id = " << edge_id;
 
@@ -296,85 +364,13 @@ void CNN_Edge::export_to_database(int _exact_id, int _genome_id) {
     genome_id = _genome_id;
     exact_id = _exact_id;
 
-    // cout << "inserting edge with exact_id: " << exact_id << " and genome id: " << genome_id << endl;
-
     if (edge_id >= 0) {
-        query << "REPLACE INTO cnn_edge SET id = " << edge_id << ",";
+        query << "REPLACE INTO cnn_edge (id, " << get_database_columns() << ") VALUES (" << edge_id << ", "
+              << get_database_values(exact_id, to_string(genome_id)) << ")";
     } else {
-        query << "INSERT INTO cnn_edge SET";
-    }
-
-    query << " exact_id = " << exact_id << ", genome_id = " << genome_id << ", type = " << type
-          << ", innovation_number = " << innovation_number
-          << ", input_node_innovation_number = " << input_node_innovation_number
-          << ", output_node_innovation_number = " << output_node_innovation_number << ", batch_size = " << batch_size
-          << ", filter_x = " << filter_x << ", filter_y = " << filter_y << ", fixed = " << fixed
-          << ", disabled = " << disabled << ", forward_visited = " << forward_visited
-          << ", reverse_visited = " << reverse_visited << ", reverse_filter_x = " << reverse_filter_x
-          << ", reverse_filter_y = " << reverse_filter_y << ", needs_initialization = " << needs_initialization
-          << ", weights = '";
-
-    int current = 0;
-    for (int32_t y = 0; y < filter_y; y++) {
-        for (int32_t x = 0; x < filter_x; x++) {
-            if (x != 0) {
-                query << " ";
-            }
-            write_hexfloat(query, weights[current]);
-            // query << setprecision(15) << weights[current];
-            current++;
-        }
-        if (y != filter_y - 1) {
-            query << "\n";
-        }
-    }
-
-    query << "', best_weights = '";
-    current = 0;
-    for (int32_t y = 0; y < filter_y; y++) {
-        for (int32_t x = 0; x < filter_x; x++) {
-            if (x != 0) {
-                query << " ";
-            }
-            write_hexfloat(query, best_weights[current]);
-            // query << setprecision(15) << best_weights[current];
-            current++;
-        }
-        if (y != filter_y - 1) {
-            query << "\n";
-        }
-    }
-    query << "', scale_values = '";
-    write_hexfloat(query, scale);
-    query << " ";
-    write_hexfloat(query, best_scale);
-    query << " ";
-    write_hexfloat(query, previous_velocity_scale);
-    query << " ";
-    write_hexfloat(query, best_velocity_scale);
-    query << "'";
-
-    /*
-    query << "', previous_velocity = '";
-    for (int32_t y = 0; y < filter_y; y++) {
-        for (int32_t x = 0; x < filter_x; x++) {
-            if (x != 0) query << " ";
-            query << setprecision(15) << previous_velocity[y][x];
-        }
-        if (y != filter_y - 1) query << "\n";
-    }
-
-    query << "', best_velocity = '";
-    for (int32_t y = 0; y < filter_y; y++) {
-        for (int32_t x = 0; x < filter_x; x++) {
-            if (x != 0) query << " ";
-            query << setprecision(15) << best_velocity[y][x];
-        }
-        if (y != filter_y - 1) query << "\n";
+        query << "INSERT INTO cnn_edge (" << get_database_columns() << ") VALUES ("
+              << get_database_values(exact_id, to_string(genome_id)) << ")";
     }
-    query << "'";
-    */
-    // query << "', previous_velocity = '', best_velocity = ''";
 
     mysql_exact_query(query.str());
 
@@ -395,6 +391,29 @@ bool CNN_Edge::equals(CNN_Edge* other) const {
            && type == other->type;
 }
 
+/**
+ * Mixes the bits of a 64 bit value (the splitmix64 finalizer).
+ */
+static uint64_t mix_hash(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+uint64_t CNN_Edge::get_structural_hash() const {
+    uint64_t hash = mix_hash((uint64_t) (uint32_t) innovation_number);
+    hash = mix_hash(hash ^ (((uint64_t) (uint32_t) filter_x << 32) | (uint32_t) filter_y));
+    hash = mix_hash(
+        hash
+        ^ (((uint64_t) type << 4) | ((uint64_t) disabled << 2) | ((uint64_t) reverse_filter_x << 1)
+           | (uint64_t) reverse_filter_y)
+    );
+    return hash;
+}
+
 bool CNN_Edge::needs_init() const {
     return needs_initialization;
 }
@@ -403,6 +422,10 @@ void CNN_Edge::set_needs_init() {
     needs_initialization = true;
 }
 
+void CNN_Edge::set_timing(bool _timing) {
+    timing = _timing;
+}
+
 void CNN_Edge::reset_times() {
     propagate_forward_time = 0.0;
     propagate_backward_time = 0.0;
@@ -417,6 +440,54 @@ void CNN_Edge::accumulate_times(
     total_weight_update_time += weight_update_time;
 }
 
+float CNN_Edge::get_operations_estimate() const {
+    float operations_estimate = 0.0;
+
+    float if_cost = 15.0;
+    float multiply_cost = 7.0;
+    float add_cost = 1.0;
+
+    // propagate forward has 1 multiply 1 add per input to output
+    // propagate backward has 3 multiplies and 2 adds per output to input
+
+    // TODO: calculate differently for POOLING nodes
+    if (type == CONVOLUTIONAL) {
+        float propagate_count;
+
+        if (reverse_filter_x && reverse_filter_y) {
+            propagate_count = filter_x * filter_y * input_node->get_size_x() * input_node->get_size_y();
+        } else if (reverse_filter_x) {
+            propagate_count = filter_x * filter_y * input_node->get_size_x() * output_node->get_size_y();
+        } else if (reverse_filter_y) {
+            propagate_count = filter_x * filter_y * output_node->get_size_x() * input_node->get_size_y();
+        } else {
+            propagate_count = filter_x * filter_y * output_node->get_size_x() * output_node->get_size_y();
+        }
+
+        operations_estimate += propagate_count * ((4.0 * multiply_cost) + (3.0 * add_cost));
+
+    } else {
+        float propagate_count;
+
+        if (reverse_filter_x && reverse_filter_y) {
+            propagate_count = input_node->get_size_x() * input_node->get_size_y();
+        } else if (reverse_filter_y) {
+            propagate_count = input_node->get_size_x() * output_node->get_size_y();
+        } else if (reverse_filter_x) {
+            propagate_count = output_node->get_size_x() * input_node->get_size_y();
+        } else {
+            propagate_count = output_node->get_size_x() * output_node->get_size_y();
+        }
+
+        operations_estimate += propagate_count * 2.0 * (16.0 * add_cost) + (4.0 * multiply_cost);
+    }
+
+    // update weights has 4 multiplies 4 adds and 2 ifs per weight
+    operations_estimate += filter_x * filter_y * (4.0 * multiply_cost + 4.0 * add_cost + 2.0 * if_cost);
+
+    return operations_estimate;
+}
+
 int CNN_Edge::get_type() const {
     return type;
 }
@@ -985,8 +1056,13 @@ void CNN_Edge::propagate_forward(
         return;
     }
 
+#ifndef CNN_NO_TIMERS
     using namespace std::chrono;
-    high_resolution_clock::time_point propagate_forward_start_time = high_resolution_clock::now();
+    high_resolution_clock::time_point propagate_forward_start_time;
+    if (timing) {
+        propagate_forward_start_time = high_resolution_clock::now();
+    }
+#endif
 
     float* input = input_node->get_values_out();
     float* pool_gradients = input_node->get_pool_gradients();
@@ -1135,10 +1211,14 @@ void CNN_Edge::propagate_forward(
         exit(1);
     }
 
-    high_resolution_clock::time_point propagate_forward_end_time = high_resolution_clock::now();
-    duration<float, std::milli> time_span = propagate_forward_end_time - propagate_forward_start_time;
+#ifndef CNN_NO_TIMERS
+    if (timing) {
+        high_resolution_clock::time_point propagate_forward_end_time = high_resolution_clock::now();
+        duration<float, std::milli> time_span = propagate_forward_end_time - propagate_forward_start_time;
 
-    propagate_forward_time += time_span.count() / 1000.0;
+        propagate_forward_time += time_span.count() / 1000.0;
+    }
+#endif
 
     output_node->input_fired(
         training, accumulate_test_statistics, epsilon, alpha, perform_dropout, hidden_dropout_probability, generator
@@ -1153,8 +1233,13 @@ void CNN_Edge::update_weights(float mu, float learning_rate, float weight_decay)
         return;
     }
 
+#ifndef CNN_NO_TIMERS
     using namespace std::chrono;
-    high_resolution_clock::time_point weight_update_start_time = high_resolution_clock::now();
+    high_resolution_clock::time_point weight_update_start_time;
+    if (timing) {
+        weight_update_start_time = high_resolution_clock::now();
+    }
+#endif
 
     float dx, pv, velocity, weight;
 #ifdef NAN_CHECKS
@@ -1237,10 +1322,14 @@ void CNN_Edge::update_weights(float mu, float learning_rate, float weight_decay)
         }
     }
 
-    high_resolution_clock::time_point weight_update_end_time = high_resolution_clock::now();
-    duration<float, std::milli> time_span = weight_update_end_time - weight_update_start_time;
+#ifndef CNN_NO_TIMERS
+    if (timing) {
+        high_resolution_clock::time_point weight_update_end_time = high_resolution_clock::now();
+        duration<float, std::milli> time_span = weight_update_end_time - weight_update_start_time;
 
-    weight_update_time += time_span.count() / 1000.0;
+        weight_update_time += time_span.count() / 1000.0;
+    }
+#endif
 }
 
 void CNN_Edge::propagate_backward(bool training, float mu, float learning_rate, float epsilon) {
@@ -1248,8 +1337,13 @@ void CNN_Edge::propagate_backward(bool training, float mu, float learning_rate,
         return;
     }
 
+#ifndef CNN_NO_TIMERS
     using namespace std::chrono;
-    high_resolution_clock::time_point propagate_backward_start_time = high_resolution_clock::now();
+    high_resolution_clock::time_point propagate_backward_start_time;
+    if (timing) {
+        propagate_backward_start_time = high_resolution_clock::now();
+    }
+#endif
 
     float* output_errors = output_node->get_errors_in();
     float* input = input_node->get_values_out();
@@ -1333,10 +1427,14 @@ void CNN_Edge::propagate_backward(bool training, float mu, float learning_rate,
         exit(1);
     }
 
-    high_resolution_clock::time_point propagate_backward_end_time = high_resolution_clock::now();
-    duration<float, std::milli> time_span = propagate_backward_end_time - propagate_backward_start_time;
+#ifndef CNN_NO_TIMERS
+    if (timing) {
+        high_resolution_clock::time_point propagate_backward_end_time = high_resolution_clock::now();
+        duration<float, std::milli> time_span = propagate_backward_end_time - propagate_backward_start_time;
 
-    propagate_backward_time += time_span.count() / 1000.0;
+        propagate_backward_time += time_span.count() / 1000.0;
+    }
+#endif
 
     input_node->output_fired(training, mu, learning_rate, epsilon);
 }
@@ -1520,15 +1618,7 @@ istream& operator>>(istream& is, CNN_Edge* edge) {
     is >> edge->needs_initialization;
     is >> edge->batch_size;
 
-    edge->filter_size = edge->filter_y * edge->filter_x;
-
-    // don't need to initialize memory for unreachable edges
-    edge->weights = new float[edge->filter_size]();
-    edge->weight_updates = new float[edge->filter_size]();
-    edge->best_weights = new float[edge->filter_size]();
-
-    edge->previous_velocity = new float[edge->filter_size]();
-    edge->best_velocity = new float[edge->filter_size]();
+    edge->allocate_weights();
 
     edge->scale = read_hexfloat(is);
     edge->best_scale = read_hexfloat(is);
@@ -1641,6 +1731,102 @@ istream& operator>>(istream& is, CNN_Edge* edge) {
     return is;
 }
 
+/**
+ * Allocates the weight arrays of an edge whose filter size was just read.
+ */
+void CNN_Edge::allocate_weights() {
+    filter_size = filter_y * filter_x;
+
+    // don't need to initialize memory for unreachable edges
+    weights = new float[filter_size]();
+    weight_updates = new float[filter_size]();
+    best_weights = new float[filter_size]();
+
+    previous_velocity = new float[filter_size]();
+    best_velocity = new float[filter_size]();
+}
+
+void CNN_Edge::write_to_stream(ostream& bin_ostream) const {
+    write_binary_value(bin_ostream, edge_id);
+    write_binary_value(bin_ostream, exact_id);
+    write_binary_value(bin_ostream, genome_id);
+    write_binary_value(bin_ostream, type);
+    write_binary_value(bin_ostream, innovation_number);
+    write_binary_value(bin_ostream, input_node_innovation_number);
+    write_binary_value(bin_ostream, output_node_innovation_number);
+    write_binary_value(bin_ostream, filter_x);
+    write_binary_value(bin_ostream, filter_y);
+    write_binary_value(bin_ostream, fixed);
+    write_binary_value(bin_ostream, reverse_filter_x);
+    write_binary_value(bin_ostream, reverse_filter_y);
+    write_binary_value(bin_ostream, disabled);
+    write_binary_value(bin_ostream, forward_visited);
+    write_binary_value(bin_ostream, reverse_visited);
+    write_binary_value(bin_ostream, needs_initialization);
+    write_binary_value(bin_ostream, batch_size);
+
+    write_binary_value(bin_ostream, scale);
+    write_binary_value(bin_ostream, best_scale);
+    write_binary_value(bin_ostream, previous_velocity_scale);
+    write_binary_value(bin_ostream, best_velocity_scale);
+
+    write_binary_ints(bin_ostream, y_pools);
+    write_binary_ints(bin_ostream, x_pools);
+
+    write_binary_floats(bin_ostream, weights, filter_size);
+    write_binary_floats(bin_ostream, best_weights, filter_size);
+    write_binary_floats(bin_ostream, previous_velocity, filter_size);
+    write_binary_floats(bin_ostream, best_velocity, filter_size);
+}
+
+void CNN_Edge::read_from_stream(istream& bin_istream) {
+    read_binary_value(bin_istream, edge_id);
+    read_binary_value(bin_istream, exact_id);
+    read_binary_value(bin_istream, genome_id);
+    read_binary_value(bin_istream, type);
+    read_binary_value(bin_istream, innovation_number);
+    read_binary_value(bin_istream, input_node_innovation_number);
+    read_binary_value(bin_istream, output_node_innovation_number);
+    read_binary_value(bin_istream, filter_x);
+    read_binary_value(bin_istream, filter_y);
+    read_binary_value(bin_istream, fixed);
+    read_binary_value(bin_istream, reverse_filter_x);
+    read_binary_value(bin_istream, reverse_filter_y);
+    read_binary_value(bin_istream, disabled);
+    read_binary_value(bin_istream, forward_visited);
+    read_binary_value(bin_istream, reverse_visited);
+    read_binary_value(bin_istream, needs_initialization);
+    read_binary_value(bin_istream, batch_size);
+
+    // the four weight arrays are stored after the edge's fields
+    if (batch_size <= 0 || filter_y <= 0 || filter_x <= 0
+        || !valid_binary_count(bin_istream, (int64_t) filter_y * filter_x, 4 * sizeof(float))) {
+        cerr << "ERROR: binary genome has edge " << innovation_number << " with an invalid filter size of "
+             << filter_y << " x " << filter_x << " or batch size of " << batch_size << endl;
+        exit(1);
+    }
+
+    allocate_weights();
+
+    scale = read_binary_float(bin_istream);
+    best_scale = read_binary_float(bin_istream);
+    previous_velocity_scale = read_binary_float(bin_istream);
+    best_velocity_scale = read_binary_float(bin_istream);
+
+    read_binary_ints(bin_istream, y_pools);
+    read_binary_ints(bin_istream, x_pools);
+
+    update_offset(y_pools, y_pool_offset);
+    update_offset(x_pools, x_pool_offset);
+
+    read_binary_floats(bin_istream, weights, filter_size);
+    read_binary_floats(bin_istream, best_weights, filter_size);
+    read_binary_floats(bin_istream, previous_velocity, filter_size);
+    read_binary_floats(bin_istream, best_velocity, filter_size);
+
+    // pools will be initialized after nodes are set
+}
+
 bool CNN_Edge::is_identical(const CNN_Edge* other, bool testing_checkpoint) {
     if (are_different("edge_id", edge_id, other->edge_id)) {
         return false;
@@ -77,11 +77,22 @@ class CNN_Edge {
     float propagate_forward_time;
     float weight_update_time;
 
+    // only time the edge when profiling, so the clock is not read on every propagation
+    bool timing;
+
+    void allocate_weights();
+
    public:
     CNN_Edge();
 
     CNN_Edge(CNN_Node* _input_node, CNN_Node* _output_node, bool _fixed, int _innovation_number, int _type);
 
+    /**
+     * The columns of the cnn_edge table and this edge's values for them (see CNN_Node).
+     */
+    static string get_database_columns();
+    string get_database_values(int database_exact_id, string database_genome_id) const;
+
 #ifdef _MYSQL_
     CNN_Edge(int edge_id);
     void export_to_database(int exact_id, int genome_id);
@@ -95,13 +106,21 @@ class CNN_Edge {
 
     bool equals(CNN_Edge* other) const;
 
+    /**
+     * A hash of the edge's innovation number and the fields compared by equals.
+     */
+    uint64_t get_structural_hash() const;
+
     int get_type() const;
 
     bool has_nan() const;
 
+    void set_timing(bool _timing);
     void reset_times();
     void accumulate_times(float& total_forward_time, float& total_backward_time, float& total_weight_update_time);
 
+    float get_operations_estimate() const;
+
     void set_needs_init();
     bool needs_init() const;
     int get_filter_size() const;
@@ -188,6 +207,9 @@ class CNN_Edge {
 
     friend ostream& operator<<(ostream& os, const CNN_Edge* flight);
     friend istream& operator>>(istream& is, CNN_Edge* flight);
+
+    void write_to_stream(ostream& bin_ostream) const;
+    void read_from_stream(istream& bin_istream);
 };
 
 int random_edge_type(float random_value);
@@ -52,6 +52,10 @@ using std::vector;
 #include "common/db_conn.hxx"
 #endif
 
+#ifdef _HAS_ZLIB_
+#include <zlib.h>
+#endif
+
 #include "cnn_edge.hxx"
 #include "cnn_genome.hxx"
 #include "cnn_node.hxx"
@@ -62,9 +66,10 @@ using std::vector;
 #include "comparison.hxx"
 #include "image_tools/image_set.hxx"
 #include "image_tools/large_image_set.hxx"
+#include "softmax.hxx"
 #include "stdint.h"
 
-void write_map(ostream& out, map<string, int>& m) {
+void write_map(ostream& out, const map<string, int>& m) {
     out << m.size();
     for (auto iterator = m.begin(); iterator != m.end(); iterator++) {
         out << " " << iterator->first;
@@ -93,6 +98,18 @@ CNN_Genome::CNN_Genome(string filename, bool is_checkpoint) {
     genome_id = -1;
     started_from_checkpoint = is_checkpoint;
 
+    ifstream bin_infile(filename.c_str(), ios::in | ios::binary);
+    if (!bin_infile.good()) {
+        cerr << "ERROR: could not open genome file '" << filename << "' for reading" << endl;
+        exit(1);
+    }
+
+    if (is_binary(bin_infile)) {
+        read_from_stream(bin_infile);
+        return;
+    }
+    bin_infile.close();
+
     string file_contents;
 
     // cout << "getting file as string: '" << filename << "'" << endl;
@@ -110,7 +127,12 @@ CNN_Genome::CNN_Genome(istream& in, bool is_checkpoint) {
     exact_id = -1;
     genome_id = -1;
     started_from_checkpoint = is_checkpoint;
-    read(in);
+
+    if (is_binary(in)) {
+        read_from_stream(in);
+    } else {
+        read(in);
+    }
 }
 
 void CNN_Genome::set_progress_function(int (*_progress_function)(float)) {
@@ -118,9 +140,23 @@ void CNN_Genome::set_progress_function(int (*_progress_function)(float)) {
 }
 
 int CNN_Genome::get_genome_id() const {
+    if (export_id != NULL) {
+        return export_id->load();
+    }
     return genome_id;
 }
 
+shared_ptr<atomic<int> > CNN_Genome::get_export_id() {
+    if (export_id == NULL) {
+        export_id = shared_ptr<atomic<int> >(new atomic<int>(genome_id));
+    }
+    return export_id;
+}
+
+bool CNN_Genome::has_export_id() const {
+    return export_id != NULL;
+}
+
 int CNN_Genome::get_exact_id() const {
     return exact_id;
 }
@@ -198,9 +234,84 @@ void parse_array(vector<T>& output, istringstream& iss) {
     }
 }
 
+string CNN_Genome::get_database_columns() {
+    return "exact_id, input_node_innovation_numbers, softmax_node_innovation_numbers, generator, "
+           "normal_distribution, hyperparameters, velocity_reset, batch_size, epoch, max_epochs, reset_weights, "
+           "padding, best_epoch, number_validation_images, best_validation_error, best_validation_predictions, "
+           "number_training_images, training_error, training_predictions, number_test_images, test_error, "
+           "test_predictions, started_from_checkpoint, generation_id, name, checkpoint_filename, output_filename, "
+           "generated_by_map";
+}
+
+string CNN_Genome::get_database_values(int database_exact_id) const {
+    ostringstream values;
+
+    values << database_exact_id << ", '";
+    for (uint32_t i = 0; i < input_nodes.size(); i++) {
+        if (i != 0) {
+            values << " ";
+        }
+        values << input_nodes[i]->get_innovation_number();
+    }
+
+    values << "', '";
+    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+        if (i != 0) {
+            values << " ";
+        }
+        values << softmax_nodes[i]->get_innovation_number();
+    }
+
+    values << "', '" << generator << "', '" << normal_distribution << "', '";
+
+    write_hexfloat(values, epsilon);
+    values << " ";
+    write_hexfloat(values, alpha);
+    values << " ";
+    write_hexfloat(values, input_dropout_probability);
+    values << " ";
+    write_hexfloat(values, hidden_dropout_probability);
+    values << " ";
+    write_hexfloat(values, initial_mu);
+    values << " ";
+    write_hexfloat(values, mu);
+    values << " ";
+    write_hexfloat(values, mu_delta);
+    values << " ";
+    write_hexfloat(values, initial_learning_rate);
+    values << " ";
+    write_hexfloat(values, learning_rate);
+    values << " ";
+    write_hexfloat(values, learning_rate_delta);
+    values << " ";
+    write_hexfloat(values, initial_weight_decay);
+    values << " ";
+    write_hexfloat(values, weight_decay);
+    values << " ";
+    write_hexfloat(values, weight_decay_delta);
+
+    values << "', '" << velocity_reset << "', " << batch_size << ", " << epoch << ", " << max_epochs << ", "
+           << reset_weights << ", " << padding << ", " << best_epoch << ", " << number_validation_images << ", "
+           << setprecision(15) << fixed << best_validation_error << ", " << best_validation_predictions << ", "
+           << number_training_images << ", " << training_error << ", " << training_predictions << ", "
+           << number_test_images << ", " << test_error << ", " << test_predictions << ", " << started_from_checkpoint
+           << ", " << generation_id << ", '" << name << "', '" << checkpoint_filename << "', '" << output_filename
+           << "', '";
+
+    write_map(values, generated_by_map);
+    values << "'";
+
+    return values.str();
+}
+
 #ifdef _MYSQL_
 CNN_Genome::CNN_Genome(int _genome_id) {
     progress_function = NULL;
+    checkpoint_interval = 0;
+    interrupt_flag = NULL;
+    profile_filename = "";
+    profile_interval = 0;
+    timing = false;
     version_str = EXACT_VERSION_STR;
 
     ostringstream query;
@@ -373,96 +484,13 @@ void CNN_Genome::export_to_database(int _exact_id) {
     exact_id = _exact_id;
 
     ostringstream query;
-
     if (genome_id >= 0) {
-        query << "REPLACE INTO cnn_genome SET id = " << genome_id << ",";
+        query << "REPLACE INTO cnn_genome (id, " << get_database_columns() << ") VALUES (" << genome_id << ", "
+              << get_database_values(exact_id) << ")";
     } else {
-        query << "INSERT INTO cnn_genome SET";
-    }
-
-    query << " exact_id = " << exact_id << ", input_node_innovation_numbers = '";
-
-    for (uint32_t i = 0; i < input_nodes.size(); i++) {
-        if (i != 0) {
-            query << " ";
-        }
-        query << input_nodes[i]->get_innovation_number();
-    }
-
-    query << "', softmax_node_innovation_numbers = '";
-
-    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
-        if (i != 0) {
-            query << " ";
-        }
-        query << softmax_nodes[i]->get_innovation_number();
-    }
-
-    query << "', generator = '" << generator << "'"
-          << ", normal_distribution = '" << normal_distribution << "'"
-          << ", hyperparameters = '";
-
-    write_hexfloat(query, epsilon);
-    query << " ";
-    write_hexfloat(query, alpha);
-    query << " ";
-    write_hexfloat(query, input_dropout_probability);
-    query << " ";
-    write_hexfloat(query, hidden_dropout_probability);
-    query << " ";
-    write_hexfloat(query, initial_mu);
-    query << " ";
-    write_hexfloat(query, mu);
-    query << " ";
-    write_hexfloat(query, mu_delta);
-    query << " ";
-    write_hexfloat(query, initial_learning_rate);
-    query << " ";
-    write_hexfloat(query, learning_rate);
-    query << " ";
-    write_hexfloat(query, learning_rate_delta);
-    query << " ";
-    write_hexfloat(query, initial_weight_decay);
-    query << " ";
-    write_hexfloat(query, weight_decay);
-    query << " ";
-    write_hexfloat(query, weight_decay_delta);
-
-    query << "'"
-          << ", velocity_reset = '" << velocity_reset << "'"
-          << ", batch_size = " << batch_size << ", epoch = " << epoch << ", max_epochs = " << max_epochs
-          << ", reset_weights = " << reset_weights << ", padding = " << padding << ", best_epoch = " << best_epoch
-          << ", number_validation_images = " << number_validation_images
-          << ", best_validation_error = " << setprecision(15) << fixed << best_validation_error
-          << ", best_validation_predictions = " << best_validation_predictions
-
-          << ", number_training_images = " << number_training_images << ", training_error = " << setprecision(15)
-          << fixed << training_error << ", training_predictions = " << training_predictions
-
-          << ", number_test_images = " << number_test_images << ", test_error = " << setprecision(15) << fixed
-          << test_error << ", test_predictions = " << test_predictions
-
-          << ", started_from_checkpoint = " << started_from_checkpoint;
-
-    // too much overhead for saving this and no use for it
-    // query << ", backprop_order = ''";
-    /*
-    query << ", backprop_order = '";
-    for (uint32_t i = 0; i < backprop_order.size(); i++) {
-        if (i != 0) query << " ";
-        query << setprecision(15) << backprop_order[i];
+        query << "INSERT INTO cnn_genome (" << get_database_columns() << ") VALUES (" << get_database_values(exact_id)
+              << ")";
     }
-    query << "'";
-    */
-
-    query << ", generation_id = " << generation_id << ", name = '" << name << "'"
-          << ", checkpoint_filename = '" << checkpoint_filename << "'"
-          << ", output_filename = '" << output_filename << "'"
-          << ", generated_by_map = '";
-
-    write_map(query, generated_by_map);
-
-    query << "'";
     // cout << "query:\n" << query.str() << endl;
 
     mysql_exact_query(query.str());
@@ -504,6 +532,8 @@ CNN_Genome::CNN_Genome(
     number_test_images = _number_test_images;
 
     progress_function = NULL;
+    checkpoint_interval = 0;
+    interrupt_flag = NULL;
 
     velocity_reset = _velocity_reset;
 
@@ -545,6 +575,9 @@ CNN_Genome::CNN_Genome(
     name = "";
     output_filename = "";
     checkpoint_filename = "";
+    profile_filename = "";
+    profile_interval = 0;
+    timing = false;
 
     nodes = _nodes;
     edges = _edges;
@@ -670,6 +703,18 @@ bool CNN_Genome::equals(CNN_Genome* other) const {
     return true;
 }
 
+uint64_t CNN_Genome::get_structural_hash() const {
+    // a sum so the hash does not depend on the order of the edges
+    uint64_t hash = 0;
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        if (edges[i]->is_disabled()) {
+            continue;
+        }
+        hash += edges[i]->get_structural_hash();
+    }
+    return hash;
+}
+
 int CNN_Genome::get_padding() const {
     return padding;
 }
@@ -701,75 +746,20 @@ int CNN_Genome::get_number_weights() const {
 int CNN_Genome::get_operations_estimate() const {
     int operations_estimate = 0;
 
-    float random_cost = 100.0;
-    float if_cost = 15.0;
-    float multiply_cost = 7.0;
-    float add_cost = 1.0;
-
     for (uint32_t i = 0; i < nodes.size(); i++) {
-        // propagate forward has 1 RELU and 1 DropOut per value in node
-        // RELU is 2 ifs, 1 multiply
-        // dropout is 1 if, 1 random
         if (!nodes[i]->is_reachable()) {
             continue;
         }
 
-        operations_estimate +=
-            nodes[i]->get_size_x() * nodes[i]->get_size_y() * (3.0 * if_cost + multiply_cost + random_cost);
+        operations_estimate += nodes[i]->get_operations_estimate();
     }
 
     for (uint32_t i = 0; i < edges.size(); i++) {
-        // propagate forward has 1 multiply 1 add per input to output
-        // propagate backward has 3 multiplies and 2 adds per output to input
         if (!edges[i]->is_reachable()) {
             continue;
         }
 
-        bool reverse_filter_x = edges[i]->is_reverse_filter_x();
-        bool reverse_filter_y = edges[i]->is_reverse_filter_y();
-
-        // TODO: calculate differently for POOLING nodes
-        if (edges[i]->get_type() == CONVOLUTIONAL) {
-            float propagate_count;
-
-            if (reverse_filter_x && reverse_filter_y) {
-                propagate_count = edges[i]->get_filter_x() * edges[i]->get_filter_y()
-                                  * edges[i]->get_input_node()->get_size_x() * edges[i]->get_input_node()->get_size_y();
-            } else if (reverse_filter_x) {
-                propagate_count = edges[i]->get_filter_x() * edges[i]->get_filter_y()
-                                  * edges[i]->get_input_node()->get_size_x()
-                                  * edges[i]->get_output_node()->get_size_y();
-            } else if (reverse_filter_y) {
-                propagate_count = edges[i]->get_filter_x() * edges[i]->get_filter_y()
-                                  * edges[i]->get_output_node()->get_size_x()
-                                  * edges[i]->get_input_node()->get_size_y();
-            } else {
-                propagate_count = edges[i]->get_filter_x() * edges[i]->get_filter_y()
-                                  * edges[i]->get_output_node()->get_size_x()
-                                  * edges[i]->get_output_node()->get_size_y();
-            }
-
-            operations_estimate += propagate_count * ((4.0 * multiply_cost) + (3.0 * add_cost));
-
-        } else {
-            float propagate_count;
-
-            if (reverse_filter_x && reverse_filter_y) {
-                propagate_count = edges[i]->get_input_node()->get_size_x() * edges[i]->get_input_node()->get_size_y();
-            } else if (reverse_filter_y) {
-                propagate_count = edges[i]->get_input_node()->get_size_x() * edges[i]->get_output_node()->get_size_y();
-            } else if (reverse_filter_x) {
-                propagate_count = edges[i]->get_output_node()->get_size_x() * edges[i]->get_input_node()->get_size_y();
-            } else {
-                propagate_count = edges[i]->get_output_node()->get_size_x() * edges[i]->get_output_node()->get_size_y();
-            }
-
-            operations_estimate += propagate_count * 2.0 * (16.0 * add_cost) + (4.0 * multiply_cost);
-        }
-
-        // update weights has 4 multiplies 4 adds and 2 ifs per weight
-        operations_estimate += edges[i]->get_filter_x() * edges[i]->get_filter_y()
-                               * (4.0 * multiply_cost + 4.0 * add_cost + 2.0 * if_cost);
+        operations_estimate += edges[i]->get_operations_estimate();
     }
 
     return operations_estimate;
@@ -1324,183 +1314,43 @@ void CNN_Genome::evaluate_images(
     }
 
     // may be less images than in a batch if the total number of images is not divisible by the batch size
-    for (int32_t batch_number = 0; batch_number < batch.size(); batch_number++) {
-        int expected_class = images.get_classification(batch[batch_number]);
-
-        // cout << "before softmax max, batch number: " << batch_number << " -- ";
-        float softmax_max = softmax_nodes[0]->get_value_in(batch_number, 0, 0);
-        // cout << " " << setw(15) << fixed << setprecision(6) << softmax_nodes[0]->get_value_in(batch_number, 0,0);
-
-        for (uint32_t i = 1; i < softmax_nodes.size(); i++) {
-            // cout << " " << setw(15) << fixed << setprecision(6) << softmax_nodes[i]->get_value_in(batch_number, 0,0);
-            if (softmax_nodes[i]->get_value_in(batch_number, 0, 0) > softmax_max) {
-                softmax_max = softmax_nodes[i]->get_value_in(batch_number, 0, 0);
-            }
-        }
-        // cout << endl;
-
-        // cout << "after softmax max:" << endl;
-        float softmax_sum = 0.0;
-        for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
-            float value = softmax_nodes[i]->get_value_in(batch_number, 0, 0);
-            float previous = value;
-
-            if (isnan(value)) {
-                cerr << "ERROR: value was NAN before exp!" << endl;
-                exit(1);
-            }
-            // cout << " value - softmax_max: " << value - softmax_max << endl;
-
-            value = exact_exp(value - softmax_max);
-
-            // cout << " " << setw(15) << fixed << setprecision(6) << value;
-            if (isnan(value)) {
-                cerr << "ERROR: value was NAN AFTER exp! previously: " << previous << endl;
-                exit(1);
-            }
-
-            softmax_nodes[i]->set_value_in(batch_number, 0, 0, value);
-            // cout << "\tvalue " << softmax_nodes[i]->get_innovation_number() << ": " <<
-            // softmax_nodes[i]->get_value_in(batch_number, 0,0) << endl;
-            softmax_sum += value;
-
-            if (isnan(softmax_sum)) {
-                cerr << "ERROR: softmax_sum was NAN AFTER add!" << endl;
-                exit(1);
-            }
-        }
-        // cout << endl;
-
-        if (softmax_sum == 0) {
-            cout << "ERROR! softmax sum == 0" << endl;
-            exit(1);
-        }
-
-        // cout << "softmax sum: " << softmax_sum << endl;
-
-        float max_value = -numeric_limits<float>::max();
-        int predicted_class = -1;
+    int number_classes = softmax_nodes.size();
+    int current_batch_size = batch.size();
+    gather_softmax_values(current_batch_size);
 
-        // cout << "error:          ";
-        for (int32_t i = 0; i < (int32_t) softmax_nodes.size(); i++) {
-            float value = softmax_nodes[i]->get_value_in(batch_number, 0, 0) / softmax_sum;
-            // cout << "\tvalue " << softmax_nodes[i]->get_innovation_number() << ": " <<
-            // softmax_nodes[i]->get_value_in(0,0) << endl;
+    predicted_classes.resize(current_batch_size);
+    softmax_forward(&softmax_values[0], &predicted_classes[0], current_batch_size, number_classes);
 
-            if (isnan(value)) {
-                cerr << "ERROR: value was NAN AFTER divide by softmax_sum, previously: "
-                     << softmax_nodes[i]->get_value_in(batch_number, 0, 0) << endl;
-                cerr << "softmax_sum: " << softmax_sum << endl;
-                exit(1);
-            }
+    for (int32_t batch_number = 0; batch_number < current_batch_size; batch_number++) {
+        const float* row = &softmax_values[batch_number * number_classes];
+        vector<float>& prediction = predictions[batch[batch_number] - offset];
 
-            softmax_nodes[i]->set_value_in(batch_number, 0, 0, value);
+        for (int32_t i = 0; i < number_classes; i++) {
+            prediction[i] = row[i];
         }
+    }
+}
 
-        for (int32_t i = 0; i < (int32_t) softmax_nodes.size(); i++) {
-            float value = softmax_nodes[i]->get_value_in(batch_number, 0, 0);
-            // softmax_nodes[i]->print(cout);
-
-            int target = 0.0;
-            if (i == expected_class) {
-                target = 1.0;
-            }
-            float error = value - target;
-            float gradient = value * (1 - value);
-
-            // if (training) cout << "\t" << softmax_nodes[i]->get_innovation_number() << " -- batch number: " <<
-            // batch_number << ", value: " << value << ", error: " << error << ", gradient: " << gradient << endl;
-
-            softmax_nodes[i]->set_error_in(batch_number, 0, 0, error * gradient);
-            // softmax_nodes[i]->set_gradient_in(batch_number, 0, 0, gradient);
-
-            if (value > max_value) {
-                predicted_class = i;
-                max_value = value;
-            }
+void CNN_Genome::gather_softmax_values(int current_batch_size) {
+    int number_classes = softmax_nodes.size();
 
-            predictions[batch[batch_number] - offset][i] = value;
-        }
+    softmax_node_values.resize(number_classes);
+    for (int32_t i = 0; i < number_classes; i++) {
+        softmax_node_values[i] = softmax_nodes[i]->get_values_in();
     }
+
+    softmax_values.resize(current_batch_size * number_classes);
+    softmax_gather(&softmax_node_values[0], &softmax_values[0], current_batch_size, number_classes);
 }
 
 void calculate_softmax(
     const vector<float>& values_in, vector<float>& values_out, vector<float>& gradient, int expected_class,
     int& predicted_class, float& entropy
 ) {
-    float softmax_max = values_in[0];
-    predicted_class = 0;
-
-    for (uint32_t i = 1; i < values_in.size(); i++) {
-        if (values_in[i] > softmax_max) {
-            softmax_max = values_in[i];
-            predicted_class = i;
-        }
-    }
-
-    float softmax_sum = 0.0;
-    for (uint32_t i = 0; i < values_in.size(); i++) {
-        values_out[i] = exact_exp(values_in[i] - softmax_max);
-        // values_out[i] = exact_exp(values_in[i]);
-        softmax_sum += values_out[i];
-    }
-
-    if (softmax_sum == 0 || isinf(softmax_sum) || isnan(softmax_sum)) {
-        cerr << "ERROR! softmax sum was " << softmax_sum << endl;
-        cerr << "values_in/values_out:" << endl;
-        for (uint32_t i = 0; i < values_in.size(); i++) {
-            cerr << "\tvalues_in[" << i << "]: " << values_in[i] << ", values_out[" << i << "]: " << values_out[i]
-                 << endl;
-        }
-        exit(1);
-    }
+    values_out = values_in;
+    softmax_cross_entropy(&values_out[0], &gradient[0], &expected_class, &predicted_class, 1, values_in.size());
 
     entropy = 0.0;
-    for (uint32_t i = 0; i < values_in.size(); i++) {
-        values_out[i] /= softmax_sum;
-
-        //        entropy -= values_out[i] * log(values_out[i]);
-    }
-
-    for (uint32_t i = 0; i < values_in.size(); i++) {
-        if (i == expected_class) {
-            gradient[i] = values_out[i] - 1;
-
-        } else {
-            gradient[i] = values_out[i];
-        }
-
-        // float beta = 1.0;
-        // apply confidence penalty
-        // cout << "entropy: " << entropy << ", expected class probability: " << values_out[i] << ", regular gradient: "
-        // << gradient[i]; gradient[i] += beta * values_out[i] * (-log(values_out[i]) - entropy); cout << ", after
-        // penalty: " << gradient[i] << endl;
-
-        // cout << "values_out[" << i << "]: " << values_out[i] << ", gradient before entropy[" << i << "]: " <<
-        // gradient[i];
-
-        // cout << ", gradient after entropy[" << i << "]: " << gradient[i] << endl;
-
-        /*
-        if (modified_softmax) {
-            gradient[i] *= values_out[i] * (1.0 - values_out[i]);
-        }
-        */
-    }
-
-    /*
-    cerr << "values_in:  ";
-    for (uint32_t i = 0; i < values_in.size(); i++) {
-        cerr << fixed << setw(11) << setprecision(7) << values_in[i];
-    }
-    cerr << endl;
-
-    cerr << "values_out: ";
-    for (uint32_t i = 0; i < values_out.size(); i++) {
-        cerr << fixed << setw(11) << setprecision(7) << values_out[i];
-    }
-    cerr << endl;
-    */
 }
 
 void CNN_Genome::check_gradients(const ImagesInterface& images) {
@@ -1647,73 +1497,35 @@ void CNN_Genome::evaluate_images(
         );
     }
 
-    vector<float> values_in(softmax_nodes.size());
-    vector<float> values_out(softmax_nodes.size());
-    vector<float> gradients(softmax_nodes.size());
-
     // may be less images than in a batch if the total number of images is not divisible by the batch size
-    for (int32_t batch_number = 0; batch_number < batch.size(); batch_number++) {
-        int expected_class = images.get_classification(batch[batch_number]);
-
-        for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
-            values_in[i] = softmax_nodes[i]->get_value_in(batch_number, 0, 0);
-        }
-
-        int predicted_class = 0;
-        float entropy = 0.0;
-        calculate_softmax(values_in, values_out, gradients, expected_class, predicted_class, entropy);
+    int number_classes = softmax_nodes.size();
+    int current_batch_size = batch.size();
+    gather_softmax_values(current_batch_size);
 
-        /*
-        cerr << "values_in/values_out:" << endl;
-        for (uint32_t i = 0; i < values_in.size(); i++) {
-            cerr << "\tvalues_in[" << i << "]: " << values_in[i] << ", values_out[" << i << "]: " << values_out[i] <<
-        endl;
-        }
-        */
-
-        for (int32_t i = 0; i < (int32_t) softmax_nodes.size(); i++) {
-            softmax_nodes[i]->set_value_in(batch_number, 0, 0, values_out[i]);
-            softmax_nodes[i]->set_error_in(batch_number, 0, 0, gradients[i]);
-        }
-
-        double previous_error = total_error;
-
-        // float beta = 0.0; //controls the strength of the confidence penalty
-
-        float error = values_out[expected_class];
-        if (error == 0) {
-            error = 1.0 / EXACT_MAX_FLOAT;
-        }
-        total_error -= log(error);
-        // total_error += beta * entropy;  //entropy is negative
-
-        if (isnan(total_error) || isinf(total_error)) {
-            cerr << "ERROR! total_error became NAN or INF!" << endl;
-            cerr << "previous total_error: " << previous_error << endl;
-            cerr << "error: " << error << endl;
-            cerr << "log(error): " << log(error) << endl;
-            cerr << "predicted_class: " << predicted_class << endl;
-            cerr << "expected_class: " << expected_class << endl;
-
-            cerr << "softmax node values: " << endl;
-            for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
-                cerr << "    " << softmax_nodes[i]->get_value_in(batch_number, 0, 0) << endl;
-            }
-
-            cerr << "values_in/values_out:" << endl;
-            for (uint32_t i = 0; i < values_in.size(); i++) {
-                cerr << "\tvalues_in[" << i << "]: " << values_in[i] << ", values_out[" << i << "]: " << values_out[i]
-                     << endl;
-            }
+    softmax_gradients.resize(current_batch_size * number_classes);
+    expected_classes.resize(current_batch_size);
+    predicted_classes.resize(current_batch_size);
+    for (int32_t batch_number = 0; batch_number < current_batch_size; batch_number++) {
+        expected_classes[batch_number] = images.get_classification(batch[batch_number]);
+    }
 
-            exit(1);
-        }
+    total_error += softmax_cross_entropy(
+        &softmax_values[0], &softmax_gradients[0], &expected_classes[0], &predicted_classes[0], current_batch_size,
+        number_classes
+    );
 
-        if (predicted_class == expected_class) {
+    for (int32_t batch_number = 0; batch_number < current_batch_size; batch_number++) {
+        if (predicted_classes[batch_number] == expected_classes[batch_number]) {
             correct_predictions++;
         }
     }
 
+    softmax_scatter(&softmax_values[0], &softmax_node_values[0], current_batch_size, number_classes);
+    for (int32_t i = 0; i < number_classes; i++) {
+        softmax_node_values[i] = softmax_nodes[i]->get_errors_in();
+    }
+    softmax_scatter(&softmax_gradients[0], &softmax_node_values[0], current_batch_size, number_classes);
+
     if (training) {
         for (int32_t i = edges.size() - 1; i >= 0; i--) {
             edges[i]->propagate_backward(training, mu, learning_rate, epsilon);
@@ -1945,10 +1757,7 @@ void CNN_Genome::get_prediction_matrix(
     cout << "created predictions vector for image: " << image_number << ", number subimages: " << number_subimages
          << ", number_classes: " << number_classes << endl;
 
-    int initial_offset = 0;
-    for (uint32_t i = 0; i < image_number; i++) {
-        initial_offset += images.get_number_subimages(i);
-    }
+    int initial_offset = images.get_subimage_offset(image_number);
     int current_subimage = initial_offset;
 
     for (uint32_t j = 0; j < number_subimages; j += batch_size) {
@@ -2153,6 +1962,13 @@ void CNN_Genome::evaluate(
     duration<float, std::milli> time_span = epoch_end_time - epoch_start_time;
 
     float epoch_time = time_span.count() / 1000.0;
+
+    // the nodes and edges are only timed when profiling
+    if (!timing) {
+        cerr << "epoch time: " << epoch_time << "s" << endl;
+        return;
+    }
+
     float input_fired_time = 0.0;
     float output_fired_time = 0.0;
 
@@ -2247,14 +2063,18 @@ void CNN_Genome::stochastic_backpropagation(
 
         cerr << "pre shuffle 1: " << generator() << endl;
 
-        // shuffle the array (thanks C++ not being the same across operating systems)
-        fisher_yates_shuffle(generator, backprop_order);
+        // shuffle the array (thanks C++ not being the same across operating systems),
+        // streaming image sets shuffle themselves and need to be read in order
+        if (!training_images.is_streaming()) {
+            fisher_yates_shuffle(generator, backprop_order);
+        }
 
         cerr << "post shuffle 1: " << generator() << endl;
 
         best_validation_error = EXACT_MAX_FLOAT;
     }
     backprop_order.resize(training_resize);
+    last_checkpoint_time = std::chrono::steady_clock::now();
 
     // sort edges by depth of input node
     sort(edges.begin(), edges.end(), sort_CNN_Edges_by_depth());
@@ -2271,9 +2091,23 @@ void CNN_Genome::stochastic_backpropagation(
 
     do {
         // shuffle the array (thanks C++ not being the same across operating systems)
-        fisher_yates_shuffle(generator, backprop_order);
+        if (!training_images.is_streaming()) {
+            fisher_yates_shuffle(generator, backprop_order);
+        }
+        training_images.start_pass();
+
+        bool profiling = profile_interval > 0 && (epoch % profile_interval) == 0;
+        if (profiling) {
+            set_timing(true);
+        }
 
         evaluate(training_images, backprop_order, current_training_error, current_training_predictions, true, false);
+
+        if (profiling) {
+            write_profile(epoch, backprop_order.size());
+            set_timing(false);
+        }
+
         evaluate(
             validation_images, validation_order, current_validation_error, current_validation_predictions, false, false
         );
@@ -2326,8 +2160,13 @@ void CNN_Genome::stochastic_backpropagation(
 
         epoch++;
 
+        bool interrupted = interrupt_flag != NULL && *interrupt_flag != 0 && epoch <= max_epochs;
         if (checkpoint_filename.compare("") != 0) {
-            write_to_file(checkpoint_filename);
+            std::chrono::steady_clock::duration since_checkpoint =
+                std::chrono::steady_clock::now() - last_checkpoint_time;
+            if (interrupted || since_checkpoint >= std::chrono::seconds(checkpoint_interval)) {
+                write_checkpoint();
+            }
         }
 
         if (progress_function != NULL) {
@@ -2346,6 +2185,11 @@ void CNN_Genome::stochastic_backpropagation(
         if (epoch > max_epochs) {
             break;
         }
+
+        if (interrupted) {
+            cerr << "training interrupted after epoch " << (epoch - 1) << " of " << max_epochs << endl;
+            return;
+        }
     } while (true);
 
     cerr << "evaluating best weights on full training data." << endl;
@@ -2386,6 +2230,125 @@ void CNN_Genome::set_checkpoint_filename(string _checkpoint_filename) {
     checkpoint_filename = _checkpoint_filename;
 }
 
+void CNN_Genome::set_checkpoint_interval(int _checkpoint_interval) {
+    checkpoint_interval = _checkpoint_interval;
+}
+
+void CNN_Genome::set_interrupt_flag(const volatile sig_atomic_t* _interrupt_flag) {
+    interrupt_flag = _interrupt_flag;
+}
+
+void CNN_Genome::write_checkpoint() {
+    ostringstream checkpoint_oss;
+    write_to_stream(checkpoint_oss);
+
+    if (!write_file_atomically(checkpoint_filename, checkpoint_oss.str())) {
+        cerr << "WARNING: could not write checkpoint file '" << checkpoint_filename << "'" << endl;
+        return;
+    }
+    last_checkpoint_time = std::chrono::steady_clock::now();
+}
+
+void CNN_Genome::set_profile(string _profile_filename, int _profile_interval) {
+#ifdef CNN_NO_TIMERS
+    cerr << "WARNING: compiled with CNN_NO_TIMERS, not writing profile '" << _profile_filename << "'" << endl;
+#else
+    profile_filename = _profile_filename;
+    profile_interval = _profile_interval;
+
+    ofstream outfile(profile_filename.c_str());
+    if (!outfile.is_open()) {
+        cerr << "WARNING: could not open profile file '" << profile_filename << "', not profiling" << endl;
+        profile_interval = 0;
+        return;
+    }
+
+    outfile << "epoch,component,innovation_number,type,input_innovation_number,output_innovation_number,size_y,"
+               "size_x,filter_y,filter_x,images,forward_time,backward_time,weight_update_time,operations_estimate,"
+               "gops_per_second"
+            << endl;
+    outfile.close();
+#endif
+}
+
+void CNN_Genome::set_timing(bool _timing) {
+    timing = _timing;
+
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        nodes[i]->set_timing(timing);
+    }
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        edges[i]->set_timing(timing);
+    }
+}
+
+void CNN_Genome::write_profile(int profile_epoch, int number_images) {
+    ofstream outfile(profile_filename.c_str(), ios::app);
+    if (!outfile.is_open()) {
+        cerr << "WARNING: could not open profile file '" << profile_filename << "' for appending" << endl;
+        return;
+    }
+
+    // the operations estimates are per image, so the throughput is the estimate times the
+    // number of images over the total time spent in the node or edge
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i]->is_reachable()) {
+            continue;
+        }
+
+        float input_fired_time = 0.0;
+        float output_fired_time = 0.0;
+        nodes[i]->accumulate_times(input_fired_time, output_fired_time);
+
+        float total_time = input_fired_time + output_fired_time;
+        float operations_estimate = nodes[i]->get_operations_estimate();
+        float gops = 0.0;
+        if (total_time > 0) {
+            gops = (operations_estimate * number_images) / (total_time * 1e9);
+        }
+
+        string node_type = "hidden";
+        if (nodes[i]->is_input()) {
+            node_type = "input";
+        } else if (nodes[i]->is_softmax()) {
+            node_type = "softmax";
+        }
+
+        outfile << profile_epoch << ",node," << nodes[i]->get_innovation_number() << "," << node_type << ",,,"
+                << nodes[i]->get_size_y() << "," << nodes[i]->get_size_x() << ",,," << number_images << ","
+                << input_fired_time << "," << output_fired_time << ",0," << operations_estimate << "," << gops << endl;
+    }
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (!edges[i]->is_reachable()) {
+            continue;
+        }
+
+        float propagate_forward_time = 0.0;
+        float propagate_backward_time = 0.0;
+        float weight_update_time = 0.0;
+        edges[i]->accumulate_times(propagate_forward_time, propagate_backward_time, weight_update_time);
+
+        float total_time = propagate_forward_time + propagate_backward_time + weight_update_time;
+        float operations_estimate = edges[i]->get_operations_estimate();
+        float gops = 0.0;
+        if (total_time > 0) {
+            gops = (operations_estimate * number_images) / (total_time * 1e9);
+        }
+
+        CNN_Node* output_node = edges[i]->get_output_node();
+
+        outfile << profile_epoch << ",edge," << edges[i]->get_innovation_number() << ","
+                << (edges[i]->get_type() == CONVOLUTIONAL ? "convolutional" : "pooling") << ","
+                << edges[i]->get_input_innovation_number() << "," << edges[i]->get_output_innovation_number() << ","
+                << output_node->get_size_y() << "," << output_node->get_size_x() << "," << edges[i]->get_filter_y()
+                << "," << edges[i]->get_filter_x() << "," << number_images << "," << propagate_forward_time << ","
+                << propagate_backward_time << "," << weight_update_time << "," << operations_estimate << "," << gops
+                << endl;
+    }
+}
+
 string CNN_Genome::get_version_str() const {
     return version_str;
 }
@@ -2500,6 +2463,11 @@ void CNN_Genome::write(ostream& outfile) {
 
 void CNN_Genome::read(istream& infile) {
     progress_function = NULL;
+    checkpoint_interval = 0;
+    interrupt_flag = NULL;
+    profile_filename = "";
+    profile_interval = 0;
+    timing = false;
 
     bool verbose = true;
 
@@ -2830,12 +2798,368 @@ void CNN_Genome::read(istream& infile) {
     visit_nodes();
 }
 
-void CNN_Genome::write_to_file(string filename) {
+void CNN_Genome::write_text_to_file(string filename) {
     ofstream outfile(filename.c_str());
     write(outfile);
     outfile.close();
 }
 
+static void write_binary_string(ostream& out, const string& s) {
+    int32_t n = s.size();
+    write_binary_value(out, n);
+    if (n > 0) {
+        out.write(&s[0], n);
+    }
+}
+
+static void read_binary_string(istream& in, string& s) {
+    int32_t n;
+    read_binary_value(in, n);
+    if (!valid_binary_count(in, n, sizeof(char))) {
+        cerr << "ERROR: binary genome has a string with an invalid length: " << n << endl;
+        exit(1);
+    }
+    s.assign(n, '\0');
+    if (n > 0) {
+        in.read(&s[0], n);
+    }
+}
+
+bool CNN_Genome::is_binary(istream& in) {
+    return in.peek() == (unsigned char) CNN_GENOME_BINARY_MAGIC[0];
+}
+
+void CNN_Genome::write_to_stream(ostream& bin_ostream, bool compress) {
+    ostringstream payload_oss;
+
+    write_binary_string(payload_oss, EXACT_VERSION_STR);
+    write_binary_value(payload_oss, exact_id);
+    write_binary_value(payload_oss, genome_id);
+
+    write_binary_value(payload_oss, initial_mu);
+    write_binary_value(payload_oss, mu);
+    write_binary_value(payload_oss, mu_delta);
+    write_binary_value(payload_oss, initial_learning_rate);
+    write_binary_value(payload_oss, learning_rate);
+    write_binary_value(payload_oss, learning_rate_delta);
+    write_binary_value(payload_oss, initial_weight_decay);
+    write_binary_value(payload_oss, weight_decay);
+    write_binary_value(payload_oss, weight_decay_delta);
+
+    write_binary_value(payload_oss, batch_size);
+    write_binary_value(payload_oss, epsilon);
+    write_binary_value(payload_oss, alpha);
+    write_binary_value(payload_oss, input_dropout_probability);
+    write_binary_value(payload_oss, hidden_dropout_probability);
+    write_binary_value(payload_oss, velocity_reset);
+
+    write_binary_value(payload_oss, epoch);
+    write_binary_value(payload_oss, max_epochs);
+    write_binary_value(payload_oss, reset_weights);
+    write_binary_value(payload_oss, padding);
+
+    write_binary_value(payload_oss, best_epoch);
+    write_binary_value(payload_oss, number_validation_images);
+    write_binary_value(payload_oss, best_validation_predictions);
+    write_binary_value(payload_oss, best_validation_error);
+    write_binary_value(payload_oss, number_training_images);
+    write_binary_value(payload_oss, training_predictions);
+    write_binary_value(payload_oss, training_error);
+    write_binary_value(payload_oss, number_test_images);
+    write_binary_value(payload_oss, test_predictions);
+    write_binary_value(payload_oss, test_error);
+
+    write_binary_value(payload_oss, generation_id);
+
+    // the random number generators only have text forms
+    ostringstream normal_distribution_oss;
+    normal_distribution_oss << normal_distribution;
+    write_binary_string(payload_oss, normal_distribution_oss.str());
+
+    ostringstream generator_oss;
+    generator_oss << generator;
+    write_binary_string(payload_oss, generator_oss.str());
+
+    ostringstream generated_by_map_oss;
+    write_map(generated_by_map_oss, generated_by_map);
+    write_binary_string(payload_oss, generated_by_map_oss.str());
+
+    int32_t number_nodes = nodes.size();
+    write_binary_value(payload_oss, number_nodes);
+    for (int32_t i = 0; i < number_nodes; i++) {
+        nodes[i]->write_to_stream(payload_oss);
+    }
+
+    int32_t number_edges = edges.size();
+    write_binary_value(payload_oss, number_edges);
+    for (int32_t i = 0; i < number_edges; i++) {
+        edges[i]->write_to_stream(payload_oss);
+    }
+
+    vector<int> input_innovation_numbers;
+    for (int32_t i = 0; i < (int32_t) input_nodes.size(); i++) {
+        input_innovation_numbers.push_back(input_nodes[i]->get_innovation_number());
+    }
+    write_binary_ints(payload_oss, input_innovation_numbers);
+
+    vector<int> softmax_innovation_numbers;
+    for (int32_t i = 0; i < (int32_t) softmax_nodes.size(); i++) {
+        softmax_innovation_numbers.push_back(softmax_nodes[i]->get_innovation_number());
+    }
+    write_binary_ints(payload_oss, softmax_innovation_numbers);
+
+    int32_t order_size = backprop_order.size();
+    write_binary_value(payload_oss, order_size);
+    for (int32_t i = 0; i < order_size; i++) {
+        int64_t order = backprop_order[i];
+        write_binary_value(payload_oss, order);
+    }
+
+    string payload = payload_oss.str();
+    uint64_t payload_size = payload.size();
+
+    int32_t flags = 0;
+#ifdef _HAS_ZLIB_
+    if (compress) {
+        uLongf compressed_size = compressBound(payload_size);
+        string compressed(compressed_size, '\0');
+        int result = compress2(
+            (Bytef*) &compressed[0], &compressed_size, (const Bytef*) payload.data(), payload_size, Z_BEST_SPEED
+        );
+        if (result != Z_OK) {
+            cerr << "ERROR: could not compress genome " << generation_id << endl;
+            exit(1);
+        }
+        compressed.resize(compressed_size);
+        payload.swap(compressed);
+        flags |= CNN_GENOME_BINARY_COMPRESSED;
+    }
+#else
+    if (compress) {
+        cerr << "WARNING: EXACT was not compiled with zlib, writing genome " << generation_id << " uncompressed"
+             << endl;
+    }
+#endif
+    uint64_t stored_size = payload.size();
+
+    int32_t version = CNN_GENOME_BINARY_VERSION;
+    bin_ostream.write(CNN_GENOME_BINARY_MAGIC, 8);
+    write_binary_value(bin_ostream, version);
+    write_binary_value(bin_ostream, flags);
+    write_binary_value(bin_ostream, payload_size);
+    write_binary_value(bin_ostream, stored_size);
+    bin_ostream.write(payload.data(), stored_size);
+}
+
+void CNN_Genome::write_to_file(string filename, bool compress) {
+    ofstream bin_outfile(filename.c_str(), ios::out | ios::binary);
+    write_to_stream(bin_outfile, compress);
+    bin_outfile.close();
+}
+
+void CNN_Genome::read_from_stream(istream& bin_istream) {
+    progress_function = NULL;
+    checkpoint_interval = 0;
+    interrupt_flag = NULL;
+    profile_filename = "";
+    profile_interval = 0;
+    timing = false;
+
+    char magic[8];
+    bin_istream.read(magic, 8);
+    if (!bin_istream.good() || string(magic, 8).compare(string(CNN_GENOME_BINARY_MAGIC, 8)) != 0) {
+        cerr << "ERROR: invalid binary genome, the magic number did not match" << endl;
+        exit(1);
+    }
+
+    int32_t version, flags;
+    uint64_t payload_size, stored_size;
+    read_binary_value(bin_istream, version);
+    read_binary_value(bin_istream, flags);
+    read_binary_value(bin_istream, payload_size);
+    read_binary_value(bin_istream, stored_size);
+
+    if (version != CNN_GENOME_BINARY_VERSION) {
+        cerr << "ERROR: binary genome has format version " << version << " but this version of EXACT reads version "
+             << CNN_GENOME_BINARY_VERSION << endl;
+        exit(1);
+    }
+
+    // zlib can't compress by more than 1032:1, so a larger payload size can only come from a
+    // malformed genome
+    bool compressed = (flags & CNN_GENOME_BINARY_COMPRESSED) != 0;
+    if (!valid_binary_count(bin_istream, stored_size, sizeof(char))
+        || (compressed ? payload_size > stored_size * 1032 + 64 : payload_size != stored_size)) {
+        cerr << "ERROR: binary genome has an invalid payload size of " << payload_size << " stored in " << stored_size
+             << " bytes" << endl;
+        exit(1);
+    }
+
+    string payload(stored_size, '\0');
+    bin_istream.read(&payload[0], stored_size);
+    if ((uint64_t) bin_istream.gcount() != stored_size) {
+        cerr << "ERROR: binary genome was truncated, expected " << stored_size << " bytes but read "
+             << bin_istream.gcount() << endl;
+        exit(1);
+    }
+
+    if (flags & CNN_GENOME_BINARY_COMPRESSED) {
+#ifdef _HAS_ZLIB_
+        uLongf uncompressed_size = payload_size;
+        string uncompressed(payload_size, '\0');
+        int result =
+            uncompress((Bytef*) &uncompressed[0], &uncompressed_size, (const Bytef*) payload.data(), stored_size);
+        if (result != Z_OK || uncompressed_size != payload_size) {
+            cerr << "ERROR: could not uncompress binary genome" << endl;
+            exit(1);
+        }
+        payload.swap(uncompressed);
+#else
+        cerr << "ERROR: binary genome is compressed but EXACT was not compiled with zlib" << endl;
+        exit(1);
+#endif
+    }
+
+    istringstream payload_iss(payload);
+
+    read_binary_string(payload_iss, version_str);
+    read_binary_value(payload_iss, exact_id);
+    read_binary_value(payload_iss, genome_id);
+
+    initial_mu = read_binary_float(payload_iss);
+    mu = read_binary_float(payload_iss);
+    mu_delta = read_binary_float(payload_iss);
+    initial_learning_rate = read_binary_float(payload_iss);
+    learning_rate = read_binary_float(payload_iss);
+    learning_rate_delta = read_binary_float(payload_iss);
+    initial_weight_decay = read_binary_float(payload_iss);
+    weight_decay = read_binary_float(payload_iss);
+    weight_decay_delta = read_binary_float(payload_iss);
+
+    read_binary_value(payload_iss, batch_size);
+    epsilon = read_binary_float(payload_iss);
+    alpha = read_binary_float(payload_iss);
+    input_dropout_probability = read_binary_float(payload_iss);
+    hidden_dropout_probability = read_binary_float(payload_iss);
+    read_binary_value(payload_iss, velocity_reset);
+
+    read_binary_value(payload_iss, epoch);
+    read_binary_value(payload_iss, max_epochs);
+    read_binary_value(payload_iss, reset_weights);
+    read_binary_value(payload_iss, padding);
+
+    read_binary_value(payload_iss, best_epoch);
+    read_binary_value(payload_iss, number_validation_images);
+    read_binary_value(payload_iss, best_validation_predictions);
+    best_validation_error = read_binary_float(payload_iss);
+    read_binary_value(payload_iss, number_training_images);
+    read_binary_value(payload_iss, training_predictions);
+    training_error = read_binary_float(payload_iss);
+    read_binary_value(payload_iss, number_test_images);
+    read_binary_value(payload_iss, test_predictions);
+    test_error = read_binary_float(payload_iss);
+
+    read_binary_value(payload_iss, generation_id);
+
+    string normal_distribution_str;
+    read_binary_string(payload_iss, normal_distribution_str);
+    istringstream normal_distribution_iss(normal_distribution_str);
+    normal_distribution_iss >> normal_distribution;
+
+    string generator_str;
+    read_binary_string(payload_iss, generator_str);
+    istringstream generator_iss(generator_str);
+    generator_iss >> generator;
+
+    string generated_by_map_str;
+    read_binary_string(payload_iss, generated_by_map_str);
+    istringstream generated_by_map_iss(generated_by_map_str);
+    generated_by_map.clear();
+    read_map(generated_by_map_iss, generated_by_map);
+
+    if (!payload_iss.good() || batch_size <= 0) {
+        cerr << "ERROR: binary genome has an invalid batch size of " << batch_size << endl;
+        exit(1);
+    }
+
+    // the smallest nodes and edges are their float fields and (for edges) the lengths of their pools
+    nodes.clear();
+    int32_t number_nodes;
+    read_binary_value(payload_iss, number_nodes);
+    if (!valid_binary_count(payload_iss, number_nodes, 10 * sizeof(float))) {
+        cerr << "ERROR: binary genome has an invalid number of nodes: " << number_nodes << endl;
+        exit(1);
+    }
+    for (int32_t i = 0; i < number_nodes; i++) {
+        CNN_Node* node = new CNN_Node();
+        node->read_from_stream(payload_iss);
+        nodes.push_back(node);
+    }
+
+    edges.clear();
+    int32_t number_edges;
+    read_binary_value(payload_iss, number_edges);
+    if (!valid_binary_count(payload_iss, number_edges, 4 * sizeof(float) + 2 * sizeof(int32_t))) {
+        cerr << "ERROR: binary genome has an invalid number of edges: " << number_edges << endl;
+        exit(1);
+    }
+    for (int32_t i = 0; i < number_edges; i++) {
+        CNN_Edge* edge = new CNN_Edge();
+        edge->read_from_stream(payload_iss);
+
+        if (!edge->set_nodes(nodes)) {
+            cerr << "ERROR: filter size didn't match when reading genome from binary input!" << endl;
+            cerr << "This should never happen!" << endl;
+            exit(1);
+        }
+        edges.push_back(edge);
+    }
+
+    vector<int> input_innovation_numbers;
+    read_binary_ints(payload_iss, input_innovation_numbers);
+    input_nodes.clear();
+    for (int32_t i = 0; i < (int32_t) input_innovation_numbers.size(); i++) {
+        for (int32_t j = 0; j < (int32_t) nodes.size(); j++) {
+            if (nodes[j]->get_innovation_number() == input_innovation_numbers[i]) {
+                input_nodes.push_back(nodes[j]);
+                break;
+            }
+        }
+    }
+
+    vector<int> softmax_innovation_numbers;
+    read_binary_ints(payload_iss, softmax_innovation_numbers);
+    softmax_nodes.clear();
+    for (int32_t i = 0; i < (int32_t) softmax_innovation_numbers.size(); i++) {
+        for (int32_t j = 0; j < (int32_t) nodes.size(); j++) {
+            if (nodes[j]->get_innovation_number() == softmax_innovation_numbers[i]) {
+                softmax_nodes.push_back(nodes[j]);
+                break;
+            }
+        }
+    }
+
+    backprop_order.clear();
+    int32_t order_size;
+    read_binary_value(payload_iss, order_size);
+    if (!valid_binary_count(payload_iss, order_size, sizeof(int64_t))) {
+        cerr << "ERROR: binary genome has an invalid backpropagation order size: " << order_size << endl;
+        exit(1);
+    }
+    for (int32_t i = 0; i < order_size; i++) {
+        int64_t order;
+        read_binary_value(payload_iss, order);
+        backprop_order.push_back(order);
+    }
+
+    if (!payload_iss.good()) {
+        cerr << "ERROR: binary genome payload was shorter than its fields" << endl;
+        exit(1);
+    }
+
+    visit_nodes();
+}
+
 void CNN_Genome::print_graphviz(ostream& out) const {
     out << "digraph CNN {" << endl;
 
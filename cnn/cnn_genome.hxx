@@ -1,9 +1,18 @@
 #ifndef CNN_GENOME_H
 #define CNN_GENOME_H
 
+#include <atomic>
+using std::atomic;
+
+#include <chrono>
+#include <csignal>
+
 #include <map>
 using std::map;
 
+#include <memory>
+using std::shared_ptr;
+
 #include <random>
 using std::minstd_rand0;
 
@@ -22,18 +31,41 @@ using std::vector;
 // mysql can't handl the max float value for some reason
 #define EXACT_MAX_FLOAT 10000000
 
+/**
+ * Binary genomes start with an 8 byte magic number (whose first byte can't begin a text genome),
+ * the format version, flags and the size of the payload before and after compression. The payload
+ * is the genome's fields with the weights of each node and edge as raw float arrays.
+ */
+#define CNN_GENOME_BINARY_MAGIC      "\x89" "CNNBIN\n"
+#define CNN_GENOME_BINARY_VERSION    1
+#define CNN_GENOME_BINARY_COMPRESSED 1
+
 class CNN_Genome {
    private:
     string version_str;
     int exact_id;
     int genome_id;
 
+    // the genome's id when it is exported by a DatabaseExporter, which is set by the exporter's
+    // thread once the genome's row is inserted, so it is shared in case the genome is deleted first
+    shared_ptr<atomic<int> > export_id;
+
     vector<CNN_Node*> nodes;
     vector<CNN_Edge*> edges;
 
     vector<CNN_Node*> input_nodes;
     vector<CNN_Node*> softmax_nodes;
 
+    // contiguous [batch][class] buffers used by the softmax kernel, kept between batches so they
+    // are only allocated once
+    vector<float*> softmax_node_values;
+    vector<float> softmax_values;
+    vector<float> softmax_gradients;
+    vector<int32_t> expected_classes;
+    vector<int32_t> predicted_classes;
+
+    void gather_softmax_values(int current_batch_size);
+
     NormalDistribution normal_distribution;
     minstd_rand0 generator;
 
@@ -85,6 +117,21 @@ class CNN_Genome {
     string checkpoint_filename;
     string output_filename;
 
+    // a checkpoint is written at the end of the first epoch after checkpoint_interval seconds have
+    // passed since the last one, or after every epoch if it is 0
+    int checkpoint_interval;
+    std::chrono::time_point<std::chrono::steady_clock> last_checkpoint_time;
+
+    // if set, training stops (after writing a checkpoint) at the end of the epoch during which the
+    // flag became non-zero, so a preempted worker can hand the genome back
+    const volatile sig_atomic_t* interrupt_flag;
+
+    // if profile_interval > 0, every profile_interval-th training epoch is timed per node and
+    // edge and appended to profile_filename
+    string profile_filename;
+    int profile_interval;
+    bool timing;
+
     map<string, int> generated_by_map;
 
     int (*progress_function)(float);
@@ -109,6 +156,19 @@ class CNN_Genome {
 
     ~CNN_Genome();
 
+    /**
+     * The columns of the cnn_genome table and this genome's values for them (see CNN_Node).
+     */
+    static string get_database_columns();
+    string get_database_values(int database_exact_id) const;
+
+    /**
+     * Gets the id shared with a DatabaseExporter, which is -1 until the exporter has inserted the
+     * genome (unless the genome already had an id). get_genome_id returns it once it exists.
+     */
+    shared_ptr<atomic<int> > get_export_id();
+    bool has_export_id() const;
+
 #ifdef _MYSQL_
     CNN_Genome(int genome_id);
     void export_to_database(int exact_id);
@@ -122,6 +182,12 @@ class CNN_Genome {
 
     bool equals(CNN_Genome* other) const;
 
+    /**
+     * A hash of the enabled edges which is the same for any two genomes where equals is true, so
+     * populations can be indexed by it and only genomes with the same hash need to be compared.
+     */
+    uint64_t get_structural_hash() const;
+
     void print_results(ostream& out) const;
 
     void print_progress(
@@ -245,12 +311,36 @@ class CNN_Genome {
     void set_name(string _name);
     void set_output_filename(string _output_filename);
     void set_checkpoint_filename(string _checkpoint_filename);
+    void set_checkpoint_interval(int _checkpoint_interval);
+    void set_interrupt_flag(const volatile sig_atomic_t* _interrupt_flag);
 
-    void write(ostream& outfile);
-    void write_to_file(string filename);
+    /**
+     * Writes the genome to the checkpoint file through a synced temporary file and a rename, so a
+     * node going down mid-write leaves the previous checkpoint intact.
+     */
+    void write_checkpoint();
+    void set_profile(string _profile_filename, int _profile_interval);
 
+    void set_timing(bool _timing);
+    void write_profile(int profile_epoch, int number_images);
+
+    /**
+     * The text format, which is kept for debugging.
+     */
+    void write(ostream& outfile);
+    void write_text_to_file(string filename);
     void read(istream& infile);
 
+    /**
+     * The binary format, which is used for files, checkpoints and sending genomes over MPI. If
+     * compress is true and EXACT was compiled with zlib the payload is compressed. Genomes are
+     * read in either format, as a binary genome is recognized by its magic number.
+     */
+    void write_to_stream(ostream& bin_ostream, bool compress = false);
+    void write_to_file(string filename, bool compress = false);
+    void read_from_stream(istream& bin_istream);
+    static bool is_binary(istream& in);
+
     void print_graphviz(ostream& out) const;
 
     void set_generated_by(string type);
@@ -268,7 +358,7 @@ class CNN_Genome {
     );
 };
 
-void write_map(ostream& out, map<string, int>& m);
+void write_map(ostream& out, const map<string, int>& m);
 void read_map(istream& in, map<string, int>& m);
 
 struct sort_genomes_by_validation_error {
@@ -39,6 +39,7 @@ using std::ostringstream;
 
 #include <string>
 using std::string;
+using std::to_string;
 
 #include <vector>
 using std::vector;
@@ -81,6 +82,72 @@ void write_hexfloat(ostream& outfile, float value) {
 #endif
 }
 
+void write_binary_floats(ostream& out, const float* values, int32_t n) {
+    if (n > 0) {
+        out.write((const char*) values, sizeof(float) * n);
+    }
+}
+
+float read_binary_float(istream& in) {
+    float value;
+    read_binary_value(in, value);
+
+    if (std::isnan(value)) {
+        return EXACT_MAX_FLOAT;
+    } else {
+        return value;
+    }
+}
+
+void read_binary_floats(istream& in, float* values, int32_t n) {
+    if (n > 0) {
+        in.read((char*) values, sizeof(float) * n);
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        if (std::isnan(values[i])) {
+            values[i] = EXACT_MAX_FLOAT;
+        }
+    }
+}
+
+void write_binary_ints(ostream& out, const vector<int>& values) {
+    int32_t n = values.size();
+    write_binary_value(out, n);
+    if (n > 0) {
+        out.write((const char*) &values[0], sizeof(int) * n);
+    }
+}
+
+bool valid_binary_count(istream& in, int64_t count, size_t element_size) {
+    if (!in.good() || count < 0) {
+        return false;
+    }
+
+    std::streampos position = in.tellg();
+    if (position < 0) {
+        return true;  // the stream can't be seeked so its size is unknown
+    }
+    in.seekg(0, ios::end);
+    std::streampos end = in.tellg();
+    in.seekg(position);
+
+    return (uint64_t) count * element_size <= (uint64_t) (end - position);
+}
+
+void read_binary_ints(istream& in, vector<int>& values) {
+    int32_t n;
+    read_binary_value(in, n);
+    if (!valid_binary_count(in, n, sizeof(int))) {
+        cerr << "ERROR: binary genome has an invalid number of ints: " << n << endl;
+        exit(1);
+    }
+    values.assign(n, 0);
+    if (n > 0) {
+        in.read((char*) &values[0], sizeof(int) * n);
+    }
+}
+
 CNN_Node::CNN_Node() {
     node_id = -1;
     exact_id = -1;
@@ -94,6 +161,9 @@ CNN_Node::CNN_Node() {
 
     disabled = false;
 
+    timing = false;
+    reset_times();
+
     weight_count = 0;
     inverse_variance = 0;
 
@@ -141,6 +211,9 @@ CNN_Node::CNN_Node(int _innovation_number, float _depth, int _batch_size, int _s
 
     disabled = false;
 
+    timing = false;
+    reset_times();
+
     gamma = 1;
     best_gamma = 1;
     previous_velocity_gamma = 0;
@@ -165,10 +238,49 @@ CNN_Node::CNN_Node(int _innovation_number, float _depth, int _batch_size, int _s
     pool_gradients = new float[total_size]();
 }
 
+string CNN_Node::get_database_columns() {
+    return "exact_id, genome_id, innovation_number, depth, batch_size, size_x, size_y, type, forward_visited, "
+           "reverse_visited, weight_count, needs_initialization, disabled, batch_norm_parameters";
+}
+
+string CNN_Node::get_database_values(int database_exact_id, string database_genome_id) const {
+    ostringstream values;
+
+    values << database_exact_id << ", " << database_genome_id << ", " << innovation_number << ", " << depth << ", "
+           << batch_size << ", " << size_x << ", " << size_y << ", " << type << ", " << forward_visited << ", "
+           << reverse_visited << ", " << weight_count << ", " << needs_initialization << ", " << disabled << ", '";
+
+    write_hexfloat(values, gamma);
+    values << " ";
+    write_hexfloat(values, best_gamma);
+    values << " ";
+    write_hexfloat(values, previous_velocity_gamma);
+    values << " ";
+    write_hexfloat(values, beta);
+    values << " ";
+    write_hexfloat(values, best_beta);
+    values << " ";
+    write_hexfloat(values, previous_velocity_beta);
+    values << " ";
+    write_hexfloat(values, running_mean);
+    values << " ";
+    write_hexfloat(values, best_running_mean);
+    values << " ";
+    write_hexfloat(values, running_variance);
+    values << " ";
+    write_hexfloat(values, best_running_variance);
+    values << "'";
+
+    return values.str();
+}
+
 #ifdef _MYSQL_
 CNN_Node::CNN_Node(int _node_id) {
     node_id = _node_id;
 
+    timing = false;
+    reset_times();
+
     ostringstream query;
     query << "SELECT * FROM cnn_node WHERE id = " << node_id;
 
@@ -251,41 +363,13 @@ void CNN_Node::export_to_database(int _exact_id, int _genome_id) {
     exact_id = _exact_id;
     genome_id = _genome_id;
 
-    // cout << "inserting node with exact_id: " << exact_id << " and genome id: " << genome_id << endl;
-
     if (node_id >= 0) {
-        query << "REPLACE INTO cnn_node SET id = " << node_id << ",";
+        query << "REPLACE INTO cnn_node (id, " << get_database_columns() << ") VALUES (" << node_id << ", "
+              << get_database_values(exact_id, to_string(genome_id)) << ")";
     } else {
-        query << "INSERT INTO cnn_node SET";
-    }
-
-    query << " exact_id = " << exact_id << ", genome_id = " << genome_id
-          << ", innovation_number = " << innovation_number << ", depth = " << depth << ", batch_size = " << batch_size
-          << ", size_x = " << size_x << ", size_y = " << size_y << ", type = " << type
-          << ", forward_visited = " << forward_visited << ", reverse_visited = " << reverse_visited
-          << ", weight_count = " << weight_count << ", needs_initialization = " << needs_initialization
-          << ", disabled = " << disabled << ", batch_norm_parameters = '";
-
-    write_hexfloat(query, gamma);
-    query << " ";
-    write_hexfloat(query, best_gamma);
-    query << " ";
-    write_hexfloat(query, previous_velocity_gamma);
-    query << " ";
-    write_hexfloat(query, beta);
-    query << " ";
-    write_hexfloat(query, best_beta);
-    query << " ";
-    write_hexfloat(query, previous_velocity_beta);
-    query << " ";
-    write_hexfloat(query, running_mean);
-    query << " ";
-    write_hexfloat(query, best_running_mean);
-    query << " ";
-    write_hexfloat(query, running_variance);
-    query << " ";
-    write_hexfloat(query, best_running_variance);
-    query << "'";
+        query << "INSERT INTO cnn_node (" << get_database_columns() << ") VALUES ("
+              << get_database_values(exact_id, to_string(genome_id)) << ")";
+    }
 
     mysql_exact_query(query.str());
 
@@ -658,11 +742,26 @@ void CNN_Node::print(ostream& out) {
     }
 }
 
+void CNN_Node::set_timing(bool _timing) {
+    timing = _timing;
+}
+
 void CNN_Node::reset_times() {
     input_fired_time = 0.0;
     output_fired_time = 0.0;
 }
 
+float CNN_Node::get_operations_estimate() const {
+    float if_cost = 15.0;
+    float multiply_cost = 7.0;
+    float random_cost = 100.0;
+
+    // propagate forward has 1 RELU and 1 DropOut per value in node
+    // RELU is 2 ifs, 1 multiply
+    // dropout is 1 if, 1 random
+    return size_x * size_y * (3.0 * if_cost + multiply_cost + random_cost);
+}
+
 void CNN_Node::accumulate_times(float& total_input_time, float& total_output_time) {
     total_input_time += input_fired_time;
     total_output_time += output_fired_time;
@@ -1122,14 +1221,9 @@ void CNN_Node::set_values(
 
     // images.size() may be less than batch size, in the case when the total number of images is not divisible by the
     // batch_size
-    int current = 0;
+    int image_size = size_y * size_x;
     for (int32_t batch_number = 0; batch_number < batch.size(); batch_number++) {
-        for (int32_t y = 0; y < size_y; y++) {
-            for (int32_t x = 0; x < size_x; x++) {
-                values_out[current] = images.get_pixel(batch[batch_number], channel, y, x);
-                current++;
-            }
-        }
+        images.get_subimage(batch[batch_number], channel, &values_out[batch_number * image_size]);
     }
 
     if (input_dropout_probability > 0) {
@@ -1144,8 +1238,13 @@ void CNN_Node::input_fired(
     bool training, bool accumulate_test_statistics, float epsilon, float alpha, bool perform_dropout,
     float hidden_dropout_probability, minstd_rand0& generator
 ) {
+#ifndef CNN_NO_TIMERS
     using namespace std::chrono;
-    high_resolution_clock::time_point input_fired_start_time = high_resolution_clock::now();
+    high_resolution_clock::time_point input_fired_start_time;
+    if (timing) {
+        input_fired_start_time = high_resolution_clock::now();
+    }
+#endif
 
     inputs_fired++;
 
@@ -1178,15 +1277,24 @@ void CNN_Node::input_fired(
         throw runtime_error("Error in input fired, inputs_fired > total_inputs");
     }
 
-    high_resolution_clock::time_point input_fired_end_time = high_resolution_clock::now();
-    duration<float, std::milli> time_span = input_fired_end_time - input_fired_start_time;
+#ifndef CNN_NO_TIMERS
+    if (timing) {
+        high_resolution_clock::time_point input_fired_end_time = high_resolution_clock::now();
+        duration<float, std::milli> time_span = input_fired_end_time - input_fired_start_time;
 
-    input_fired_time += time_span.count() / 1000.0;
+        input_fired_time += time_span.count() / 1000.0;
+    }
+#endif
 }
 
 void CNN_Node::output_fired(bool training, float mu, float learning_rate, float epsilon) {
+#ifndef CNN_NO_TIMERS
     using namespace std::chrono;
-    high_resolution_clock::time_point output_fired_start_time = high_resolution_clock::now();
+    high_resolution_clock::time_point output_fired_start_time;
+    if (timing) {
+        output_fired_start_time = high_resolution_clock::now();
+    }
+#endif
 
     outputs_fired++;
 
@@ -1211,10 +1319,14 @@ void CNN_Node::output_fired(bool training, float mu, float learning_rate, float
         throw runtime_error("Error in output fired, outputs_fired > total_outputs");
     }
 
-    high_resolution_clock::time_point output_fired_end_time = high_resolution_clock::now();
-    duration<float, std::milli> time_span = output_fired_end_time - output_fired_start_time;
+#ifndef CNN_NO_TIMERS
+    if (timing) {
+        high_resolution_clock::time_point output_fired_end_time = high_resolution_clock::now();
+        duration<float, std::milli> time_span = output_fired_end_time - output_fired_start_time;
 
-    output_fired_time += time_span.count() / 1000.0;
+        output_fired_time += time_span.count() / 1000.0;
+    }
+#endif
 }
 
 bool CNN_Node::has_nan() const {
@@ -1356,8 +1468,6 @@ std::istream& operator>>(std::istream& is, CNN_Node* node) {
     is >> node->needs_initialization;
     is >> node->disabled;
 
-    node->total_size = node->batch_size * node->size_y * node->size_x;
-
     node->gamma = read_hexfloat(is);
     node->best_gamma = read_hexfloat(is);
     node->previous_velocity_gamma = read_hexfloat(is);
@@ -1383,24 +1493,94 @@ std::istream& operator>>(std::istream& is, CNN_Node* node) {
          << " " << node->best_running_variance << endl;
     */
 
-    node->total_inputs = 0;
-    node->inputs_fired = 0;
+    node->initialize_after_read();
+
+    return is;
+}
+
+/**
+ * Sets up the counters and allocates the value buffers of a node whose fields were just read.
+ */
+void CNN_Node::initialize_after_read() {
+    total_size = batch_size * size_y * size_x;
+
+    total_inputs = 0;
+    inputs_fired = 0;
+
+    total_outputs = 0;
+    outputs_fired = 0;
 
-    node->total_outputs = 0;
-    node->outputs_fired = 0;
+    forward_visited = false;
+    reverse_visited = false;
 
-    node->forward_visited = false;
-    node->reverse_visited = false;
+    values_in = new float[total_size]();
+    errors_in = new float[total_size]();
 
-    node->values_in = new float[node->total_size]();
-    node->errors_in = new float[node->total_size]();
+    values_out = new float[total_size]();
+    errors_out = new float[total_size]();
+    relu_gradients = new float[total_size]();
+    pool_gradients = new float[total_size]();
+}
 
-    node->values_out = new float[node->total_size]();
-    node->errors_out = new float[node->total_size]();
-    node->relu_gradients = new float[node->total_size]();
-    node->pool_gradients = new float[node->total_size]();
+void CNN_Node::write_to_stream(ostream& bin_ostream) const {
+    write_binary_value(bin_ostream, node_id);
+    write_binary_value(bin_ostream, exact_id);
+    write_binary_value(bin_ostream, genome_id);
+    write_binary_value(bin_ostream, innovation_number);
+    write_binary_value(bin_ostream, depth);
+    write_binary_value(bin_ostream, batch_size);
+    write_binary_value(bin_ostream, size_x);
+    write_binary_value(bin_ostream, size_y);
+    write_binary_value(bin_ostream, type);
+    write_binary_value(bin_ostream, weight_count);
+    write_binary_value(bin_ostream, needs_initialization);
+    write_binary_value(bin_ostream, disabled);
+
+    write_binary_value(bin_ostream, gamma);
+    write_binary_value(bin_ostream, best_gamma);
+    write_binary_value(bin_ostream, previous_velocity_gamma);
+    write_binary_value(bin_ostream, beta);
+    write_binary_value(bin_ostream, best_beta);
+    write_binary_value(bin_ostream, previous_velocity_beta);
+    write_binary_value(bin_ostream, running_mean);
+    write_binary_value(bin_ostream, best_running_mean);
+    write_binary_value(bin_ostream, running_variance);
+    write_binary_value(bin_ostream, best_running_variance);
+}
+
+void CNN_Node::read_from_stream(istream& bin_istream) {
+    read_binary_value(bin_istream, node_id);
+    read_binary_value(bin_istream, exact_id);
+    read_binary_value(bin_istream, genome_id);
+    read_binary_value(bin_istream, innovation_number);
+    read_binary_value(bin_istream, depth);
+    read_binary_value(bin_istream, batch_size);
+    read_binary_value(bin_istream, size_x);
+    read_binary_value(bin_istream, size_y);
+    read_binary_value(bin_istream, type);
+    read_binary_value(bin_istream, weight_count);
+    read_binary_value(bin_istream, needs_initialization);
+    read_binary_value(bin_istream, disabled);
+
+    if (!bin_istream.good() || batch_size <= 0 || size_y <= 0 || size_x <= 0
+        || (int64_t) batch_size * size_y * size_x > numeric_limits<int32_t>::max()) {
+        cerr << "ERROR: binary genome has node " << innovation_number << " with an invalid size of " << batch_size
+             << " x " << size_y << " x " << size_x << endl;
+        exit(1);
+    }
 
-    return is;
+    gamma = read_binary_float(bin_istream);
+    best_gamma = read_binary_float(bin_istream);
+    previous_velocity_gamma = read_binary_float(bin_istream);
+    beta = read_binary_float(bin_istream);
+    best_beta = read_binary_float(bin_istream);
+    previous_velocity_beta = read_binary_float(bin_istream);
+    running_mean = read_binary_float(bin_istream);
+    best_running_mean = read_binary_float(bin_istream);
+    running_variance = read_binary_float(bin_istream);
+    best_running_variance = read_binary_float(bin_istream);
+
+    initialize_after_read();
 }
 
 bool CNN_Node::is_identical(const CNN_Node* other, bool testing_checkpoint) {
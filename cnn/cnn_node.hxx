@@ -102,6 +102,11 @@ class CNN_Node {
     float input_fired_time;
     float output_fired_time;
 
+    // only time the node when profiling, so the clock is not read on every firing
+    bool timing;
+
+    void initialize_after_read();
+
    public:
     CNN_Node();
     ~CNN_Node();
@@ -110,6 +115,13 @@ class CNN_Node {
 
     CNN_Node* copy() const;
 
+    /**
+     * The columns of the cnn_node table and this node's values for them, so nodes can be inserted
+     * one at a time or in multi-row inserts. The genome id is text so it can be a SQL variable.
+     */
+    static string get_database_columns();
+    string get_database_values(int database_exact_id, string database_genome_id) const;
+
 #ifdef _MYSQL_
     CNN_Node(int node_id);
     void export_to_database(int exact_id, int genome_id);
@@ -174,9 +186,12 @@ class CNN_Node {
 
     void print(ostream& out);
 
+    void set_timing(bool _timing);
     void reset_times();
     void accumulate_times(float& total_input_time, float& total_output_time);
 
+    float get_operations_estimate() const;
+
     void reset();
     void save_best_weights();
     void set_weights_to_best();
@@ -229,11 +244,40 @@ class CNN_Node {
 
     friend ostream& operator<<(ostream& os, const CNN_Node* node);
     friend istream& operator>>(istream& is, CNN_Node* node);
+
+    void write_to_stream(ostream& bin_ostream) const;
+    void read_from_stream(istream& bin_istream);
 };
 
 float read_hexfloat(istream& infile);
 void write_hexfloat(ostream& outfile, float value);
 
+/**
+ * Raw reading and writing for the binary genome format. Floats read this way have NaNs replaced
+ * by EXACT_MAX_FLOAT, the same as read_hexfloat.
+ */
+template <class T>
+void write_binary_value(ostream& out, const T& value) {
+    out.write((const char*) &value, sizeof(T));
+}
+
+template <class T>
+void read_binary_value(istream& in, T& value) {
+    in.read((char*) &value, sizeof(T));
+}
+
+float read_binary_float(istream& in);
+void write_binary_floats(ostream& out, const float* values, int32_t n);
+void read_binary_floats(istream& in, float* values, int32_t n);
+void write_binary_ints(ostream& out, const vector<int>& values);
+void read_binary_ints(istream& in, vector<int>& values);
+
+/**
+ * Checks a count read from a binary genome is not negative and that the rest of the stream could
+ * hold that many values of element_size bytes, so nothing is allocated for a malformed count.
+ */
+bool valid_binary_count(istream& in, int64_t count, size_t element_size);
+
 struct sort_CNN_Nodes_by_depth {
     bool operator()(const CNN_Node* n1, const CNN_Node* n2) {
         if (n1->get_depth() < n2->get_depth()) {
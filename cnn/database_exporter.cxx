@@ -0,0 +1,348 @@
+#include <atomic>
+using std::atomic;
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
+#include <fstream>
+using std::ios;
+using std::ofstream;
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+
+#include <memory>
+using std::shared_ptr;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <sstream>
+using std::ostringstream;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "cnn_edge.hxx"
+#include "cnn_genome.hxx"
+#include "cnn_node.hxx"
+#include "database_exporter.hxx"
+
+#ifdef _MYSQL_
+#include "common/db_conn.hxx"
+#endif
+
+DatabaseConnection::~DatabaseConnection() {
+}
+
+void DatabaseConnection::begin_thread() {
+}
+
+void DatabaseConnection::end_thread() {
+}
+
+#ifdef _MYSQL_
+MySQLDatabaseConnection::MySQLDatabaseConnection() {
+    connection = create_exact_database_connection();
+}
+
+MySQLDatabaseConnection::~MySQLDatabaseConnection() {
+    mysql_close(connection);
+}
+
+void MySQLDatabaseConnection::begin_thread() {
+    mysql_thread_init();
+}
+
+void MySQLDatabaseConnection::end_thread() {
+    mysql_thread_end();
+}
+
+void MySQLDatabaseConnection::query(const string& query) {
+    mysql_exact_query_on(connection, query);
+}
+
+int MySQLDatabaseConnection::last_insert_id() {
+    return mysql_insert_id(connection);
+}
+#endif
+
+FileDatabaseConnection::FileDatabaseConnection(string filename, int first_id) : next_id(first_id), current_id(-1) {
+    outfile.open(filename.c_str(), ios::out | ios::app);
+    if (!outfile.is_open()) {
+        cerr << "ERROR: could not open database statement file '" << filename << "'" << endl;
+        exit(1);
+    }
+}
+
+FileDatabaseConnection::~FileDatabaseConnection() {
+    outfile.close();
+}
+
+void FileDatabaseConnection::query(const string& query) {
+    outfile << query << ";" << endl;
+
+    if (query.compare(0, 7, "INSERT ") == 0) {
+        current_id = next_id;
+        next_id++;
+    }
+}
+
+int FileDatabaseConnection::last_insert_id() {
+    return current_id;
+}
+
+DatabaseExportJob::~DatabaseExportJob() {
+}
+
+/**
+ * Runs the inserts of rows (each of which is "(value, ...)") into the table, with as many rows in
+ * each insert as the row and statement size limits allow.
+ */
+static void insert_rows(
+    DatabaseConnection* connection, string table, string columns, const vector<string>& rows, int32_t rows_per_insert
+) {
+    string prefix = "INSERT INTO " + table + " (" + columns + ") VALUES ";
+
+    string query;
+    int32_t query_rows = 0;
+    for (int32_t i = 0; i < (int32_t) rows.size(); i++) {
+        if (query_rows > 0
+            && (query_rows >= rows_per_insert
+                || query.size() + rows[i].size() + 2 > DATABASE_EXPORT_MAX_STATEMENT_SIZE)) {
+            connection->query(query);
+            query_rows = 0;
+        }
+
+        if (query_rows == 0) {
+            query = prefix;
+        } else {
+            query += ", ";
+        }
+        query += rows[i];
+        query_rows++;
+    }
+
+    if (query_rows > 0) {
+        connection->query(query);
+    }
+}
+
+class GenomeExportJob : public DatabaseExportJob {
+   private:
+    shared_ptr<atomic<int> > genome_id;
+    int32_t rows_per_insert;
+
+    string genome_values;
+    vector<string> node_rows;
+    vector<string> edge_rows;
+
+   public:
+    GenomeExportJob(CNN_Genome* genome, int exact_id, int32_t _rows_per_insert) : rows_per_insert(_rows_per_insert) {
+        genome_id = genome->get_export_id();
+        genome_values = genome->get_database_values(exact_id);
+
+        // the genome's id may not be known until the genome is inserted, so the nodes and edges use
+        // a variable which is set to it
+        vector<CNN_Node*> nodes = genome->get_nodes();
+        for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+            node_rows.push_back("(" + nodes[i]->get_database_values(exact_id, "@genome_id") + ")");
+        }
+
+        vector<CNN_Edge*> edges = genome->get_edges();
+        for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+            edge_rows.push_back("(" + edges[i]->get_database_values(exact_id, "@genome_id") + ")");
+        }
+    }
+
+    void run(DatabaseConnection* connection) {
+        connection->query("START TRANSACTION");
+
+        // an earlier job will have set the id if the genome was exported before
+        int id = genome_id->load();
+        if (id >= 0) {
+            connection->query(
+                "REPLACE INTO cnn_genome (id, " + CNN_Genome::get_database_columns() + ") VALUES (" + to_string(id)
+                + ", " + genome_values + ")"
+            );
+            connection->query("DELETE FROM cnn_node WHERE genome_id = " + to_string(id));
+            connection->query("DELETE FROM cnn_edge WHERE genome_id = " + to_string(id));
+        } else {
+            connection->query(
+                "INSERT INTO cnn_genome (" + CNN_Genome::get_database_columns() + ") VALUES (" + genome_values + ")"
+            );
+            id = connection->last_insert_id();
+        }
+        connection->query("SET @genome_id = " + to_string(id));
+
+        insert_rows(connection, "cnn_node", CNN_Node::get_database_columns(), node_rows, rows_per_insert);
+        insert_rows(connection, "cnn_edge", CNN_Edge::get_database_columns(), edge_rows, rows_per_insert);
+
+        connection->query("COMMIT");
+
+        genome_id->store(id);
+    }
+};
+
+class SearchUpdateJob : public DatabaseExportJob {
+   private:
+    int exact_id;
+    string fields;
+    shared_ptr<atomic<int> > best_predictions_genome_id;
+    vector<shared_ptr<atomic<int> > > kept_genome_ids;
+    bool delete_other_genomes;
+
+   public:
+    SearchUpdateJob(
+        int _exact_id, string _fields, shared_ptr<atomic<int> > _best_predictions_genome_id,
+        const vector<shared_ptr<atomic<int> > >& _kept_genome_ids, bool _delete_other_genomes
+    )
+        : exact_id(_exact_id),
+          fields(_fields),
+          best_predictions_genome_id(_best_predictions_genome_id),
+          kept_genome_ids(_kept_genome_ids),
+          delete_other_genomes(_delete_other_genomes) {
+    }
+
+    void run(DatabaseConnection* connection) {
+        int best_id = -1;
+        if (best_predictions_genome_id != NULL) {
+            best_id = best_predictions_genome_id->load();
+        }
+
+        ostringstream query;
+        query << "UPDATE exact_search SET " << fields << ", best_predictions_genome_id = " << best_id
+              << " WHERE id = " << exact_id;
+        connection->query(query.str());
+
+        if (!delete_other_genomes) {
+            return;
+        }
+
+        ostringstream delete_query;
+        delete_query << "DELETE FROM cnn_genome WHERE exact_id = " << exact_id << " AND (";
+        for (int32_t i = 0; i < (int32_t) kept_genome_ids.size(); i++) {
+            if (i != 0) {
+                delete_query << " AND ";
+            }
+            delete_query << "id != " << kept_genome_ids[i]->load();
+        }
+        if (best_id > 0) {
+            delete_query << " AND id != " << best_id;
+        }
+        delete_query << ")";
+        connection->query(delete_query.str());
+
+        connection->query(
+            "DELETE FROM cnn_node WHERE exact_id = " + to_string(exact_id)
+            + " AND genome_id > 0 AND NOT EXISTS(SELECT id FROM cnn_genome WHERE cnn_genome.id = cnn_node.genome_id)"
+        );
+        connection->query(
+            "DELETE FROM cnn_edge WHERE exact_id = " + to_string(exact_id)
+            + " AND genome_id > 0 AND NOT EXISTS(SELECT id FROM cnn_genome WHERE cnn_genome.id = cnn_edge.genome_id)"
+        );
+    }
+};
+
+DatabaseExporter::DatabaseExporter(DatabaseConnection* _connection, int32_t _rows_per_insert)
+    : connection(_connection), rows_per_insert(_rows_per_insert), running_job(false), stopping(false) {
+    exporter_thread = thread(&DatabaseExporter::run_jobs, this);
+}
+
+DatabaseExporter::~DatabaseExporter() {
+    {
+        lock_guard<mutex> lock(jobs_mutex);
+        stopping = true;
+    }
+    jobs_changed.notify_all();
+    exporter_thread.join();
+
+    delete connection;
+}
+
+void DatabaseExporter::run_jobs() {
+    connection->begin_thread();
+
+    unique_lock<mutex> lock(jobs_mutex);
+    while (true) {
+        while (jobs.empty() && !stopping) {
+            jobs_changed.wait(lock);
+        }
+
+        if (jobs.empty()) {
+            break;
+        }
+
+        shared_ptr<DatabaseExportJob> job = jobs.front();
+        jobs.pop_front();
+        job_search_ids.pop_front();
+        running_job = true;
+
+        lock.unlock();
+        job->run(connection);
+        lock.lock();
+
+        running_job = false;
+        jobs_changed.notify_all();
+    }
+
+    lock.unlock();
+    connection->end_thread();
+}
+
+void DatabaseExporter::export_genome(CNN_Genome* genome, int exact_id) {
+    shared_ptr<DatabaseExportJob> job(new GenomeExportJob(genome, exact_id, rows_per_insert));
+
+    {
+        lock_guard<mutex> lock(jobs_mutex);
+        jobs.push_back(job);
+        job_search_ids.push_back(-1);
+    }
+    jobs_changed.notify_all();
+}
+
+void DatabaseExporter::update_search(
+    int exact_id, string fields, shared_ptr<atomic<int> > best_predictions_genome_id,
+    const vector<shared_ptr<atomic<int> > >& kept_genome_ids, bool delete_other_genomes
+) {
+    shared_ptr<DatabaseExportJob> job(
+        new SearchUpdateJob(exact_id, fields, best_predictions_genome_id, kept_genome_ids, delete_other_genomes)
+    );
+
+    {
+        lock_guard<mutex> lock(jobs_mutex);
+
+        // this update sets everything an earlier queued update of the search would, and genomes
+        // queued after the earlier update still run before this one
+        for (int32_t i = (int32_t) jobs.size() - 1; i >= 0; i--) {
+            if (job_search_ids[i] == exact_id) {
+                jobs.erase(jobs.begin() + i);
+                job_search_ids.erase(job_search_ids.begin() + i);
+            }
+        }
+
+        jobs.push_back(job);
+        job_search_ids.push_back(exact_id);
+    }
+    jobs_changed.notify_all();
+}
+
+void DatabaseExporter::flush() {
+    unique_lock<mutex> lock(jobs_mutex);
+    while (!jobs.empty() || running_job) {
+        jobs_changed.wait(lock);
+    }
+}
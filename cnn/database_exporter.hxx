@@ -0,0 +1,162 @@
+#ifndef EXACT_DATABASE_EXPORTER_HXX
+#define EXACT_DATABASE_EXPORTER_HXX
+
+#include <atomic>
+using std::atomic;
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
+#include <fstream>
+using std::ofstream;
+
+#include <memory>
+using std::shared_ptr;
+
+#include <mutex>
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#ifdef _MYSQL_
+#include "common/db_conn.hxx"
+#endif
+
+#include "cnn_genome.hxx"
+
+// multi-row inserts are split so statements stay well under MySQL's max_allowed_packet
+#define DATABASE_EXPORT_MAX_STATEMENT_SIZE (1 << 20)
+
+/**
+ * Where a DatabaseExporter's statements are run. Each exporter has its own connection, as a
+ * connection can only be used by one thread at a time.
+ */
+class DatabaseConnection {
+   public:
+    virtual ~DatabaseConnection();
+
+    /**
+     * Called by the thread which will use the connection before and after using it.
+     */
+    virtual void begin_thread();
+    virtual void end_thread();
+
+    virtual void query(const string& query) = 0;
+    virtual int last_insert_id() = 0;
+};
+
+#ifdef _MYSQL_
+class MySQLDatabaseConnection : public DatabaseConnection {
+   private:
+    MYSQL* connection;
+
+   public:
+    MySQLDatabaseConnection();
+    ~MySQLDatabaseConnection();
+
+    void begin_thread();
+    void end_thread();
+
+    void query(const string& query);
+    int last_insert_id();
+};
+#endif
+
+/**
+ * Appends each statement to a file and returns increasing ids for inserts, so the exporter can be
+ * tested (and its statements checked) without a database.
+ */
+class FileDatabaseConnection : public DatabaseConnection {
+   private:
+    ofstream outfile;
+    int next_id;
+    int current_id;
+
+   public:
+    FileDatabaseConnection(string filename, int first_id);
+    ~FileDatabaseConnection();
+
+    void query(const string& query);
+    int last_insert_id();
+};
+
+/**
+ * A snapshot of database work taken when it was queued, so the genomes and search it came from
+ * can change or be deleted before it is run.
+ */
+class DatabaseExportJob {
+   public:
+    virtual ~DatabaseExportJob();
+    virtual void run(DatabaseConnection* connection) = 0;
+};
+
+/**
+ * Exports genomes and updates EXACT searches on a background thread, so the search never waits on
+ * the database. Each genome is exported in a transaction with its nodes and edges in multi-row
+ * inserts, and an update of a search replaces any update of it which has not been run yet.
+ *
+ * Jobs are run in the order they were queued, so the ids of genomes queued before a search update
+ * are known when the update is run.
+ */
+class DatabaseExporter {
+   private:
+    DatabaseConnection* connection;
+    int32_t rows_per_insert;
+
+    deque<shared_ptr<DatabaseExportJob> > jobs;
+    // the search id of each queued update (or -1), so earlier updates of a search can be replaced
+    deque<int> job_search_ids;
+    bool running_job;
+    bool stopping;
+
+    mutex jobs_mutex;
+    condition_variable jobs_changed;
+    thread exporter_thread;
+
+    void run_jobs();
+
+   public:
+    /**
+     * The exporter owns the connection and deletes it when it is deleted. Nodes and edges are
+     * inserted up to rows_per_insert at a time.
+     */
+    DatabaseExporter(DatabaseConnection* _connection, int32_t _rows_per_insert);
+
+    /**
+     * Runs all the queued jobs before returning.
+     */
+    ~DatabaseExporter();
+
+    /**
+     * Inserts the genome, or replaces it if it has already been exported. The genome's export id is
+     * set once it has been inserted.
+     */
+    void export_genome(CNN_Genome* genome, int exact_id);
+
+    /**
+     * Sets the fields of the search's row (given as "field = value, ..."), and the id of its best
+     * predictions genome. If the population is full, genomes of the search which are not one of
+     * the kept genomes are deleted along with their nodes and edges.
+     */
+    void update_search(
+        int exact_id, string fields, shared_ptr<atomic<int> > best_predictions_genome_id,
+        const vector<shared_ptr<atomic<int> > >& kept_genome_ids, bool delete_other_genomes
+    );
+
+    /**
+     * Waits until all the queued jobs have been run.
+     */
+    void flush();
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include <algorithm>
+using std::lower_bound;
 using std::sort;
 using std::upper_bound;
 
@@ -42,6 +43,7 @@ using std::vector;
 
 #ifdef _MYSQL_
 #include "common/db_conn.hxx"
+#include "database_exporter.hxx"
 #endif
 
 #include "stdlib.h"
@@ -74,6 +76,8 @@ bool EXACT::exists_in_database(int exact_id) {
 }
 
 EXACT::EXACT(int exact_id) {
+    database_exporter = NULL;
+
     ostringstream query;
 
     query << "SELECT * FROM exact_search WHERE id = " << exact_id;
@@ -238,9 +242,7 @@ EXACT::EXACT(int exact_id) {
             // cout << "got genome with id: " << genome_id << endl;
 
             CNN_Genome* genome = new CNN_Genome(genome_id);
-            genomes.insert(
-                upper_bound(genomes.begin(), genomes.end(), genome, sort_genomes_by_validation_error()), genome
-            );
+            add_to_population(genome);
         }
 
         cout << "got " << genomes.size() << " genomes." << endl;
@@ -261,6 +263,18 @@ EXACT::EXACT(int exact_id) {
 }
 
 void EXACT::export_to_database() {
+    if (id >= 0 && database_exporter != NULL) {
+        // the search's settings don't change once it has been inserted, so only its progress and
+        // the genomes which have not been exported yet need to be
+        for (uint32_t i = 0; i < genomes.size(); i++) {
+            if (!genomes[i]->has_export_id() && genomes[i]->get_genome_id() < 0) {
+                database_exporter->export_genome(genomes[i], id);
+            }
+        }
+        update_database();
+        return;
+    }
+
     ostringstream query;
     if (id >= 0) {
         query << "REPLACE INTO exact_search SET id = " << id << ",";
@@ -384,40 +398,7 @@ void EXACT::export_to_database() {
     }
 
     if ((int32_t) genomes.size() == population_size) {
-        ostringstream delete_query;
-        delete_query << "DELETE FROM cnn_genome WHERE exact_id = " << id << " AND ";
-        delete_query << "(";
-
-        for (uint32_t i = 0; i < genomes.size(); i++) {
-            delete_query << "id != " << genomes[i]->get_genome_id();
-
-            if (i < (genomes.size() - 1)) {
-                delete_query << " AND ";
-            }
-        }
-
-        if (best_predictions_genome_id > 0) {
-            delete_query << " AND id != " << best_predictions_genome_id;
-        }
-
-        delete_query << ")";
-
-        cout << delete_query.str() << endl;
-        mysql_exact_query(delete_query.str());
-
-        ostringstream delete_node_query;
-        delete_node_query
-            << "DELETE FROM cnn_node WHERE exact_id = " << id
-            << " AND genome_id > 0 AND NOT EXISTS(SELECT id FROM cnn_genome WHERE cnn_genome.id = cnn_node.genome_id)";
-        cout << delete_node_query.str() << endl;
-        mysql_exact_query(delete_node_query.str());
-
-        ostringstream delete_edge_query;
-        delete_edge_query
-            << "DELETE FROM cnn_edge WHERE exact_id = " << id
-            << " AND genome_id > 0 AND NOT EXISTS(SELECT id FROM cnn_genome WHERE cnn_genome.id = cnn_edge.genome_id)";
-        cout << delete_edge_query.str() << endl;
-        mysql_exact_query(delete_edge_query.str());
+        delete_other_genomes_from_database();
     }
 }
 
@@ -428,27 +409,29 @@ void EXACT::update_database() {
         return;
     }
 
-    ostringstream query;
-    query << "UPDATE exact_search SET";
-
-    query << " genomes_generated = " << genomes_generated << ", inserted_genomes = " << inserted_genomes
-
-          << ", node_innovation_count = " << node_innovation_count
-          << ", edge_innovation_count = " << edge_innovation_count
-          << ", best_predictions_genome_id = " << best_predictions_genome_id << ", inserted_from_map = '";
+    if (database_exporter != NULL) {
+        // the genomes' ids are resolved when the update is run, as they may not have been
+        // inserted yet
+        vector<shared_ptr<atomic<int> > > kept_genome_ids;
+        for (uint32_t i = 0; i < genomes.size(); i++) {
+            kept_genome_ids.push_back(genomes[i]->get_export_id());
+        }
 
-    write_map(query, inserted_from_map);
+        shared_ptr<atomic<int> > best_genome_id;
+        if (best_predictions_genome != NULL) {
+            best_genome_id = best_predictions_genome->get_export_id();
+        }
 
-    query << "'"
-          << ", generated_from_map = '";
-    write_map(query, generated_from_map);
+        database_exporter->update_search(
+            id, get_database_update_fields(), best_genome_id, kept_genome_ids,
+            (int32_t) genomes.size() == population_size
+        );
+        return;
+    }
 
-    query << "'"
-          << ", generator = '" << generator << "'"
-          << ", normal_distribution = '" << normal_distribution << "'"
-          << ", rng_long = '" << rng_long << "'"
-          << ", rng_float = '" << rng_float << "'"
-          << " WHERE id = " << id;
+    ostringstream query;
+    query << "UPDATE exact_search SET " << get_database_update_fields()
+          << ", best_predictions_genome_id = " << best_predictions_genome_id << " WHERE id = " << id;
 
     cout << query.str() << endl;
     mysql_exact_query(query.str());
@@ -456,41 +439,79 @@ void EXACT::update_database() {
     // genomes are inserted separately
 
     if ((int32_t) genomes.size() == population_size) {
-        ostringstream delete_query;
-        delete_query << "DELETE FROM cnn_genome WHERE exact_id = " << id << " AND ";
-        delete_query << "(";
+        delete_other_genomes_from_database();
+    }
+}
 
-        for (uint32_t i = 0; i < genomes.size(); i++) {
-            delete_query << "id != " << genomes[i]->get_genome_id();
+void EXACT::set_database_exporter(DatabaseExporter* _database_exporter) {
+    database_exporter = _database_exporter;
+}
 
-            if (i < (genomes.size() - 1)) {
-                delete_query << " AND ";
-            }
-        }
+/**
+ * The fields of the search's row which change as it progresses, other than its best predictions
+ * genome.
+ */
+string EXACT::get_database_update_fields() const {
+    ostringstream fields;
 
-        if (best_predictions_genome_id > 0) {
-            delete_query << " AND id != " << best_predictions_genome_id;
-        }
+    fields << "genomes_generated = " << genomes_generated << ", inserted_genomes = " << inserted_genomes
+           << ", node_innovation_count = " << node_innovation_count
+           << ", edge_innovation_count = " << edge_innovation_count << ", inserted_from_map = '";
+
+    write_map(fields, inserted_from_map);
 
-        delete_query << ")";
+    fields << "'"
+           << ", generated_from_map = '";
+    write_map(fields, generated_from_map);
 
-        cout << delete_query.str() << endl;
-        mysql_exact_query(delete_query.str());
+    fields << "'"
+           << ", generator = '" << generator << "'"
+           << ", normal_distribution = '" << normal_distribution << "'"
+           << ", rng_long = '" << rng_long << "'"
+           << ", rng_float = '" << rng_float << "'";
 
-        ostringstream delete_node_query;
-        delete_node_query
-            << "DELETE FROM cnn_node WHERE exact_id = " << id
-            << " AND genome_id > 0 AND NOT EXISTS(SELECT id FROM cnn_genome WHERE cnn_genome.id = cnn_node.genome_id)";
-        cout << delete_node_query.str() << endl;
-        mysql_exact_query(delete_node_query.str());
+    return fields.str();
+}
+
+/**
+ * Deletes the search's genomes which are no longer in the population (or its best predictions
+ * genome), along with their nodes and edges.
+ */
+void EXACT::delete_other_genomes_from_database() {
+    ostringstream delete_query;
+    delete_query << "DELETE FROM cnn_genome WHERE exact_id = " << id << " AND ";
+    delete_query << "(";
+
+    for (uint32_t i = 0; i < genomes.size(); i++) {
+        delete_query << "id != " << genomes[i]->get_genome_id();
+
+        if (i < (genomes.size() - 1)) {
+            delete_query << " AND ";
+        }
+    }
 
-        ostringstream delete_edge_query;
-        delete_edge_query
-            << "DELETE FROM cnn_edge WHERE exact_id = " << id
-            << " AND genome_id > 0 AND NOT EXISTS(SELECT id FROM cnn_genome WHERE cnn_genome.id = cnn_edge.genome_id)";
-        cout << delete_edge_query.str() << endl;
-        mysql_exact_query(delete_edge_query.str());
+    if (best_predictions_genome_id > 0) {
+        delete_query << " AND id != " << best_predictions_genome_id;
     }
+
+    delete_query << ")";
+
+    cout << delete_query.str() << endl;
+    mysql_exact_query(delete_query.str());
+
+    ostringstream delete_node_query;
+    delete_node_query
+        << "DELETE FROM cnn_node WHERE exact_id = " << id
+        << " AND genome_id > 0 AND NOT EXISTS(SELECT id FROM cnn_genome WHERE cnn_genome.id = cnn_node.genome_id)";
+    cout << delete_node_query.str() << endl;
+    mysql_exact_query(delete_node_query.str());
+
+    ostringstream delete_edge_query;
+    delete_edge_query
+        << "DELETE FROM cnn_edge WHERE exact_id = " << id
+        << " AND genome_id > 0 AND NOT EXISTS(SELECT id FROM cnn_genome WHERE cnn_genome.id = cnn_edge.genome_id)";
+    cout << delete_edge_query.str() << endl;
+    mysql_exact_query(delete_edge_query.str());
 }
 
 #endif
@@ -529,6 +550,10 @@ EXACT::EXACT(
     best_predictions_genome_id = -1;
     best_predictions_genome = NULL;
 
+#ifdef _MYSQL_
+    database_exporter = NULL;
+#endif
+
     inserted_genomes = 0;
 
     population_size = _population_size;
@@ -1318,21 +1343,68 @@ CNN_Genome* EXACT::generate_individual() {
     return genome;
 }
 
-int32_t EXACT::population_contains(CNN_Genome* genome) const {
-    for (int32_t i = 0; i < (int32_t) genomes.size(); i++) {
-        // we can overwrite genomes that were inserted in the initialization phase
-        // and not evaluated
-        // if (genomes[i]->get_best_validation_error() == EXACT_MAX_FLOAT) continue;
+void EXACT::add_to_population(CNN_Genome* genome) {
+    genomes.insert(upper_bound(genomes.begin(), genomes.end(), genome, sort_genomes_by_validation_error()), genome);
+    genome_hashes.insert({genome->get_structural_hash(), genome});
+}
 
-        if (genomes[i]->equals(genome)) {
-            cout << "\tgenome was the same as genome with generation id: " << genomes[i]->get_generation_id() << endl;
-            return i;
+void EXACT::remove_from_population(int32_t position) {
+    CNN_Genome* genome = genomes[position];
+
+    auto range = genome_hashes.equal_range(genome->get_structural_hash());
+    for (auto i = range.first; i != range.second; i++) {
+        if (i->second == genome) {
+            genome_hashes.erase(i);
+            break;
+        }
+    }
+
+    genomes.erase(genomes.begin() + position);
+}
+
+/**
+ * Finds where a genome in the population is with a binary search to the genomes with the same
+ * validation error. NaN errors break the ordering, so falls back to searching the whole population.
+ */
+int32_t EXACT::population_position(CNN_Genome* genome) const {
+    auto i = lower_bound(genomes.begin(), genomes.end(), genome, sort_genomes_by_validation_error());
+    for (; i != genomes.end(); i++) {
+        if (*i == genome) {
+            return i - genomes.begin();
+        }
+    }
+
+    for (int32_t j = 0; j < (int32_t) genomes.size(); j++) {
+        if (genomes[j] == genome) {
+            return j;
         }
     }
 
     return -1;
 }
 
+int32_t EXACT::population_contains(CNN_Genome* genome) const {
+    // only genomes with the same structural hash can be equal, if more than one is then the
+    // first in the population is used
+    int32_t position = -1;
+
+    auto range = genome_hashes.equal_range(genome->get_structural_hash());
+    for (auto i = range.first; i != range.second; i++) {
+        if (i->second->equals(genome)) {
+            int32_t duplicate_position = population_position(i->second);
+            if (position < 0 || duplicate_position < position) {
+                position = duplicate_position;
+            }
+        }
+    }
+
+    if (position >= 0) {
+        cout << "\tgenome was the same as genome with generation id: " << genomes[position]->get_generation_id()
+             << endl;
+    }
+    return position;
+}
+
 string parse_fitness(float fitness) {
     if (fitness == EXACT_MAX_FLOAT) {
         return "UNEVALUATED";
@@ -1366,9 +1438,14 @@ bool EXACT::insert_genome(CNN_Genome* genome) {
             best_predictions_genome = genome;
 
 #ifdef _MYSQL_
-            genome->export_to_database(id);
-            cout << "set new best predictions genome id to: " << genome->get_genome_id();
-            best_predictions_genome_id = genome->get_genome_id();
+            if (id >= 0 && database_exporter != NULL) {
+                // the search's best predictions genome is set with its id once it is exported
+                database_exporter->export_genome(genome, id);
+            } else {
+                genome->export_to_database(id);
+                cout << "set new best predictions genome id to: " << genome->get_genome_id();
+                best_predictions_genome_id = genome->get_genome_id();
+            }
 #endif
 
             if (genomes.size() > 0) {
@@ -1407,7 +1484,7 @@ bool EXACT::insert_genome(CNN_Genome* genome) {
             cout << "REPLACING DUPLICATE GENOME, fitness of genome in search: "
                  << parse_fitness(duplicate->get_best_validation_error())
                  << ", new fitness: " << parse_fitness(genome->get_best_validation_error()) << endl;
-            genomes.erase(genomes.begin() + duplicate_genome);
+            remove_from_population(duplicate_genome);
             delete duplicate;
 
         } else {
@@ -1436,12 +1513,12 @@ bool EXACT::insert_genome(CNN_Genome* genome) {
         cout << "new best fitness!" << endl;
 
         cout << "writing new best (data) to: "
-             << (output_directory + "/global_best_" + to_string(inserted_genomes) + ".txt") << endl;
+             << (output_directory + "/global_best_" + to_string(inserted_genomes) + ".bin") << endl;
 
-        genome->write_to_file(output_directory + "/global_best_" + to_string(inserted_genomes) + ".txt");
+        genome->write_to_file(output_directory + "/global_best_" + to_string(inserted_genomes) + ".bin");
 
         cout << "writing new best (graphviz) to: "
-             << (output_directory + "/global_best_" + to_string(inserted_genomes) + ".txt") << endl;
+             << (output_directory + "/global_best_" + to_string(inserted_genomes) + ".gv") << endl;
 
         ofstream gv_file(output_directory + "/global_best_" + to_string(inserted_genomes) + ".gv");
         gv_file << "#EXACT settings: " << endl;
@@ -1565,7 +1642,7 @@ bool EXACT::insert_genome(CNN_Genome* genome) {
 
         cout << "inserting new genome" << endl;
         // inorder insert the new individual
-        genomes.insert(upper_bound(genomes.begin(), genomes.end(), genome, sort_genomes_by_validation_error()), genome);
+        add_to_population(genome);
 
         cout << "inserted the new genome" << endl;
 
@@ -1573,9 +1650,9 @@ bool EXACT::insert_genome(CNN_Genome* genome) {
         if ((int32_t) genomes.size() > population_size) {
             cout << "deleting worst genome" << endl;
             CNN_Genome* worst = genomes.back();
-            genomes.pop_back();
+            remove_from_population(genomes.size() - 1);
 
-            if (worst->get_genome_id() != best_predictions_genome_id) {
+            if (worst != best_predictions_genome) {
                 delete worst;
             }
         }
@@ -20,6 +20,9 @@ using std::uniform_real_distribution;
 #include <string>
 using std::to_string;
 
+#include <unordered_map>
+using std::unordered_multimap;
+
 #include <vector>
 using std::vector;
 
@@ -28,6 +31,10 @@ using std::vector;
 #include "cnn_node.hxx"
 #include "image_tools/image_set.hxx"
 
+#ifdef _MYSQL_
+class DatabaseExporter;
+#endif
+
 class EXACT {
    private:
     int id;
@@ -58,7 +65,14 @@ class EXACT {
     uniform_int_distribution<long> rng_long;
     uniform_real_distribution<float> rng_float;
 
+    // sorted by best validation error, with an index of the genomes by their structural hash so
+    // duplicates can be found without comparing against the whole population
     vector<CNN_Genome*> genomes;
+    unordered_multimap<uint64_t, CNN_Genome*> genome_hashes;
+
+    void add_to_population(CNN_Genome* genome);
+    void remove_from_population(int32_t position);
+    int32_t population_position(CNN_Genome* genome) const;
 
     int best_predictions_genome_id;
     CNN_Genome* best_predictions_genome;
@@ -154,11 +168,25 @@ class EXACT {
     map<string, int> inserted_from_map;
     map<string, int> generated_from_map;
 
+#ifdef _MYSQL_
+    // if set, genomes are exported and the search is updated in the background
+    DatabaseExporter* database_exporter;
+
+    string get_database_update_fields() const;
+    void delete_other_genomes_from_database();
+#endif
+
    public:
 #ifdef _MYSQL_
     static bool exists_in_database(int exact_id);
     EXACT(int exact_id);
 
+    /**
+     * Exports genomes and updates the search with the exporter (which the caller owns) once the
+     * search has been inserted, instead of waiting for the database.
+     */
+    void set_database_exporter(DatabaseExporter* _database_exporter);
+
     void export_to_database();
     void update_database();
 #endif
@@ -0,0 +1,129 @@
+#include <cmath>
+using std::isinf;
+using std::isnan;
+using std::log;
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+
+#include "cnn_genome.hxx"
+#include "common/exp.hxx"
+#include "softmax.hxx"
+#include "stdint.h"
+
+// the smallest probability used for the loss, so an expected class which underflows to 0 does not
+// make the loss infinite
+#define SOFTMAX_MIN_PROBABILITY (1.0 / EXACT_MAX_FLOAT)
+
+void softmax_gather(float** node_values, float* values, int32_t batch_size, int32_t number_classes) {
+    for (int32_t i = 0; i < number_classes; i++) {
+        const float* node = node_values[i];
+        float* current = values + i;
+
+        for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+            *current = node[batch_number];
+            current += number_classes;
+        }
+    }
+}
+
+void softmax_scatter(const float* values, float** node_values, int32_t batch_size, int32_t number_classes) {
+    for (int32_t i = 0; i < number_classes; i++) {
+        float* node = node_values[i];
+        const float* current = values + i;
+
+        for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+            node[batch_number] = *current;
+            current += number_classes;
+        }
+    }
+}
+
+/**
+ * Computes the softmax of a single row in place and returns the index of its maximum,
+ * subtracting the maximum first so the exponents cannot overflow.
+ */
+static inline int32_t softmax_row(float* row, int32_t number_classes) {
+    int32_t predicted_class = 0;
+    float softmax_max = row[0];
+    for (int32_t i = 1; i < number_classes; i++) {
+        if (row[i] > softmax_max) {
+            softmax_max = row[i];
+            predicted_class = i;
+        }
+    }
+
+    float softmax_sum = 0.0;
+    for (int32_t i = 0; i < number_classes; i++) {
+        row[i] = exact_exp(row[i] - softmax_max);
+        softmax_sum += row[i];
+    }
+
+#ifdef NAN_CHECKS
+    if (softmax_sum == 0 || isinf(softmax_sum) || isnan(softmax_sum)) {
+        cerr << "ERROR! softmax sum was " << softmax_sum << ", softmax_max: " << softmax_max << endl;
+        cerr << "values_out:" << endl;
+        for (int32_t i = 0; i < number_classes; i++) {
+            cerr << "\tvalues_out[" << i << "]: " << row[i] << endl;
+        }
+        exit(1);
+    }
+#endif
+
+    float inverse_sum = 1.0 / softmax_sum;
+    for (int32_t i = 0; i < number_classes; i++) {
+        row[i] *= inverse_sum;
+    }
+
+    return predicted_class;
+}
+
+void softmax_forward(float* values, int32_t* predicted_classes, int32_t batch_size, int32_t number_classes) {
+    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+        predicted_classes[batch_number] = softmax_row(values + (batch_number * number_classes), number_classes);
+    }
+}
+
+double softmax_cross_entropy(
+    float* values, float* gradients, const int32_t* expected_classes, int32_t* predicted_classes, int32_t batch_size,
+    int32_t number_classes
+) {
+    // summed in a double so large batches don't lose the precision of each sample's loss
+    double total_loss = 0.0;
+
+    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+        float* row = values + (batch_number * number_classes);
+        float* gradient = gradients + (batch_number * number_classes);
+        int32_t expected_class = expected_classes[batch_number];
+
+        predicted_classes[batch_number] = softmax_row(row, number_classes);
+
+        for (int32_t i = 0; i < number_classes; i++) {
+            gradient[i] = row[i];
+        }
+        gradient[expected_class] -= 1.0;
+
+        float probability = row[expected_class];
+        if (probability == 0) {
+            probability = SOFTMAX_MIN_PROBABILITY;
+        }
+
+#ifdef NAN_CHECKS
+        double previous_loss = total_loss;
+#endif
+        total_loss -= log(probability);
+
+#ifdef NAN_CHECKS
+        if (isnan(total_loss) || isinf(total_loss)) {
+            cerr << "ERROR! total_loss became NAN or INF!" << endl;
+            cerr << "previous total_loss: " << previous_loss << ", probability: " << probability << endl;
+            cerr << "predicted_class: " << predicted_classes[batch_number] << ", expected_class: " << expected_class
+                 << endl;
+            exit(1);
+        }
+#endif
+    }
+
+    return total_loss;
+}
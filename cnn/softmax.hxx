@@ -0,0 +1,28 @@
+#ifndef CNN_SOFTMAX_H
+#define CNN_SOFTMAX_H
+
+#include "stdint.h"
+
+/**
+ * Gathers the values of the 1x1 softmax nodes (each stored as [batch_size]) into a contiguous
+ * [batch_size][number_classes] buffer, and scatters a buffer of the same layout back.
+ */
+void softmax_gather(float** node_values, float* values, int32_t batch_size, int32_t number_classes);
+void softmax_scatter(const float* values, float** node_values, int32_t batch_size, int32_t number_classes);
+
+/**
+ * Replaces each row of values with its softmax and sets the row's predicted (argmax) class.
+ */
+void softmax_forward(float* values, int32_t* predicted_classes, int32_t batch_size, int32_t number_classes);
+
+/**
+ * Replaces each row of values with its softmax, sets the predicted class and the cross entropy
+ * gradient (softmax - one hot of the expected class) of each row, and returns the summed cross
+ * entropy loss of the batch.
+ */
+double softmax_cross_entropy(
+    float* values, float* gradients, const int32_t* expected_classes, int32_t* predicted_classes, int32_t batch_size,
+    int32_t number_classes
+);
+
+#endif
@@ -0,0 +1,771 @@
+/**
+ * Benchmarks the CNN kernels (prop_forward, prop_backward and pool_forward, with each of their
+ * reverse filter variants, and CNN_Node::batch_normalize) over a sweep of image sizes, filter
+ * sizes and batch sizes, reporting GFLOP/s and GB/s against a roofline estimate. It also
+ * reports the images per second of evaluating and training the lenet and two_layer
+ * architectures from cnn_examples on synthetic images, e.g.:
+ *
+ *   ./cnn_benchmarks/cnn_throughput --image_sizes 14 28 56 --filter_sizes 3 5 --batch_sizes 1 25 100
+ *
+ * For an image size s and filter size f, the normal variant convolves an s x s input into an
+ * (s - f + 1) x (s - f + 1) output, while the reverse filter variants (ry, rx, ry_rx) have outputs
+ * which are f - 1 larger than the input in the reversed dimensions. Pooling uses f as the pool
+ * size, so the output is s / f (or s * f for the reversed dimensions).
+ *
+ * FLOPs count each multiply and add, and bytes are the compulsory traffic (each input, output,
+ * error and weight array read or written once), so the arithmetic intensity is an upper bound.
+ * The roofline is min(peak GFLOP/s, arithmetic intensity * peak GB/s), where the peaks are
+ * measured with a single threaded FMA loop and a STREAM style triad (the kernels are single
+ * threaded) unless given with --peak_gflops and --peak_bandwidth. Small problems fit in cache,
+ * so they can exceed the (memory bandwidth) roofline.
+ *
+ * batch_normalize and training are skipped for batches of 1 image, as the unbiased batch
+ * variance divides by batch_size - 1.
+ *
+ * Results are written as CSV (to standard output, or --output_file).
+ */
+
+#include <algorithm>
+using std::max;
+using std::min;
+
+#include <chrono>
+
+#include <fstream>
+using std::ofstream;
+
+#include <functional>
+using std::function;
+
+#include <iostream>
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::ostream;
+
+#include <random>
+using std::minstd_rand0;
+using std::uniform_real_distribution;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "cnn/cnn_edge.hxx"
+#include "cnn/cnn_genome.hxx"
+#include "cnn/cnn_node.hxx"
+#include "cnn/pooling.hxx"
+#include "cnn/propagation.hxx"
+#include "common/arguments.hxx"
+#include "image_tools/image_set_interface.hxx"
+
+#define NUMBER_ACCUMULATORS 32
+
+// pool_forward is overloaded, so the variants need the type of the one used in training
+typedef void (*PoolForward)(
+    const float*, float, float*, float*, int32_t, int32_t, int32_t, int32_t, int32_t, vector<int>&, vector<int>&,
+    vector<int>&, vector<int>&, minstd_rand0&, bool, bool
+);
+
+/**
+ * Runs the benchmark once to warm up and then runs it (doubling the number of repeats) until it
+ * takes at least min_seconds.
+ *
+ * \return the seconds per repeat
+ */
+double run_benchmark(double min_seconds, function<void()> benchmark) {
+    benchmark();
+
+    int64_t repeats = 1;
+    while (true) {
+        auto start_time = std::chrono::steady_clock::now();
+        for (int64_t i = 0; i < repeats; i++) {
+            benchmark();
+        }
+        auto end_time = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end_time - start_time).count();
+        if (seconds >= min_seconds) {
+            return seconds / repeats;
+        }
+        repeats *= 2;
+    }
+}
+
+/**
+ * \return the GB/s of a STREAM style triad (a = b + scalar * c) over arrays too large to be cached
+ */
+double measure_peak_bandwidth(int32_t array_size, double min_seconds) {
+    float* a = new float[array_size];
+    float* b = new float[array_size];
+    float* c = new float[array_size];
+    std::fill_n(a, array_size, 0.0f);
+    std::fill_n(b, array_size, 1.0f);
+    std::fill_n(c, array_size, 2.0f);
+
+    float scalar = 3.0f;
+    double seconds = run_benchmark(min_seconds, [&]() {
+        for (int32_t i = 0; i < array_size; i++) {
+            a[i] = b[i] + scalar * c[i];
+        }
+    });
+
+    // keeps the triad from being optimized away
+    volatile float sink = a[array_size / 2];
+    (void) sink;
+
+    delete[] a;
+    delete[] b;
+    delete[] c;
+
+    return (3.0 * sizeof(float) * array_size) / seconds / 1.0e9;
+}
+
+/**
+ * \return the GFLOP/s of independent multiply adds, which the compiler vectorizes with the
+ * same instruction set as the kernels
+ */
+double measure_peak_gflops(double min_seconds) {
+    int32_t iterations = 1000000;
+    float accumulators[NUMBER_ACCUMULATORS];
+
+    double seconds = run_benchmark(min_seconds, [&]() {
+        for (int32_t j = 0; j < NUMBER_ACCUMULATORS; j++) {
+            accumulators[j] = j;
+        }
+        for (int32_t i = 0; i < iterations; i++) {
+            for (int32_t j = 0; j < NUMBER_ACCUMULATORS; j++) {
+                accumulators[j] = accumulators[j] * 0.999999f + 0.000001f;
+            }
+        }
+    });
+
+    float sum = 0.0f;
+    for (int32_t j = 0; j < NUMBER_ACCUMULATORS; j++) {
+        sum += accumulators[j];
+    }
+    volatile float sink = sum;
+    (void) sink;
+
+    return (2.0 * NUMBER_ACCUMULATORS * iterations) / seconds / 1.0e9;
+}
+
+void fill_random(float* values, int64_t size, minstd_rand0& generator, float low, float high) {
+    uniform_real_distribution<float> rng(low, high);
+    for (int64_t i = 0; i < size; i++) {
+        values[i] = rng(generator);
+    }
+}
+
+/**
+ * Fixed size images of random pixels with random classes, so the end to end benchmarks do not
+ * need a dataset. The pixels are already normalized.
+ */
+class SyntheticImages : public ImagesInterface {
+   private:
+    int number_images;
+    int number_classes;
+    int channels;
+    int height;
+    int width;
+
+    vector<int> classifications;
+    vector<int> class_sizes;
+    vector<float> pixels;
+
+    vector<float> average;
+    vector<float> std_dev;
+
+   public:
+    SyntheticImages(
+        int _number_images, int _number_classes, int _channels, int _height, int _width, minstd_rand0& generator
+    )
+        : number_images(_number_images),
+          number_classes(_number_classes),
+          channels(_channels),
+          height(_height),
+          width(_width),
+          average(_channels, 0.0),
+          std_dev(_channels, 1.0) {
+        class_sizes.assign(number_classes, 0);
+        for (int32_t i = 0; i < number_images; i++) {
+            classifications.push_back(generator() % number_classes);
+            class_sizes[classifications.back()]++;
+        }
+
+        pixels.resize((int64_t) number_images * channels * height * width);
+        fill_random(pixels.data(), pixels.size(), generator, -1.0, 1.0);
+    }
+
+    string get_filename() const {
+        return "synthetic";
+    }
+
+    int get_class_size(int i) const {
+        return class_sizes[i];
+    }
+
+    int get_number_classes() const {
+        return number_classes;
+    }
+
+    int get_number_images() const {
+        return number_images;
+    }
+
+    int get_image_channels() const {
+        return channels;
+    }
+
+    int get_image_width() const {
+        return width;
+    }
+
+    int get_image_height() const {
+        return height;
+    }
+
+    bool is_streaming() const {
+        return false;
+    }
+
+    int get_classification(int image) const {
+        return classifications[image];
+    }
+
+    float get_pixel(int image, int z, int y, int x) const {
+        return pixels[((((int64_t) image * channels + z) * height) + y) * width + x];
+    }
+
+    void get_subimage(int image, int z, float* values) const {
+        std::copy_n(&pixels[(((int64_t) image * channels + z) * height) * width], height * width, values);
+    }
+
+    float get_channel_avg(int channel) const {
+        return average[channel];
+    }
+
+    float get_channel_std_dev(int channel) const {
+        return std_dev[channel];
+    }
+
+    const vector<float>& get_average() const {
+        return average;
+    }
+
+    const vector<float>& get_std_dev() const {
+        return std_dev;
+    }
+};
+
+/**
+ * The hyperparameters used for the end to end genomes, which only change how long a pass takes
+ * through dropout.
+ */
+CNN_Genome* create_genome(
+    const ImagesInterface& images, int batch_size, int seed, const vector<CNN_Node*>& nodes,
+    const vector<CNN_Edge*>& edges
+) {
+    // the genome reports its size on cout, which would be mixed into the csv
+    std::streambuf* cout_buffer = cout.rdbuf(cerr.rdbuf());
+    CNN_Genome* genome = new CNN_Genome(
+        1, 0, images.get_number_images(), 0, 0, seed, 1, true, 0, 0.5, 0.0, 0.001, 0.0, 0.0001, 0.0, batch_size,
+        1.0e-7, 0.1, 0.0, 0.0, nodes, edges
+    );
+    genome->initialize();
+    cout.rdbuf(cout_buffer);
+    return genome;
+}
+
+/**
+ * The two_layer architecture from cnn_examples: each channel is convolved to 10 5x5 nodes which
+ * are fully connected to the softmax nodes.
+ */
+CNN_Genome* create_two_layer(const ImagesInterface& images, int batch_size, int seed) {
+    int node_innovation_count = 0;
+    int edge_innovation_count = 0;
+    vector<CNN_Node*> nodes;
+    vector<CNN_Node*> input_nodes;
+    vector<CNN_Node*> layer1_nodes;
+    vector<CNN_Edge*> edges;
+
+    for (int32_t i = 0; i < images.get_image_channels(); i++) {
+        CNN_Node* input_node = new CNN_Node(
+            ++node_innovation_count, 0, batch_size, images.get_image_height(), images.get_image_width(), INPUT_NODE
+        );
+        nodes.push_back(input_node);
+        input_nodes.push_back(input_node);
+    }
+
+    for (int32_t i = 0; i < 10; i++) {
+        CNN_Node* layer1_node = new CNN_Node(++node_innovation_count, 1, batch_size, 5, 5, HIDDEN_NODE);
+        nodes.push_back(layer1_node);
+        layer1_nodes.push_back(layer1_node);
+
+        for (int32_t j = 0; j < (int32_t) input_nodes.size(); j++) {
+            edges.push_back(new CNN_Edge(input_nodes[j], layer1_node, false, ++edge_innovation_count, CONVOLUTIONAL));
+        }
+    }
+
+    for (int32_t i = 0; i < images.get_number_classes(); i++) {
+        CNN_Node* softmax_node = new CNN_Node(++node_innovation_count, 2, batch_size, 1, 1, SOFTMAX_NODE);
+        nodes.push_back(softmax_node);
+
+        for (int32_t j = 0; j < (int32_t) layer1_nodes.size(); j++) {
+            edges.push_back(new CNN_Edge(layer1_nodes[j], softmax_node, false, ++edge_innovation_count, CONVOLUTIONAL));
+        }
+    }
+
+    return create_genome(images, batch_size, seed, nodes, edges);
+}
+
+/**
+ * The lenet architecture from cnn_examples (which expects 32x32 images): 6 28x28 nodes, pooled to
+ * 14x14, partially connected to 16 10x10 nodes, pooled to 5x5, then fully connected layers of
+ * 120 and 84 nodes and the softmax nodes.
+ */
+CNN_Genome* create_lenet(const ImagesInterface& images, int batch_size, int seed) {
+    // which of the 6 layer 2 nodes each of the 16 layer 3 nodes is connected to
+    const vector<vector<int> > layer3_connections = {
+        {0, 1, 2},    {1, 2, 3},    {2, 3, 4},    {3, 4, 5},    {4, 5, 0},    {5, 0, 1},
+        {0, 1, 2, 3}, {1, 2, 3, 4}, {2, 3, 4, 5}, {3, 4, 5, 0}, {4, 5, 0, 1}, {5, 0, 1, 2},
+        {0, 1, 3, 4}, {1, 2, 4, 5}, {0, 2, 3, 5}, {0, 1, 2, 3, 4, 5}
+    };
+
+    int node_innovation_count = 0;
+    int edge_innovation_count = 0;
+    vector<CNN_Node*> nodes;
+    vector<CNN_Node*> input_nodes;
+    vector<CNN_Node*> layer1_nodes;
+    vector<CNN_Node*> layer2_nodes;
+    vector<CNN_Node*> layer3_nodes;
+    vector<CNN_Node*> layer4_nodes;
+    vector<CNN_Node*> layer5_nodes;
+    vector<CNN_Node*> layer6_nodes;
+    vector<CNN_Edge*> edges;
+
+    for (int32_t i = 0; i < images.get_image_channels(); i++) {
+        CNN_Node* input_node = new CNN_Node(
+            ++node_innovation_count, 0, batch_size, images.get_image_height(), images.get_image_width(), INPUT_NODE
+        );
+        nodes.push_back(input_node);
+        input_nodes.push_back(input_node);
+    }
+
+    for (int32_t i = 0; i < 6; i++) {
+        CNN_Node* layer1_node = new CNN_Node(++node_innovation_count, 1, batch_size, 28, 28, HIDDEN_NODE);
+        nodes.push_back(layer1_node);
+        layer1_nodes.push_back(layer1_node);
+
+        for (int32_t j = 0; j < (int32_t) input_nodes.size(); j++) {
+            edges.push_back(new CNN_Edge(input_nodes[j], layer1_node, false, ++edge_innovation_count, CONVOLUTIONAL));
+        }
+    }
+
+    for (int32_t i = 0; i < 6; i++) {
+        CNN_Node* layer2_node = new CNN_Node(++node_innovation_count, 2, batch_size, 14, 14, HIDDEN_NODE);
+        nodes.push_back(layer2_node);
+        layer2_nodes.push_back(layer2_node);
+
+        edges.push_back(new CNN_Edge(layer1_nodes[i], layer2_node, false, ++edge_innovation_count, POOLING));
+    }
+
+    for (int32_t i = 0; i < 16; i++) {
+        CNN_Node* layer3_node = new CNN_Node(++node_innovation_count, 3, batch_size, 10, 10, HIDDEN_NODE);
+        nodes.push_back(layer3_node);
+        layer3_nodes.push_back(layer3_node);
+
+        for (int32_t j : layer3_connections[i]) {
+            edges.push_back(new CNN_Edge(layer2_nodes[j], layer3_node, false, ++edge_innovation_count, CONVOLUTIONAL));
+        }
+    }
+
+    for (int32_t i = 0; i < 16; i++) {
+        CNN_Node* layer4_node = new CNN_Node(++node_innovation_count, 4, batch_size, 5, 5, HIDDEN_NODE);
+        nodes.push_back(layer4_node);
+        layer4_nodes.push_back(layer4_node);
+
+        edges.push_back(new CNN_Edge(layer3_nodes[i], layer4_node, false, ++edge_innovation_count, POOLING));
+    }
+
+    for (int32_t i = 0; i < 120; i++) {
+        CNN_Node* layer5_node = new CNN_Node(++node_innovation_count, 6, batch_size, 1, 1, HIDDEN_NODE);
+        nodes.push_back(layer5_node);
+        layer5_nodes.push_back(layer5_node);
+
+        for (int32_t j = 0; j < (int32_t) layer4_nodes.size(); j++) {
+            edges.push_back(new CNN_Edge(layer4_nodes[j], layer5_node, false, ++edge_innovation_count, CONVOLUTIONAL));
+        }
+    }
+
+    for (int32_t i = 0; i < 84; i++) {
+        CNN_Node* layer6_node = new CNN_Node(++node_innovation_count, 7, batch_size, 1, 1, HIDDEN_NODE);
+        nodes.push_back(layer6_node);
+        layer6_nodes.push_back(layer6_node);
+
+        for (int32_t j = 0; j < (int32_t) layer5_nodes.size(); j++) {
+            edges.push_back(new CNN_Edge(layer5_nodes[j], layer6_node, false, ++edge_innovation_count, CONVOLUTIONAL));
+        }
+    }
+
+    for (int32_t i = 0; i < images.get_number_classes(); i++) {
+        CNN_Node* softmax_node = new CNN_Node(++node_innovation_count, 8, batch_size, 1, 1, SOFTMAX_NODE);
+        nodes.push_back(softmax_node);
+
+        for (int32_t j = 0; j < (int32_t) layer6_nodes.size(); j++) {
+            edges.push_back(new CNN_Edge(layer6_nodes[j], softmax_node, false, ++edge_innovation_count, CONVOLUTIONAL));
+        }
+    }
+
+    return create_genome(images, batch_size, seed, nodes, edges);
+}
+
+/**
+ * \return the multiplies and adds of propagating forward through a convolution, each filter
+ * weight is applied over the smaller of the input and output in each dimension
+ */
+double convolution_flops(
+    int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x,
+    int32_t output_size_y, int32_t output_size_x
+) {
+    return 2.0 * batch_size * filter_y * filter_x * min(input_size_y, output_size_y) * min(input_size_x, output_size_x);
+}
+
+/**
+ * \return the forward convolution FLOPs of one image through a genome (pooling, batch
+ * normalization and the activation functions are not counted)
+ */
+double genome_flops_per_image(CNN_Genome* genome) {
+    double flops = 0.0;
+    for (CNN_Edge* edge : genome->get_edges()) {
+        if (edge->get_type() != CONVOLUTIONAL) {
+            continue;
+        }
+
+        CNN_Node* input_node = edge->get_input_node();
+        CNN_Node* output_node = edge->get_output_node();
+        flops += convolution_flops(
+            1, input_node->get_size_y(), input_node->get_size_x(), edge->get_filter_y(), edge->get_filter_x(),
+            output_node->get_size_y(), output_node->get_size_x()
+        );
+    }
+    return flops;
+}
+
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    vector<int32_t> image_sizes;
+    get_argument_vector(arguments, "--image_sizes", false, image_sizes);
+    if (image_sizes.size() == 0) {
+        image_sizes = {14, 28, 56};
+    }
+
+    vector<int32_t> filter_sizes;
+    get_argument_vector(arguments, "--filter_sizes", false, filter_sizes);
+    if (filter_sizes.size() == 0) {
+        filter_sizes = {2, 3, 5};
+    }
+
+    vector<int32_t> batch_sizes;
+    get_argument_vector(arguments, "--batch_sizes", false, batch_sizes);
+    if (batch_sizes.size() == 0) {
+        batch_sizes = {1, 25, 100};
+    }
+
+    vector<string> architectures;
+    get_argument_vector(arguments, "--architectures", false, architectures);
+    if (architectures.size() == 0) {
+        architectures = {"two_layer", "lenet"};
+    }
+
+    double min_seconds = 0.1;
+    get_argument(arguments, "--min_seconds", false, min_seconds);
+
+    int32_t number_images = 1000;
+    get_argument(arguments, "--number_images", false, number_images);
+
+    int32_t number_classes = 10;
+    get_argument(arguments, "--number_classes", false, number_classes);
+
+    int32_t channels = 1;
+    get_argument(arguments, "--channels", false, channels);
+
+    int32_t seed = 1337;
+    get_argument(arguments, "--seed", false, seed);
+    minstd_rand0 generator(seed);
+
+    double peak_bandwidth = 0.0;
+    if (!get_argument(arguments, "--peak_bandwidth", false, peak_bandwidth)) {
+        peak_bandwidth = measure_peak_bandwidth(1 << 24, min_seconds);
+    }
+
+    double peak_gflops = 0.0;
+    if (!get_argument(arguments, "--peak_gflops", false, peak_gflops)) {
+        peak_gflops = measure_peak_gflops(min_seconds);
+    }
+    cerr << "roofline peaks: " << peak_gflops << " GFLOP/s, " << peak_bandwidth << " GB/s" << endl;
+
+    ofstream* output_file = NULL;
+    string output_filename;
+    if (get_argument(arguments, "--output_file", false, output_filename)) {
+        output_file = new ofstream(output_filename);
+    }
+    ostream& output = output_file != NULL ? *output_file : cout;
+
+    output << "benchmark,variant,batch_size,input_y,input_x,filter_y,filter_x,output_y,output_x,seconds,gflops,"
+              "gbytes_per_second,arithmetic_intensity,roofline_gflops,roofline_efficiency,images_per_second"
+           << endl;
+
+    auto write_result = [&](string benchmark, string variant, int32_t batch_size, int32_t input_size_y,
+                            int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+                            int32_t output_size_x, double seconds, double flops, double bytes, int64_t images) {
+        double gflops = flops / seconds / 1.0e9;
+
+        output << benchmark << "," << variant << "," << batch_size << "," << input_size_y << "," << input_size_x
+               << "," << filter_y << "," << filter_x << "," << output_size_y << "," << output_size_x << ","
+               << seconds << "," << gflops << ",";
+
+        // the bytes are not estimated for whole genomes, so their roofline is the peak GFLOP/s
+        double roofline_gflops = peak_gflops;
+        if (bytes > 0) {
+            double arithmetic_intensity = flops / bytes;
+            roofline_gflops = min(peak_gflops, arithmetic_intensity * peak_bandwidth);
+            output << bytes / seconds / 1.0e9 << "," << arithmetic_intensity << ",";
+        } else {
+            output << ",,";
+        }
+
+        output << roofline_gflops << "," << gflops / roofline_gflops << "," << images / seconds << endl;
+    };
+
+    const vector<string> variants = {"normal", "ry", "rx", "ry_rx"};
+
+    for (int32_t image_size : image_sizes) {
+        for (int32_t filter_size : filter_sizes) {
+            for (int32_t batch_size : batch_sizes) {
+                for (string variant : variants) {
+                    bool reverse_y = (variant == "ry" || variant == "ry_rx");
+                    bool reverse_x = (variant == "rx" || variant == "ry_rx");
+
+                    int32_t input_size_y = image_size;
+                    int32_t input_size_x = image_size;
+                    int32_t output_size_y = reverse_y ? image_size + filter_size - 1 : image_size - filter_size + 1;
+                    int32_t output_size_x = reverse_x ? image_size + filter_size - 1 : image_size - filter_size + 1;
+                    if (output_size_y < 1 || output_size_x < 1) {
+                        continue;
+                    }
+
+                    int64_t input_size = (int64_t) batch_size * input_size_y * input_size_x;
+                    int64_t output_size = (int64_t) batch_size * output_size_y * output_size_x;
+                    int32_t filter = filter_size * filter_size;
+
+                    float* input = new float[input_size];
+                    float* input_errors = new float[input_size]();
+                    float* output = new float[output_size]();
+                    float* output_errors = new float[output_size];
+                    float* weights = new float[filter];
+                    float* weight_updates = new float[filter]();
+
+                    fill_random(input, input_size, generator, 0.0, 1.0);
+                    fill_random(output_errors, output_size, generator, -0.1, 0.1);
+                    fill_random(weights, filter, generator, -0.1, 0.1);
+
+                    auto forward = prop_forward;
+                    auto backward = prop_backward;
+                    if (reverse_y && reverse_x) {
+                        forward = prop_forward_ry_rx;
+                        backward = prop_backward_ry_rx;
+                    } else if (reverse_y) {
+                        forward = prop_forward_ry;
+                        backward = prop_backward_ry;
+                    } else if (reverse_x) {
+                        forward = prop_forward_rx;
+                        backward = prop_backward_rx;
+                    }
+
+                    double flops = convolution_flops(
+                        batch_size, input_size_y, input_size_x, filter_size, filter_size, output_size_y, output_size_x
+                    );
+
+                    // reads the input and weights, reads and writes the output
+                    double seconds = run_benchmark(min_seconds, [&]() {
+                        forward(
+                            input, weights, output, batch_size, input_size_y, input_size_x, filter_size, filter_size,
+                            output_size_y, output_size_x
+                        );
+                    });
+                    write_result(
+                        "prop_forward", variant, batch_size, input_size_y, input_size_x, filter_size, filter_size,
+                        output_size_y, output_size_x, seconds, flops,
+                        sizeof(float) * (input_size + 2 * output_size + filter), batch_size
+                    );
+
+                    // the weight updates and input errors are both multiply adds, reads the output errors,
+                    // input and weights and reads and writes the input errors and weight updates
+                    seconds = run_benchmark(min_seconds, [&]() {
+                        backward(
+                            output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y,
+                            input_size_x, filter_size, filter_size, output_size_y, output_size_x
+                        );
+                    });
+                    write_result(
+                        "prop_backward", variant, batch_size, input_size_y, input_size_x, filter_size, filter_size,
+                        output_size_y, output_size_x, seconds, 2.0 * flops,
+                        sizeof(float) * (3 * input_size + output_size + 3 * filter), batch_size
+                    );
+
+                    delete[] input;
+                    delete[] input_errors;
+                    delete[] output;
+                    delete[] output_errors;
+                    delete[] weights;
+                    delete[] weight_updates;
+                }
+
+                if (filter_size < 2) {
+                    continue;
+                }
+
+                for (string variant : variants) {
+                    bool reverse_y = (variant == "ry" || variant == "ry_rx");
+                    bool reverse_x = (variant == "rx" || variant == "ry_rx");
+
+                    int32_t input_size_y = image_size;
+                    int32_t input_size_x = image_size;
+                    int32_t output_size_y = reverse_y ? image_size * filter_size : image_size / filter_size;
+                    int32_t output_size_x = reverse_x ? image_size * filter_size : image_size / filter_size;
+                    if (output_size_y < 1 || output_size_x < 1) {
+                        continue;
+                    }
+
+                    int64_t input_size = (int64_t) batch_size * input_size_y * input_size_x;
+                    int64_t output_size = (int64_t) batch_size * output_size_y * output_size_x;
+
+                    float* input = new float[input_size];
+                    float* pool_gradients = new float[input_size]();
+                    float* output = new float[output_size]();
+                    fill_random(input, input_size, generator, 0.0, 1.0);
+
+                    vector<int> y_pools, y_pool_offset, x_pools, x_pool_offset;
+                    initialize_pools(y_pools, y_pool_offset, input_size_y, output_size_y);
+                    initialize_pools(x_pools, x_pool_offset, input_size_x, output_size_x);
+
+                    PoolForward pool = pool_forward;
+                    if (reverse_y && reverse_x) {
+                        pool = pool_forward_ry_rx;
+                    } else if (reverse_y) {
+                        pool = pool_forward_ry;
+                    } else if (reverse_x) {
+                        pool = pool_forward_rx;
+                    }
+
+                    // training uses max pooling
+                    double seconds = run_benchmark(min_seconds, [&]() {
+                        pool(
+                            input, 1.0, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y,
+                            output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, true, true
+                        );
+                    });
+
+                    // a comparison for each pooled value and a multiply add for each output, reads the
+                    // input and writes the pool gradients, reads and writes the output
+                    double pooled = (double) batch_size * max(input_size_y, output_size_y)
+                                    * max(input_size_x, output_size_x);
+                    write_result(
+                        "pool_forward", variant, batch_size, input_size_y, input_size_x, filter_size, filter_size,
+                        output_size_y, output_size_x, seconds, pooled + 2.0 * output_size,
+                        sizeof(float) * (2 * input_size + 2 * output_size), batch_size
+                    );
+
+                    delete[] input;
+                    delete[] pool_gradients;
+                    delete[] output;
+                }
+            }
+        }
+
+        for (int32_t batch_size : batch_sizes) {
+            // the unbiased batch variance divides by batch_size - 1
+            if (batch_size < 2) {
+                continue;
+            }
+
+            CNN_Node* node = new CNN_Node(1, 1, batch_size, image_size, image_size, HIDDEN_NODE);
+            node->initialize();
+            int64_t size = (int64_t) batch_size * image_size * image_size;
+            fill_random(node->get_values_in(), size, generator, -1.0, 1.0);
+
+            // the mean, the variance (a subtract and multiply add) and the normalization (a subtract,
+            // multiply and multiply add), reads the inputs three times, writes them and the outputs
+            double seconds = run_benchmark(min_seconds, [&]() {
+                node->batch_normalize(true, false, 1.0e-7, 0.1);
+            });
+            write_result(
+                "batch_normalize", "normal", batch_size, image_size, image_size, 0, 0, image_size, image_size, seconds,
+                8.0 * size, sizeof(float) * 5 * size, batch_size
+            );
+
+            delete node;
+        }
+    }
+
+    // lenet (like the cnn_examples) expects 32x32 images, e.g., MNIST with a padding of 2
+    SyntheticImages images(number_images, number_classes, channels, 32, 32, generator);
+    vector<long> order;
+    for (int32_t i = 0; i < number_images; i++) {
+        order.push_back(i);
+    }
+
+    for (string architecture : architectures) {
+        for (int32_t batch_size : batch_sizes) {
+            CNN_Genome* genome = NULL;
+            if (architecture == "two_layer") {
+                genome = create_two_layer(images, batch_size, seed);
+            } else if (architecture == "lenet") {
+                genome = create_lenet(images, batch_size, seed);
+            } else {
+                cerr << "ERROR: unknown architecture '" << architecture << "', options are two_layer and lenet"
+                     << endl;
+                exit(1);
+            }
+
+            double flops = genome_flops_per_image(genome) * number_images;
+
+            vector<vector<float> > predictions;
+            double seconds = run_benchmark(min_seconds, [&]() {
+                genome->evaluate(images, predictions);
+            });
+            write_result(
+                "evaluate", architecture, batch_size, 32, 32, 0, 0, 0, 0, seconds, flops, 0.0, number_images
+            );
+
+            // training batch normalizes, which needs at least 2 images in a batch
+            if (batch_size < 2) {
+                delete genome;
+                continue;
+            }
+
+            // the forward pass and backward pass (twice the FLOPs) with weight updates
+            float total_error;
+            int correct_predictions;
+            seconds = run_benchmark(min_seconds, [&]() {
+                genome->evaluate(images, order, total_error, correct_predictions, true, false);
+            });
+            write_result(
+                "train", architecture, batch_size, 32, 32, 0, 0, 0, 0, seconds, 3.0 * flops, 0.0, number_images
+            );
+
+            delete genome;
+        }
+    }
+
+    if (output_file != NULL) {
+        output_file->close();
+        delete output_file;
+    }
+
+    return 0;
+}
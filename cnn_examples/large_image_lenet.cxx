@@ -305,7 +305,7 @@ int main(int argc, char** argv) {
     genome->stochastic_backpropagation(training_images, validation_images);
 
     cout << "writing genome to file!" << endl;
-    genome->write_to_file("./large_image_lenet.txt");
+    genome->write_to_file("./large_image_lenet.bin");
 
     cout << endl << "getting training images predictions." << endl;
     genome->evaluate_large_images(training_images, "./prediction_results_training/");
@@ -289,5 +289,5 @@ int main(int argc, char** argv) {
     genome->evaluate_test(testing_images);
     genome->print_results(cerr);
 
-    genome->write_to_file("lenet_trained.txt");
+    genome->write_to_file("lenet_trained.bin");
 }
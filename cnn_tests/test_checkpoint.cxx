@@ -39,9 +39,9 @@ int main(int argc, char** argv) {
     bool is_checkpoint = false;
     CNN_Genome* genome_from_file = new CNN_Genome(genome_filename, is_checkpoint);
 
-    genome_from_file->write_to_file("temp_genome.txt");
+    genome_from_file->write_to_file("temp_genome.bin");
 
-    CNN_Genome* genome_from_checkpoint = new CNN_Genome("temp_genome.txt", true);
+    CNN_Genome* genome_from_checkpoint = new CNN_Genome("temp_genome.bin", true);
 
     Images training_images(training_data, genome_from_file->get_padding());
     Images testing_images(
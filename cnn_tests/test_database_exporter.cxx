@@ -0,0 +1,139 @@
+#include <atomic>
+using std::atomic;
+
+#include <cstdio>
+
+#include <fstream>
+using std::ifstream;
+
+#include <iostream>
+using std::cerr;
+using std::cout;
+using std::endl;
+
+#include <memory>
+using std::shared_ptr;
+
+#include <string>
+using std::getline;
+using std::string;
+using std::to_string;
+
+#include <vector>
+using std::vector;
+
+#include "cnn/cnn_genome.hxx"
+#include "cnn/database_exporter.hxx"
+#include "common/arguments.hxx"
+
+int count_statements(const vector<string>& statements, string prefix) {
+    int count = 0;
+    for (int32_t i = 0; i < (int32_t) statements.size(); i++) {
+        if (statements[i].compare(0, prefix.size(), prefix) == 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    string genome_filename;
+    get_argument(arguments, "--genome_file", true, genome_filename);
+
+    int32_t rows_per_insert = 3;
+    get_argument(arguments, "--rows_per_insert", false, rows_per_insert);
+
+    string statements_filename = "temp_database_export.sql";
+    remove(statements_filename.c_str());
+
+    bool is_checkpoint = false;
+    CNN_Genome* genome = new CNN_Genome(genome_filename, is_checkpoint);
+    int exact_id = 7;
+    int first_id = 1000;
+
+    DatabaseExporter* exporter =
+        new DatabaseExporter(new FileDatabaseConnection(statements_filename, first_id), rows_per_insert);
+
+    // the search update is queued before the genome has been inserted, so its id must be resolved
+    // when the update is run
+    exporter->export_genome(genome, exact_id);
+    vector<shared_ptr<atomic<int> > > kept_genome_ids{genome->get_export_id()};
+    exporter->update_search(exact_id, "inserted_genomes = 1", genome->get_export_id(), kept_genome_ids, false);
+    exporter->update_search(exact_id, "inserted_genomes = 2", genome->get_export_id(), kept_genome_ids, true);
+    exporter->flush();
+
+    if (genome->get_genome_id() != first_id) {
+        cerr << "ERROR! genome id was " << genome->get_genome_id() << " after being exported, not " << first_id
+             << endl;
+        exit(1);
+    }
+
+    // exporting it again should replace it rather than inserting a new genome
+    exporter->export_genome(genome, exact_id);
+    delete genome;
+    delete exporter;
+
+    vector<string> statements;
+    ifstream infile(statements_filename);
+    string line;
+    while (getline(infile, line)) {
+        statements.push_back(line);
+    }
+
+    bool failed = false;
+    if (count_statements(statements, "INSERT INTO cnn_genome") != 1
+        || count_statements(statements, "REPLACE INTO cnn_genome") != 1) {
+        cerr << "ERROR! genome should have been inserted once and then replaced" << endl;
+        failed = true;
+    }
+
+    if (count_statements(statements, "START TRANSACTION") != 2 || count_statements(statements, "COMMIT") != 2) {
+        cerr << "ERROR! each genome export should be in its own transaction" << endl;
+        failed = true;
+    }
+
+    CNN_Genome* read_genome = new CNN_Genome(genome_filename, is_checkpoint);
+    int32_t number_nodes = read_genome->get_nodes().size();
+    int32_t number_edges = read_genome->get_edges().size();
+    delete read_genome;
+
+    int32_t node_inserts = (number_nodes + rows_per_insert - 1) / rows_per_insert;
+    int32_t edge_inserts = (number_edges + rows_per_insert - 1) / rows_per_insert;
+    if (count_statements(statements, "INSERT INTO cnn_node") != 2 * node_inserts
+        || count_statements(statements, "INSERT INTO cnn_edge") != 2 * edge_inserts) {
+        cerr << "ERROR! expected " << node_inserts << " node and " << edge_inserts
+             << " edge inserts for each export, with " << number_nodes << " nodes and " << number_edges << " edges"
+             << endl;
+        failed = true;
+    }
+
+    // the first update may have been run before the second was queued, but the last must be the second
+    string last_update;
+    for (int32_t i = 0; i < (int32_t) statements.size(); i++) {
+        if (statements[i].compare(0, 6, "UPDATE") == 0) {
+            last_update = statements[i];
+        }
+    }
+    string expected_update = "UPDATE exact_search SET inserted_genomes = 2, best_predictions_genome_id = "
+                             + to_string(first_id) + " WHERE id = " + to_string(exact_id) + ";";
+    if (last_update.compare(expected_update) != 0) {
+        cerr << "ERROR! last search update was '" << last_update << "', expected '" << expected_update << "'" << endl;
+        failed = true;
+    }
+
+    if (count_statements(statements, "DELETE FROM cnn_genome WHERE exact_id = 7 AND (id != 1000 AND id != 1000)")
+        != 1) {
+        cerr << "ERROR! genomes not in the population should have been deleted once" << endl;
+        failed = true;
+    }
+
+    if (failed) {
+        cout << "FAILED!" << endl;
+        return 1;
+    }
+
+    cout << "PASSED!" << endl;
+    return 0;
+}
@@ -24,19 +24,27 @@ void __mysql_check(string query, const char* file, const int line) {
         initialize_exact_database();
     }
 
-    mysql_query(exact_db_conn, query.c_str());
+    __mysql_check_connection(exact_db_conn, query, file, line);
+}
+
+void __mysql_check_connection(MYSQL* connection, string query, const char* file, const int line) {
+    mysql_query(connection, query.c_str());
 
-    if (mysql_errno(exact_db_conn) != 0) {
+    if (mysql_errno(connection) != 0) {
         ostringstream ex_msg;
-        ex_msg << "ERROR in MySQL query: '" << query.c_str() << "'. Error: " << mysql_errno(exact_db_conn) << " -- '"
-               << mysql_error(exact_db_conn) << "'. Thrown on " << file << ":" << line;
+        ex_msg << "ERROR in MySQL query: '" << query.c_str() << "'. Error: " << mysql_errno(connection) << " -- '"
+               << mysql_error(connection) << "'. Thrown on " << file << ":" << line;
         fprintf(stderr, "%s\n", ex_msg.str().c_str());
         exit(1);
     }
 }
 
 void initialize_exact_database() {
-    exact_db_conn = mysql_init(NULL);
+    exact_db_conn = create_exact_database_connection();
+}
+
+MYSQL* create_exact_database_connection() {
+    MYSQL* connection = mysql_init(NULL);
 
     // shoud get database info from a file
     string db_host, db_name, db_password, db_user, db_port_s;
@@ -58,14 +66,14 @@ void initialize_exact_database() {
     );
 
     if (mysql_real_connect(
-            exact_db_conn, db_host.c_str(), db_user.c_str(), db_password.c_str(), db_name.c_str(), db_port, NULL, 0
+            connection, db_host.c_str(), db_user.c_str(), db_password.c_str(), db_name.c_str(), db_port, NULL, 0
         )
         == NULL) {
-        fprintf(
-            stderr, "Error connecting to database: %d, '%s'\n", mysql_errno(exact_db_conn), mysql_error(exact_db_conn)
-        );
+        fprintf(stderr, "Error connecting to database: %d, '%s'\n", mysql_errno(connection), mysql_error(connection));
         exit(1);
     }
+
+    return connection;
 }
 
 int mysql_exact_last_insert_id() {
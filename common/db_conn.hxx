@@ -5,13 +5,18 @@
 
 #define mysql_exact_query(query) __mysql_check(query, __FILE__, __LINE__)
 
+// for threads which need their own connection, as a connection can't be shared between threads
+#define mysql_exact_query_on(connection, query) __mysql_check_connection(connection, query, __FILE__, __LINE__)
+
 extern MYSQL* exact_db_conn;
 
 void set_db_info_filename(string _filename);
 
 void __mysql_check(string query, const char* file, const int line);
+void __mysql_check_connection(MYSQL* connection, string query, const char* file, const int line);
 
 void initialize_exact_database();
+MYSQL* create_exact_database_connection();
 
 int mysql_exact_last_insert_id();
 
@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <cstring>
 #include <stdexcept>
 using std::runtime_error;
@@ -17,13 +18,13 @@ using std::ostringstream;
 
 #include <string>
 using std::string;
+using std::to_string;
 
 // for mkdir
 #include <errno.h>
 #include <sys/stat.h>
-#ifdef HAVE_UNISTD_H
+// for fsync, getpid and unlink
 #include <unistd.h>
-#endif /* HAVE_UNISTD_H */
 
 typedef struct stat Stat;
 
@@ -106,3 +107,24 @@ int mkpath(const char* path, mode_t mode) {
     free(copypath);
     return (status);
 }
+
+bool write_file_atomically(const string& filename, const string& contents) {
+    string temporary_filename = filename + ".tmp." + to_string(getpid());
+
+    FILE* file = fopen(temporary_filename.c_str(), "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    // the contents need to be on disk before the rename, otherwise a crash could leave the renamed
+    // file empty
+    bool written = fwrite(contents.data(), 1, contents.size(), file) == contents.size() && fflush(file) == 0
+                   && fsync(fileno(file)) == 0;
+    written = (fclose(file) == 0) && written;
+
+    if (!written || rename(temporary_filename.c_str(), filename.c_str()) != 0) {
+        unlink(temporary_filename.c_str());
+        return false;
+    }
+    return true;
+}
@@ -11,4 +11,12 @@ string get_file_as_string(string file_path) noexcept(false);
 
 int mkpath(const char* path, mode_t mode);
 
+/**
+ * Writes the contents to the file through a synced temporary file and a rename, so if the process
+ * or node goes down mid-write the file still holds its previous contents.
+ *
+ * \return true if the file was written
+ */
+bool write_file_atomically(const string& filename, const string& contents);
+
 #endif
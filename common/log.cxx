@@ -1,3 +1,10 @@
+#include <algorithm>
+using std::find;
+using std::max;
+using std::min;
+
+#include <chrono>
+
 #include <cstdio>
 using std::fprintf;
 using std::printf;
@@ -7,12 +14,20 @@ using std::vsnprintf;
 // for va_list, va_start
 #include <stdarg.h>
 
+#include <cstdlib>
+
 #include <iostream>
-using std::ofstream;
+
+#include <mutex>
+using std::lock_guard;
+using std::unique_lock;
 
 #include <thread>
 using std::thread;
 
+// for stat
+#include <sys/stat.h>
+
 #include "arguments.hxx"
 #include "files.hxx"
 #include "log.hxx"
@@ -20,6 +35,112 @@ using std::thread;
 using std::cerr;
 using std::endl;
 
+// how often (in milliseconds) the writer thread writes out queued messages when it is not woken
+#define LOG_WRITER_INTERVAL 10
+
+// where a queued message goes, or if it is a request to close its id's log file
+#define LOG_TO_STD     1
+#define LOG_TO_FILE    2
+#define LOG_RELEASE_ID 4
+
+class LogEntry {
+   public:
+    LogFile* log_file;
+    int32_t id_index;
+    int8_t message_level;
+    int8_t destinations;
+    int32_t length;
+};
+
+/**
+ * A single producer, single consumer ring buffer of formatted messages. The logging thread
+ * writes entries at head and the writer thread reads them at tail, so neither needs a lock.
+ */
+class LogBuffer {
+   public:
+    LogEntry entries[LOG_BUFFER_ENTRIES];
+    vector<char> text;
+    int32_t entry_length;
+
+    atomic<uint64_t> head;
+    atomic<uint64_t> tail;
+
+    // set when the thread exits, so the writer can delete the buffer once it is empty
+    atomic<bool> closed;
+
+    LogBuffer(int32_t _entry_length)
+        : text(LOG_BUFFER_ENTRIES * _entry_length), entry_length(_entry_length), head(0), tail(0), closed(false) {
+    }
+};
+
+/**
+ * The log file of an interned id. The slot (and this object) is reused for another id once the id
+ * is released, unless the logs are multiplexed.
+ */
+class LogFile {
+   public:
+    // the name and file are protected by file_mutex, the name is also only set while holding
+    // Log::log_ids_mutex
+    string name;
+    FILE* file;
+    mutex file_mutex;
+
+    // if the id record has been written to the multiplexed log, protected by Log::multiplexed_mutex
+    bool multiplexed;
+
+    // incremented when the id is released, so threads still holding it know to set their id again
+    atomic<uint32_t> generation;
+
+    LogFile() : file(NULL), multiplexed(false), generation(0) {
+    }
+};
+
+/**
+ * The logging state of each thread, so its id does not need to be looked up for every message.
+ */
+class LogThreadState {
+   public:
+    int32_t id_index;
+    string id_name;
+    LogFile* log_file;
+    uint32_t generation;
+    LogBuffer* buffer;
+
+    // used to format messages when writing synchronously
+    vector<char> text;
+
+    LogThreadState() : id_index(-1), log_file(NULL), generation(0), buffer(NULL) {
+    }
+
+    ~LogThreadState() {
+        if (buffer != NULL) {
+            buffer->closed.store(true, std::memory_order_release);
+        }
+    }
+};
+
+static thread_local LogThreadState thread_state;
+
+/**
+ * A log file modified after this process started was written by it, e.g., for an id which was
+ * released and set again, or by a message logged (or written by the writer thread) after its id
+ * was released. These are appended to instead of truncated. The second of slack covers the
+ * filesystem's coarser timestamps.
+ */
+static const int64_t log_start_nanoseconds =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count()
+    - 1000000000;
+
+static bool written_by_this_process(const string& filename) {
+    struct stat file_stat;
+    if (stat(filename.c_str(), &file_stat) != 0) {
+        return false;
+    }
+    int64_t modified = ((int64_t) file_stat.st_mtim.tv_sec * 1000000000) + file_stat.st_mtim.tv_nsec;
+    return modified >= log_start_nanoseconds;
+}
+
 int32_t Log::std_message_level = INFO;
 int32_t Log::file_message_level = INFO;
 bool Log::write_to_file = true;
@@ -30,14 +151,25 @@ int32_t Log::restricted_rank = -1;
 
 string Log::output_directory = "./logs";
 
-map<thread::id, string> Log::log_ids;
-map<string, LogFile*> Log::output_files;
+atomic<bool> Log::async(false);
+bool Log::multiplex = false;
 
+map<string, int32_t> Log::id_indexes;
+vector<LogFile*> Log::id_files;
+vector<int32_t> Log::free_id_indexes;
 shared_mutex Log::log_ids_mutex;
 
-LogFile::LogFile(FILE* _file) {
-    file = _file;
-}
+FILE* Log::multiplexed_file = NULL;
+mutex Log::multiplexed_mutex;
+
+vector<LogBuffer*> Log::buffers;
+mutex Log::buffers_mutex;
+thread Log::writer_thread;
+mutex Log::writer_mutex;
+condition_variable Log::writer_condition;
+condition_variable Log::flushed_condition;
+bool Log::writer_stopping = false;
+uint64_t Log::writer_passes = 0;
 
 void Log::register_command_line_arguments() {
     // CommandLine::create_group("Log", "");
@@ -94,6 +226,16 @@ void Log::initialize(const vector<string>& arguments) {
     get_argument(arguments, "--max_message_length", false, max_message_length);
 
     mkpath(output_directory.c_str(), 0777);
+
+    multiplex = argument_exists(arguments, "--multiplex_logs");
+
+    if (argument_exists(arguments, "--async_log") && !async) {
+        writer_stopping = false;
+        writer_thread = thread(&Log::run_writer);
+        async = true;
+        // write out anything still queued when the program exits
+        atexit(&Log::shutdown);
+    }
 }
 
 void Log::set_rank(int32_t _process_rank) {
@@ -109,46 +251,94 @@ void Log::clear_rank_restriction() {
 }
 
 void Log::set_id(string human_readable_id) {
-    thread::id id = std::this_thread::get_id();
+    log_ids_mutex.lock();
 
-    // cerr << "setting thread id " << id << " to human readable id: '" << human_readable_id << "'" << endl;
+    int32_t id_index;
+    map<string, int32_t>::iterator it = id_indexes.find(human_readable_id);
+    if (it != id_indexes.end()) {
+        id_index = it->second;
+    } else {
+        if (free_id_indexes.size() > 0) {
+            id_index = free_id_indexes.back();
+            free_id_indexes.pop_back();
+        } else {
+            id_index = id_files.size();
+            id_files.push_back(new LogFile());
+        }
 
-    log_ids_mutex.lock();
+        LogFile* log_file = id_files[id_index];
+        log_file->file_mutex.lock();
+        log_file->name = human_readable_id;
+        log_file->file_mutex.unlock();
 
-    log_ids[id] = human_readable_id;
+        id_indexes[human_readable_id] = id_index;
+    }
+    thread_state.id_index = id_index;
+    thread_state.log_file = id_files[id_index];
+    thread_state.generation = thread_state.log_file->generation.load(std::memory_order_relaxed);
 
     log_ids_mutex.unlock();
+
+    thread_state.id_name = human_readable_id;
 }
 
 void Log::release_id(string human_readable_id) {
-    // cerr << "locking thread from human readable id: '" << human_readable_id << "'" << endl;
-    log_ids_mutex.lock();
-    // cerr << "releasing thread from human readable id: '" << human_readable_id << "'" << endl;
-
-    if (output_files.count(human_readable_id) == 0) {
-        // this file was never created and written to
-
-        // cerr << "ERROR: log id '" << human_readable_id << "' was either already released or not previously set!" <<
-        // endl; exit(1);
+    log_ids_mutex.lock_shared();
+    map<string, int32_t>::iterator it = id_indexes.find(human_readable_id);
+    if (it == id_indexes.end()) {
+        // this id was never set, or was already released
+        log_ids_mutex.unlock_shared();
+        return;
+    }
+    int32_t id_index = it->second;
+    LogFile* log_file = id_files[id_index];
+    log_ids_mutex.unlock_shared();
+
+    if (async) {
+        // the file is closed by the writer, after the messages queued before this
+        LogBuffer* buffer = get_thread_buffer();
+        uint64_t head = reserve_entry(buffer);
+
+        LogEntry& entry = buffer->entries[head % LOG_BUFFER_ENTRIES];
+        entry.log_file = log_file;
+        entry.id_index = id_index;
+        entry.message_level = NONE;
+        entry.destinations = LOG_RELEASE_ID;
+        entry.length = 0;
+        buffer->head.store(head + 1, std::memory_order_release);
     } else {
-        LogFile* log_file = output_files[human_readable_id];
-        fflush(log_file->file);
-        fclose(log_file->file);
+        close_file(log_file, id_index);
+    }
+}
 
-        delete log_file;
-        output_files.erase(human_readable_id);
+LogBuffer* Log::get_thread_buffer() {
+    if (thread_state.buffer == NULL) {
+        thread_state.buffer = new LogBuffer(max_header_length + max_message_length);
+
+        lock_guard<mutex> lock(buffers_mutex);
+        buffers.push_back(thread_state.buffer);
     }
+    return thread_state.buffer;
+}
 
-    log_ids_mutex.unlock();
+uint64_t Log::reserve_entry(LogBuffer* buffer) {
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    while (head - buffer->tail.load(std::memory_order_acquire) >= LOG_BUFFER_ENTRIES) {
+        // the writer has fallen behind, so wake it up and wait for it to make room
+        writer_condition.notify_one();
+        std::this_thread::yield();
+    }
+    return head;
 }
 
 void Log::write_message(
-    bool print_header, int8_t message_level, const char* message_type, const char* format, va_list arguments
+    bool print_header, int8_t message_level, const char* message_type, const char* format, ...
 ) {
-    thread::id id = std::this_thread::get_id();
+    va_list arguments;
+    va_start(arguments, format);
 
-    if (log_ids.count(id) == 0) {
-        cerr << "ERROR: could not write message from thread '" << id
+    if (thread_state.id_index < 0) {
+        cerr << "ERROR: could not write message from thread '" << std::this_thread::get_id()
              << "' because it did not have a human readable id assigned (please use the Log::set_id(string) function "
                 "before writing to the Log on any thread)."
              << endl;
@@ -158,248 +348,271 @@ void Log::write_message(
         exit(1);
     }
 
-    string human_readable_id = log_ids[id];
-
-    // print the message header into a string
-    char header_buffer[max_header_length];
-    // we only need to print the header for some messages
-    if (print_header) {
-        // snprintf(header_buffer, max_header_length, "[%-8s %-20s]", message_type, human_readable_id.c_str());
-        snprintf(header_buffer, max_header_length, "[%-7s %-21s]", message_type, human_readable_id.c_str());
+    if (thread_state.log_file->generation.load(std::memory_order_relaxed) != thread_state.generation) {
+        // the id was released (and its slot may be in use by another id), so intern it again
+        set_id(thread_state.id_name);
     }
 
-    // print the actual message contents into a string
-    char message_buffer[max_message_length];
-    vsnprintf(message_buffer, max_message_length, format, arguments);
-
+    int8_t destinations = 0;
     if (std_message_level >= message_level) {
-        if (print_header) {
-            printf("%s %s", header_buffer, message_buffer);
-        } else {
-            printf("%s", message_buffer);
-        }
+        destinations |= LOG_TO_STD;
     }
-
     if (file_message_level >= message_level) {
-        LogFile* log_file = NULL;
-
-        // check and see if we've already opened a file for this human readable id, if we haven't
-        // open a new one for it
-
-        if (output_files.count(human_readable_id) == 0) {
-            string output_filename = output_directory + "/" + human_readable_id;
-            FILE* outfile = fopen(output_filename.c_str(), "w");
-            log_file = new LogFile(outfile);
-            output_files[human_readable_id] = log_file;
-        } else {
-            log_file = output_files[human_readable_id];
-        }
-
-        // lock this log_file in case multiple threads are trying to write
-        // to the same file
-        log_file->file_mutex.lock();
-        if (print_header) {
-            fprintf(log_file->file, "%s %s", header_buffer, message_buffer);
-        } else {
-            fprintf(log_file->file, "%s", message_buffer);
-        }
-        fflush(log_file->file);
-        log_file->file_mutex.unlock();
-    }
-}
-
-bool Log::at_level(int8_t level) {
-    return level >= std_message_level || level >= file_message_level;
-}
-
-void Log::fatal(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
-        return;
+        destinations |= LOG_TO_FILE;
     }
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < FATAL && file_message_level < FATAL) {
-        return;
+    LogBuffer* buffer = NULL;
+    uint64_t head = 0;
+    char* text;
+    if (async) {
+        // the message is formatted straight into the ring buffer
+        buffer = get_thread_buffer();
+        head = reserve_entry(buffer);
+        text = &buffer->text[(head % LOG_BUFFER_ENTRIES) * buffer->entry_length];
+    } else {
+        thread_state.text.resize(max_header_length + max_message_length);
+        text = &thread_state.text[0];
     }
 
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(true, FATAL, "FATAL", format, arguments);
-}
-
-void Log::error(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
-        return;
+    int32_t length = 0;
+    // we only need to print the header for some messages
+    if (print_header) {
+        length = snprintf(text, max_header_length, "[%-7s %-21s]", message_type, thread_state.id_name.c_str());
+        length = max(0, min(length, max_header_length - 1));
+        text[length++] = ' ';
     }
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < ERROR && file_message_level < ERROR) {
-        return;
+    // print the actual message contents
+    int32_t message_length = vsnprintf(text + length, max_message_length, format, arguments);
+    va_end(arguments);
+    length += max(0, min(message_length, max_message_length - 1));
+
+    if (async) {
+        LogEntry& entry = buffer->entries[head % LOG_BUFFER_ENTRIES];
+        entry.log_file = thread_state.log_file;
+        entry.id_index = thread_state.id_index;
+        entry.message_level = message_level;
+        entry.destinations = destinations;
+        entry.length = length;
+        buffer->head.store(head + 1, std::memory_order_release);
+
+        // don't make errors wait for the writer's next pass
+        if (message_level <= ERROR) {
+            writer_condition.notify_one();
+        }
+    } else {
+        write_entry(thread_state.log_file, thread_state.id_index, message_level, destinations, text, length, true);
     }
-
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(true, ERROR, "ERROR", format, arguments);
 }
 
-void Log::warning(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
-        return;
+void Log::write_entry(
+    LogFile* log_file, int32_t id_index, int8_t message_level, int8_t destinations, const char* text, int32_t length,
+    bool flush
+) {
+    if (destinations & LOG_TO_STD) {
+        // stdio locks stdout for each call, so messages from different threads are not interleaved
+        fwrite(text, 1, length, stdout);
+        if (flush) {
+            fflush(stdout);
+        }
     }
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < WARNING && file_message_level < WARNING) {
+    if (!(destinations & LOG_TO_FILE)) {
         return;
     }
 
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(true, WARNING, "WARNING", format, arguments);
-}
+    if (multiplex) {
+        lock_guard<mutex> lock(multiplexed_mutex);
+        if (multiplexed_file == NULL) {
+            string output_filename = output_directory + "/log.bin";
+            multiplexed_file = fopen(output_filename.c_str(), "wb");
+            if (multiplexed_file == NULL) {
+                cerr << "ERROR: could not open multiplexed log file '" << output_filename << "'" << endl;
+                exit(1);
+            }
+
+            int32_t version = LOG_MULTIPLEXED_VERSION;
+            fwrite(LOG_MULTIPLEXED_MAGIC, 1, 8, multiplexed_file);
+            fwrite(&version, sizeof(int32_t), 1, multiplexed_file);
+        }
 
-void Log::info(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
-        return;
-    }
+        if (!log_file->multiplexed) {
+            // slots are not reused when multiplexing, so the name can't change
+            int8_t record_type = LOG_RECORD_ID;
+            int32_t name_length = log_file->name.size();
+            fwrite(&record_type, sizeof(int8_t), 1, multiplexed_file);
+            fwrite(&id_index, sizeof(int32_t), 1, multiplexed_file);
+            fwrite(&name_length, sizeof(int32_t), 1, multiplexed_file);
+            fwrite(log_file->name.c_str(), 1, name_length, multiplexed_file);
+            log_file->multiplexed = true;
+        }
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < INFO && file_message_level < INFO) {
+        int8_t record_type = LOG_RECORD_MESSAGE;
+        fwrite(&record_type, sizeof(int8_t), 1, multiplexed_file);
+        fwrite(&id_index, sizeof(int32_t), 1, multiplexed_file);
+        fwrite(&message_level, sizeof(int8_t), 1, multiplexed_file);
+        fwrite(&length, sizeof(int32_t), 1, multiplexed_file);
+        fwrite(text, 1, length, multiplexed_file);
+        if (flush) {
+            fflush(multiplexed_file);
+        }
         return;
     }
 
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(true, INFO, "INFO", format, arguments);
-}
+    lock_guard<mutex> lock(log_file->file_mutex);
 
-void Log::debug(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
-        return;
+    // open a file for this human readable id if there isn't one already
+    if (log_file->file == NULL) {
+        string output_filename = output_directory + "/" + log_file->name;
+        log_file->file = fopen(output_filename.c_str(), written_by_this_process(output_filename) ? "a" : "w");
+        if (log_file->file == NULL) {
+            cerr << "ERROR: could not open log file '" << output_filename << "'" << endl;
+            return;
+        }
     }
-
-    // not writing this type of message to either std out or a file
-    if (std_message_level < DEBUG && file_message_level < DEBUG) {
-        return;
+    fwrite(text, 1, length, log_file->file);
+    if (flush) {
+        fflush(log_file->file);
     }
-
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(true, DEBUG, "DEBUG", format, arguments);
 }
 
-void Log::trace(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
-        return;
+void Log::close_file(LogFile* log_file, int32_t id_index) {
+    log_file->file_mutex.lock();
+    if (log_file->file != NULL) {
+        fclose(log_file->file);
+        log_file->file = NULL;
     }
+    log_file->file_mutex.unlock();
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < TRACE && file_message_level < TRACE) {
+    if (multiplex) {
+        // the multiplexed log refers to the id by its index, so it can't be given to another id
         return;
     }
 
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(true, TRACE, "TRACE", format, arguments);
+    log_ids_mutex.lock();
+    map<string, int32_t>::iterator it = id_indexes.find(log_file->name);
+    if (it != id_indexes.end() && it->second == id_index) {
+        id_indexes.erase(it);
+        log_file->generation.fetch_add(1, std::memory_order_relaxed);
+        free_id_indexes.push_back(id_index);
+    }
+    log_ids_mutex.unlock();
 }
 
-void Log::fatal_no_header(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
-        return;
-    }
+void Log::drain_buffers() {
+    vector<LogBuffer*> current_buffers;
+    buffers_mutex.lock();
+    current_buffers = buffers;
+    buffers_mutex.unlock();
+
+    vector<LogBuffer*> closed_buffers;
+
+    // only the writer thread drains the buffers, so messages are written in the order they were queued
+    for (int32_t i = 0; i < (int32_t) current_buffers.size(); i++) {
+        LogBuffer* buffer = current_buffers[i];
+
+        // if the thread had exited before reading head, nothing can be added after it
+        bool closed = buffer->closed.load(std::memory_order_acquire);
+        uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+
+        for (; tail < head; tail++) {
+            LogEntry& entry = buffer->entries[tail % LOG_BUFFER_ENTRIES];
+            if (entry.destinations & LOG_RELEASE_ID) {
+                close_file(entry.log_file, entry.id_index);
+            } else {
+                const char* text = &buffer->text[(tail % LOG_BUFFER_ENTRIES) * buffer->entry_length];
+                write_entry(
+                    entry.log_file, entry.id_index, entry.message_level, entry.destinations, text, entry.length, false
+                );
+            }
+            buffer->tail.store(tail + 1, std::memory_order_release);
+        }
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < FATAL && file_message_level < FATAL) {
-        return;
+        if (closed) {
+            closed_buffers.push_back(buffer);
+        }
+    }
+    // flush once per pass rather than once per message
+    fflush(NULL);
+
+    if (closed_buffers.size() > 0) {
+        buffers_mutex.lock();
+        for (int32_t i = 0; i < (int32_t) closed_buffers.size(); i++) {
+            buffers.erase(find(buffers.begin(), buffers.end(), closed_buffers[i]));
+            delete closed_buffers[i];
+        }
+        buffers_mutex.unlock();
     }
-
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(false, FATAL, "FATAL", format, arguments);
 }
 
-void Log::error_no_header(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
-        return;
-    }
+void Log::run_writer() {
+    unique_lock<mutex> lock(writer_mutex);
+    while (true) {
+        bool stopping = writer_stopping;
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < ERROR && file_message_level < ERROR) {
-        return;
-    }
+        lock.unlock();
+        drain_buffers();
+        lock.lock();
 
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(false, ERROR, "ERROR", format, arguments);
-}
-
-void Log::warning_no_header(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
-        return;
-    }
+        writer_passes++;
+        flushed_condition.notify_all();
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < WARNING && file_message_level < WARNING) {
-        return;
+        if (stopping) {
+            break;
+        }
+        writer_condition.wait_for(lock, std::chrono::milliseconds(LOG_WRITER_INTERVAL));
     }
-
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(false, WARNING, "WARNING", format, arguments);
 }
 
-void Log::info_no_header(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
+void Log::flush() {
+    if (!async) {
+        // messages are written as they are logged
         return;
     }
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < INFO && file_message_level < INFO) {
-        return;
+    // the writer may be part way through a pass which missed the latest messages, so wait for
+    // the pass after it
+    unique_lock<mutex> lock(writer_mutex);
+    uint64_t target_passes = writer_passes + 2;
+    while (writer_passes < target_passes && !writer_stopping) {
+        writer_condition.notify_one();
+        flushed_condition.wait(lock);
     }
-
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(false, INFO, "INFO", format, arguments);
 }
 
-void Log::debug_no_header(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
+void Log::shutdown() {
+    if (!async) {
         return;
     }
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < DEBUG && file_message_level < DEBUG) {
-        return;
-    }
+    writer_mutex.lock();
+    writer_stopping = true;
+    writer_mutex.unlock();
+    writer_condition.notify_one();
+    writer_thread.join();
 
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(false, DEBUG, "DEBUG", format, arguments);
-}
+    async = false;
 
-void Log::trace_no_header(const char* format, ...) {
-    // don't write if this is the wrong process rank
-    if (restricted_rank >= 0 && restricted_rank != process_rank) {
-        return;
+    log_ids_mutex.lock_shared();
+    vector<LogFile*> log_files = id_files;
+    log_ids_mutex.unlock_shared();
+
+    for (int32_t i = 0; i < (int32_t) log_files.size(); i++) {
+        lock_guard<mutex> lock(log_files[i]->file_mutex);
+        if (log_files[i]->file != NULL) {
+            fclose(log_files[i]->file);
+            log_files[i]->file = NULL;
+        }
     }
 
-    // not writing this type of message to either std out or a file
-    if (std_message_level < TRACE && file_message_level < TRACE) {
-        return;
+    lock_guard<mutex> lock(multiplexed_mutex);
+    if (multiplexed_file != NULL) {
+        fclose(multiplexed_file);
+        multiplexed_file = NULL;
     }
+}
 
-    va_list arguments;
-    va_start(arguments, format);
-    write_message(false, TRACE, "TRACE", format, arguments);
+bool Log::at_level(int8_t level) {
+    return level >= std_message_level || level >= file_message_level;
 }
@@ -1,6 +1,12 @@
 #ifndef EXONA_LOG
 #define EXONA_LOG
 
+#include <atomic>
+using std::atomic;
+
+#include <condition_variable>
+using std::condition_variable;
+
 #include <cstdio>
 #include <iostream>
 using std::ofstream;
@@ -23,16 +29,35 @@ using std::thread;
 #include <vector>
 using std::vector;
 
-class LogFile {
-   private:
-    FILE* file;
-    mutex file_mutex;
-
-   public:
-    LogFile(FILE* file);
+/**
+ * The formatting and writing of messages above this level (along with their level checks) are
+ * removed at compile time. Their arguments are still evaluated at the call site, so an expensive
+ * argument in an inner loop should be guarded with if constexpr (Log::DEBUG <= EXAMM_LOG_LEVEL).
+ * It can be set with cmake, e.g., -DLOG_LEVEL=4 keeps up to INFO.
+ */
+#ifndef EXAMM_LOG_LEVEL
+#define EXAMM_LOG_LEVEL 7
+#endif
 
-    friend class Log;
-};
+/**
+ * The multiplexed log is a single binary file holding the messages of every log id. It starts
+ * with the magic number and version, followed by records which start with a type byte:
+ *  - LOG_RECORD_ID: int32 id index, int32 length and the human readable id
+ *  - LOG_RECORD_MESSAGE: int32 id index, int8 message level, int32 length and the message
+ * An id record is written before the first message with that id.
+ */
+#define LOG_MULTIPLEXED_MAGIC   "EXAMMLOG"
+#define LOG_MULTIPLEXED_VERSION 1
+#define LOG_RECORD_ID           0
+#define LOG_RECORD_MESSAGE      1
+
+/**
+ * The number of messages each thread can have waiting to be written when logging asynchronously.
+ */
+#define LOG_BUFFER_ENTRIES 256
+
+class LogBuffer;
+class LogFile;
 
 class Log {
    private:
@@ -70,14 +95,6 @@ class Log {
      */
     static string output_directory;
 
-    /**
-     * A map of C++ thread ids (which are not human readable) to human
-     * readable integer ids.
-     * Thread ids are specified with the Log::set_id(string)
-     * method.
-     */
-    static map<thread::id, string> log_ids;
-
     /**
      *  The MPI process rank for this Log instance. Set to -1 if not specified or not using MPI.
      */
@@ -90,32 +107,121 @@ class Log {
     static int32_t restricted_rank;
 
     /**
-     * A map of human readable ids to output files which the log messages
-     * will be written to.
+     * If true, messages are copied into a ring buffer for each thread and written by a background
+     * thread, instead of being written (and flushed) by the thread logging them.
      */
-    static map<string, LogFile*> output_files;
+    static atomic<bool> async;
 
     /**
-     * A std::shared_mutex protecting the Log::thread_ids map.
-     * The Log::set_thread_id(int32_t) mehod needs write access so it will use the std::shared_mutex::lock()x and
-     * std::shared_mutex()::unlock() mechanism, while the Log::get_thread_id() only needs read access and can used the
-     * std::shared_mutex::lock_shared() and std::shared_mutex::unlock_shared() methods.
+     * If true, the messages for every log id are written to a single binary file (see
+     * LOG_MULTIPLEXED_MAGIC) instead of a file for each id.
+     */
+    static bool multiplex;
+
+    /**
+     * Human readable ids are interned when they are set, so a thread only needs its id's log file
+     * (which is cached thread locally) to log a message. When logs are not multiplexed, releasing
+     * an id frees its slot for the next new id, so the number of slots is bounded by the number of
+     * ids in use at once rather than growing with every genome's id.
+     */
+    static map<string, int32_t> id_indexes;
+    static vector<LogFile*> id_files;
+    static vector<int32_t> free_id_indexes;
+
+    /**
+     * A std::shared_mutex protecting the interned ids, Log::set_id(string) and releasing an id need
+     * to write to them while the writers only need to read them.
      */
     static shared_mutex log_ids_mutex;
 
     /**
-     * Potentially writes the message to either standard output or the log file if the message level is high enough.
+     * The single multiplexed log file and the lock for writing to it. Each id's own file is locked
+     * with its LogFile's mutex, so threads with different ids don't wait on each other.
+     */
+    static FILE* multiplexed_file;
+    static mutex multiplexed_mutex;
+
+    /**
+     * The ring buffers of every thread which has logged asynchronously, and the thread which
+     * writes their messages.
+     */
+    static vector<LogBuffer*> buffers;
+    static mutex buffers_mutex;
+    static thread writer_thread;
+    static mutex writer_mutex;
+    static condition_variable writer_condition;
+    static condition_variable flushed_condition;
+    static bool writer_stopping;
+    static uint64_t writer_passes;
+
+    /**
+     * \return true if a message of the given level would be written to either standard output or a file
+     */
+    static bool is_enabled(int8_t message_level) {
+        // don't write if this is the wrong process rank
+        if (restricted_rank >= 0 && restricted_rank != process_rank) {
+            return false;
+        }
+        return std_message_level >= message_level || file_message_level >= message_level;
+    }
+
+    /**
+     * Checks a message's level (at compile time and then at run time) before formatting and
+     * writing it, so disabled messages skip the formatting. The arguments have already been
+     * evaluated by the caller.
+     */
+    template <int8_t message_level, typename... Arguments>
+    static void log(bool print_header, const char* message_type, const char* format, Arguments... arguments) {
+        if constexpr (message_level <= EXAMM_LOG_LEVEL) {
+            if (is_enabled(message_level)) {
+                write_message(print_header, message_level, message_type, format, arguments...);
+            }
+        }
+    }
+
+    /**
+     * Formats the message and either writes it or queues it for the writer thread.
      *
      * \param print_header specifies if the header to the message should be printed out
      * \param message_level the level of the message to potentially be printed out
      * \param message_type a string representation of this message type
-     * \param message_type the format string for this message (as in printf)
-     * \param arguments the arguments for the print statement
+     * \param format the format string for this message (as in printf), followed by its arguments
      */
     static void write_message(
-        bool print_header, int8_t message_level, const char* message_type, const char* format, va_list arguments
+        bool print_header, int8_t message_level, const char* message_type, const char* format, ...
     );
 
+    /**
+     * Writes a formatted message to standard output and/or the log file for its id.
+     *
+     * \param flush if true, the streams written to are flushed
+     */
+    static void write_entry(
+        LogFile* log_file, int32_t id_index, int8_t message_level, int8_t destinations, const char* text,
+        int32_t length, bool flush
+    );
+
+    /**
+     * Closes the log file for an id and, if logs are not multiplexed, frees its slot.
+     */
+    static void close_file(LogFile* log_file, int32_t id_index);
+
+    /**
+     * \return the calling thread's ring buffer, which is created the first time the thread logs
+     */
+    static LogBuffer* get_thread_buffer();
+
+    /**
+     * Waits until the buffer has room for another message.
+     *
+     * \return the position of the free entry, which is given to the writer by advancing the buffer's head past it
+     */
+    static uint64_t reserve_entry(LogBuffer* buffer);
+
+    static void run_writer();
+    static void drain_buffers();
+    static void shutdown();
+
    public:
     static const int8_t NONE = 0;    /**< Specifies no messages will be logged. */
     static const int8_t FATAL = 1;   /**< Specifies only fatal messages will be logged. */
@@ -171,12 +277,8 @@ class Log {
     /**
      * Sets a human readable thread id for this thread.
      *
-     * This will use std::this_thread::get_id() to get c++'s automatically
-     * generated thread id, and then put it in the Log::thread_ids map, so
-     * it can be used to write cleaner logs.
-     *
-     * This will report an error and exit if another thread has already
-     * reserved this human readable id.
+     * The id is interned and cached thread locally, so messages from this
+     * thread don't need to look it up.
      *
      * \param human_readable_id a human readable thread id
      */
@@ -186,9 +288,9 @@ class Log {
      * Releases a the human readable thread id previously set
      * by by the provided human readable id;
      *
-     * This will report an error and exit if this human readable id
-     * has not already been set, or if it has been relased by another
-     * thread.
+     * This closes the log file for the id (after any messages still
+     * waiting to be written have been written). If the id is set again,
+     * or a message is logged with it afterwards, its log file is appended to.
      *
      * \param human_readable_id is a human readable thread id which has previously been set with Log::set_id(string)
      */
@@ -204,37 +306,85 @@ class Log {
      */
     static bool at_level(int8_t level);
 
-    static void fatal(const char* format, ...);   /**< Logs a fatal message. varargs are the same as in printf. */
-    static void error(const char* format, ...);   /**< Logs an error message. varargs are the same as in printf. */
-    static void warning(const char* format, ...); /**< Logs a warning message. varargs are the same as in printf. */
-    static void info(const char* format, ...);    /**< Logs an info message. varargs are the same as in printf. */
-    static void debug(const char* format, ...);   /**< Logs a debug message. varargs are the same as in printf. */
-    static void trace(const char* format, ...);   /**< Logs a trace message. varargs are the same as in printf. */
-
-    static void fatal_no_header(
-        const char* format, ...
-    ); /**< Logs a fatal message. Does not print the message header (useful if doing
-          multiple log prints to the same line). varargs are the same as in printf. */
-    static void error_no_header(
-        const char* format, ...
-    ); /**< Logs an error message. Does not print the message header (useful if doing
-          multiple log prints to the same line).  varargs are the same as in printf. */
-    static void warning_no_header(
-        const char* format, ...
-    ); /**< Logs a warning message. Does not print the message header (useful if doing
-          multiple log prints to the same line).  varargs are the same as in printf. */
-    static void info_no_header(
-        const char* format, ...
-    ); /**< Logs an info message. Does not print the message header (useful if doing
-          multiple log prints to the same line).  varargs are the same as in printf. */
-    static void debug_no_header(
-        const char* format, ...
-    ); /**< Logs a debug message. Does not print the message header (useful if doing
-          multiple log prints to the same line).  varargs are the same as in printf. */
-    static void trace_no_header(
-        const char* format, ...
-    ); /**< Logs a trace message. Does not print the message header (useful if doing
-          multiple log prints to the same line).  varargs are the same as in printf. */
+    /**
+     * Waits until every message logged so far has been written, if logging asynchronously.
+     */
+    static void flush();
+
+    /**
+     * Logs a fatal message. Arguments are the same as in printf. When logging asynchronously the
+     * message is written before this returns, as the program is about to exit.
+     */
+    template <typename... Arguments>
+    static void fatal(const char* format, Arguments... arguments) {
+        log<FATAL>(true, "FATAL", format, arguments...);
+        flush();
+    }
+
+    /** Logs an error message. Arguments are the same as in printf. */
+    template <typename... Arguments>
+    static void error(const char* format, Arguments... arguments) {
+        log<ERROR>(true, "ERROR", format, arguments...);
+    }
+
+    /** Logs a warning message. Arguments are the same as in printf. */
+    template <typename... Arguments>
+    static void warning(const char* format, Arguments... arguments) {
+        log<WARNING>(true, "WARNING", format, arguments...);
+    }
+
+    /** Logs an info message. Arguments are the same as in printf. */
+    template <typename... Arguments>
+    static void info(const char* format, Arguments... arguments) {
+        log<INFO>(true, "INFO", format, arguments...);
+    }
+
+    /** Logs a debug message. Arguments are the same as in printf. */
+    template <typename... Arguments>
+    static void debug(const char* format, Arguments... arguments) {
+        log<DEBUG>(true, "DEBUG", format, arguments...);
+    }
+
+    /** Logs a trace message. Arguments are the same as in printf. */
+    template <typename... Arguments>
+    static void trace(const char* format, Arguments... arguments) {
+        log<TRACE>(true, "TRACE", format, arguments...);
+    }
+
+    /**
+     * The *_no_header methods log a message without the message header (useful if doing multiple
+     * log prints to the same line). Arguments are the same as in printf.
+     */
+    template <typename... Arguments>
+    static void fatal_no_header(const char* format, Arguments... arguments) {
+        log<FATAL>(false, "FATAL", format, arguments...);
+        flush();
+    }
+
+    template <typename... Arguments>
+    static void error_no_header(const char* format, Arguments... arguments) {
+        log<ERROR>(false, "ERROR", format, arguments...);
+    }
+
+    template <typename... Arguments>
+    static void warning_no_header(const char* format, Arguments... arguments) {
+        log<WARNING>(false, "WARNING", format, arguments...);
+    }
+
+    template <typename... Arguments>
+    static void info_no_header(const char* format, Arguments... arguments) {
+        log<INFO>(false, "INFO", format, arguments...);
+    }
+
+    template <typename... Arguments>
+    static void debug_no_header(const char* format, Arguments... arguments) {
+        log<DEBUG>(false, "DEBUG", format, arguments...);
+    }
+
+    template <typename... Arguments>
+    static void trace_no_header(const char* format, Arguments... arguments) {
+        log<TRACE>(false, "TRACE", format, arguments...);
+    }
 };
 
 #endif
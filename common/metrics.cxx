@@ -0,0 +1,310 @@
+#include <chrono>
+
+#include <cstdio>
+using std::snprintf;
+
+#include <cstdlib>
+
+#include <mutex>
+using std::lock_guard;
+using std::unique_lock;
+
+#include <string>
+using std::to_string;
+
+#include "arguments.hxx"
+#include "files.hxx"
+#include "log.hxx"
+#include "metrics.hxx"
+
+// the upper bounds (in seconds) of the histogram buckets, there is also a final +Inf bucket
+static const double histogram_bounds[] = {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                                          0.05,   0.1,     0.25,   0.5,   1.0,    2.5,   5.0,  10.0,
+                                          25.0,   50.0,    100.0,  250.0, 500.0,  1000.0};
+static const int32_t number_histogram_bounds = sizeof(histogram_bounds) / sizeof(double);
+
+// the id of each thread's track in the trace, assigned the first time the thread records a span
+static thread_local int32_t trace_thread_id = -1;
+
+atomic<bool> Metrics::metrics_enabled(false);
+atomic<bool> Metrics::trace_enabled(false);
+int32_t Metrics::metrics_interval = 10;
+string Metrics::output_directory = "./";
+int32_t Metrics::process_rank = -1;
+
+map<string, MetricCounter*> Metrics::counters;
+map<string, MetricHistogram*> Metrics::histograms;
+mutex Metrics::registry_mutex;
+
+FILE* Metrics::trace_file = NULL;
+mutex Metrics::trace_mutex;
+atomic<int32_t> Metrics::trace_threads(0);
+
+thread Metrics::exporter_thread;
+mutex Metrics::exporter_mutex;
+condition_variable Metrics::exporter_condition;
+bool Metrics::exporter_stopping = false;
+
+MetricCounter::MetricCounter(string _name, string _help) : name(_name), help(_help), value(0) {
+}
+
+void MetricCounter::increment(int64_t amount) {
+    value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+void MetricCounter::write_prometheus(string& output) {
+    output += "# HELP " + name + " " + help + "\n";
+    output += "# TYPE " + name + " counter\n";
+    output += name + " " + to_string(value.load(std::memory_order_relaxed)) + "\n";
+}
+
+MetricHistogram::MetricHistogram(string _name, string _help)
+    : name(_name), help(_help), bucket_counts(number_histogram_bounds + 1, 0), sum(0.0), count(0) {
+}
+
+void MetricHistogram::observe(double seconds) {
+    int32_t bucket = 0;
+    while (bucket < number_histogram_bounds && seconds > histogram_bounds[bucket]) {
+        bucket++;
+    }
+
+    lock_guard<mutex> lock(histogram_mutex);
+    bucket_counts[bucket]++;
+    sum += seconds;
+    count++;
+}
+
+void MetricHistogram::write_prometheus(string& output) {
+    lock_guard<mutex> lock(histogram_mutex);
+
+    output += "# HELP " + name + " " + help + "\n";
+    output += "# TYPE " + name + " histogram\n";
+
+    char line[256];
+    int64_t cumulative_count = 0;
+    for (int32_t i = 0; i < number_histogram_bounds; i++) {
+        cumulative_count += bucket_counts[i];
+        snprintf(
+            line, sizeof(line), "%s_bucket{le=\"%g\"} %ld\n", name.c_str(), histogram_bounds[i],
+            (long) cumulative_count
+        );
+        output += line;
+    }
+    snprintf(line, sizeof(line), "%s_bucket{le=\"+Inf\"} %ld\n", name.c_str(), (long) count);
+    output += line;
+    snprintf(line, sizeof(line), "%s_sum %.9g\n", name.c_str(), sum);
+    output += line;
+    snprintf(line, sizeof(line), "%s_count %ld\n", name.c_str(), (long) count);
+    output += line;
+}
+
+void Metrics::initialize(const vector<string>& arguments) {
+    metrics_enabled = argument_exists(arguments, "--metrics");
+    trace_enabled = argument_exists(arguments, "--trace");
+    get_argument(arguments, "--metrics_interval", false, metrics_interval);
+    get_argument(arguments, "--output_directory", false, output_directory);
+
+    if (!metrics_enabled && !trace_enabled) {
+        return;
+    }
+
+    if (metrics_interval <= 0) {
+        Log::fatal("ERROR: --metrics_interval must be > 0, was %d\n", metrics_interval);
+        exit(1);
+    }
+
+    mkpath(output_directory.c_str(), 0777);
+
+    if (metrics_enabled) {
+        exporter_stopping = false;
+        exporter_thread = thread(&Metrics::run_exporter);
+    }
+    // write out the final metrics and finish the trace when the program exits
+    atexit(&Metrics::shutdown);
+}
+
+void Metrics::set_rank(int32_t _process_rank) {
+    process_rank = _process_rank;
+}
+
+bool Metrics::is_enabled() {
+    return metrics_enabled || trace_enabled;
+}
+
+string Metrics::get_filename(string name, string extension) {
+    if (process_rank >= 0) {
+        name.append("_").append(to_string(process_rank));
+    }
+    return output_directory + "/" + name + extension;
+}
+
+MetricCounter* Metrics::get_counter(string name, string help) {
+    lock_guard<mutex> lock(registry_mutex);
+    MetricCounter*& counter = counters[name];
+    if (counter == NULL) {
+        counter = new MetricCounter(name, help);
+    }
+    return counter;
+}
+
+MetricHistogram* Metrics::get_histogram(string name, string help) {
+    lock_guard<mutex> lock(registry_mutex);
+    MetricHistogram*& histogram = histograms[name];
+    if (histogram == NULL) {
+        histogram = new MetricHistogram(name, help);
+    }
+    return histogram;
+}
+
+void Metrics::increment(string name, string help, int64_t amount) {
+    if (metrics_enabled) {
+        get_counter(name, help)->increment(amount);
+    }
+}
+
+int64_t Metrics::now_microseconds() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch()
+    )
+        .count();
+}
+
+void Metrics::trace_span(const char* name, int64_t start_microseconds, int64_t end_microseconds) {
+    if (!trace_enabled) {
+        return;
+    }
+
+    if (trace_thread_id < 0) {
+        trace_thread_id = trace_threads.fetch_add(1);
+    }
+    int32_t pid = process_rank >= 0 ? process_rank : 0;
+
+    lock_guard<mutex> lock(trace_mutex);
+    if (!trace_enabled) {
+        // tracing was stopped while waiting for the lock, so the trace file must not be reopened
+        return;
+    }
+
+    if (trace_file == NULL) {
+        string trace_filename = get_filename("trace", ".json");
+        trace_file = fopen(trace_filename.c_str(), "w");
+        if (trace_file == NULL) {
+            Log::error("could not open trace file: '%s', not tracing\n", trace_filename.c_str());
+            trace_enabled = false;
+            return;
+        }
+
+        // the closing ] is optional in the trace event format, so the trace is still readable if
+        // the program is killed before it is written
+        fprintf(trace_file, "[\n");
+        string process_name = "examm";
+        if (process_rank == 0) {
+            process_name = "master";
+        } else if (process_rank > 0) {
+            process_name = "worker " + to_string(process_rank);
+        }
+        fprintf(
+            trace_file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}", pid,
+            process_name.c_str()
+        );
+    }
+
+    fprintf(
+        trace_file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%ld,\"dur\":%ld}", name, pid,
+        trace_thread_id, (long) start_microseconds, (long) (end_microseconds - start_microseconds)
+    );
+}
+
+void Metrics::write_metrics() {
+    string output;
+
+    registry_mutex.lock();
+    for (auto it = counters.begin(); it != counters.end(); it++) {
+        it->second->write_prometheus(output);
+    }
+    for (auto it = histograms.begin(); it != histograms.end(); it++) {
+        it->second->write_prometheus(output);
+    }
+    registry_mutex.unlock();
+
+    // write to a temporary file and rename it so anything scraping the file never sees a partial export
+    string metrics_filename = get_filename("metrics", ".prom");
+    string temporary_filename = metrics_filename + ".tmp";
+
+    FILE* metrics_file = fopen(temporary_filename.c_str(), "w");
+    if (metrics_file == NULL) {
+        Log::error("could not open metrics file: '%s'\n", temporary_filename.c_str());
+        return;
+    }
+    bool written = fwrite(output.data(), 1, output.size(), metrics_file) == output.size();
+    written = (fclose(metrics_file) == 0) && written;
+
+    if (!written || rename(temporary_filename.c_str(), metrics_filename.c_str()) != 0) {
+        Log::error("could not write metrics file: '%s'\n", metrics_filename.c_str());
+        remove(temporary_filename.c_str());
+    }
+}
+
+void Metrics::run_exporter() {
+    unique_lock<mutex> lock(exporter_mutex);
+    while (!exporter_stopping) {
+        exporter_condition.wait_for(lock, std::chrono::seconds(metrics_interval));
+
+        lock.unlock();
+        write_metrics();
+        lock.lock();
+    }
+}
+
+void Metrics::shutdown() {
+    if (metrics_enabled) {
+        exporter_mutex.lock();
+        exporter_stopping = true;
+        exporter_mutex.unlock();
+        exporter_condition.notify_one();
+        // the exporter writes the final metrics before it stops
+        exporter_thread.join();
+        metrics_enabled = false;
+    }
+
+    lock_guard<mutex> lock(trace_mutex);
+    if (trace_file != NULL) {
+        fprintf(trace_file, "\n]\n");
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+    trace_enabled = false;
+}
+
+MetricTimer::MetricTimer(string histogram_name, string help, const char* _span_name)
+    : histogram(NULL), span_name(_span_name), start_microseconds(0), stopped(true) {
+    if (Metrics::is_enabled()) {
+        histogram = Metrics::get_histogram(histogram_name, help);
+        start_time = std::chrono::steady_clock::now();
+        start_microseconds = Metrics::now_microseconds();
+        stopped = false;
+    }
+}
+
+MetricTimer::~MetricTimer() {
+    stop();
+}
+
+double MetricTimer::stop() {
+    if (stopped) {
+        return 0.0;
+    }
+    stopped = true;
+
+    int64_t duration_microseconds =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    double seconds = duration_microseconds / 1000000.0;
+    histogram->observe(seconds);
+
+    if (span_name != NULL) {
+        // the span starts at the wall clock time so it lines up with other processes, but its
+        // length is the steady clock duration
+        Metrics::trace_span(span_name, start_microseconds, start_microseconds + duration_microseconds);
+    }
+    return seconds;
+}
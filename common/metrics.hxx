@@ -0,0 +1,200 @@
+#ifndef EXAMM_METRICS_HXX
+#define EXAMM_METRICS_HXX
+
+#include <atomic>
+using std::atomic;
+
+#include <chrono>
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <cstdio>
+
+#include <map>
+using std::map;
+
+#include <mutex>
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+/**
+ * A count of events (e.g., genomes inserted) which only increases.
+ */
+class MetricCounter {
+   private:
+    string name;
+    string help;
+    atomic<int64_t> value;
+
+   public:
+    MetricCounter(string _name, string _help);
+
+    void increment(int64_t amount = 1);
+
+    /**
+     * Writes the counter in the Prometheus text format.
+     */
+    void write_prometheus(string& output);
+};
+
+/**
+ * The distribution of a duration (in seconds), counted in fixed buckets from 100 microseconds
+ * to 1000 seconds along with their sum, so the export is the same as a Prometheus histogram.
+ */
+class MetricHistogram {
+   private:
+    string name;
+    string help;
+
+    mutex histogram_mutex;
+    vector<int64_t> bucket_counts;
+    double sum;
+    int64_t count;
+
+   public:
+    MetricHistogram(string _name, string _help);
+
+    void observe(double seconds);
+
+    /**
+     * Writes the histogram (with cumulative buckets) in the Prometheus text format.
+     */
+    void write_prometheus(string& output);
+};
+
+/**
+ * An in process registry of counters and histograms for EXAMM runs, which is written to
+ * output_directory/metrics.prom (in the Prometheus text format) every --metrics_interval
+ * seconds when --metrics is given. With --trace, timed spans are also written to
+ * output_directory/trace.json in the Chrome trace event format (viewable with chrome://tracing
+ * or Perfetto), with a process for each MPI rank and a track for each thread.
+ *
+ * When using MPI each rank writes its own files, named with the rank (e.g., metrics_3.prom).
+ */
+class Metrics {
+   private:
+    /**
+     * Read without a lock by every thread recording a metric or span, and cleared when a trace
+     * file can't be opened or at shutdown.
+     */
+    static atomic<bool> metrics_enabled;
+    static atomic<bool> trace_enabled;
+    static int32_t metrics_interval;
+    static string output_directory;
+    static int32_t process_rank;
+
+    static map<string, MetricCounter*> counters;
+    static map<string, MetricHistogram*> histograms;
+    static mutex registry_mutex;
+
+    static FILE* trace_file;
+    static mutex trace_mutex;
+    static atomic<int32_t> trace_threads;
+
+    static thread exporter_thread;
+    static mutex exporter_mutex;
+    static condition_variable exporter_condition;
+    static bool exporter_stopping;
+
+    /**
+     * \return the output filename for this process, with its rank appended if using MPI
+     */
+    static string get_filename(string name, string extension);
+
+    static void run_exporter();
+    static void shutdown();
+
+   public:
+    /**
+     * Reads --metrics, --metrics_interval, --trace and --output_directory and starts the thread
+     * which periodically writes out the metrics.
+     */
+    static void initialize(const vector<string>& arguments);
+
+    /**
+     * Sets the MPI process rank, which is used in the output filenames and as the trace's
+     * process id. Must be called before any metrics are written.
+     */
+    static void set_rank(int32_t _process_rank);
+
+    /**
+     * \return true if either metrics or traces are being recorded
+     */
+    static bool is_enabled();
+
+    /**
+     * \return the counter with the given name, which is created the first time it is used
+     */
+    static MetricCounter* get_counter(string name, string help);
+
+    /**
+     * \return the histogram with the given name, which is created the first time it is used
+     */
+    static MetricHistogram* get_histogram(string name, string help);
+
+    /**
+     * Increments a counter, if metrics are enabled.
+     */
+    static void increment(string name, string help, int64_t amount = 1);
+
+    /**
+     * Records a completed span on the calling thread's track, if tracing is enabled.
+     *
+     * \param name is the name of the span shown in the trace
+     * \param start_microseconds is when the span started (from Metrics::now_microseconds())
+     * \param end_microseconds is when the span ended (from Metrics::now_microseconds())
+     */
+    static void trace_span(const char* name, int64_t start_microseconds, int64_t end_microseconds);
+
+    /**
+     * \return the wall clock time in microseconds, so spans from different processes line up. Only
+     * used for trace timestamps, durations are measured with std::chrono::steady_clock so they
+     * aren't skewed when the wall clock is adjusted.
+     */
+    static int64_t now_microseconds();
+
+    /**
+     * Writes all the counters and histograms to the metrics file.
+     */
+    static void write_metrics();
+};
+
+/**
+ * Times a scope, recording its duration in a histogram and (if tracing) as a span when it is
+ * stopped or goes out of scope.
+ */
+class MetricTimer {
+   private:
+    MetricHistogram* histogram;
+    const char* span_name;
+    std::chrono::steady_clock::time_point start_time;
+    int64_t start_microseconds;
+    bool stopped;
+
+   public:
+    /**
+     * \param histogram_name is the name of the histogram to record the duration in
+     * \param help is the description of the histogram used in the export
+     * \param _span_name is the name of the span in the trace, or NULL to not trace it
+     */
+    MetricTimer(string histogram_name, string help, const char* _span_name = NULL);
+    ~MetricTimer();
+
+    /**
+     * Records the duration, the timer will not record anything after this.
+     *
+     * \return the duration in seconds
+     */
+    double stop();
+};
+
+#endif
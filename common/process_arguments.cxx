@@ -24,6 +24,14 @@ EXAMM* generate_examm_from_arguments(
     get_argument_vector(arguments, "--possible_node_types", false, possible_node_types);
     string save_genome_option = "all_best_genomes";
     get_argument(arguments, "--save_genome_option", false, save_genome_option);
+    string resume_from = "";
+    get_argument(arguments, "--resume_from", false, resume_from);
+    int32_t checkpoint_interval = 0;
+    get_argument(arguments, "--checkpoint_interval", false, checkpoint_interval);
+    string checkpoint_file = output_directory + "/examm_checkpoint.bin";
+    get_argument(arguments, "--checkpoint_file", false, checkpoint_file);
+    int32_t seed = -1;
+    get_argument(arguments, "--seed", false, seed);
 
     Log::info(
         "Setting up examm with %d islands, island size %d, and max_genome %d\n", number_islands, island_size,
@@ -57,11 +65,14 @@ EXAMM* generate_examm_from_arguments(
 
     EXAMM* examm = new EXAMM(
         island_size, number_islands, max_genomes, speciation_strategy, weight_rules, genome_property, output_directory,
-        save_genome_option
+        save_genome_option, resume_from, seed
     );
     if (possible_node_types.size() > 0) {
         examm->set_possible_node_types(possible_node_types);
     }
+    if (checkpoint_interval > 0) {
+        examm->set_checkpointing(checkpoint_file, checkpoint_interval);
+    }
 
     return examm;
 }
@@ -204,6 +215,48 @@ void get_train_validation_data(
     Log::info("Generating time series data finished! \n");
 }
 
+/**
+ * The same data as get_train_validation_data, except the sequences are windows over the exported series
+ * instead of copies of them. The windows start every --train_sequence_stride (or --validation_sequence_stride)
+ * rows, which defaults to the sequence length (the same sequences slice_input_data makes).
+ */
+void get_train_validation_windows(
+    const vector<string>& arguments, TimeSeriesSets* time_series_sets, TimeSeriesWindows& train_inputs,
+    TimeSeriesWindows& train_outputs, TimeSeriesWindows& validation_inputs, TimeSeriesWindows& validation_outputs
+) {
+    int32_t time_offset = 1;
+    get_argument(arguments, "--time_offset", true, time_offset);
+
+    int32_t sequence_length = 0;
+    int32_t sequence_stride = 0;
+    if (get_argument(arguments, "--train_sequence_length", false, sequence_length)) {
+        get_argument(arguments, "--train_sequence_stride", false, sequence_stride);
+        Log::info("Windowing training data with sequence length: %d, stride: %d\n", sequence_length, sequence_stride);
+    }
+    time_series_sets->export_training_series(
+        time_offset, sequence_length, sequence_stride, train_inputs, train_outputs
+    );
+
+    int32_t validation_sequence_length = 0;
+    int32_t validation_sequence_stride = 0;
+    if (get_argument(arguments, "--validation_sequence_length", false, validation_sequence_length)) {
+        get_argument(arguments, "--validation_sequence_stride", false, validation_sequence_stride);
+        Log::info(
+            "Windowing validation data with sequence length: %d, stride: %d\n", validation_sequence_length,
+            validation_sequence_stride
+        );
+    }
+    time_series_sets->export_test_series(
+        time_offset, validation_sequence_length, validation_sequence_stride, validation_inputs, validation_outputs
+    );
+
+    Log::info(
+        "Generated %d training windows over %d series and %d validation windows over %d series\n",
+        train_inputs.size(), train_inputs.get_number_series(), validation_inputs.size(),
+        validation_inputs.get_number_series()
+    );
+}
+
 void slice_input_data(
     vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs, int32_t sequence_length
 ) {
@@ -44,6 +44,10 @@ void get_train_validation_data(
     vector<vector<vector<double> > >& train_outputs, vector<vector<vector<double> > >& test_inputs,
     vector<vector<vector<double> > >& test_outputs
 );
+void get_train_validation_windows(
+    const vector<string>& arguments, TimeSeriesSets* time_series_sets, TimeSeriesWindows& train_inputs,
+    TimeSeriesWindows& train_outputs, TimeSeriesWindows& validation_inputs, TimeSeriesWindows& validation_outputs
+);
 void slice_input_data(
     vector<vector<vector<double> > >& traing_inputs, vector<vector<vector<double> > >& train_outputs,
     int32_t sequence_length
@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <cstring>
+
+#include <iostream>
+using std::cerr;
+using std::cout;
+using std::endl;
+
+#include <map>
+using std::map;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+
+/**
+ * Prints the messages from a multiplexed binary log (written with --multiplex_logs), either for
+ * every id or for a single one.
+ */
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    string log_filename;
+    get_argument(arguments, "--log_file", true, log_filename);
+
+    string selected_id = "";
+    get_argument(arguments, "--id", false, selected_id);
+
+    bool list_ids = argument_exists(arguments, "--list_ids");
+
+    FILE* log_file = fopen(log_filename.c_str(), "rb");
+    if (log_file == NULL) {
+        cerr << "ERROR: could not open log file '" << log_filename << "'" << endl;
+        exit(1);
+    }
+
+    char magic[8];
+    int32_t version;
+    if (fread(magic, 1, 8, log_file) != 8 || memcmp(magic, LOG_MULTIPLEXED_MAGIC, 8) != 0) {
+        cerr << "ERROR: '" << log_filename << "' is not a multiplexed log file" << endl;
+        exit(1);
+    }
+    if (fread(&version, sizeof(int32_t), 1, log_file) != 1 || version != LOG_MULTIPLEXED_VERSION) {
+        cerr << "ERROR: unsupported multiplexed log version " << version << " in '" << log_filename << "'" << endl;
+        exit(1);
+    }
+
+    map<int32_t, string> id_names;
+    vector<char> text;
+
+    int8_t record_type;
+    while (fread(&record_type, sizeof(int8_t), 1, log_file) == 1) {
+        int32_t id_index;
+        int32_t length;
+        int8_t message_level = 0;
+
+        bool complete = fread(&id_index, sizeof(int32_t), 1, log_file) == 1;
+        if (record_type == LOG_RECORD_MESSAGE) {
+            complete = complete && fread(&message_level, sizeof(int8_t), 1, log_file) == 1;
+        } else if (record_type != LOG_RECORD_ID) {
+            cerr << "ERROR: unknown record type " << (int32_t) record_type << " in '" << log_filename << "'" << endl;
+            exit(1);
+        }
+        complete = complete && fread(&length, sizeof(int32_t), 1, log_file) == 1 && length >= 0;
+
+        if (complete) {
+            text.resize(length);
+            complete = (int32_t) fread(text.data(), 1, length, log_file) == length;
+        }
+
+        if (!complete) {
+            // the program writing the log may have been killed part way through a record
+            cerr << "WARNING: '" << log_filename << "' ends with an incomplete record" << endl;
+            break;
+        }
+
+        if (record_type == LOG_RECORD_ID) {
+            id_names[id_index] = string(text.begin(), text.end());
+            if (list_ids) {
+                cout << id_names[id_index] << endl;
+            }
+        } else if (!list_ids && (selected_id.empty() || id_names[id_index] == selected_id)) {
+            cout.write(text.data(), length);
+        }
+    }
+    fclose(log_file);
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <condition_variable>
+using std::condition_variable;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include "checkpoint_writer.hxx"
+#include "common/files.hxx"
+#include "common/log.hxx"
+
+CheckpointWriter::CheckpointWriter(string _filename)
+    : filename(_filename), has_pending_checkpoint(false), writing(false), stopping(false) {
+    writer_thread = thread(&CheckpointWriter::run, this);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        lock_guard<mutex> lock(checkpoint_mutex);
+        stopping = true;
+    }
+    checkpoint_changed.notify_all();
+    writer_thread.join();
+}
+
+const string& CheckpointWriter::get_filename() const {
+    return filename;
+}
+
+void CheckpointWriter::run() {
+    unique_lock<mutex> lock(checkpoint_mutex);
+    while (true) {
+        while (!has_pending_checkpoint && !stopping) {
+            checkpoint_changed.wait(lock);
+        }
+
+        if (!has_pending_checkpoint) {
+            break;
+        }
+
+        string checkpoint;
+        checkpoint.swap(pending_checkpoint);
+        has_pending_checkpoint = false;
+        writing = true;
+
+        lock.unlock();
+        if (!write_file_atomically(filename, checkpoint)) {
+            Log::error("could not write checkpoint file: '%s'\n", filename.c_str());
+        }
+        lock.lock();
+
+        writing = false;
+        checkpoint_changed.notify_all();
+    }
+}
+
+void CheckpointWriter::write(string checkpoint) {
+    {
+        lock_guard<mutex> lock(checkpoint_mutex);
+        pending_checkpoint.swap(checkpoint);
+        has_pending_checkpoint = true;
+    }
+    checkpoint_changed.notify_all();
+}
+
+void CheckpointWriter::flush() {
+    unique_lock<mutex> lock(checkpoint_mutex);
+    while (has_pending_checkpoint || writing) {
+        checkpoint_changed.wait(lock);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef EXAMM_CHECKPOINT_WRITER_HXX
+#define EXAMM_CHECKPOINT_WRITER_HXX
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <mutex>
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+/**
+ * Writes checkpoints to a file on a background thread so the search does not wait for the disk.
+ * Each checkpoint is written to a temporary file which is synced and then renamed over the
+ * previous one, so if the process is killed the file always holds a complete checkpoint.
+ *
+ * Only the latest checkpoint matters, so if a new checkpoint arrives before the previous one has
+ * been written the previous one is skipped.
+ */
+class CheckpointWriter {
+   private:
+    string filename;
+
+    string pending_checkpoint;
+    bool has_pending_checkpoint;
+    bool writing;
+    bool stopping;
+
+    mutex checkpoint_mutex;
+    condition_variable checkpoint_changed;
+    thread writer_thread;
+
+    void run();
+
+   public:
+    explicit CheckpointWriter(string _filename);
+
+    /**
+     * Writes the last checkpoint (if it has not been written yet) before returning.
+     */
+    ~CheckpointWriter();
+
+    const string& get_filename() const;
+
+    /**
+     * Queues the checkpoint to be written, replacing any queued checkpoint.
+     */
+    void write(string checkpoint);
+
+    /**
+     * Waits until the queued checkpoint has been written.
+     */
+    void flush();
+};
+
+#endif
@@ -9,6 +9,8 @@ using std::bind;
 using std::function;
 
 #include <fstream>
+using std::ifstream;
+using std::ios;
 using std::ofstream;
 
 #include <iomanip>
@@ -23,12 +25,19 @@ using std::minstd_rand0;
 using std::uniform_int_distribution;
 using std::uniform_real_distribution;
 
+#include <sstream>
+using std::istringstream;
+using std::ostringstream;
+
 #include <string>
 using std::string;
 using std::to_string;
 
+#include <unistd.h>
+
 #include "common/files.hxx"
 #include "common/log.hxx"
+#include "common/metrics.hxx"
 #include "examm.hxx"
 #include "island_speciation_strategy.hxx"
 #include "neat_speciation_strategy.hxx"
@@ -44,14 +53,23 @@ using std::to_string;
 #include "speciation_strategy.hxx"
 #include "weights/weight_update.hxx"
 
+#define EXAMM_CHECKPOINT_MAGIC "EXAMMCKP"
+#define EXAMM_CHECKPOINT_MAGIC_LENGTH 8
+#define EXAMM_CHECKPOINT_VERSION 1
+
 EXAMM::~EXAMM() {
+    // deleting the writer waits for the last checkpoint to be written
+    if (checkpoint_writer != NULL) {
+        delete checkpoint_writer;
+    }
     delete weight_rules;
     delete genome_property;
 }
 
 EXAMM::EXAMM(
     int32_t _island_size, int32_t _number_islands, int32_t _max_genomes, SpeciationStrategy* _speciation_strategy,
-    WeightRules* _weight_rules, GenomeProperty* _genome_property, string _output_directory, string _save_genome_option
+    WeightRules* _weight_rules, GenomeProperty* _genome_property, string _output_directory, string _save_genome_option,
+    string _resume_from, int32_t _seed
 )
     : island_size(_island_size),
       number_islands(_number_islands),
@@ -65,8 +83,16 @@ EXAMM::EXAMM(
     edge_innovation_count = 0;
     node_innovation_count = 0;
     generate_op_log = false;
-
-    int32_t seed = std::chrono::system_clock::now().time_since_epoch().count();
+    log_file = NULL;
+    op_log_file = NULL;
+    checkpoint_writer = NULL;
+    checkpoint_interval = 0;
+
+    // searches are seeded from the clock unless given a seed, e.g., to repeat a benchmark
+    int32_t seed = _seed;
+    if (seed < 0) {
+        seed = std::chrono::system_clock::now().time_since_epoch().count();
+    }
     generator = minstd_rand0(seed);
     rng_0_1 = uniform_real_distribution<double>(0.0, 1.0);
     rng_crossover_weight = uniform_real_distribution<double>(-0.5, 1.5);
@@ -80,6 +106,13 @@ EXAMM::EXAMM(
         this->mutate(max_mutations, genome);
     };
 
+    if (_resume_from != "") {
+        // the populations, counters and random number generators all come from the checkpoint
+        read_checkpoint(_resume_from);
+        Log::info("Finished resuming from '%s', now continue EXAMM evolution\n", _resume_from.c_str());
+        return;
+    }
+
     Log::info("Finished initializing, now start EXAMM evolution\n");
 
     speciation_strategy->initialize_population(mutate_function);
@@ -87,6 +120,170 @@ EXAMM::EXAMM(
     startClock = std::chrono::system_clock::now();
 }
 
+void EXAMM::set_checkpointing(string checkpoint_filename, int32_t _checkpoint_interval) {
+    if (_checkpoint_interval <= 0) {
+        Log::fatal("checkpoint interval must be > 0, was %d\n", _checkpoint_interval);
+        exit(1);
+    }
+
+    if (checkpoint_writer != NULL) {
+        delete checkpoint_writer;
+    }
+    checkpoint_writer = new CheckpointWriter(checkpoint_filename);
+    checkpoint_interval = _checkpoint_interval;
+    Log::info(
+        "writing a checkpoint to '%s' every %d inserted genomes\n", checkpoint_filename.c_str(), checkpoint_interval
+    );
+}
+
+void EXAMM::write_checkpoint(ostream& checkpoint_stream) {
+    checkpoint_stream.write(EXAMM_CHECKPOINT_MAGIC, EXAMM_CHECKPOINT_MAGIC_LENGTH);
+    int32_t version = EXAMM_CHECKPOINT_VERSION;
+    checkpoint_stream.write((char*) &version, sizeof(int32_t));
+
+    checkpoint_stream.write((char*) &edge_innovation_count, sizeof(int32_t));
+    checkpoint_stream.write((char*) &node_innovation_count, sizeof(int32_t));
+    checkpoint_stream.write((char*) &total_bp_epochs, sizeof(int32_t));
+
+    // the log's time column keeps counting from where the search left off when it is resumed
+    int64_t elapsed_milliseconds =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - startClock).count();
+    checkpoint_stream.write((char*) &elapsed_milliseconds, sizeof(int64_t));
+
+    ostringstream generator_oss;
+    generator_oss << generator;
+    write_binary_string(checkpoint_stream, generator_oss.str(), "generator");
+
+    ostringstream rng_0_1_oss;
+    rng_0_1_oss << rng_0_1;
+    write_binary_string(checkpoint_stream, rng_0_1_oss.str(), "rng_0_1");
+
+    ostringstream rng_crossover_weight_oss;
+    rng_crossover_weight_oss << rng_crossover_weight;
+    write_binary_string(checkpoint_stream, rng_crossover_weight_oss.str(), "rng_crossover_weight");
+
+    vector<map<string, int32_t>*> maps = {&inserted_from_map, &generated_from_map, &inserted_counts, &generated_counts};
+    for (int32_t i = 0; i < (int32_t) maps.size(); i++) {
+        ostringstream map_oss;
+        write_map(map_oss, *maps[i]);
+        write_binary_string(checkpoint_stream, map_oss.str(), "map");
+    }
+
+    // the logs are cut back to these lengths on a resume, so rows written after the checkpoint are
+    // not repeated
+    int64_t log_size = -1;
+    if (log_file != NULL) {
+        log_file->flush();
+        log_size = (int64_t) log_file->tellp();
+    }
+    checkpoint_stream.write((char*) &log_size, sizeof(int64_t));
+
+    int64_t op_log_size = -1;
+    if (generate_op_log && op_log_file != NULL) {
+        op_log_file->flush();
+        op_log_size = (int64_t) op_log_file->tellp();
+    }
+    checkpoint_stream.write((char*) &op_log_size, sizeof(int64_t));
+
+    speciation_strategy->write_checkpoint(checkpoint_stream);
+}
+
+void EXAMM::read_checkpoint(string checkpoint_filename) {
+    ifstream checkpoint_stream(checkpoint_filename, ios::in | ios::binary);
+    if (!checkpoint_stream.is_open()) {
+        Log::fatal("could not open checkpoint file: '%s'\n", checkpoint_filename.c_str());
+        exit(1);
+    }
+
+    char magic[EXAMM_CHECKPOINT_MAGIC_LENGTH];
+    int32_t version = -1;
+    checkpoint_stream.read(magic, EXAMM_CHECKPOINT_MAGIC_LENGTH);
+    checkpoint_stream.read((char*) &version, sizeof(int32_t));
+    if (!checkpoint_stream.good() || memcmp(magic, EXAMM_CHECKPOINT_MAGIC, EXAMM_CHECKPOINT_MAGIC_LENGTH) != 0) {
+        Log::fatal("'%s' is not an EXAMM checkpoint file\n", checkpoint_filename.c_str());
+        exit(1);
+    }
+    if (version != EXAMM_CHECKPOINT_VERSION) {
+        Log::fatal(
+            "checkpoint file '%s' has version %d, expected version %d\n", checkpoint_filename.c_str(), version,
+            EXAMM_CHECKPOINT_VERSION
+        );
+        exit(1);
+    }
+
+    checkpoint_stream.read((char*) &edge_innovation_count, sizeof(int32_t));
+    checkpoint_stream.read((char*) &node_innovation_count, sizeof(int32_t));
+    checkpoint_stream.read((char*) &total_bp_epochs, sizeof(int32_t));
+
+    int64_t elapsed_milliseconds;
+    checkpoint_stream.read((char*) &elapsed_milliseconds, sizeof(int64_t));
+    startClock = std::chrono::system_clock::now() - std::chrono::milliseconds(elapsed_milliseconds);
+
+    string generator_str;
+    read_binary_string(checkpoint_stream, generator_str, "generator");
+    istringstream generator_iss(generator_str);
+    generator_iss >> generator;
+
+    string rng_0_1_str;
+    read_binary_string(checkpoint_stream, rng_0_1_str, "rng_0_1");
+    istringstream rng_0_1_iss(rng_0_1_str);
+    rng_0_1_iss >> rng_0_1;
+
+    string rng_crossover_weight_str;
+    read_binary_string(checkpoint_stream, rng_crossover_weight_str, "rng_crossover_weight");
+    istringstream rng_crossover_weight_iss(rng_crossover_weight_str);
+    rng_crossover_weight_iss >> rng_crossover_weight;
+
+    vector<map<string, int32_t>*> maps = {&inserted_from_map, &generated_from_map, &inserted_counts, &generated_counts};
+    for (int32_t i = 0; i < (int32_t) maps.size(); i++) {
+        string map_str;
+        read_binary_string(checkpoint_stream, map_str, "map");
+        istringstream map_iss(map_str);
+        maps[i]->clear();
+        read_map(map_iss, *maps[i]);
+    }
+
+    int64_t log_size, op_log_size;
+    checkpoint_stream.read((char*) &log_size, sizeof(int64_t));
+    checkpoint_stream.read((char*) &op_log_size, sizeof(int64_t));
+
+    speciation_strategy->read_checkpoint(checkpoint_stream);
+
+    if (!checkpoint_stream.good()) {
+        Log::fatal("checkpoint file '%s' is truncated\n", checkpoint_filename.c_str());
+        exit(1);
+    }
+
+    log_file = NULL;
+    op_log_file = NULL;
+    if (output_directory != "") {
+        mkpath(output_directory.c_str(), 0777);
+        resume_log(output_directory + "/fitness_log.csv", log_file, log_size);
+        if (generate_op_log) {
+            set_op_log_ordering();
+            resume_log(output_directory + "/op_log.csv", op_log_file, op_log_size);
+        }
+    }
+}
+
+void EXAMM::resume_log(string filename, ofstream*& file, int64_t size) {
+    if (size < 0) {
+        Log::fatal("checkpoint has no length for log '%s', it was not written by this search\n", filename.c_str());
+        exit(1);
+    }
+
+    if (truncate(filename.c_str(), size) != 0) {
+        Log::fatal("could not truncate log '%s' to %ld bytes when resuming\n", filename.c_str(), (long) size);
+        exit(1);
+    }
+
+    file = new ofstream(filename, std::ios_base::app);
+    if (!file->is_open()) {
+        Log::fatal("could not open EXAMM output log: '%s'\n", filename.c_str());
+        exit(1);
+    }
+}
+
 void EXAMM::print() {
     if (Log::at_level(Log::TRACE)) {
         speciation_strategy->print();
@@ -110,20 +307,7 @@ void EXAMM::generate_log() {
 
         if (generate_op_log) {
             op_log_file = new ofstream(output_directory + "/op_log.csv");
-            op_log_ordering = {
-                "genomes",     "crossover",    "island_crossover", "clone",        "add_edge", "add_recurrent_edge",
-                "enable_edge", "disable_edge", "enable_node",      "disable_node",
-            };
-            // To get data about these ops without respect to node type,
-            // you'll have to calculate the sum, e.g. sum split_node(x) for all node types x
-            // to get information about split_node as a whole.
-            vector<string> ops_with_node_type = {"add_node", "split_node", "merge_node", "split_edge"};
-            for (int32_t i = 0; i < (int32_t) ops_with_node_type.size(); i++) {
-                string op = ops_with_node_type[i];
-                for (int32_t j = 0; j < (int32_t) possible_node_types.size(); j++) {
-                    op_log_ordering.push_back(op + "(" + NODE_TYPES[possible_node_types[j]] + ")");
-                }
-            }
+            set_op_log_ordering();
             for (int32_t i = 0; i < (int32_t) op_log_ordering.size(); i++) {
                 string op = op_log_ordering[i];
                 (*op_log_file) << op;
@@ -141,6 +325,23 @@ void EXAMM::generate_log() {
     }
 }
 
+void EXAMM::set_op_log_ordering() {
+    op_log_ordering = {
+        "genomes",     "crossover",    "island_crossover", "clone",        "add_edge", "add_recurrent_edge",
+        "enable_edge", "disable_edge", "enable_node",      "disable_node",
+    };
+    // To get data about these ops without respect to node type,
+    // you'll have to calculate the sum, e.g. sum split_node(x) for all node types x
+    // to get information about split_node as a whole.
+    vector<string> ops_with_node_type = {"add_node", "split_node", "merge_node", "split_edge"};
+    for (int32_t i = 0; i < (int32_t) ops_with_node_type.size(); i++) {
+        string op = ops_with_node_type[i];
+        for (int32_t j = 0; j < (int32_t) possible_node_types.size(); j++) {
+            op_log_ordering.push_back(op + "(" + NODE_TYPES[possible_node_types[j]] + ")");
+        }
+    }
+}
+
 void EXAMM::update_op_log_statistics(RNN_Genome* genome, int32_t insert_position) {
     // Name of the operator
     const map<string, int32_t>* generated_by_map = genome->get_generated_by_map();
@@ -265,10 +466,18 @@ RNN_Genome* EXAMM::get_worst_genome() {
 
 // this will insert a COPY, original needs to be deleted
 bool EXAMM::insert_genome(RNN_Genome* genome) {
+    MetricTimer insert_timer(
+        "examm_insert_genome_seconds", "Time the master took to insert a genome.", "insert_genome"
+    );
+
     // discard genomes with NaN fitness
     if (std::isnan(genome->get_fitness()) || std::isinf(genome->get_fitness())) {
+        Metrics::increment("examm_genomes_discarded_total", "Genomes discarded for having a NaN or infinite fitness.");
         return false;
     }
+    Metrics::increment(
+        "examm_bp_epochs_total", "Backpropagation epochs done by evaluated genomes.", genome->get_bp_iterations()
+    );
 
     total_bp_epochs += genome->get_bp_iterations();
     if (!genome->sanity_check()) {
@@ -302,6 +511,20 @@ bool EXAMM::insert_genome(RNN_Genome* genome) {
     } else {
         update_log();
     }
+
+    if (checkpoint_writer != NULL && speciation_strategy->get_evaluated_genomes() % checkpoint_interval == 0) {
+        ostringstream checkpoint;
+        write_checkpoint(checkpoint);
+        checkpoint_writer->write(checkpoint.str());
+    }
+
+    if (insert_position >= 0) {
+        Metrics::increment("examm_genomes_inserted_total", "Evaluated genomes inserted into the population.");
+    } else {
+        Metrics::increment(
+            "examm_genomes_rejected_total", "Evaluated genomes which were not inserted into the population."
+        );
+    }
     return insert_position >= 0;
 }
 
@@ -371,6 +594,9 @@ vector<vector<double> > EXAMM::get_genome_information(int simplex_count) {
 }
 
 RNN_Genome* EXAMM::generate_genome() {
+    MetricTimer generate_timer(
+        "examm_generate_genome_seconds", "Time the master took to generate a genome.", "generate_genome"
+    );
 
     vector<vector<double>> genome_information;
     double tuned_learning_rate;
@@ -466,6 +692,7 @@ RNN_Genome* EXAMM::generate_genome() {
     double _mu, _sigma;
     genome->get_mu_sigma(genome->best_parameters, _mu, _sigma);
 
+    Metrics::increment("examm_genomes_generated_total", "Genomes generated for evaluation.");
     return genome;
 }
 
@@ -496,6 +723,13 @@ void EXAMM::mutate(int32_t max_mutations, RNN_Genome* g) {
         g->get_mu_sigma(g->best_parameters, mu, sigma);
     }
 
+    // the optimizer state is inherited along with the weights, so it needs to be keyed by innovation
+    // number before the mutations change the order of the weights
+    map<WeightKey, WeightOptimizerState> optimizer_state;
+    if (weight_rules->get_weight_inheritance_method() == WeightType::LAMARCKIAN) {
+        g->get_best_optimizer_state(optimizer_state);
+    }
+
     int32_t number_mutations = 0;
 
     for (;;) {
@@ -634,6 +868,7 @@ void EXAMM::mutate(int32_t max_mutations, RNN_Genome* g) {
 
     g->get_weights(new_parameters);
     g->initial_parameters = new_parameters;
+    g->set_initial_optimizer_state(optimizer_state, g->get_best_optimizer_epoch());
 
     if (Log::at_level(Log::DEBUG)) {
         g->get_mu_sigma(new_parameters, mu, sigma);
@@ -651,6 +886,8 @@ void EXAMM::mutate(int32_t max_mutations, RNN_Genome* g) {
     }
 
     g->best_parameters.clear();
+    g->best_velocity.clear();
+    g->best_prev_velocity.clear();
 }
 
 void EXAMM::attempt_node_insert(
@@ -1100,6 +1337,15 @@ RNN_Genome* EXAMM::crossover(RNN_Genome* p1, RNN_Genome* p2) {
     child->get_weights(new_parameters);
     child->initial_parameters = new_parameters;
 
+    // the optimizer state of the weights both parents have comes from the more fit parent (p1), as
+    // does the epoch it continues from
+    map<WeightKey, WeightOptimizerState> optimizer_state;
+    if (weight_inheritance == WeightType::LAMARCKIAN) {
+        p1->get_best_optimizer_state(optimizer_state);
+        p2->get_best_optimizer_state(optimizer_state);
+    }
+    child->set_initial_optimizer_state(optimizer_state, p1->get_best_optimizer_epoch());
+
     Log::debug("checking parameters after crossover\n");
     child->get_mu_sigma(child->initial_parameters, mu, sigma);
 
@@ -1159,6 +1405,7 @@ void EXAMM::initialize_seed_genome() {
     seed_genome->best_validation_mse = EXAMM_MAX_DOUBLE;
     seed_genome->best_validation_mae = EXAMM_MAX_DOUBLE;
     seed_genome->best_parameters.clear();
+    seed_genome->clear_optimizer_state();
 }
 
 void EXAMM::set_evolution_hyper_parameters() {
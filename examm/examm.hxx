@@ -4,6 +4,10 @@
 #include <fstream>
 using std::ofstream;
 
+#include <iostream>
+using std::istream;
+using std::ostream;
+
 #include <map>
 using std::map;
 
@@ -17,6 +21,7 @@ using std::to_string;
 #include <vector>
 using std::vector;
 
+#include "checkpoint_writer.hxx"
 #include "rnn/genome_property.hxx"
 #include "rnn/rnn_genome.hxx"
 #include "speciation_strategy.hxx"
@@ -79,11 +84,18 @@ class EXAMM {
     string genome_file_name;
     string save_genome_option;
 
+    // if set, a checkpoint is written every checkpoint_interval inserted genomes
+    CheckpointWriter* checkpoint_writer;
+    int32_t checkpoint_interval;
+
+    void read_checkpoint(string checkpoint_filename);
+    void resume_log(string filename, ofstream*& file, int64_t size);
+
    public:
     EXAMM(
         int32_t _island_size, int32_t _number_islands, int32_t _max_genomes, SpeciationStrategy* _speciation_strategy,
         WeightRules* _weight_rules, GenomeProperty* _genome_property, string _output_directory,
-        string _save_genome_option
+        string _save_genome_option, string _resume_from = "", int32_t _seed = -1
     );
 
     ~EXAMM();
@@ -124,10 +136,23 @@ class EXAMM {
 
     void save_genome(RNN_Genome* genome, string genome_name);
 
+    /**
+     * Writes a checkpoint in the background every _checkpoint_interval inserted genomes, which a
+     * search can be resumed from by passing it to the constructor.
+     */
+    void set_checkpointing(string checkpoint_filename, int32_t _checkpoint_interval);
+
+    /**
+     * Writes everything needed to resume the search: the speciation strategy's populations, the
+     * innovation counters, the random number generators and the lengths of the logs.
+     */
+    void write_checkpoint(ostream& checkpoint_stream);
+
     string get_output_directory() const;
 
     void check_weight_initialize_validity();
     void generate_log();
+    void set_op_log_ordering();
     void set_evolution_hyper_parameters();
     void initialize_seed_genome();
     void update_op_log_statistics(RNN_Genome* genome, int32_t insert_position);
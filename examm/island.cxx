@@ -6,6 +6,10 @@ using std::upper_bound;
 #include <iomanip>
 using std::setw;
 
+#include <iostream>
+using std::istream;
+using std::ostream;
+
 #include <random>
 using std::minstd_rand0;
 using std::uniform_real_distribution;
@@ -37,6 +41,43 @@ Island::Island(int32_t _id, vector<RNN_Genome*> _genomes)
       erased(false) {
 }
 
+Island::Island(istream& checkpoint_stream) {
+    int32_t number_genomes;
+    checkpoint_stream.read((char*) &id, sizeof(int32_t));
+    checkpoint_stream.read((char*) &max_size, sizeof(int32_t));
+    checkpoint_stream.read((char*) &erased_generation_id, sizeof(int32_t));
+    checkpoint_stream.read((char*) &latest_generation_id, sizeof(int32_t));
+    checkpoint_stream.read((char*) &status, sizeof(int32_t));
+    checkpoint_stream.read((char*) &erase_again, sizeof(int32_t));
+    checkpoint_stream.read((char*) &erased, sizeof(bool));
+    checkpoint_stream.read((char*) &number_genomes, sizeof(int32_t));
+
+    // the genomes were written best to worst, so they are still sorted
+    for (int32_t i = 0; i < number_genomes; i++) {
+        RNN_Genome* genome = new RNN_Genome(checkpoint_stream);
+        genomes.push_back(genome);
+        structure_map[genome->get_structural_hash()].push_back(genome);
+    }
+
+    Log::info("Island %d: read %d genomes from checkpoint, status: %d\n", id, number_genomes, status);
+}
+
+void Island::write_checkpoint(ostream& checkpoint_stream) {
+    int32_t number_genomes = genomes.size();
+    checkpoint_stream.write((char*) &id, sizeof(int32_t));
+    checkpoint_stream.write((char*) &max_size, sizeof(int32_t));
+    checkpoint_stream.write((char*) &erased_generation_id, sizeof(int32_t));
+    checkpoint_stream.write((char*) &latest_generation_id, sizeof(int32_t));
+    checkpoint_stream.write((char*) &status, sizeof(int32_t));
+    checkpoint_stream.write((char*) &erase_again, sizeof(int32_t));
+    checkpoint_stream.write((char*) &erased, sizeof(bool));
+    checkpoint_stream.write((char*) &number_genomes, sizeof(int32_t));
+
+    for (int32_t i = 0; i < number_genomes; i++) {
+        genomes[i]->write_to_stream(checkpoint_stream);
+    }
+}
+
 RNN_Genome* Island::get_best_genome() {
     if (genomes.size() == 0) {
         return NULL;
@@ -8,6 +8,10 @@ using std::upper_bound;
 #include <functional>
 using std::function;
 
+#include <iostream>
+using std::istream;
+using std::ostream;
+
 #include <random>
 using std::minstd_rand0;
 using std::uniform_real_distribution;
@@ -27,8 +31,8 @@ class Island {
     int32_t erased_generation_id =
         -1; /**< The latest generation id of an erased island, erased_generation_id = largest_generation_id when this
                island is erased, to prevent deleted genomes get inserted back */
-    int32_t latest_generation_id; /**< The latest generation id of genome being generated, including the ones doing
-                                     backprop by workers */
+    int32_t latest_generation_id = -1; /**< The latest generation id of genome being generated, including the ones
+                                          doing backprop by workers */
 
     /**
      * The genomes on this island, stored in sorted order best (front) to worst (back).
@@ -60,6 +64,16 @@ class Island {
      */
     Island(int32_t id, vector<RNN_Genome*> genomes);
 
+    /**
+     * Reads an island written by Island::write_checkpoint, with its genomes and status.
+     */
+    explicit Island(istream& checkpoint_stream);
+
+    /**
+     * Writes everything needed to continue the search with this island to the stream.
+     */
+    void write_checkpoint(ostream& checkpoint_stream);
+
     /**
      * Returns the fitness of the best genome in the island
      *
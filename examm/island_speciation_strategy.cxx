@@ -684,6 +684,66 @@ void IslandSpeciationStrategy::save_entire_population(string output_path) {
     }
 }
 
+void IslandSpeciationStrategy::write_checkpoint(ostream& checkpoint_stream) {
+    checkpoint_stream.write((char*) &number_of_islands, sizeof(int32_t));
+    checkpoint_stream.write((char*) &max_island_size, sizeof(int32_t));
+    checkpoint_stream.write((char*) &generation_island, sizeof(int32_t));
+    checkpoint_stream.write((char*) &generated_genomes, sizeof(int32_t));
+    checkpoint_stream.write((char*) &evaluated_genomes, sizeof(int32_t));
+
+    bool has_global_best_genome = global_best_genome != NULL;
+    checkpoint_stream.write((char*) &has_global_best_genome, sizeof(bool));
+    if (has_global_best_genome) {
+        global_best_genome->write_to_stream(checkpoint_stream);
+    }
+
+    for (int32_t i = 0; i < (int32_t) islands.size(); i++) {
+        islands[i]->write_checkpoint(checkpoint_stream);
+    }
+}
+
+void IslandSpeciationStrategy::read_checkpoint(istream& checkpoint_stream) {
+    int32_t checkpoint_number_of_islands, checkpoint_max_island_size;
+    checkpoint_stream.read((char*) &checkpoint_number_of_islands, sizeof(int32_t));
+    checkpoint_stream.read((char*) &checkpoint_max_island_size, sizeof(int32_t));
+
+    if (checkpoint_number_of_islands != number_of_islands || checkpoint_max_island_size != max_island_size) {
+        Log::fatal(
+            "ERROR: checkpoint has %d islands of size %d but the search was started with %d islands of size %d\n",
+            checkpoint_number_of_islands, checkpoint_max_island_size, number_of_islands, max_island_size
+        );
+        exit(1);
+    }
+
+    checkpoint_stream.read((char*) &generation_island, sizeof(int32_t));
+    checkpoint_stream.read((char*) &generated_genomes, sizeof(int32_t));
+    checkpoint_stream.read((char*) &evaluated_genomes, sizeof(int32_t));
+
+    bool has_global_best_genome;
+    checkpoint_stream.read((char*) &has_global_best_genome, sizeof(bool));
+    if (global_best_genome != NULL) {
+        delete global_best_genome;
+        global_best_genome = NULL;
+    }
+    if (has_global_best_genome) {
+        global_best_genome = new RNN_Genome(checkpoint_stream);
+    }
+
+    for (int32_t i = 0; i < (int32_t) islands.size(); i++) {
+        delete islands[i];
+    }
+    islands.clear();
+
+    for (int32_t i = 0; i < number_of_islands; i++) {
+        islands.push_back(new Island(checkpoint_stream));
+    }
+
+    Log::info(
+        "Island Strategy: resumed from checkpoint with %d generated and %d evaluated genomes\n", generated_genomes,
+        evaluated_genomes
+    );
+}
+
 int32_t IslandSpeciationStrategy::get_islands_size() const {
     return islands.size();
 }
@@ -246,6 +246,9 @@ class IslandSpeciationStrategy : public SpeciationStrategy {
 
     void save_entire_population(string output_path);
 
+    void write_checkpoint(ostream& checkpoint_stream);
+    void read_checkpoint(istream& checkpoint_stream);
+
     /**
     * Get the number of islands
     *
@@ -572,6 +572,16 @@ void NeatSpeciationStrategy::initialize_population(function<void(int32_t, RNN_Ge
 void NeatSpeciationStrategy::save_entire_population(string output_path) {
 }
 
+void NeatSpeciationStrategy::write_checkpoint(ostream& checkpoint_stream) {
+    Log::fatal("ERROR: checkpointing is not supported by the NEAT speciation strategy\n");
+    exit(1);
+}
+
+void NeatSpeciationStrategy::read_checkpoint(istream& checkpoint_stream) {
+    Log::fatal("ERROR: resuming from a checkpoint is not supported by the NEAT speciation strategy\n");
+    exit(1);
+}
+
 int32_t NeatSpeciationStrategy::get_islands_size() const {
     return 0;
 }
@@ -161,6 +161,9 @@ class NeatSpeciationStrategy : public SpeciationStrategy {
     RNN_Genome* get_seed_genome();
     void save_entire_population(string output_path);
 
+    void write_checkpoint(ostream& checkpoint_stream);
+    void read_checkpoint(istream& checkpoint_stream);
+
     /**
     *  \return true if all the islands are full
     */
@@ -3,6 +3,9 @@
 
 #include <functional>
 using std::function;
+#include <iostream>
+using std::istream;
+using std::ostream;
 #include <string>
 using std::string;
 #include <random>
@@ -107,6 +110,21 @@ class SpeciationStrategy {
     virtual RNN_Genome* get_seed_genome() = 0;
     virtual void save_entire_population(string output_path) = 0;
 
+    /**
+     * Writes the populations and counters of this strategy, so a search can be resumed from them.
+     *
+     * \param checkpoint_stream is the stream to write to
+     */
+    virtual void write_checkpoint(ostream& checkpoint_stream) = 0;
+
+    /**
+     * Replaces the populations and counters of this strategy with those written by write_checkpoint,
+     * instead of initializing the population.
+     *
+     * \param checkpoint_stream is the stream to read from
+     */
+    virtual void read_checkpoint(istream& checkpoint_stream) = 0;
+
     /**
     *  \return true if all the islands are full
     */
@@ -0,0 +1,57 @@
+#include <iostream>
+using std::cerr;
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include "image_set.hxx"
+#include "large_image_set.hxx"
+
+int main(int argc, char** argv) {
+    if (argc != 4) {
+        cerr << "error: incorrect arguments." << endl;
+        cerr << "usage: " << endl;
+        cerr << "    " << argv[0] << " <input image file> <output image file> <fixed | large>" << endl;
+        cerr << endl;
+        cerr << "converts an image set into the versioned format which can be memory mapped, storing the channel"
+             << endl;
+        cerr << "averages and standard deviations of the images so they do not need to be recalculated on load."
+             << endl;
+        exit(1);
+    }
+
+    string input_filename(argv[1]);
+    string output_filename(argv[2]);
+    string image_type(argv[3]);
+
+    int result = 0;
+    if (image_type.compare("fixed") == 0) {
+        Images images(input_filename, 0);
+        if (!images.loaded_correctly()) {
+            cerr << "ERROR: could not read images from '" << input_filename << "'" << endl;
+            exit(1);
+        }
+
+        result = images.write_image_file(output_filename);
+
+    } else if (image_type.compare("large") == 0) {
+        // the subimage size does not change what is written, so use the smallest possible
+        LargeImages images(input_filename, 0, 1, 1);
+        result = images.write_image_file(output_filename);
+
+    } else {
+        cerr << "ERROR: unknown image type '" << image_type << "', must be 'fixed' or 'large'" << endl;
+        exit(1);
+    }
+
+    if (result != 0) {
+        cerr << "ERROR: could not write images to '" << output_filename << "'" << endl;
+        exit(1);
+    }
+
+    cout << "wrote '" << output_filename << "'" << endl;
+
+    return 0;
+}
@@ -22,32 +22,16 @@ using std::vector;
 #include "stdint.h"
 
 Image::Image(
-    ifstream& infile, int _channels, int _width, int _height, int _padding, int _classification, const Images* _images
+    const uint8_t* _pixels, int _channels, int _width, int _height, int _padding, int _classification,
+    const Images* _images
 ) {
+    pixels = _pixels;
     channels = _channels;
     width = _width;
     height = _height;
     padding = _padding;
     classification = _classification;
     images = _images;
-
-    pixels = vector<vector<vector<uint8_t> > >(channels, vector<vector<uint8_t> >(height, vector<uint8_t>(width, 0)));
-
-    char* c_pixels = new char[channels * width * height];
-
-    infile.read(c_pixels, sizeof(char) * channels * width * height);
-
-    int current = 0;
-    for (int32_t z = 0; z < channels; z++) {
-        for (int32_t y = 0; y < height; y++) {
-            for (int32_t x = 0; x < width; x++) {
-                pixels[z][y][x] = (uint8_t) c_pixels[current];
-                current++;
-            }
-        }
-    }
-
-    delete[] c_pixels;
 }
 
 float Image::get_pixel(int z, int y, int x) const {
@@ -56,7 +40,7 @@ float Image::get_pixel(int z, int y, int x) const {
     } else if (y >= width + padding || x >= height + padding) {
         return 0;
     } else {
-        return ((pixels[z][y - padding][x - padding] / 255.0) - images->get_channel_avg(z))
+        return ((pixels[(((z * height) + (y - padding)) * width) + (x - padding)] / 255.0) - images->get_channel_avg(z))
                / images->get_channel_std_dev(z);
     }
 }
@@ -72,7 +56,7 @@ void Image::get_pixel_avg(vector<float>& channel_avgs) const {
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                channel_avgs[z] += pixels[z][y][x] / 255.0;
+                channel_avgs[z] += pixels[(((z * height) + y) * width) + x] / 255.0;
             }
         }
         channel_avgs[z] /= (height * width);
@@ -87,7 +71,7 @@ void Image::get_pixel_variance(const vector<float>& channel_avgs, vector<float>&
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                tmp = channel_avgs[z] - (pixels[z][y][x] / 255.0);
+                tmp = channel_avgs[z] - (pixels[(((z * height) + y) * width) + x] / 255.0);
                 channel_variances[z] += tmp * tmp;
             }
         }
@@ -101,7 +85,7 @@ void Image::print(ostream& out) {
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                out << setw(7) << pixels[z][y][x];
+                out << setw(7) << pixels[(((z * height) + y) * width) + x];
             }
             out << endl;
         }
@@ -115,62 +99,129 @@ string Images::get_filename() const {
 int Images::read_images(string _filename) {
     filename = _filename;
 
-    ifstream infile(filename.c_str(), ios::in | ios::binary);
-
-    if (!infile.is_open()) {
-        cerr << "Could not open '" << filename << "' for reading." << endl;
+    mapped_file = new MappedImageFile();
+    if (mapped_file->map(filename)) {
         return 1;
     }
 
-    int initial_vals[4];
-    infile.read((char*) &initial_vals, sizeof(initial_vals));
+    const uint8_t* data = mapped_file->get_data();
 
-    number_classes = initial_vals[0];
-    channels = initial_vals[1];
-    width = initial_vals[2];
-    height = initial_vals[3];
+    if (mapped_file->is_versioned()) {
+        const ImageFileHeader* header = mapped_file->get_header();
+        const ImageFileEntry* entries = mapped_file->get_entries();
 
-    cerr << "number_classes: " << number_classes << endl;
-    cerr << "channels: " << channels << endl;
-    cerr << "width: " << width << endl;
-    cerr << "height: " << height << endl;
+        if (header->number_images == 0) {
+            cerr << "Could not read '" << filename << "', it does not contain any images." << endl;
+            return 1;
+        }
+
+        number_classes = header->number_classes;
+        channels = header->channels;
+        height = entries[0].height;
+        width = entries[0].width;
+
+        class_sizes.assign(mapped_file->get_class_sizes(), mapped_file->get_class_sizes() + number_classes);
+
+        for (uint32_t i = 0; i < header->number_images; i++) {
+            if (entries[i].channels != channels || entries[i].height != height || entries[i].width != width) {
+                cerr << "Could not read '" << filename << "', image " << i << " is " << entries[i].channels << "x"
+                     << entries[i].width << "x" << entries[i].height << " but all images in an image set must be "
+                     << channels << "x" << width << "x" << height << endl;
+                return 1;
+            }
+
+            size_t image_size = (size_t) channels * width * height;
+            if (entries[i].offset > mapped_file->get_size()
+                || image_size > mapped_file->get_size() - entries[i].offset) {
+                cerr << "Could not read '" << filename << "', image " << i << " is past the end of the file." << endl;
+                return 1;
+            }
+
+            images.push_back(
+                Image(data + entries[i].offset, channels, width, height, padding, entries[i].classification, this)
+            );
+        }
+
+        if (header->has_statistics) {
+            channel_avg.assign(mapped_file->get_channel_avg(), mapped_file->get_channel_avg() + channels);
+            channel_std_dev.assign(mapped_file->get_channel_std_dev(), mapped_file->get_channel_std_dev() + channels);
+        }
+    } else {
+        // the original format: number_classes, channels, width, height, class_sizes[number_classes]
+        // followed by the pixels of every image ordered by class
+        if (mapped_file->get_size() < sizeof(int) * 4) {
+            cerr << "Could not read '" << filename << "', the file is truncated." << endl;
+            return 1;
+        }
+
+        const int* initial_vals = (const int*) data;
+
+        number_classes = initial_vals[0];
+        channels = initial_vals[1];
+        width = initial_vals[2];
+        height = initial_vals[3];
 
-    class_sizes = vector<int>(number_classes, 0);
-    infile.read((char*) &class_sizes[0], sizeof(int) * number_classes);
+        class_sizes.assign(initial_vals + 4, initial_vals + 4 + number_classes);
 
-    int image_size = channels * width * height;
+        size_t current_offset = sizeof(int) * (4 + number_classes);
+        size_t image_size = channels * width * height;
 
-    for (int i = 0; i < number_classes; i++) {
-        cerr << "reading image set with " << class_sizes[i] << " images." << endl;
+        for (int i = 0; i < number_classes; i++) {
+            cerr << "reading image set with " << class_sizes[i] << " images." << endl;
 
-        for (int32_t j = 0; j < class_sizes[i]; j++) {
-            images.push_back(Image(infile, channels, width, height, padding, i, this));
+            for (int32_t j = 0; j < class_sizes[i]; j++) {
+                if (current_offset + image_size > mapped_file->get_size()) {
+                    cerr << "Could not read '" << filename << "', the file is truncated." << endl;
+                    return 1;
+                }
+
+                images.push_back(Image(data + current_offset, channels, width, height, padding, i, this));
+                current_offset += image_size;
+            }
         }
     }
     number_images = images.size();
 
-    infile.close();
+    cerr << "number_classes: " << number_classes << endl;
+    cerr << "channels: " << channels << endl;
+    cerr << "width: " << width << endl;
+    cerr << "height: " << height << endl;
 
-    cerr << "image_size: " << channels << "x" << width << "x" << height << " = " << image_size << endl;
+    cerr << "image_size: " << channels << "x" << width << "x" << height << " = " << (channels * width * height)
+         << endl;
 
     cerr << "read " << images.size() << " images." << endl;
     for (int i = 0; i < (int32_t) class_sizes.size(); i++) {
         cerr << "    class " << setw(4) << i << ": " << class_sizes[i] << endl;
     }
 
-    /*
-   for (int i = 0; i < images.size(); i++) {
-       images[i].print(cerr);
-   }
-   */
-
     return 0;
 }
 
+int Images::write_image_file(string output_filename) const {
+    vector<ImageFileEntry> entries(images.size());
+    vector<const uint8_t*> pixels(images.size());
+
+    for (uint32_t i = 0; i < images.size(); i++) {
+        entries[i].classification = images[i].classification;
+        entries[i].channels = images[i].channels;
+        entries[i].height = images[i].height;
+        entries[i].width = images[i].width;
+        entries[i].offset = 0;
+
+        pixels[i] = images[i].pixels;
+    }
+
+    return ::write_image_file(
+        output_filename, number_classes, channels, class_sizes, channel_avg, channel_std_dev, entries, pixels
+    );
+}
+
 Images::Images(
     string _filename, int _padding, const vector<float>& _channel_avg, const vector<float>& _channel_std_dev
 ) {
     padding = _padding;
+    mapped_file = NULL;
 
     filename = _filename;
     had_error = read_images(filename);
@@ -181,11 +232,20 @@ Images::Images(
 
 Images::Images(string _filename, int _padding) {
     padding = _padding;
+    mapped_file = NULL;
 
     filename = _filename;
     had_error = read_images(filename);
 
-    calculate_avg_std_dev();
+    // versioned image files store the statistics of their images so there is no need to
+    // page in the whole file to recalculate them
+    if (channel_avg.size() == 0) {
+        calculate_avg_std_dev();
+    }
+}
+
+Images::~Images() {
+    delete mapped_file;
 }
 
 bool Images::loaded_correctly() const {
@@ -216,6 +276,10 @@ int Images::get_image_width() const {
     return width + (2 * padding);
 }
 
+bool Images::is_streaming() const {
+    return false;
+}
+
 int Images::get_classification(int image) const {
     return images[image].get_classification();
 }
@@ -224,6 +288,18 @@ float Images::get_pixel(int image, int z, int y, int x) const {
     return images[image].get_pixel(z, y, x);
 }
 
+void Images::get_subimage(int image, int z, float* values) const {
+    const Image& current_image = images[image];
+
+    int current = 0;
+    for (int32_t y = 0; y < height + (2 * padding); y++) {
+        for (int32_t x = 0; x < width + (2 * padding); x++) {
+            values[current] = current_image.get_pixel(z, y, x);
+            current++;
+        }
+    }
+}
+
 const vector<float>& Images::get_average() const {
     return channel_avg;
 }
@@ -14,6 +14,7 @@ using std::string;
 using std::vector;
 
 #include "image_set_interface.hxx"
+#include "mapped_image_file.hxx"
 
 typedef class Images Images;
 
@@ -26,14 +27,16 @@ class Image : public ImageInterface {
     int height;
     int width;
     int classification;
-    vector<vector<vector<uint8_t> > > pixels;
+
+    // channel major (z, y, x) pixels, pointing into the image set's memory mapped file
+    const uint8_t* pixels;
 
     // reference to images to get channel avgs and std_Devs
     const Images* images;
 
    public:
     Image(
-        ifstream& infile, int _channels, int _width, int _height, int _padding, int _classification,
+        const uint8_t* _pixels, int _channels, int _width, int _height, int _padding, int _classification,
         const Images* _images
     );
 
@@ -69,6 +72,9 @@ class Images : public ImagesInterface {
 
     bool had_error;
 
+    // the images are views into this mapping, so it needs to live as long as the image set
+    MappedImageFile* mapped_file;
+
    public:
     int read_images(string binary_filename);
 
@@ -76,6 +82,12 @@ class Images : public ImagesInterface {
     Images(
         string binary_filename, int _padding, const vector<float>& _channeL_avg, const vector<float>& channel_std_dev
     );
+    ~Images();
+
+    Images(const Images&) = delete;
+    Images& operator=(const Images&) = delete;
+
+    int write_image_file(string output_filename) const;
 
     string get_filename() const;
 
@@ -89,8 +101,11 @@ class Images : public ImagesInterface {
     int get_image_width() const;
     int get_image_height() const;
 
+    bool is_streaming() const;
+
     int get_classification(int image) const;
     float get_pixel(int image, int z, int y, int x) const;
+    void get_subimage(int image, int z, float* values) const;
 
     void calculate_avg_std_dev();
 
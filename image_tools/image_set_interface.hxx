@@ -26,6 +26,14 @@ class ImageInterface {
 
 class ImagesInterface {
    public:
+    virtual ~ImagesInterface() {
+    }
+
+    // image sets which can fail to load override this to report it
+    virtual bool loaded_correctly() const {
+        return true;
+    }
+
     virtual string get_filename() const = 0;
 
     virtual int get_class_size(int i) const = 0;
@@ -38,9 +46,22 @@ class ImagesInterface {
     virtual int get_image_width() const = 0;
     virtual int get_image_height() const = 0;
 
+    // streaming image sets only keep some of their images in memory and shuffle them themselves,
+    // so they need to be read in order instead of randomly
+    virtual bool is_streaming() const = 0;
+
+    // called before each pass over a streaming image set, so it can start the next (differently
+    // shuffled) pass even if the images are never requested from a lower shard
+    virtual void start_pass() const {
+    }
+
     virtual int get_classification(int image) const = 0;
     virtual float get_pixel(int image, int z, int y, int x) const = 0;
 
+    // copies the (padded) normalized pixels of channel z for an image into values, which needs to hold
+    // get_image_height() * get_image_width() floats
+    virtual void get_subimage(int image, int z, float* values) const = 0;
+
     virtual float get_channel_avg(int channel) const = 0;
     virtual float get_channel_std_dev(int channel) const = 0;
 
@@ -52,6 +73,7 @@ class MultiImagesInterface : public ImagesInterface {
    public:
     virtual int get_number_large_images() const = 0;
     virtual int get_number_subimages(int i) const = 0;
+    virtual int get_subimage_offset(int i) const = 0;
 
     virtual int get_padding() const = 0;
 
@@ -1,5 +1,9 @@
 #include <dirent.h>
 
+#include <algorithm>
+using std::fill;
+using std::upper_bound;
+
 #include <cmath>
 #include <fstream>
 using std::ifstream;
@@ -38,8 +42,8 @@ ImageInterface::~ImageInterface() {
 }
 
 LargeImage::LargeImage(
-    ifstream& infile, int _number_subimages, int _channels, int _width, int _height, int _padding, int _classification,
-    const LargeImages* _images
+    const uint8_t* _mapped_pixels, int _number_subimages, int _channels, int _width, int _height, int _padding,
+    int _classification, const LargeImages* _images
 ) {
     number_subimages = _number_subimages;
     channels = _channels;
@@ -49,25 +53,7 @@ LargeImage::LargeImage(
     classification = _classification;
     images = _images;
 
-    // cout << "channels: " << channels << ", height: " << height << ", width: " << width << endl;
-
-    pixels = vector<vector<vector<uint8_t> > >(channels, vector<vector<uint8_t> >(height, vector<uint8_t>(width, 0)));
-
-    char* c_pixels = new char[channels * width * height];
-
-    infile.read(c_pixels, sizeof(char) * channels * width * height);
-
-    int current = 0;
-    for (int z = 0; z < channels; z++) {
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                pixels[z][y][x] = (uint8_t) c_pixels[current];
-                current++;
-                // cout << "pixels[" << z << "][" << y << "][" << x << "]: " << (int)pixels[z][y][x] << endl;
-            }
-        }
-    }
-    delete[] c_pixels;
+    mapped_pixels = _mapped_pixels;
 }
 
 LargeImage::LargeImage(
@@ -80,7 +66,7 @@ LargeImage::LargeImage(
     height = _height;
     padding = _padding;
     classification = _classification;
-    pixels = _pixels;
+    copy_pixels(_pixels);
 }
 
 LargeImage::LargeImage(
@@ -93,12 +79,43 @@ LargeImage::LargeImage(
     height = _height;
     padding = _padding;
     classification = _classification;
-    pixels = _pixels;
+    copy_pixels(_pixels);
     alpha = _alpha;
 }
 
+void LargeImage::copy_pixels(const vector<vector<vector<uint8_t> > >& _pixels) {
+    mapped_pixels = NULL;
+    pixel_storage.resize(channels * height * width);
+
+    int current = 0;
+    for (int32_t z = 0; z < channels; z++) {
+        for (int32_t y = 0; y < height; y++) {
+            for (int32_t x = 0; x < width; x++) {
+                pixel_storage[current] = _pixels[z][y][x];
+                current++;
+            }
+        }
+    }
+}
+
+const uint8_t* LargeImage::get_pixel_data() const {
+    if (mapped_pixels != NULL) {
+        return mapped_pixels;
+    } else {
+        return pixel_storage.data();
+    }
+}
+
 LargeImage* LargeImage::copy() const {
-    return new LargeImage(number_subimages, channels, width, height, padding, classification, pixels);
+    // copies always own their pixels so they can outlive a memory mapped image set
+    LargeImage* image = new LargeImage(*this);
+    if (mapped_pixels != NULL) {
+        image->pixel_storage.assign(mapped_pixels, mapped_pixels + (channels * height * width));
+        image->mapped_pixels = NULL;
+    }
+    image->alpha.clear();
+
+    return image;
 }
 
 uint8_t LargeImage::get_pixel_unnormalized(int z, int y, int x) const {
@@ -107,7 +124,7 @@ uint8_t LargeImage::get_pixel_unnormalized(int z, int y, int x) const {
     } else if (y >= height + padding || x >= width + padding) {
         return 0;
     } else {
-        return pixels[z][y - padding][x - padding];
+        return get_pixel_data()[(((z * height) + (y - padding)) * width) + (x - padding)];
     }
 }
 
@@ -127,7 +144,13 @@ void LargeImage::set_pixel(int z, int y, int x, uint8_t value) {
     } else if (y >= height + padding || x >= width + padding) {
         return;
     } else {
-        pixels[z][y - padding][x - padding] = value;
+        // the memory mapped file is read only, so take a private copy before modifying it
+        if (mapped_pixels != NULL) {
+            pixel_storage.assign(mapped_pixels, mapped_pixels + (channels * height * width));
+            mapped_pixels = NULL;
+        }
+
+        pixel_storage[(((z * height) + (y - padding)) * width) + (x - padding)] = value;
     }
 }
 
@@ -137,7 +160,29 @@ uint8_t LargeImage::get_pixel(int z, int y, int x) const {
     } else if (y >= height + padding || x >= width + padding) {
         return 0;
     } else {
-        return pixels[z][y - padding][x - padding];
+        return get_pixel_data()[(((z * height) + (y - padding)) * width) + (x - padding)];
+    }
+}
+
+void LargeImage::get_subimage(
+    int z, int y_offset, int x_offset, int subimage_height, int subimage_width, float channel_avg,
+    float channel_std_dev, float* values
+) const {
+    int padded_width = subimage_width + (2 * padding);
+    int padded_height = subimage_height + (2 * padding);
+
+    // zero the whole tile first so only the padding is left when the
+    // interior is copied over
+    fill(values, values + (padded_height * padded_width), 0.0f);
+
+    const uint8_t* channel_pixels = get_pixel_data() + (z * height * width);
+    for (int32_t y = 0; y < subimage_height; y++) {
+        const uint8_t* row = channel_pixels + ((y_offset + y) * width);
+        float* tile_row = values + ((y + padding) * padded_width) + padding;
+
+        for (int32_t x = 0; x < subimage_width; x++) {
+            tile_row[x] = ((row[x_offset + x] / 255.0) - channel_avg) / channel_std_dev;
+        }
     }
 }
 
@@ -395,10 +440,13 @@ void LargeImage::get_pixel_avg(vector<float>& channel_avgs) const {
 
     // cout << "channels: " << channels << ", height: " << height << ", width: " << width << endl;
 
+    const uint8_t* pixels = get_pixel_data();
+    int current = 0;
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                channel_avgs[z] += pixels[z][y][x] / 255.0;
+                channel_avgs[z] += pixels[current] / 255.0;
+                current++;
             }
         }
         channel_avgs[z] /= (height * width);
@@ -409,12 +457,15 @@ void LargeImage::get_pixel_variance(const vector<float>& channel_avgs, vector<fl
     channel_variances.clear();
     channel_variances.assign(channels, 0.0);
 
+    const uint8_t* pixels = get_pixel_data();
+    int current = 0;
     float tmp;
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                tmp = channel_avgs[z] - (pixels[z][y][x] / 255.0);
+                tmp = channel_avgs[z] - (pixels[current] / 255.0);
                 channel_variances[z] += tmp * tmp;
+                current++;
             }
         }
 
@@ -449,10 +500,11 @@ void LargeImage::set_alpha(const vector<vector<float> >& _alpha) {
 
 void LargeImage::print(ostream& out) {
     out << "LargeImage Class: " << classification << endl;
+    const uint8_t* pixels = get_pixel_data();
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                out << setw(7) << pixels[z][y][x];
+                out << setw(7) << pixels[(((z * height) + y) * width) + x];
             }
             out << endl;
         }
@@ -468,18 +520,65 @@ int LargeImages::read_images_from_file(string _filename) {
 
     cout << "reading filename: " << filename << endl;
 
-    ifstream infile(filename.c_str(), ios::in | ios::binary);
-
-    if (!infile.is_open()) {
-        cerr << "Could not open '" << filename << "' for reading." << endl;
+    mapped_file = new MappedImageFile();
+    if (mapped_file->map(filename)) {
         return 1;
     }
 
-    int initial_vals[2];
-    infile.read((char*) &initial_vals, sizeof(initial_vals));
+    const uint8_t* data = mapped_file->get_data();
 
-    number_classes = initial_vals[0];
-    number_images = initial_vals[1];
+    vector<ImageFileEntry> entries;
+    if (mapped_file->is_versioned()) {
+        const ImageFileHeader* header = mapped_file->get_header();
+
+        number_classes = header->number_classes;
+        number_images = header->number_images;
+        entries.assign(mapped_file->get_entries(), mapped_file->get_entries() + number_images);
+
+        if (header->has_statistics) {
+            channel_avg.assign(mapped_file->get_channel_avg(), mapped_file->get_channel_avg() + header->channels);
+            channel_std_dev.assign(
+                mapped_file->get_channel_std_dev(), mapped_file->get_channel_std_dev() + header->channels
+            );
+        }
+    } else {
+        // the original format: number_classes, number_images, then for each image its class,
+        // channels, height and width followed by its pixels
+        if (mapped_file->get_size() < sizeof(int) * 2) {
+            cerr << "Could not read '" << filename << "', the file is truncated." << endl;
+            return 1;
+        }
+
+        const int* initial_vals = (const int*) data;
+        number_classes = initial_vals[0];
+        number_images = initial_vals[1];
+
+        size_t current_offset = sizeof(int) * 2;
+        for (int i = 0; i < number_images; i++) {
+            if (current_offset + (sizeof(int) * 4) > mapped_file->get_size()) {
+                cerr << "Could not read '" << filename << "', the file is truncated." << endl;
+                return 1;
+            }
+
+            const int* image_vals = (const int*) (data + current_offset);
+            current_offset += sizeof(int) * 4;
+
+            ImageFileEntry entry;
+            entry.classification = image_vals[0];
+            entry.channels = image_vals[1];
+            entry.height = image_vals[2];
+            entry.width = image_vals[3];
+            entry.offset = current_offset;
+            entries.push_back(entry);
+
+            current_offset += (size_t) entry.channels * entry.height * entry.width;
+        }
+
+        if (current_offset > mapped_file->get_size()) {
+            cerr << "Could not read '" << filename << "', the file is truncated." << endl;
+            return 1;
+        }
+    }
 
     cerr << "number_classes: " << number_classes << endl;
     cerr << "number_images: " << number_images << endl;
@@ -487,13 +586,10 @@ int LargeImages::read_images_from_file(string _filename) {
     class_sizes = vector<int>(number_classes, 0);
 
     for (int i = 0; i < number_images; i++) {
-        int image_vals[4];
-        infile.read((char*) &image_vals, sizeof(image_vals));
-
-        int image_class = image_vals[0];
-        channels = image_vals[1];
-        int height = image_vals[2];
-        int width = image_vals[3];
+        int image_class = entries[i].classification;
+        channels = entries[i].channels;
+        int height = entries[i].height;
+        int width = entries[i].width;
 
         cerr << "image[" << i << "] class: " << image_class << ", channels: " << channels << ", height: " << height
              << ", width: " << width << endl;
@@ -504,17 +600,21 @@ int LargeImages::read_images_from_file(string _filename) {
         int subimages_along_height = (height - subimage_height) + 1;
         int number_subimages = subimages_along_width * subimages_along_height;
 
-        LargeImage large_image(infile, number_subimages, channels, width, height, padding, image_class, this);
-
         if (number_subimages < 0) {
             cerr << "ERROR! number subimages < 0!" << endl;
             continue;
         }
 
-        images.push_back(large_image);
-    }
+        size_t image_size = (size_t) channels * height * width;
+        if (entries[i].offset > mapped_file->get_size() || image_size > mapped_file->get_size() - entries[i].offset) {
+            cerr << "Could not read '" << filename << "', image " << i << " is past the end of the file." << endl;
+            return 1;
+        }
 
-    infile.close();
+        images.push_back(LargeImage(
+            data + entries[i].offset, number_subimages, channels, width, height, padding, image_class, this
+        ));
+    }
 
     cerr << "read " << images.size() << " images." << endl;
     for (int i = 0; i < (int32_t) class_sizes.size(); i++) {
@@ -522,10 +622,7 @@ int LargeImages::read_images_from_file(string _filename) {
     }
 
     // update number images to number of subimages
-    number_images = 0;
-    for (int i = 0; i < images.size(); i++) {
-        number_images += images[i].get_number_subimages();
-    }
+    initialize_subimage_index();
 
     cerr << "number_subimages: " << number_images << endl;
 
@@ -734,6 +831,7 @@ LargeImages::LargeImages(
     padding = _padding;
     subimage_height = _subimage_height;
     subimage_width = _subimage_width;
+    mapped_file = NULL;
 
     filename = _filename;
     cout << "filename substr: " << filename.substr(filename.size() - 4, 4) << endl;
@@ -744,6 +842,7 @@ LargeImages::LargeImages(
     } else {
         cout << "reading images from directory: " << endl;
         read_images_from_directory(filename);
+        initialize_subimage_index();
 #endif
     }
 
@@ -760,6 +859,7 @@ LargeImages::LargeImages(string _filename, int _padding, int _subimage_height, i
     padding = _padding;
     subimage_height = _subimage_height;
     subimage_width = _subimage_width;
+    mapped_file = NULL;
 
     filename = _filename;
     cout << "filename substr: " << filename.substr(filename.size() - 4, 4) << endl;
@@ -770,10 +870,38 @@ LargeImages::LargeImages(string _filename, int _padding, int _subimage_height, i
     } else {
         cout << "reading images from directory: " << endl;
         read_images_from_directory(filename);
+        initialize_subimage_index();
 #endif
     }
 
-    calculate_avg_std_dev();
+    // versioned image files store the statistics of their images so there is no need to
+    // page in the whole file to recalculate them
+    if (channel_avg.size() == 0) {
+        calculate_avg_std_dev();
+    }
+}
+
+LargeImages::~LargeImages() {
+    delete mapped_file;
+}
+
+int LargeImages::write_image_file(string output_filename) const {
+    vector<ImageFileEntry> entries(images.size());
+    vector<const uint8_t*> pixels(images.size());
+
+    for (uint32_t i = 0; i < images.size(); i++) {
+        entries[i].classification = images[i].classification;
+        entries[i].channels = images[i].channels;
+        entries[i].height = images[i].height;
+        entries[i].width = images[i].width;
+        entries[i].offset = 0;
+
+        pixels[i] = images[i].get_pixel_data();
+    }
+
+    return ::write_image_file(
+        output_filename, number_classes, channels, class_sizes, channel_avg, channel_std_dev, entries, pixels
+    );
 }
 
 int LargeImages::get_class_size(int i) const {
@@ -796,6 +924,39 @@ int LargeImages::get_number_subimages(int i) const {
     return images[i].get_number_subimages();
 }
 
+int LargeImages::get_subimage_offset(int i) const {
+    return subimage_offsets[i];
+}
+
+void LargeImages::initialize_subimage_index() {
+    subimage_offsets.assign(images.size() + 1, 0);
+    for (int32_t i = 0; i < images.size(); i++) {
+        subimage_offsets[i + 1] = subimage_offsets[i] + images[i].get_number_subimages();
+    }
+
+    number_images = subimage_offsets.back();
+}
+
+int LargeImages::get_subimage_location(int subimage, int& y_offset, int& x_offset) const {
+    if (subimage < 0 || subimage >= number_images) {
+        cerr << "Error locating subimage, subimage was: " << subimage << " and there are only " << number_images
+             << " subimages!" << endl;
+        exit(1);
+    }
+
+    // the owning image is the last one whose first subimage is <= subimage, images
+    // without any subimages share an offset with the next image so they are skipped
+    int image = (upper_bound(subimage_offsets.begin(), subimage_offsets.end(), subimage) - subimage_offsets.begin()) - 1;
+
+    int local_subimage = subimage - subimage_offsets[image];
+    int subimages_along_width = images[image].get_width() - subimage_width + 1;
+
+    y_offset = local_subimage / subimages_along_width;
+    x_offset = local_subimage % subimages_along_width;
+
+    return image;
+}
+
 int LargeImages::get_padding() const {
     return padding;
 }
@@ -812,6 +973,10 @@ int LargeImages::get_image_height() const {
     return subimage_height + (2 * padding);
 }
 
+bool LargeImages::is_streaming() const {
+    return false;
+}
+
 int LargeImages::get_large_image_height(int image) const {
     return images[image].get_height();
 }
@@ -829,57 +994,32 @@ int LargeImages::get_image_classification(int image) const {
 }
 
 int LargeImages::get_classification(int subimage) const {
-    for (int32_t i = 0; i < images.size(); i++) {
-        if (subimage < images[i].get_number_subimages()) {
-            return images[i].get_classification();
-        } else {
-            subimage -= images[i].get_number_subimages();
-
-            if (i == images.size() - 1) {
-                return images[i].get_classification();
-            }
-        }
-    }
-
-    cerr << "Error getting classification, subimage was: " << subimage << " and there are not that many subimages!"
-         << endl;
-    exit(1);
-    return 0;
+    int y_offset, x_offset;
+    return images[get_subimage_location(subimage, y_offset, x_offset)].get_classification();
 }
 
 float LargeImages::get_pixel(int subimage, int z, int y, int x) const {
     // cout << "getting pixel from subimage: " << subimage << ", z: " << z << ", y: " << y << ", x: " << x << endl;
 
-    int32_t i;
-    for (i = 0; i < images.size(); i++) {
-        if (subimage < images[i].get_number_subimages()) {
-            const LargeImage& image = images[i];
-
-            if (y < padding || x < padding) {
-                return 0;
-            } else if (y >= subimage_height + padding || x >= subimage_width + padding) {
-                return 0;
-            } else {
-                int subimages_along_width = image.get_width() - subimage_width + 1;
-
-                int subimage_y_offset = subimage / subimages_along_width;
-                int subimage_x_offset = subimage % subimages_along_width;
+    if (y < padding || x < padding) {
+        return 0;
+    } else if (y >= subimage_height + padding || x >= subimage_width + padding) {
+        return 0;
+    } else {
+        int y_offset, x_offset;
+        const LargeImage& image = images[get_subimage_location(subimage, y_offset, x_offset)];
 
-                return ((image.get_pixel(z, subimage_y_offset + y, subimage_x_offset + x) / 255.0) - channel_avg[z])
-                       / channel_std_dev[z];
-            }
-        } else {
-            subimage -= images[i].get_number_subimages();
-        }
+        return ((image.get_pixel(z, y_offset + y, x_offset + x) / 255.0) - channel_avg[z]) / channel_std_dev[z];
     }
+}
 
-    cerr << "Error getting normalized pixel, subimage was: " << subimage << " and there are not that many subimages!"
-         << endl;
-    cerr << "images[" << i << "] had " << images[subimage].get_number_subimages() << " subimages" << endl;
-    cerr << "images[" << i << "].get_height(): " << images[subimage].get_height() << endl;
-    cerr << "images[" << i << "].get_width(): " << images[subimage].get_width() << endl;
-    exit(1);
-    return 0;
+void LargeImages::get_subimage(int subimage, int z, float* values) const {
+    int y_offset, x_offset;
+    const LargeImage& image = images[get_subimage_location(subimage, y_offset, x_offset)];
+
+    image.get_subimage(
+        z, y_offset, x_offset, subimage_height, subimage_width, channel_avg[z], channel_std_dev[z], values
+    );
 }
 
 const vector<float>& LargeImages::get_average() const {
@@ -953,7 +1093,7 @@ LargeImage* LargeImages::copy_image(int i) const {
 }
 
 float LargeImages::get_raw_pixel(int subimage, int z, int y, int x) const {
-    return images[subimage].pixels[z][y][x];
+    return images[subimage].get_pixel_data()[(((z * images[subimage].height) + y) * images[subimage].width) + x];
 }
 
 #ifdef LARGE_IMAGES_TEST
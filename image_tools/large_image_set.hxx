@@ -14,6 +14,7 @@ using std::string;
 using std::vector;
 
 #include "image_set_interface.hxx"
+#include "mapped_image_file.hxx"
 
 typedef class LargeImages LargeImages;
 
@@ -27,15 +28,23 @@ class LargeImage : public ImageInterface {
     int height;
     int width;
     int classification;
-    vector<vector<vector<uint8_t> > > pixels;
+
+    // channel major (z, y, x) pixels, either owned in pixel_storage or pointing into
+    // the memory mapped file of the image set (in which case pixel_storage is empty)
+    vector<uint8_t> pixel_storage;
+    const uint8_t* mapped_pixels;
+
     vector<vector<uint8_t> > alpha;
 
     // reference to images to get channel avgs and std_Devs
     const LargeImages* images;
 
+    void copy_pixels(const vector<vector<vector<uint8_t> > >& _pixels);
+    const uint8_t* get_pixel_data() const;
+
    public:
     LargeImage(
-        ifstream& infile, int _number_subimages, int _channels, int _width, int _height, int _padding,
+        const uint8_t* _mapped_pixels, int _number_subimages, int _channels, int _width, int _height, int _padding,
         int _classification, const LargeImages* _images
     );
     LargeImage(
@@ -66,6 +75,11 @@ class LargeImage : public ImageInterface {
     void set_pixel(int z, int y, int x, uint8_t value);
     uint8_t get_pixel(int z, int y, int x) const;
 
+    void get_subimage(
+        int z, int y_offset, int x_offset, int subimage_height, int subimage_width, float channel_avg,
+        float channel_std_dev, float* values
+    ) const;
+
     void set_alpha(const vector<vector<uint8_t> >& _alpha);
     void set_alpha(const vector<vector<float> >& _alpha);
 
@@ -97,17 +111,33 @@ class LargeImages : public MultiImagesInterface {
 
     vector<LargeImage> images;
 
+    // subimage_offsets[i] is the index of the first subimage of images[i], with one extra
+    // entry at the end holding the total number of subimages
+    vector<int> subimage_offsets;
+
     vector<float> channel_avg;
     vector<float> channel_std_dev;
 
+    // images read from a binary file are views into this mapping, so it needs to live as
+    // long as the image set
+    MappedImageFile* mapped_file;
+
    public:
     int read_images_from_file(string binary_filename);
+    int write_image_file(string output_filename) const;
+
+    void initialize_subimage_index();
+    int get_subimage_location(int subimage, int& y_offset, int& x_offset) const;
 
     LargeImages(string binary_filename, int _padding, int _subimage_height, int _subimage_width);
     LargeImages(
         string binary_filename, int _padding, int _subimage_height, int _subimage_width,
         const vector<float>& _channel_avg, const vector<float>& channel_std_dev
     );
+    ~LargeImages();
+
+    LargeImages(const LargeImages&) = delete;
+    LargeImages& operator=(const LargeImages&) = delete;
 
     string get_filename() const;
 
@@ -118,6 +148,7 @@ class LargeImages : public MultiImagesInterface {
     int get_number_images() const;
     int get_number_large_images() const;
     int get_number_subimages(int i) const;
+    int get_subimage_offset(int i) const;
 
     int get_padding() const;
 
@@ -125,6 +156,8 @@ class LargeImages : public MultiImagesInterface {
     int get_image_width() const;
     int get_image_height() const;
 
+    bool is_streaming() const;
+
     int get_large_image_channels(int image) const;
     int get_large_image_width(int image) const;
     int get_large_image_height(int image) const;
@@ -133,6 +166,7 @@ class LargeImages : public MultiImagesInterface {
     int get_classification(int subimage) const;
     float get_pixel(int subimage, int z, int y, int x) const;
     float get_raw_pixel(int subimage, int z, int y, int x) const;
+    void get_subimage(int subimage, int z, float* values) const;
 
     void calculate_avg_std_dev();
 
@@ -0,0 +1,194 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include <fstream>
+using std::ios;
+using std::ofstream;
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "mapped_image_file.hxx"
+
+// pixel data starts on a page boundary so each image's pixels can be paged in independently
+static const uint64_t IMAGE_FILE_DATA_ALIGNMENT = 4096;
+
+static uint64_t align_offset(uint64_t offset, uint64_t alignment) {
+    return ((offset + alignment - 1) / alignment) * alignment;
+}
+
+MappedImageFile::MappedImageFile() {
+    file_descriptor = -1;
+    data = NULL;
+    size = 0;
+    header = NULL;
+}
+
+MappedImageFile::~MappedImageFile() {
+    if (data != NULL) {
+        munmap(data, size);
+    }
+
+    if (file_descriptor >= 0) {
+        close(file_descriptor);
+    }
+}
+
+int MappedImageFile::map(string _filename) {
+    filename = _filename;
+
+    file_descriptor = open(filename.c_str(), O_RDONLY);
+    if (file_descriptor < 0) {
+        cerr << "Could not open '" << filename << "' for reading: " << strerror(errno) << endl;
+        return 1;
+    }
+
+    struct stat file_stat;
+    if (fstat(file_descriptor, &file_stat) != 0) {
+        cerr << "Could not stat '" << filename << "': " << strerror(errno) << endl;
+        return 1;
+    }
+
+    size = file_stat.st_size;
+    if (size == 0) {
+        cerr << "Could not map '" << filename << "', the file is empty." << endl;
+        return 1;
+    }
+
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+    if (mapping == MAP_FAILED) {
+        cerr << "Could not memory map '" << filename << "': " << strerror(errno) << endl;
+        size = 0;
+        return 1;
+    }
+    data = (uint8_t*) mapping;
+
+    if (size >= sizeof(ImageFileHeader) && memcmp(data, IMAGE_FILE_MAGIC, sizeof(header->magic)) == 0) {
+        header = (const ImageFileHeader*) data;
+
+        if (header->version != IMAGE_FILE_VERSION) {
+            cerr << "Could not read '" << filename << "', image file version " << header->version
+                 << " is not supported (expected " << IMAGE_FILE_VERSION << ")." << endl;
+            return 1;
+        }
+
+        if (header->entries_offset + (header->number_images * sizeof(ImageFileEntry)) > size
+            || header->data_offset > size) {
+            cerr << "Could not read '" << filename << "', the file is truncated." << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+const uint8_t* MappedImageFile::get_data() const {
+    return data;
+}
+
+size_t MappedImageFile::get_size() const {
+    return size;
+}
+
+bool MappedImageFile::is_versioned() const {
+    return header != NULL;
+}
+
+const ImageFileHeader* MappedImageFile::get_header() const {
+    return header;
+}
+
+const int32_t* MappedImageFile::get_class_sizes() const {
+    return (const int32_t*) (data + sizeof(ImageFileHeader));
+}
+
+const float* MappedImageFile::get_channel_avg() const {
+    return (const float*) (data + header->statistics_offset);
+}
+
+const float* MappedImageFile::get_channel_std_dev() const {
+    return (const float*) (data + header->statistics_offset) + header->channels;
+}
+
+const ImageFileEntry* MappedImageFile::get_entries() const {
+    return (const ImageFileEntry*) (data + header->entries_offset);
+}
+
+int write_image_file(
+    string filename, int number_classes, int channels, const vector<int>& class_sizes, const vector<float>& channel_avg,
+    const vector<float>& channel_std_dev, const vector<ImageFileEntry>& entries, const vector<const uint8_t*>& pixels
+) {
+    ofstream outfile(filename.c_str(), ios::out | ios::binary);
+    if (!outfile.is_open()) {
+        cerr << "Could not open '" << filename << "' for writing." << endl;
+        return 1;
+    }
+
+    ImageFileHeader header;
+    memset(&header, 0, sizeof(ImageFileHeader));
+    memcpy(header.magic, IMAGE_FILE_MAGIC, sizeof(header.magic));
+    header.version = IMAGE_FILE_VERSION;
+    header.number_classes = number_classes;
+    header.number_images = entries.size();
+    header.channels = channels;
+    header.has_statistics = (channel_avg.size() == channels && channel_std_dev.size() == channels);
+
+    header.statistics_offset = sizeof(ImageFileHeader) + (number_classes * sizeof(int32_t));
+    header.entries_offset = align_offset(header.statistics_offset + (2 * channels * sizeof(float)), sizeof(uint64_t));
+    header.data_offset =
+        align_offset(header.entries_offset + (entries.size() * sizeof(ImageFileEntry)), IMAGE_FILE_DATA_ALIGNMENT);
+
+    vector<ImageFileEntry> file_entries(entries);
+    uint64_t current_offset = header.data_offset;
+    for (uint32_t i = 0; i < file_entries.size(); i++) {
+        file_entries[i].offset = current_offset;
+        current_offset += (uint64_t) file_entries[i].channels * file_entries[i].height * file_entries[i].width;
+    }
+
+    vector<char> zeros(IMAGE_FILE_DATA_ALIGNMENT, 0);
+
+    outfile.write((char*) &header, sizeof(ImageFileHeader));
+    for (int32_t i = 0; i < number_classes; i++) {
+        int32_t class_size = class_sizes[i];
+        outfile.write((char*) &class_size, sizeof(int32_t));
+    }
+
+    vector<float> statistics(2 * channels, 0.0);
+    if (header.has_statistics) {
+        for (int32_t i = 0; i < channels; i++) {
+            statistics[i] = channel_avg[i];
+            statistics[channels + i] = channel_std_dev[i];
+        }
+    }
+    outfile.write((char*) &statistics[0], statistics.size() * sizeof(float));
+
+    outfile.write(&zeros[0], header.entries_offset - outfile.tellp());
+    outfile.write((char*) &file_entries[0], file_entries.size() * sizeof(ImageFileEntry));
+
+    outfile.write(&zeros[0], header.data_offset - outfile.tellp());
+    for (uint32_t i = 0; i < file_entries.size(); i++) {
+        outfile.write(
+            (const char*) pixels[i], (uint64_t) file_entries[i].channels * file_entries[i].height * file_entries[i].width
+        );
+    }
+
+    if (!outfile.good()) {
+        cerr << "Error writing image file '" << filename << "'." << endl;
+        return 1;
+    }
+    outfile.close();
+
+    return 0;
+}
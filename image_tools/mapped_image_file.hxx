@@ -0,0 +1,88 @@
+#ifndef MAPPED_IMAGE_FILE_HXX
+#define MAPPED_IMAGE_FILE_HXX
+
+#include <cstdint>
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+/**
+ * Version 1 of the memory mappable image set layout (all values are native endian):
+ *
+ *     ImageFileHeader
+ *     int32_t class_sizes[number_classes]
+ *     float channel_avg[channels], float channel_std_dev[channels]    (at statistics_offset, if has_statistics)
+ *     ImageFileEntry entries[number_images]                          (at entries_offset)
+ *     uint8_t pixels[]                                               (at data_offset, page aligned)
+ *
+ * Each image's pixels are stored channel major (z, y, x) starting at its entry's offset, so the image
+ * sets can point straight into the mapping instead of copying anything out of it.
+ */
+#define IMAGE_FILE_MAGIC "EXACTIMG"
+#define IMAGE_FILE_VERSION 1
+
+struct ImageFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t number_classes;
+    uint32_t number_images;
+    uint32_t channels;
+    uint32_t has_statistics;
+    uint32_t reserved;
+    uint64_t statistics_offset;
+    uint64_t entries_offset;
+    uint64_t data_offset;
+};
+
+struct ImageFileEntry {
+    int32_t classification;
+    int32_t channels;
+    int32_t height;
+    int32_t width;
+    uint64_t offset;
+};
+
+class MappedImageFile {
+   private:
+    string filename;
+    int file_descriptor;
+    uint8_t* data;
+    size_t size;
+
+    const ImageFileHeader* header;
+
+   public:
+    MappedImageFile();
+    ~MappedImageFile();
+
+    /**
+     * Maps the file read only and shared, so every process on a node reading the same
+     * file uses the same pages of the page cache. Returns 0 on success.
+     */
+    int map(string _filename);
+
+    const uint8_t* get_data() const;
+    size_t get_size() const;
+
+    /**
+     * Returns true if the file starts with the versioned header, otherwise it is one of
+     * the original unversioned binary formats and must be parsed by the caller.
+     */
+    bool is_versioned() const;
+
+    const ImageFileHeader* get_header() const;
+    const int32_t* get_class_sizes() const;
+    const float* get_channel_avg() const;
+    const float* get_channel_std_dev() const;
+    const ImageFileEntry* get_entries() const;
+};
+
+int write_image_file(
+    string filename, int number_classes, int channels, const vector<int>& class_sizes, const vector<float>& channel_avg,
+    const vector<float>& channel_std_dev, const vector<ImageFileEntry>& entries, const vector<const uint8_t*>& pixels
+);
+
+#endif
@@ -1,5 +1,8 @@
 #include <dirent.h>
 
+#include <algorithm>
+using std::upper_bound;
+
 #include <cmath>
 #include <fstream>
 using std::ifstream;
@@ -257,12 +260,40 @@ void MosaicImages::initialize_counts(const vector<vector<int> >& classes) {
 
     class_sizes.assign(number_classes, 0);
 
-    number_images = 0;
     for (uint32_t i = 0; i < images.size(); i++) {
-        int32_t number_subimages = images[i].get_number_subimages();
-        number_images += number_subimages;
-        class_sizes[images[i].get_classification()] += number_subimages;
+        class_sizes[images[i].get_classification()] += images[i].get_number_subimages();
+    }
+
+    initialize_subimage_index();
+}
+
+void MosaicImages::initialize_subimage_index() {
+    subimage_offsets.assign(images.size() + 1, 0);
+    for (int32_t i = 0; i < images.size(); i++) {
+        subimage_offsets[i + 1] = subimage_offsets[i] + images[i].get_number_subimages();
+    }
+
+    number_images = subimage_offsets.back();
+}
+
+int MosaicImages::get_subimage_location(int subimage, int& y_offset, int& x_offset) const {
+    if (subimage < 0 || subimage >= number_images) {
+        cerr << "Error locating subimage, subimage was: " << subimage << " and there are only " << number_images
+             << " subimages!" << endl;
+        exit(1);
     }
+
+    // the owning image is the last one whose first subimage is <= subimage, images
+    // without any subimages share an offset with the next image so they are skipped
+    int image = (upper_bound(subimage_offsets.begin(), subimage_offsets.end(), subimage) - subimage_offsets.begin()) - 1;
+
+    int local_subimage = subimage - subimage_offsets[image];
+    int subimages_along_width = images[image].get_width() - subimage_width + 1;
+
+    y_offset = local_subimage / subimages_along_width;
+    x_offset = local_subimage % subimages_along_width;
+
+    return image;
 }
 
 MosaicImages::MosaicImages(
@@ -380,6 +411,10 @@ int MosaicImages::get_number_subimages(int i) const {
     return images[i].get_number_subimages();
 }
 
+int MosaicImages::get_subimage_offset(int i) const {
+    return subimage_offsets[i];
+}
+
 int MosaicImages::get_padding() const {
     return padding;
 }
@@ -396,6 +431,10 @@ int MosaicImages::get_image_height() const {
     return subimage_height + (2 * padding);
 }
 
+bool MosaicImages::is_streaming() const {
+    return false;
+}
+
 int MosaicImages::get_large_image_height(int image) const {
     return images[image].get_height();
 }
@@ -413,57 +452,32 @@ int MosaicImages::get_image_classification(int image) const {
 }
 
 int MosaicImages::get_classification(int subimage) const {
-    for (int32_t i = 0; i < images.size(); i++) {
-        if (subimage < images[i].get_number_subimages()) {
-            return images[i].get_classification();
-        } else {
-            subimage -= images[i].get_number_subimages();
-
-            if (i == images.size() - 1) {
-                return images[i].get_classification();
-            }
-        }
-    }
-
-    cerr << "Error getting classification, subimage was: " << subimage << " and there are not that many subimages!"
-         << endl;
-    exit(1);
-    return 0;
+    int y_offset, x_offset;
+    return images[get_subimage_location(subimage, y_offset, x_offset)].get_classification();
 }
 
 float MosaicImages::get_pixel(int subimage, int z, int y, int x) const {
     // cout << "getting pixel from subimage: " << subimage << ", z: " << z << ", y: " << y << ", x: " << x << endl;
 
-    int32_t i;
-    for (i = 0; i < images.size(); i++) {
-        if (subimage < images[i].get_number_subimages()) {
-            const LargeImage& image = images[i];
-
-            if (y < padding || x < padding) {
-                return 0;
-            } else if (y >= subimage_height + padding || x >= subimage_width + padding) {
-                return 0;
-            } else {
-                int subimages_along_width = image.get_width() - subimage_width + 1;
+    if (y < padding || x < padding) {
+        return 0;
+    } else if (y >= subimage_height + padding || x >= subimage_width + padding) {
+        return 0;
+    } else {
+        int y_offset, x_offset;
+        const LargeImage& image = images[get_subimage_location(subimage, y_offset, x_offset)];
 
-                int subimage_y_offset = subimage / subimages_along_width;
-                int subimage_x_offset = subimage % subimages_along_width;
-
-                return ((image.get_pixel(z, subimage_y_offset + y, subimage_x_offset + x) / 255.0) - channel_avg[z])
-                       / channel_std_dev[z];
-            }
-        } else {
-            subimage -= images[i].get_number_subimages();
-        }
+        return ((image.get_pixel(z, y_offset + y, x_offset + x) / 255.0) - channel_avg[z]) / channel_std_dev[z];
     }
+}
+
+void MosaicImages::get_subimage(int subimage, int z, float* values) const {
+    int y_offset, x_offset;
+    const LargeImage& image = images[get_subimage_location(subimage, y_offset, x_offset)];
 
-    cerr << "Error getting normalized pixel, subimage was: " << subimage << " and there are not that many subimages!"
-         << endl;
-    cerr << "images[" << i << "] had " << images[i].get_number_subimages() << " subimages" << endl;
-    cerr << "images[" << i << "].get_height(): " << images[i].get_height() << endl;
-    cerr << "images[" << i << "].get_width(): " << images[i].get_width() << endl;
-    exit(1);
-    return 0;
+    image.get_subimage(
+        z, y_offset, x_offset, subimage_height, subimage_width, channel_avg[z], channel_std_dev[z], values
+    );
 }
 
 const vector<float>& MosaicImages::get_average() const {
@@ -61,6 +61,10 @@ class MosaicImages : public MultiImagesInterface {
 
     vector<LargeImage> images;
 
+    // subimage_offsets[i] is the index of the first subimage of images[i], with one extra
+    // entry at the end holding the total number of subimages
+    vector<int> subimage_offsets;
+
     vector<float> channel_avg;
     vector<float> channel_std_dev;
 
@@ -74,6 +78,9 @@ class MosaicImages : public MultiImagesInterface {
 
     void initialize_counts(const vector<vector<int> >& classes);
 
+    void initialize_subimage_index();
+    int get_subimage_location(int subimage, int& y_offset, int& x_offset) const;
+
     MosaicImages(
         vector<string> _filenames, const vector<vector<Point> >& _box_centers, int _box_radius,
         const vector<vector<int> >& _box_classes, int _padding, int _subimage_height, int _subimage_width
@@ -105,6 +112,7 @@ class MosaicImages : public MultiImagesInterface {
     int get_number_images() const;
     int get_number_large_images() const;
     int get_number_subimages(int i) const;
+    int get_subimage_offset(int i) const;
 
     int get_padding() const;
 
@@ -112,6 +120,8 @@ class MosaicImages : public MultiImagesInterface {
     int get_image_width() const;
     int get_image_height() const;
 
+    bool is_streaming() const;
+
     int get_large_image_channels(int image) const;
     int get_large_image_width(int image) const;
     int get_large_image_height(int image) const;
@@ -120,6 +130,7 @@ class MosaicImages : public MultiImagesInterface {
     int get_classification(int subimage) const;
     float get_pixel(int subimage, int z, int y, int x) const;
     float get_raw_pixel(int subimage, int z, int y, int x) const;
+    void get_subimage(int subimage, int z, float* values) const;
 
     void calculate_avg_std_dev();
 
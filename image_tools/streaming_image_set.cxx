@@ -0,0 +1,550 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstring>
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <iomanip>
+using std::setw;
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/random.hxx"
+#include "mapped_image_file.hxx"
+#include "streaming_image_set.hxx"
+
+ImageShard::ImageShard() {
+    sequence = -1;
+    ready = false;
+    number_images = 0;
+}
+
+StreamingImages::StreamingImages(string _filename, int _padding, int _shard_size, int _chunk_size, int seed)
+    : StreamingImages(_filename, _padding, _shard_size, _chunk_size, seed, vector<float>(), vector<float>()) {
+}
+
+StreamingImages::StreamingImages(
+    string _filename, int _padding, int _shard_size, int _chunk_size, int seed, const vector<float>& _channel_avg,
+    const vector<float>& _channel_std_dev
+) {
+    filename = _filename;
+    padding = _padding;
+    shard_size = _shard_size;
+    chunk_size = _chunk_size;
+    generator = minstd_rand0(seed);
+
+    file_descriptor = -1;
+    finished = false;
+
+    consumer_sequence = 0;
+    next_sequence = 0;
+    order_epoch = -1;
+
+    consumer_epoch = 0;
+    current_shard = -1;
+    current_buffer = NULL;
+    previous_buffer = NULL;
+
+    if (shard_size < 1 || chunk_size < 1) {
+        cerr << "ERROR: streaming images need a shard size and chunk size of at least 1, shard size was: "
+             << shard_size << ", chunk size was: " << chunk_size << endl;
+        had_error = true;
+        return;
+    }
+
+    had_error = read_header();
+    if (had_error) {
+        return;
+    }
+
+    if (_channel_avg.size() > 0) {
+        channel_avg = _channel_avg;
+        channel_std_dev = _channel_std_dev;
+    } else if (channel_avg.size() == 0) {
+        calculate_avg_std_dev();
+    }
+
+    shards_per_epoch = (number_images + shard_size - 1) / shard_size;
+
+    int number_chunks = (number_images + chunk_size - 1) / chunk_size;
+    for (int32_t i = 0; i < number_chunks; i++) {
+        chunk_order.push_back(i);
+    }
+
+    cerr << "streaming " << number_images << " images from '" << filename << "' in " << shards_per_epoch
+         << " shards of " << shard_size << " images, read in chunks of " << chunk_size << " images" << endl;
+}
+
+StreamingImages::~StreamingImages() {
+    if (prefetch_thread.joinable()) {
+        {
+            lock_guard<mutex> lock(shard_mutex);
+            finished = true;
+        }
+        shard_condition.notify_all();
+        prefetch_thread.join();
+    }
+
+    if (file_descriptor >= 0) {
+        close(file_descriptor);
+    }
+}
+
+int StreamingImages::read_header() {
+    file_descriptor = open(filename.c_str(), O_RDONLY);
+    if (file_descriptor < 0) {
+        cerr << "Could not open '" << filename << "' for reading: " << strerror(errno) << endl;
+        return 1;
+    }
+
+    ImageFileHeader header;
+    ssize_t header_bytes = pread(file_descriptor, &header, sizeof(ImageFileHeader), 0);
+
+    if (header_bytes == sizeof(ImageFileHeader) && memcmp(header.magic, IMAGE_FILE_MAGIC, sizeof(header.magic)) == 0) {
+        if (header.version != IMAGE_FILE_VERSION) {
+            cerr << "Could not read '" << filename << "', image file version " << header.version
+                 << " is not supported (expected " << IMAGE_FILE_VERSION << ")." << endl;
+            return 1;
+        }
+
+        number_classes = header.number_classes;
+        number_images = header.number_images;
+        channels = header.channels;
+
+        if (number_images == 0) {
+            cerr << "Could not read '" << filename << "', it does not contain any images." << endl;
+            return 1;
+        }
+
+        class_sizes.resize(number_classes);
+        read_pixels(sizeof(ImageFileHeader), number_classes * sizeof(int32_t), (uint8_t*) &class_sizes[0]);
+
+        if (header.has_statistics) {
+            vector<float> statistics(2 * channels);
+            read_pixels(header.statistics_offset, statistics.size() * sizeof(float), (uint8_t*) &statistics[0]);
+            channel_avg.assign(statistics.begin(), statistics.begin() + channels);
+            channel_std_dev.assign(statistics.begin() + channels, statistics.end());
+        }
+
+        vector<ImageFileEntry> entries(number_images);
+        read_pixels(header.entries_offset, number_images * sizeof(ImageFileEntry), (uint8_t*) &entries[0]);
+
+        height = entries[0].height;
+        width = entries[0].width;
+
+        for (int32_t i = 0; i < number_images; i++) {
+            if (entries[i].channels != channels || entries[i].height != height || entries[i].width != width) {
+                cerr << "Could not read '" << filename << "', image " << i << " is " << entries[i].channels << "x"
+                     << entries[i].width << "x" << entries[i].height << " but all images in an image set must be "
+                     << channels << "x" << width << "x" << height << endl;
+                return 1;
+            }
+
+            image_offsets.push_back(entries[i].offset);
+            image_classes.push_back(entries[i].classification);
+        }
+    } else {
+        // the original format: number_classes, channels, width, height, class_sizes[number_classes]
+        // followed by the pixels of every image ordered by class
+        int initial_vals[4];
+        if (pread(file_descriptor, initial_vals, sizeof(initial_vals), 0) != sizeof(initial_vals)) {
+            cerr << "Could not read '" << filename << "', the file is truncated." << endl;
+            return 1;
+        }
+
+        number_classes = initial_vals[0];
+        channels = initial_vals[1];
+        width = initial_vals[2];
+        height = initial_vals[3];
+
+        class_sizes.resize(number_classes);
+        read_pixels(sizeof(initial_vals), number_classes * sizeof(int), (uint8_t*) &class_sizes[0]);
+
+        uint64_t current_offset = sizeof(int) * (4 + number_classes);
+        for (int32_t i = 0; i < number_classes; i++) {
+            for (int32_t j = 0; j < class_sizes[i]; j++) {
+                image_offsets.push_back(current_offset);
+                image_classes.push_back(i);
+                current_offset += channels * width * height;
+            }
+        }
+        number_images = image_offsets.size();
+    }
+
+    image_size = channels * width * height;
+
+    cerr << "number_classes: " << number_classes << endl;
+    cerr << "image_size: " << channels << "x" << width << "x" << height << " = " << image_size << endl;
+    cerr << "streaming " << number_images << " images." << endl;
+    for (int i = 0; i < (int32_t) class_sizes.size(); i++) {
+        cerr << "    class " << setw(4) << i << ": " << class_sizes[i] << endl;
+    }
+
+    return 0;
+}
+
+void StreamingImages::read_pixels(uint64_t offset, uint64_t length, uint8_t* destination) const {
+    while (length > 0) {
+        ssize_t bytes_read = pread(file_descriptor, destination, length, offset);
+
+        if (bytes_read < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (bytes_read <= 0) {
+            cerr << "ERROR: could not read " << length << " bytes at offset " << offset << " from '" << filename
+                 << "'";
+            if (bytes_read < 0) {
+                cerr << ": " << strerror(errno);
+            }
+            cerr << endl;
+            exit(1);
+        }
+
+        offset += bytes_read;
+        length -= bytes_read;
+        destination += bytes_read;
+    }
+}
+
+void StreamingImages::calculate_avg_std_dev() {
+    // the same statistics as Images::calculate_avg_std_dev, the average over all images of each
+    // image's average and variance, calculated with two sequential passes over the file
+    cerr << "calculating averages and standard deviations for streamed images" << endl;
+    channel_avg.assign(channels, 0.0);
+    channel_std_dev.assign(channels, 0.0);
+
+    vector<uint8_t> pixels(image_size);
+
+    for (int32_t i = 0; i < number_images; i++) {
+        read_pixels(image_offsets[i], image_size, &pixels[0]);
+
+        for (int32_t z = 0; z < channels; z++) {
+            float image_avg = 0.0;
+            for (int32_t j = 0; j < height * width; j++) {
+                image_avg += pixels[(z * height * width) + j] / 255.0;
+            }
+            channel_avg[z] += image_avg / (height * width);
+        }
+    }
+
+    for (int32_t z = 0; z < channels; z++) {
+        channel_avg[z] /= number_images;
+        cerr << "average pixel value for channel " << z << ": " << channel_avg[z] << endl;
+    }
+
+    for (int32_t i = 0; i < number_images; i++) {
+        read_pixels(image_offsets[i], image_size, &pixels[0]);
+
+        for (int32_t z = 0; z < channels; z++) {
+            float image_variance = 0.0;
+            for (int32_t j = 0; j < height * width; j++) {
+                float tmp = channel_avg[z] - (pixels[(z * height * width) + j] / 255.0);
+                image_variance += tmp * tmp;
+            }
+            channel_std_dev[z] += image_variance / (height * width);
+        }
+    }
+
+    for (int32_t z = 0; z < channels; z++) {
+        channel_std_dev[z] /= number_images;
+        cerr << "pixel variance for channel " << z << ": " << channel_std_dev[z] << endl;
+        channel_std_dev[z] = sqrt(channel_std_dev[z]);
+        cerr << "pixel standard deviation for channel " << z << ": " << channel_std_dev[z] << endl;
+    }
+}
+
+void StreamingImages::prefetch() {
+    while (true) {
+        ImageShard* shard = NULL;
+        int64_t sequence;
+
+        {
+            unique_lock<mutex> lock(shard_mutex);
+
+            // only read one shard ahead of the consumer, into a buffer which is empty or holds a
+            // shard the consumer has moved past (it may still be using the shard before its current one)
+            shard_condition.wait(lock, [&] {
+                if (finished) {
+                    return true;
+                }
+
+                if (next_sequence > consumer_sequence + 1) {
+                    return false;
+                }
+
+                for (int32_t i = 0; i < NUMBER_SHARD_BUFFERS; i++) {
+                    if (shards[i].sequence == -1 || (shards[i].ready && shards[i].sequence < consumer_sequence - 1)) {
+                        shard = &shards[i];
+                        return true;
+                    }
+                }
+                return false;
+            });
+
+            if (finished) {
+                return;
+            }
+
+            sequence = next_sequence;
+            next_sequence++;
+
+            shard->sequence = sequence;
+            shard->ready = false;
+        }
+
+        load_shard(sequence, *shard);
+
+        {
+            lock_guard<mutex> lock(shard_mutex);
+            shard->ready = true;
+        }
+        shard_condition.notify_all();
+    }
+}
+
+void StreamingImages::load_shard(int64_t sequence, ImageShard& shard) {
+    int64_t epoch = sequence / shards_per_epoch;
+    int shard_number = sequence % shards_per_epoch;
+
+    if (order_epoch != epoch) {
+        // reshuffle the chunks for every epoch passed, so the order only depends on the seed and
+        // which epochs were read
+        while (order_epoch < epoch) {
+            fisher_yates_shuffle(generator, chunk_order);
+            order_epoch++;
+        }
+
+        epoch_order.clear();
+        for (uint32_t i = 0; i < chunk_order.size(); i++) {
+            int first = chunk_order[i] * chunk_size;
+            int last = first + chunk_size;
+            if (last > number_images) {
+                last = number_images;
+            }
+
+            for (int32_t j = first; j < last; j++) {
+                epoch_order.push_back(j);
+            }
+        }
+    }
+
+    int first = shard_number * shard_size;
+    int last = first + shard_size;
+    if (last > number_images) {
+        last = number_images;
+    }
+
+    shard.number_images = last - first;
+    shard.pixels.resize(shard.number_images * image_size);
+    shard.classifications.resize(shard.number_images);
+    shard.order.resize(shard.number_images);
+
+    // images which are next to each other in the file are read with a single read
+    int current = first;
+    while (current < last) {
+        int run_end = current + 1;
+        while (run_end < last && image_offsets[epoch_order[run_end]]
+                                     == image_offsets[epoch_order[run_end - 1]] + image_size) {
+            run_end++;
+        }
+
+        read_pixels(
+            image_offsets[epoch_order[current]], (uint64_t) (run_end - current) * image_size,
+            &shard.pixels[(current - first) * image_size]
+        );
+        current = run_end;
+    }
+
+    for (int32_t i = 0; i < shard.number_images; i++) {
+        shard.classifications[i] = image_classes[epoch_order[first + i]];
+        shard.order[i] = i;
+    }
+
+    fisher_yates_shuffle(generator, shard.order);
+}
+
+const ImageShard& StreamingImages::get_shard(int image, int& shard_image) const {
+    int shard = image / shard_size;
+    int position = image - (shard * shard_size);
+
+    if (current_buffer != NULL && shard == current_shard) {
+        shard_image = current_buffer->order[position];
+        return *current_buffer;
+    }
+
+    if (previous_buffer != NULL && shard == current_shard - 1) {
+        shard_image = previous_buffer->order[position];
+        return *previous_buffer;
+    }
+
+    if (shard < current_shard) {
+        // the images are being read from the start again, so this is the next pass over them
+        consumer_epoch++;
+    }
+
+    int64_t sequence = (consumer_epoch * shards_per_epoch) + shard;
+
+    if (!prefetch_thread.joinable()) {
+        prefetch_thread = thread(&StreamingImages::prefetch, const_cast<StreamingImages*>(this));
+    }
+
+    unique_lock<mutex> lock(shard_mutex);
+    consumer_sequence = sequence;
+    if (next_sequence < sequence) {
+        // the consumer skipped ahead, so there is no point reading the shards in between
+        next_sequence = sequence;
+    }
+    shard_condition.notify_all();
+
+    const ImageShard* buffer = NULL;
+    shard_condition.wait(lock, [&] {
+        for (int32_t i = 0; i < NUMBER_SHARD_BUFFERS; i++) {
+            if (shards[i].sequence == sequence && shards[i].ready) {
+                buffer = &shards[i];
+                return true;
+            }
+        }
+        return false;
+    });
+
+    previous_buffer = NULL;
+    for (int32_t i = 0; i < NUMBER_SHARD_BUFFERS; i++) {
+        if (shard > 0 && shards[i].sequence == sequence - 1 && shards[i].ready) {
+            previous_buffer = &shards[i];
+        }
+    }
+
+    current_buffer = buffer;
+    current_shard = shard;
+
+    shard_image = current_buffer->order[position];
+    return *current_buffer;
+}
+
+void StreamingImages::start_pass() const {
+    // a pass which started from a lower shard has already moved to the next epoch in get_shard,
+    // forgetting the current shard keeps it from being counted twice
+    if (current_shard >= 0) {
+        consumer_epoch++;
+        current_shard = -1;
+        current_buffer = NULL;
+        previous_buffer = NULL;
+    }
+}
+
+bool StreamingImages::loaded_correctly() const {
+    return !had_error;
+}
+
+string StreamingImages::get_filename() const {
+    return filename;
+}
+
+int StreamingImages::get_class_size(int i) const {
+    return class_sizes[i];
+}
+
+int StreamingImages::get_number_classes() const {
+    return number_classes;
+}
+
+int StreamingImages::get_number_images() const {
+    return number_images;
+}
+
+int StreamingImages::get_image_channels() const {
+    return channels;
+}
+
+int StreamingImages::get_image_height() const {
+    return height + (2 * padding);
+}
+
+int StreamingImages::get_image_width() const {
+    return width + (2 * padding);
+}
+
+bool StreamingImages::is_streaming() const {
+    return true;
+}
+
+int StreamingImages::get_classification(int image) const {
+    int shard_image;
+    const ImageShard& shard = get_shard(image, shard_image);
+
+    return shard.classifications[shard_image];
+}
+
+float StreamingImages::get_pixel(int image, int z, int y, int x) const {
+    if (y < padding || x < padding) {
+        return 0;
+    } else if (y >= height + padding || x >= width + padding) {
+        return 0;
+    } else {
+        int shard_image;
+        const ImageShard& shard = get_shard(image, shard_image);
+        const uint8_t* pixels = &shard.pixels[shard_image * image_size];
+
+        return ((pixels[(((z * height) + (y - padding)) * width) + (x - padding)] / 255.0) - channel_avg[z])
+               / channel_std_dev[z];
+    }
+}
+
+void StreamingImages::get_subimage(int image, int z, float* values) const {
+    int shard_image;
+    const ImageShard& shard = get_shard(image, shard_image);
+    const uint8_t* pixels = &shard.pixels[(shard_image * image_size) + (z * height * width)];
+
+    float avg = channel_avg[z];
+    float std_dev = channel_std_dev[z];
+    int padded_width = width + (2 * padding);
+
+    int current = 0;
+    for (int32_t y = 0; y < height + (2 * padding); y++) {
+        for (int32_t x = 0; x < padded_width; x++) {
+            if (y < padding || x < padding || y >= height + padding || x >= width + padding) {
+                values[current] = 0;
+            } else {
+                values[current] = ((pixels[((y - padding) * width) + (x - padding)] / 255.0) - avg) / std_dev;
+            }
+            current++;
+        }
+    }
+}
+
+float StreamingImages::get_channel_avg(int channel) const {
+    return channel_avg[channel];
+}
+
+float StreamingImages::get_channel_std_dev(int channel) const {
+    return channel_std_dev[channel];
+}
+
+const vector<float>& StreamingImages::get_average() const {
+    return channel_avg;
+}
+
+const vector<float>& StreamingImages::get_std_dev() const {
+    return channel_std_dev;
+}
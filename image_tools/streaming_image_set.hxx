@@ -0,0 +1,158 @@
+#ifndef STREAMING_IMAGE_SET_HXX
+#define STREAMING_IMAGE_SET_HXX
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <cstdint>
+
+#include <mutex>
+using std::mutex;
+
+#include <random>
+using std::minstd_rand0;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "image_set_interface.hxx"
+
+class ImageShard {
+   public:
+    // the global sequence number of this shard (epoch * shards per epoch + shard within the epoch),
+    // or -1 if the buffer is empty
+    int64_t sequence;
+    bool ready;
+
+    int number_images;
+
+    // pixels of each image in the order they were read, and the shuffled order they are
+    // handed out in
+    vector<uint8_t> pixels;
+    vector<int> classifications;
+    vector<int> order;
+
+    ImageShard();
+};
+
+/**
+ * An image set which does not fit in memory. Images are read from an image file (either the
+ * versioned format or the original fixed size binary format) one shard at a time by a background
+ * thread, which prefetches the next shard while the current one is being used.
+ *
+ * Each pass over the images is shuffled: the images are split into chunks of contiguous images
+ * (so each chunk is a single read), the chunks are shuffled and grouped into shards, and the
+ * images within each shard are shuffled again once the shard has been read.
+ *
+ * Because only a few shards are resident at a time the images must be requested in order, so
+ * image i means the i-th image of the current pass. Calling start_pass (or starting again from a
+ * lower shard) begins the next, differently shuffled, pass. The prefetch thread is only started
+ * when the first image is requested, so a process which only needs the set's size and statistics
+ * does not read any shards. A streaming image set must only be read by one thread.
+ */
+class StreamingImages : public ImagesInterface {
+   private:
+    string filename;
+    int file_descriptor;
+
+    int number_classes;
+    int number_images;
+
+    vector<int> class_sizes;
+
+    int padding;
+    int channels, width, height;
+    int image_size;
+
+    vector<uint64_t> image_offsets;
+    vector<int> image_classes;
+
+    vector<float> channel_avg;
+    vector<float> channel_std_dev;
+
+    int shard_size;
+    int chunk_size;
+    int shards_per_epoch;
+
+    bool had_error;
+
+    // one shard being used, the one before it (a batch can span two shards) and one being prefetched
+    static const int NUMBER_SHARD_BUFFERS = 3;
+    ImageShard shards[NUMBER_SHARD_BUFFERS];
+
+    // state shared with the prefetch thread, guarded by shard_mutex
+    mutable mutex shard_mutex;
+    mutable condition_variable shard_condition;
+    mutable int64_t consumer_sequence;
+    mutable int64_t next_sequence;
+    bool finished;
+
+    // only touched by the prefetch thread
+    minstd_rand0 generator;
+    int64_t order_epoch;
+    vector<int> chunk_order;
+    vector<int> epoch_order;
+
+    // only touched by the consumer, caches the last shard used so most requests do not need the lock
+    mutable int64_t consumer_epoch;
+    mutable int current_shard;
+    mutable const ImageShard* current_buffer;
+    mutable const ImageShard* previous_buffer;
+
+    // started by the consumer when it first requests an image
+    mutable thread prefetch_thread;
+
+    int read_header();
+    void read_pixels(uint64_t offset, uint64_t length, uint8_t* destination) const;
+    void calculate_avg_std_dev();
+
+    void prefetch();
+    void load_shard(int64_t sequence, ImageShard& shard);
+    const ImageShard& get_shard(int image, int& shard_image) const;
+
+   public:
+    StreamingImages(string _filename, int _padding, int _shard_size, int _chunk_size, int seed);
+    StreamingImages(
+        string _filename, int _padding, int _shard_size, int _chunk_size, int seed, const vector<float>& _channel_avg,
+        const vector<float>& _channel_std_dev
+    );
+    ~StreamingImages();
+
+    StreamingImages(const StreamingImages&) = delete;
+    StreamingImages& operator=(const StreamingImages&) = delete;
+
+    bool loaded_correctly() const;
+
+    string get_filename() const;
+
+    int get_class_size(int i) const;
+
+    int get_number_classes() const;
+
+    int get_number_images() const;
+
+    int get_image_channels() const;
+    int get_image_width() const;
+    int get_image_height() const;
+
+    bool is_streaming() const;
+    void start_pass() const;
+
+    int get_classification(int image) const;
+    float get_pixel(int image, int z, int y, int x) const;
+    void get_subimage(int image, int z, float* values) const;
+
+    float get_channel_avg(int channel) const;
+    float get_channel_std_dev(int channel) const;
+
+    const vector<float>& get_average() const;
+    const vector<float>& get_std_dev() const;
+};
+
+#endif
@@ -1,4 +1,12 @@
+#include <dirent.h>
+
 #include <chrono>
+#include <csignal>
+#include <cstdio>
+
+#include <deque>
+using std::deque;
+
 #include <iomanip>
 using std::fixed;
 using std::setprecision;
@@ -23,13 +31,20 @@ using std::vector;
 
 #include "cnn/exact.hxx"
 #include "common/arguments.hxx"
+#include "common/files.hxx"
 #include "image_tools/image_set.hxx"
+#include "image_tools/streaming_image_set.hxx"
 #include "mpi.h"
 
 #define WORK_REQUEST_TAG  1
 #define GENOME_LENGTH_TAG 2
 #define GENOME_TAG        3
 #define TERMINATE_TAG     4
+#define INTERRUPTED_TAG   5
+
+// the flags sent with a genome
+#define INTERRUPTED_GENOME  1  // its training was interrupted and continues from where it left off
+#define PREVIOUS_RUN_GENOME 2  // it was resumed from a checkpoint left by a previous run
 
 mutex exact_mutex;
 
@@ -41,6 +56,124 @@ bool finished = false;
 
 int images_resize;
 
+// if > 0, every profile_interval-th training epoch of each genome is profiled into
+// <output_directory>/profile_<generation id>.csv
+int profile_interval = 0;
+string profile_directory;
+
+// if true, genomes are compressed before they are sent (if EXACT was compiled with zlib)
+bool compress_genomes = false;
+
+// if set, workers checkpoint the genome they are training to this (node local) directory at the
+// end of an epoch, at most once every checkpoint_interval seconds. checkpoints left there by a
+// run which was stopped are picked up and finished by the next run
+string checkpoint_directory = "";
+int checkpoint_interval = 600;
+
+// set when a rank is sent SIGTERM or SIGUSR1 (e.g., when its node is being preempted). a worker
+// then hands its genome back to the master at the end of the current epoch and exits, the master
+// stops giving out work and saves the genomes handed back to it for the next run
+volatile sig_atomic_t interrupted = 0;
+
+void interrupt_handler(int signal_number) {
+    interrupted = 1;
+}
+
+/**
+ * The checkpoint of a genome being trained by a rank, the rank is part of the name so a genome
+ * resumed from a previous run can't share a file with a new genome that has the same id.
+ */
+string get_checkpoint_filename(int generation_id, int rank) {
+    return checkpoint_directory + "/genome_" + to_string(generation_id) + "_" + to_string(rank) + ".bin";
+}
+
+/**
+ * \return the names of the genome checkpoints (claimed or not) in the checkpoint directory
+ */
+vector<string> get_checkpoint_filenames() {
+    vector<string> filenames;
+
+    DIR* directory = opendir(checkpoint_directory.c_str());
+    if (directory == NULL) {
+        return filenames;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != NULL) {
+        string filename = entry->d_name;
+        if (filename.compare(0, 7, "genome_") == 0 && filename.find(".bin") != string::npos) {
+            filenames.push_back(filename);
+        }
+    }
+    closedir(directory);
+
+    return filenames;
+}
+
+/**
+ * Checkpoints still claimed when a run starts were claimed by a rank of a previous run which was
+ * stopped or died before it finished them, so they are renamed back to be claimed again. Every
+ * rank must do this before any rank starts claiming.
+ */
+void restore_orphaned_checkpoints(string name) {
+    vector<string> filenames = get_checkpoint_filenames();
+
+    for (int i = 0; i < (int) filenames.size(); i++) {
+        size_t claimed_position = filenames[i].find(".bin.claimed_");
+        if (claimed_position == string::npos) {
+            continue;
+        }
+
+        string claimed_filename = checkpoint_directory + "/" + filenames[i];
+        string filename = checkpoint_directory + "/" + filenames[i].substr(0, claimed_position + 4);
+
+        // fails if another rank on this node restored it first
+        if (rename(claimed_filename.c_str(), filename.c_str()) == 0) {
+            cout << "[" << setw(10) << name << "] restored orphaned checkpoint: " << filename << endl;
+        }
+    }
+}
+
+/**
+ * Reads the checkpoints left in the checkpoint directory by a run which was stopped before it
+ * could finish their genomes. Each is claimed by renaming it first, so when multiple ranks share
+ * a node only one of them resumes it. The claimed file is removed once the genome is back with
+ * the master, so if this run is stopped before then the next run restores and claims it again.
+ */
+vector<CNN_Genome*> claim_leftover_checkpoints(string name, int rank, vector<string>& claimed_filenames) {
+    restore_orphaned_checkpoints(name);
+
+    // every rank has restored the orphaned checkpoints before any of them claims one
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    vector<string> all_filenames = get_checkpoint_filenames();
+    vector<string> filenames;
+    for (int i = 0; i < (int) all_filenames.size(); i++) {
+        const string& filename = all_filenames[i];
+        if (filename.size() > 11 && filename.compare(filename.size() - 4, 4, ".bin") == 0) {
+            filenames.push_back(filename);
+        }
+    }
+
+    vector<CNN_Genome*> genomes;
+    for (int i = 0; i < (int) filenames.size(); i++) {
+        string filename = checkpoint_directory + "/" + filenames[i];
+        string claimed_filename = filename + ".claimed_" + to_string(rank);
+        if (rename(filename.c_str(), claimed_filename.c_str()) != 0) {
+            continue;  // another rank on this node claimed it first
+        }
+
+        CNN_Genome* genome = new CNN_Genome(claimed_filename, true);
+        cout << "[" << setw(10) << name << "] resuming genome " << genome->get_generation_id() << " from epoch "
+             << genome->get_epoch() << " of a previous run" << endl;
+
+        genomes.push_back(genome);
+        claimed_filenames.push_back(claimed_filename);
+    }
+
+    return genomes;
+}
+
 void send_work_request(int target) {
     int work_request_message[1];
     work_request_message[0] = 0;
@@ -53,12 +186,13 @@ void receive_work_request(int source) {
     MPI_Recv(work_request_message, 1, MPI_INT, source, WORK_REQUEST_TAG, MPI_COMM_WORLD, &status);
 }
 
-CNN_Genome* receive_genome_from(string name, int source) {
+CNN_Genome* receive_genome_from(string name, int source, int& flags) {
     MPI_Status status;
-    int length_message[1];
-    MPI_Recv(length_message, 1, MPI_INT, source, GENOME_LENGTH_TAG, MPI_COMM_WORLD, &status);
+    int length_message[2];
+    MPI_Recv(length_message, 2, MPI_INT, source, GENOME_LENGTH_TAG, MPI_COMM_WORLD, &status);
 
     int length = length_message[0];
+    flags = length_message[1];
 
     cout << "[" << setw(10) << name << "] receiving genome of length: " << length << " from: " << source << endl;
 
@@ -67,31 +201,32 @@ CNN_Genome* receive_genome_from(string name, int source) {
     cout << "[" << setw(10) << name << "] receiving genome from: " << source << endl;
     MPI_Recv(genome_str, length, MPI_CHAR, source, GENOME_TAG, MPI_COMM_WORLD, &status);
 
-    genome_str[length] = '\0';
-
-    // cout << "genome_str:" << endl << genome_str << endl;
+    istringstream iss(string(genome_str, length));
 
-    istringstream iss(genome_str);
-
-    CNN_Genome* genome = new CNN_Genome(iss, false);
+    CNN_Genome* genome = new CNN_Genome(iss, (flags & INTERRUPTED_GENOME) != 0);
 
     delete[] genome_str;
     return genome;
 }
 
-void send_genome_to(string name, int target, CNN_Genome* genome) {
+/**
+ * Sends a genome, with flags saying if its training was interrupted (so the receiver should
+ * continue training it from where it left off) and if it came from a previous run.
+ */
+void send_genome_to(string name, int target, CNN_Genome* genome, int flags) {
     ostringstream oss;
 
-    genome->write(oss);
+    genome->write_to_stream(oss, compress_genomes);
 
     string genome_str = oss.str();
     int length = genome_str.size();
 
     cout << "[" << setw(10) << name << "] sending genome of length: " << length << " to: " << target << endl;
 
-    int length_message[1];
+    int length_message[2];
     length_message[0] = length;
-    MPI_Send(length_message, 1, MPI_INT, target, GENOME_LENGTH_TAG, MPI_COMM_WORLD);
+    length_message[1] = flags;
+    MPI_Send(length_message, 2, MPI_INT, target, GENOME_LENGTH_TAG, MPI_COMM_WORLD);
 
     cout << "[" << setw(10) << name << "] sending genome to: " << target << endl;
     MPI_Send(genome_str.c_str(), length, MPI_CHAR, target, GENOME_TAG, MPI_COMM_WORLD);
@@ -109,8 +244,43 @@ void receive_terminate_message(int source) {
     MPI_Recv(terminate_message, 1, MPI_INT, source, TERMINATE_TAG, MPI_COMM_WORLD, &status);
 }
 
+void send_interrupted_message(int target) {
+    int interrupted_message[1];
+    interrupted_message[0] = 0;
+    MPI_Send(interrupted_message, 1, MPI_INT, target, INTERRUPTED_TAG, MPI_COMM_WORLD);
+}
+
+void receive_interrupted_message(int source) {
+    MPI_Status status;
+    int interrupted_message[1];
+    MPI_Recv(interrupted_message, 1, MPI_INT, source, INTERRUPTED_TAG, MPI_COMM_WORLD, &status);
+}
+
+/**
+ * Saves genomes no worker was left to finish to the checkpoint directory, so the next run can
+ * resume them.
+ */
+void save_unfinished_genomes(string name, deque<CNN_Genome*>& genomes) {
+    while (genomes.size() > 0) {
+        CNN_Genome* genome = genomes.front();
+        genomes.pop_front();
+
+        if (checkpoint_directory != "") {
+            genome->set_checkpoint_filename(get_checkpoint_filename(genome->get_generation_id(), 0));
+            genome->write_checkpoint();
+            cout << "[" << setw(10) << name << "] saved unfinished genome " << genome->get_generation_id()
+                 << " for the next run" << endl;
+        } else {
+            cerr << "[" << setw(10) << name << "] WARNING: no workers are left to finish genome "
+                 << genome->get_generation_id() << " and there is no checkpoint directory to save it to" << endl;
+        }
+        delete genome;
+    }
+}
+
 void master(
-    const Images& training_images, const Images& validation_images, const Images& testing_images, int max_rank
+    const ImagesInterface& training_images, const ImagesInterface& validation_images,
+    const ImagesInterface& testing_images, int max_rank
 ) {
     string name = "master";
 
@@ -118,6 +288,23 @@ void master(
 
     int terminates_sent = 0;
 
+    // genomes handed back by interrupted workers, which are given out again before any new genomes
+    deque<CNN_Genome*> interrupted_genomes;
+
+    // genomes left unfinished by a previous run. their innovation numbers come from a different
+    // search so they can't be inserted into this one, but their training is finished and they are
+    // written to the output directory
+    deque<CNN_Genome*> previous_run_genomes;
+
+    vector<string> claimed_filenames;
+    if (checkpoint_directory != "") {
+        vector<CNN_Genome*> leftover_genomes = claim_leftover_checkpoints(name, 0, claimed_filenames);
+        previous_run_genomes.insert(previous_run_genomes.end(), leftover_genomes.begin(), leftover_genomes.end());
+
+        // every rank has claimed its node's leftover checkpoints before any new ones are written
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
     while (true) {
         // wait for a incoming message
         MPI_Status status;
@@ -132,11 +319,35 @@ void master(
         if (tag == WORK_REQUEST_TAG) {
             receive_work_request(source);
 
-            exact_mutex.lock();
-            CNN_Genome* genome = exact->generate_individual();
-            exact_mutex.unlock();
+            if (!interrupted && (interrupted_genomes.size() > 0 || previous_run_genomes.size() > 0)) {
+                int flags = INTERRUPTED_GENOME;
+                CNN_Genome* genome;
+                if (interrupted_genomes.size() > 0) {
+                    genome = interrupted_genomes.front();
+                    interrupted_genomes.pop_front();
+                } else {
+                    genome = previous_run_genomes.front();
+                    previous_run_genomes.pop_front();
+                    flags |= PREVIOUS_RUN_GENOME;
+                }
+
+                cout << "[" << setw(10) << name << "] reassigning interrupted genome "
+                     << genome->get_generation_id() << " to: " << source << endl;
+                send_genome_to(name, source, genome, flags);
+
+                delete genome;
+                continue;
+            }
 
-            if (genome == NULL) {  // search was completed if it returns NULL for an individual
+            CNN_Genome* genome = NULL;
+            if (!interrupted) {
+                exact_mutex.lock();
+                genome = exact->generate_individual();
+                exact_mutex.unlock();
+            }
+
+            // search was completed if it returns NULL for an individual, or the master was interrupted
+            if (genome == NULL) {
                 // send terminate message
                 cout << "[" << setw(10) << name << "] terminating worker: " << source << endl;
                 send_terminate_message(source);
@@ -145,40 +356,106 @@ void master(
                 cout << "[" << setw(10) << name << "] sent: " << terminates_sent << " terminates of: " << (max_rank - 1)
                      << endl;
                 if (terminates_sent >= max_rank - 1) {
-                    return;
+                    break;
                 }
 
             } else {
-                ofstream outfile(exact->get_output_directory() + "/gen_" + to_string(genome->get_generation_id()));
-                genome->write(outfile);
-                outfile.close();
+                genome->write_to_file(
+                    exact->get_output_directory() + "/gen_" + to_string(genome->get_generation_id()) + ".bin"
+                );
 
                 // send genome
                 cout << "[" << setw(10) << name << "] sending genome to: " << source << endl;
-                send_genome_to(name, source, genome);
+                send_genome_to(name, source, genome, 0);
 
                 // delete this genome as it will not be used again
                 delete genome;
             }
         } else if (tag == GENOME_LENGTH_TAG) {
             cout << "[" << setw(10) << name << "] received genome from: " << source << endl;
-            CNN_Genome* genome = receive_genome_from(name, source);
+            int flags;
+            CNN_Genome* genome = receive_genome_from(name, source, flags);
+
+            if (flags & INTERRUPTED_GENOME) {
+                cout << "[" << setw(10) << name << "] genome " << genome->get_generation_id()
+                     << " was interrupted on epoch " << genome->get_epoch() << " of " << genome->get_max_epochs()
+                     << endl;
+                if (flags & PREVIOUS_RUN_GENOME) {
+                    previous_run_genomes.push_back(genome);
+                } else {
+                    interrupted_genomes.push_back(genome);
+                }
+                continue;
+            }
+
+            if (flags & PREVIOUS_RUN_GENOME) {
+                string filename =
+                    exact->get_output_directory() + "/previous_run_" + to_string(genome->get_generation_id()) + ".bin";
+                cout << "[" << setw(10) << name << "] finished genome " << genome->get_generation_id()
+                     << " from a previous run with fitness: " << genome->get_best_validation_error()
+                     << ", writing it to: " << filename << endl;
+                genome->write_to_file(filename);
+                delete genome;
+                continue;
+            }
 
             exact_mutex.lock();
             exact->insert_genome(genome);
             exact_mutex.unlock();
 
             // this genome will be deleted if/when removed from population
+        } else if (tag == INTERRUPTED_TAG) {
+            receive_interrupted_message(source);
+            // the worker has exited, so it will not ask for more work
+            terminates_sent++;
+
+            cout << "[" << setw(10) << name << "] worker: " << source << " was interrupted, " << terminates_sent
+                 << " of " << (max_rank - 1) << " workers have finished" << endl;
+            if (terminates_sent >= max_rank - 1) {
+                break;
+            }
         } else {
             cerr << "[" << setw(10) << name << "] ERROR: received message with unknown tag: " << tag << endl;
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
     }
+
+    // the leftover checkpoints this rank claimed are either finished or about to be saved again
+    for (int i = 0; i < (int) claimed_filenames.size(); i++) {
+        remove(claimed_filenames[i].c_str());
+    }
+
+    save_unfinished_genomes(name, interrupted_genomes);
+    save_unfinished_genomes(name, previous_run_genomes);
 }
 
-void worker(const Images& training_images, const Images& validation_images, const Images& testing_images, int rank) {
+void worker(
+    const ImagesInterface& training_images, const ImagesInterface& validation_images,
+    const ImagesInterface& testing_images, int rank
+) {
     string name = "worker_" + to_string(rank);
+
+    if (checkpoint_directory != "") {
+        vector<string> claimed_filenames;
+        vector<CNN_Genome*> leftover_genomes = claim_leftover_checkpoints(name, rank, claimed_filenames);
+
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        // the master gives these out again like the genomes handed back by interrupted workers
+        for (int i = 0; i < (int) leftover_genomes.size(); i++) {
+            send_genome_to(name, 0, leftover_genomes[i], INTERRUPTED_GENOME | PREVIOUS_RUN_GENOME);
+            remove(claimed_filenames[i].c_str());
+            delete leftover_genomes[i];
+        }
+    }
+
     while (true) {
+        if (interrupted) {
+            cout << "[" << setw(10) << name << "] interrupted, exiting!" << endl;
+            send_interrupted_message(0);
+            break;
+        }
+
         cout << "[" << setw(10) << name << "] sending work request!" << endl;
         send_work_request(0);
         cout << "[" << setw(10) << name << "] sent work request!" << endl;
@@ -196,14 +473,47 @@ void worker(const Images& training_images, const Images& validation_images, cons
 
         } else if (tag == GENOME_LENGTH_TAG) {
             cout << "[" << setw(10) << name << "] received genome!" << endl;
-            CNN_Genome* genome = receive_genome_from(name, 0);
+            int flags;
+            CNN_Genome* genome = receive_genome_from(name, 0, flags);
 
             genome->set_name(name);
-            genome->initialize();
+            if (flags & INTERRUPTED_GENOME) {
+                // the weights and velocities were restored from the checkpoint, so they must not be
+                // reinitialized
+                cout << "[" << setw(10) << name << "] resuming genome " << genome->get_generation_id()
+                     << " from epoch " << genome->get_epoch() << endl;
+            } else {
+                genome->initialize();
+            }
+            if (profile_interval > 0) {
+                genome->set_profile(
+                    profile_directory + "/profile_" + to_string(genome->get_generation_id()) + ".csv", profile_interval
+                );
+            }
+
+            string checkpoint_filename = "";
+            if (checkpoint_directory != "") {
+                checkpoint_filename = get_checkpoint_filename(genome->get_generation_id(), rank);
+                genome->set_checkpoint_filename(checkpoint_filename);
+                genome->set_checkpoint_interval(checkpoint_interval);
+            }
+            genome->set_interrupt_flag(&interrupted);
+
             genome->stochastic_backpropagation(training_images, images_resize, validation_images);
-            genome->evaluate_test(testing_images);
 
-            send_genome_to(name, 0, genome);
+            if (genome->get_epoch() <= genome->get_max_epochs()) {
+                // training stopped early, so hand the genome back to be finished by another worker
+                send_genome_to(name, 0, genome, flags | INTERRUPTED_GENOME);
+            } else {
+                genome->evaluate_test(testing_images);
+                send_genome_to(name, 0, genome, flags & PREVIOUS_RUN_GENOME);
+            }
+
+            // the genome is back with the master either way, so the local checkpoint is only
+            // needed if this node goes down mid-training
+            if (checkpoint_filename != "") {
+                remove(checkpoint_filename.c_str());
+            }
 
             delete genome;
         } else {
@@ -260,23 +570,70 @@ int main(int argc, char** argv) {
 
     get_argument(arguments, "--images_resize", true, images_resize);
 
-    Images training_images(training_filename, padding);
+    get_argument(arguments, "--profile_interval", false, profile_interval);
+    profile_directory = output_directory;
+
+    compress_genomes = argument_exists(arguments, "--compress_genomes");
+
+    get_argument(arguments, "--checkpoint_directory", false, checkpoint_directory);
+    get_argument(arguments, "--checkpoint_interval", false, checkpoint_interval);
+    if (checkpoint_directory != "") {
+        mkpath(checkpoint_directory.c_str(), 0777);
+    }
+
+    // the master needs to keep running after being signalled so interrupted workers can hand their
+    // genomes back to it
+    signal(SIGTERM, interrupt_handler);
+    signal(SIGUSR1, interrupt_handler);
+
+    // training images which do not fit in memory can be streamed from disk a shard at a time,
+    // each rank uses a different seed so they read the images in different orders. the master
+    // only uses the set's size and statistics, so it never starts reading shards
+    ImagesInterface* training_images;
+    if (argument_exists(arguments, "--streaming_shard_size")) {
+        int streaming_shard_size;
+        get_argument(arguments, "--streaming_shard_size", true, streaming_shard_size);
+
+        int streaming_chunk_size = 64;
+        get_argument(arguments, "--streaming_chunk_size", false, streaming_chunk_size);
+
+        training_images =
+            new StreamingImages(training_filename, padding, streaming_shard_size, streaming_chunk_size, rank);
+    } else {
+        training_images = new Images(training_filename, padding);
+    }
+
+    if (!training_images->loaded_correctly()) {
+        cerr << "ERROR: had error loading training images: '" << training_filename << "'" << endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
     Images validation_images(
-        validation_filename, padding, training_images.get_average(), training_images.get_std_dev()
+        validation_filename, padding, training_images->get_average(), training_images->get_std_dev()
     );
-    Images testing_images(testing_filename, padding, training_images.get_average(), training_images.get_std_dev());
+    Images testing_images(testing_filename, padding, training_images->get_average(), training_images->get_std_dev());
+
+    if (!validation_images.loaded_correctly()) {
+        cerr << "ERROR: had error loading validation images: '" << validation_filename << "'" << endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    } else if (!testing_images.loaded_correctly()) {
+        cerr << "ERROR: had error loading testing images: '" << testing_filename << "'" << endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
 
     if (rank == 0) {
         exact = new EXACT(
-            training_images, validation_images, testing_images, padding, population_size, max_epochs, use_sfmp,
+            *training_images, validation_images, testing_images, padding, population_size, max_epochs, use_sfmp,
             use_node_operations, max_genomes, output_directory, search_name, reset_edges
         );
 
-        master(training_images, validation_images, testing_images, max_rank);
+        master(*training_images, validation_images, testing_images, max_rank);
     } else {
-        worker(training_images, validation_images, testing_images, rank);
+        worker(*training_images, validation_images, testing_images, rank);
     }
 
+    delete training_images;
+
     finished = true;
 
     cout << "rank " << rank << " completed!" << endl;
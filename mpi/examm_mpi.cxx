@@ -17,10 +17,12 @@ using std::thread;
 using std::vector;
 
 #include "common/log.hxx"
+#include "common/metrics.hxx"
 #include "common/process_arguments.hxx"
 #include "examm/examm.hxx"
 #include "mpi.h"
 #include "rnn/generate_nn.hxx"
+#include "shared_time_series.hxx"
 #include "time_series/time_series.hxx"
 #include "weights/weight_rules.hxx"
 #include "weights/weight_update.hxx"
@@ -39,10 +41,10 @@ WeightUpdate* weight_update_method;
 
 bool finished = false;
 
-vector<vector<vector<double> > > training_inputs;
-vector<vector<vector<double> > > training_outputs;
-vector<vector<vector<double> > > validation_inputs;
-vector<vector<vector<double> > > validation_outputs;
+TimeSeriesWindows training_inputs;
+TimeSeriesWindows training_outputs;
+TimeSeriesWindows validation_inputs;
+TimeSeriesWindows validation_outputs;
 
 // bool random_sequence_length;
 // int32_t sequence_length_lower_bound = 30;
@@ -78,7 +80,11 @@ RNN_Genome* receive_genome_from(int32_t source) {
 
     Log::trace("genome_str:\n%s\n", genome_str);
 
+    MetricTimer deserialize_timer(
+        "examm_genome_deserialize_seconds", "Time taken to deserialize a received genome.", "deserialize_genome"
+    );
     RNN_Genome* genome = new RNN_Genome(genome_str, length);
+    deserialize_timer.stop();
 
     delete[] genome_str;
     return genome;
@@ -88,7 +94,11 @@ void send_genome_to(int32_t target, RNN_Genome* genome) {
     char* byte_array;
     int32_t length;
 
+    MetricTimer serialize_timer(
+        "examm_genome_serialize_seconds", "Time taken to serialize a genome to send.", "serialize_genome"
+    );
     genome->write_to_array(&byte_array, length);
+    serialize_timer.stop();
 
     Log::debug("sending genome of length: %d to: %d\n", length, target);
 
@@ -120,10 +130,17 @@ void master(int32_t max_rank) {
 
     int32_t terminates_sent = 0;
 
+    // the time spent handing out and collecting genomes, without startup and loading the data
+    MetricTimer master_timer("examm_master_seconds", "Time the master spent running the search.", "master");
+
     while (true) {
         // wait for a incoming message
         MPI_Status status;
+        MetricTimer idle_timer(
+            "examm_master_idle_seconds", "Time the master waited for messages from the workers.", "master_idle"
+        );
         MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        idle_timer.stop();
 
         int32_t source = status.MPI_SOURCE;
         int32_t tag = status.MPI_TAG;
@@ -185,6 +202,12 @@ void worker(int32_t rank) {
     Log::set_id("worker_" + to_string(rank));
 
     while (true) {
+        // the time from requesting work to getting a response is the time this worker spent queued
+        // behind the master and the other workers
+        MetricTimer idle_timer(
+            "examm_worker_idle_seconds", "Time workers waited for the master to respond to a work request.",
+            "worker_idle"
+        );
         Log::debug("sending work request!\n");
         send_work_request(0);
         Log::debug("sent work request!\n");
@@ -192,6 +215,7 @@ void worker(int32_t rank) {
         MPI_Status status;
         MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
         int32_t tag = status.MPI_TAG;
+        idle_timer.stop();
 
         Log::debug("probe received message with tag: %d\n", tag);
 
@@ -207,9 +231,11 @@ void worker(int32_t rank) {
             // have each worker write the backproagation to a separate log file
             string log_id = "genome_" + to_string(genome->get_generation_id()) + "_worker_" + to_string(rank);
             Log::set_id(log_id);
+            MetricTimer train_timer("examm_genome_train_seconds", "Time taken to train a genome.", "train_genome");
             genome->backpropagate_stochastic(
                 training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method
             );
+            train_timer.stop();
             Log::release_id(log_id);
 
             // go back to the worker's log for MPI communication
@@ -245,9 +271,13 @@ int main(int argc, char** argv) {
     Log::restrict_to_rank(0);
     std::cout << "initailized log!" << std::endl;
 
-    TimeSeriesSets* time_series_sets = NULL;
-    time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    get_train_validation_data(
+    Metrics::initialize(arguments);
+    Metrics::set_rank(rank);
+
+    // only one rank on each node loads the time series, the rest use its copy in shared memory
+    SharedTimeSeries* shared_time_series = new SharedTimeSeries();
+    TimeSeriesSets* time_series_sets = shared_time_series->generate_time_series_sets(arguments);
+    shared_time_series->get_train_validation_windows(
         arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
     );
 
@@ -265,6 +295,8 @@ int main(int argc, char** argv) {
         write_time_series_to_file(arguments, time_series_sets);
         examm = generate_examm_from_arguments(arguments, time_series_sets, weight_rules, seed_genome);
         master(max_rank);
+        // writes out the final checkpoint if checkpointing is enabled
+        delete examm;
     } else {
         worker(rank);
     }
@@ -272,6 +304,7 @@ int main(int argc, char** argv) {
     finished = true;
     Log::debug("rank %d completed!\n");
     Log::release_id("main_" + to_string(rank));
+    delete shared_time_series;
     MPI_Finalize();
 
     delete time_series_sets;
@@ -23,6 +23,7 @@ using std::vector;
 #include "examm/examm.hxx"
 #include "mpi.h"
 #include "rnn/generate_nn.hxx"
+#include "shared_time_series.hxx"
 #include "time_series/time_series.hxx"
 #include "weights/weight_update.hxx"
 
@@ -39,10 +40,10 @@ EXAMM* examm;
 
 WeightUpdate* weight_update_method;
 
-vector<vector<vector<double> > > training_inputs;
-vector<vector<vector<double> > > training_outputs;
-vector<vector<vector<double> > > validation_inputs;
-vector<vector<vector<double> > > validation_outputs;
+TimeSeriesWindows training_inputs;
+TimeSeriesWindows training_outputs;
+TimeSeriesWindows validation_inputs;
+TimeSeriesWindows validation_outputs;
 
 int32_t global_slice;
 int32_t global_repeat;
@@ -245,9 +246,10 @@ int main(int argc, char** argv) {
     int32_t repeats;
     get_argument(arguments, "--repeats", true, repeats);
 
-    TimeSeriesSets* time_series_sets = NULL;
-    time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    get_train_validation_data(
+    // only one rank on each node loads the time series, the rest use its copy in shared memory
+    SharedTimeSeries* shared_time_series = new SharedTimeSeries();
+    TimeSeriesSets* time_series_sets = shared_time_series->generate_time_series_sets(arguments);
+    shared_time_series->get_train_validation_windows(
         arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
     );
 
@@ -261,11 +263,11 @@ int main(int argc, char** argv) {
 
     Log::clear_rank_restriction();
 
-    for (int32_t i = 0; i < time_series_sets->get_number_series(); i += fold_size) {
+    for (int32_t i = 0; i < shared_time_series->get_number_series(); i += fold_size) {
         vector<int32_t> training_indexes;
         vector<int32_t> test_indexes;
 
-        for (int32_t j = 0; j < time_series_sets->get_number_series(); j += fold_size) {
+        for (int32_t j = 0; j < shared_time_series->get_number_series(); j += fold_size) {
             if (j == i) {
                 for (int32_t k = 0; k < fold_size; k++) {
                     test_indexes.push_back(j + k);
@@ -328,14 +330,15 @@ int main(int argc, char** argv) {
 
             MPI_Barrier(MPI_COMM_WORLD);
             Log::debug(
-                "rank %d completed slice %d of %d repeat %d of %d\n", rank, i, time_series_sets->get_number_series(), k,
-                repeats
+                "rank %d completed slice %d of %d repeat %d of %d\n", rank, i,
+                shared_time_series->get_number_series(), k, repeats
             );
         }
 
         slice_times_file.close();
     }
 
+    delete shared_time_series;
     MPI_Finalize();
     Log::release_id("main_" + to_string(rank));
 
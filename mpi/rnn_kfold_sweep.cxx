@@ -1,20 +1,32 @@
+#include <atomic>
+using std::atomic;
+
 #include <chrono>
 #include <fstream>
 using std::getline;
 using std::ifstream;
+using std::ofstream;
 
 #include <iomanip>
+using std::setprecision;
 using std::setw;
 
 #include <iostream>
 using std::endl;
 
+#include <sstream>
+using std::istringstream;
+
 #include <random>
 using std::minstd_rand0;
 using std::uniform_real_distribution;
 
 #include <string>
 using std::string;
+using std::to_string;
+
+#include <thread>
+using std::thread;
 
 #include <cstring>
 using std::memcpy;
@@ -24,15 +36,10 @@ using std::strchr;
 using std::vector;
 
 // for mkdir
-#include <errno.h>
 #include <sys/stat.h>
-#ifdef HAVE_UNISTD_H
-#include <unistd.h>
-#endif /* HAVE_UNISTD_H */
-
-typedef struct stat Stat;
 
 #include "common/arguments.hxx"
+#include "common/files.hxx"
 #include "common/log.hxx"
 #include "mpi.h"
 #include "rnn/generate_nn.hxx"
@@ -41,6 +48,7 @@ typedef struct stat Stat;
 #include "rnn/rnn_genome.hxx"
 #include "rnn/rnn_node.hxx"
 #include "rnn/rnn_node_interface.hxx"
+#include "shared_time_series.hxx"
 #include "time_series/time_series.hxx"
 #include "weights/weight_rules.hxx"
 #include "weights/weight_update.hxx"
@@ -57,6 +65,11 @@ int32_t repeats = 5;
 int32_t fold_size = 2;
 string weight_initialize_string = "xavier";
 
+// each worker rank runs number_threads jobs at once, and is sent jobs_per_message jobs for each of
+// its threads at a time so short jobs are not waiting on messages to the master
+int32_t number_threads = 1;
+int32_t jobs_per_message = 1;
+
 string process_name;
 
 WeightUpdate* weight_update_method;
@@ -70,6 +83,12 @@ vector<string> rnn_types(
 
 TimeSeriesSets* time_series_sets = NULL;
 
+// every series (with the time offset applied), shared by the ranks on each node. the jobs select
+// their training and test series from these
+SharedTimeSeries* shared_time_series = NULL;
+TimeSeriesWindows all_inputs;
+TimeSeriesWindows all_outputs;
+
 struct ResultSet {
     int32_t job;
     double training_mae;
@@ -81,36 +100,41 @@ struct ResultSet {
 
 vector<ResultSet> results;
 
-void send_work_request_to(int32_t target) {
+// the results of completed jobs are appended to this file so a sweep which was killed can be
+// restarted with --resume, which skips them
+ofstream* completed_jobs_file = NULL;
+
+void send_work_request_to(int32_t target, int32_t number_jobs) {
     int32_t work_request_message[1];
-    work_request_message[0] = 0;
+    work_request_message[0] = number_jobs;
     MPI_Send(work_request_message, 1, MPI_INT, target, WORK_REQUEST_TAG, MPI_COMM_WORLD);
 }
 
-void receive_work_request_from(int32_t source) {
+int32_t receive_work_request_from(int32_t source) {
     MPI_Status status;
     int32_t work_request_message[1];
     MPI_Recv(work_request_message, 1, MPI_INT, source, WORK_REQUEST_TAG, MPI_COMM_WORLD, &status);
+    return work_request_message[0];
 }
 
-void send_job_to(int32_t target, int32_t current_job) {
-    int32_t job_message[1];
-    job_message[0] = current_job;
-
-    Log::debug("sending job %d of %d to %d\n", current_job, results.size(), target);
-    MPI_Send(job_message, 1, MPI_INT, target, JOB_TAG, MPI_COMM_WORLD);
+void send_jobs_to(int32_t target, const vector<int32_t>& jobs) {
+    Log::debug("sending %d jobs starting with job %d of %d to %d\n", jobs.size(), jobs[0], results.size(), target);
+    MPI_Send(&jobs[0], jobs.size(), MPI_INT, target, JOB_TAG, MPI_COMM_WORLD);
 }
 
-int32_t receive_job_from(int32_t source) {
+vector<int32_t> receive_jobs_from(int32_t source) {
     MPI_Status status;
-    int32_t job_message[1];
-    MPI_Recv(job_message, 1, MPI_INT, source, JOB_TAG, MPI_COMM_WORLD, &status);
+    MPI_Probe(source, JOB_TAG, MPI_COMM_WORLD, &status);
+
+    int32_t number_jobs;
+    MPI_Get_count(&status, MPI_INT, &number_jobs);
 
-    int32_t current_job = job_message[0];
+    vector<int32_t> jobs(number_jobs);
+    MPI_Recv(&jobs[0], number_jobs, MPI_INT, source, JOB_TAG, MPI_COMM_WORLD, &status);
 
-    Log::debug("receiving current_job: %d from %d\n", current_job, source);
+    Log::debug("received %d jobs starting with job %d from %d\n", number_jobs, jobs[0], source);
 
-    return current_job;
+    return jobs;
 }
 
 string result_to_string(ResultSet result) {
@@ -119,26 +143,64 @@ string result_to_string(ResultSet result) {
            + ", test mse: " + to_string(result.test_mae) + ", millis: " + to_string(result.milliseconds) + "]";
 }
 
-void send_result_to(int32_t target, ResultSet result) {
-    size_t result_size = sizeof(result);
-    char bytes[result_size];
-    memcpy(bytes, &result, result_size);
+void send_results_to(int32_t target, const vector<ResultSet>& job_results) {
+    size_t results_size = sizeof(ResultSet) * job_results.size();
+    vector<char> bytes(results_size);
+    memcpy(&bytes[0], &job_results[0], results_size);
 
-    MPI_Send(bytes, result_size, MPI_CHAR, target, RESULT_TAG, MPI_COMM_WORLD);
+    MPI_Send(&bytes[0], results_size, MPI_CHAR, target, RESULT_TAG, MPI_COMM_WORLD);
 }
 
-ResultSet receive_result_from(int32_t source) {
-    ResultSet result;
-
+vector<ResultSet> receive_results_from(int32_t source) {
     MPI_Status status;
-    size_t result_size = sizeof(result);
-    char bytes[result_size];
+    MPI_Probe(source, RESULT_TAG, MPI_COMM_WORLD, &status);
 
-    MPI_Recv(bytes, result_size, MPI_CHAR, source, RESULT_TAG, MPI_COMM_WORLD, &status);
+    int32_t results_size;
+    MPI_Get_count(&status, MPI_CHAR, &results_size);
 
-    memcpy(&result, bytes, result_size);
+    vector<char> bytes(results_size);
+    MPI_Recv(&bytes[0], results_size, MPI_CHAR, source, RESULT_TAG, MPI_COMM_WORLD, &status);
 
-    return result;
+    vector<ResultSet> job_results(results_size / sizeof(ResultSet));
+    memcpy(&job_results[0], &bytes[0], results_size);
+
+    return job_results;
+}
+
+void write_completed_job(const ResultSet& result) {
+    (*completed_jobs_file) << result.job << "," << result.milliseconds << "," << result.training_mse << ","
+                           << result.training_mae << "," << result.test_mse << "," << result.test_mae << endl;
+}
+
+/**
+ * Reads the results of the jobs completed by a previous run of the sweep, returning how many there were.
+ */
+int32_t read_completed_jobs(string filename) {
+    ifstream infile(filename);
+
+    int32_t number_completed = 0;
+    string line;
+    while (getline(infile, line)) {
+        istringstream line_stream(line);
+        ResultSet result;
+        char comma;
+
+        line_stream >> result.job >> comma >> result.milliseconds >> comma >> result.training_mse >> comma
+            >> result.training_mae >> comma >> result.test_mse >> comma >> result.test_mae;
+
+        // skip a partially written last line or a job from a sweep with different settings
+        if (line_stream.fail() || result.job < 0 || result.job >= (int32_t) results.size()) {
+            Log::warning("skipping line of completed jobs file '%s': '%s'\n", filename.c_str(), line.c_str());
+            continue;
+        }
+
+        if (results[result.job].job < 0) {
+            number_completed++;
+        }
+        results[result.job] = result;
+    }
+
+    return number_completed;
 }
 
 void send_terminate_to(int32_t target) {
@@ -153,59 +215,56 @@ void receive_terminate_from(int32_t source) {
     MPI_Recv(terminate_message, 1, MPI_INT, source, TERMINATE_TAG, MPI_COMM_WORLD, &status);
 }
 
-// tweaked from: https://stackoverflow.com/questions/675039/how-can-i-create-directory-tree-in-c-linux/29828907
-static int32_t do_mkdir(const char* path, mode_t mode) {
-    Stat st;
-    int32_t status = 0;
+/**
+ * Writes the combined results of an rnn type once all of its jobs have completed.
+ */
+void write_rnn_results(int32_t rnn) {
+    int32_t jobs_per_rnn = (time_series_sets->get_number_series() / fold_size) * repeats;
+
+    // get the results which should be there for this rnn type
+    int32_t rnn_job_start = rnn * jobs_per_rnn;
+    int32_t rnn_job_end = (rnn + 1) * jobs_per_rnn;
 
-    if (stat(path, &st) != 0) {
-        /* Directory does not exist. EEXIST for race condition */
-        if (mkdir(path, mode) != 0 && errno != EEXIST) {
-            status = -1;
+    bool rnn_finished = true;
+    Log::debug("testing finished for rnn: '%s'\n", rnn_types[rnn].c_str());
+    for (int32_t i = rnn_job_start; i < rnn_job_end; i++) {
+        if (i == rnn_job_start) {
+            Log::debug(" %d", results[i].job);
+        } else {
+            Log::debug_no_header(" %d", results[i].job);
         }
 
-    } else if (!S_ISDIR(st.st_mode)) {
-        errno = ENOTDIR;
-        status = -1;
+        if (results[i].job < 0) {
+            rnn_finished = false;
+            break;
+        }
     }
+    Log::debug_no_header("\n");
 
-    return (status);
-}
+    Log::debug("rnn '%s' finished? %d\n", rnn_types[rnn].c_str(), rnn_finished);
 
-/**
- * ** mkpath - ensure all directories in path exist
- * ** Algorithm takes the pessimistic view and works top-down to ensure
- * ** each directory in path exists, rather than optimistically creating
- * ** the last element and working backwards.
- * */
-int32_t mkpath(const char* path, mode_t mode) {
-    char* pp;
-    char* sp;
-    int32_t status;
-    char* copypath = strdup(path);
-
-    status = 0;
-    pp = copypath;
-    while (status == 0 && (sp = strchr(pp, '/')) != 0) {
-        Log::debug("trying to create directory: '%s'\n", copypath);
-        if (sp != pp) {
-            /* Neither root nor double slash in path */
-            *sp = '\0';
-            status = do_mkdir(copypath, mode);
-            *sp = '/';
-        }
-        pp = sp + 1;
-    }
+    if (rnn_finished) {
+        ofstream outfile(output_directory + "/combined_" + rnn_types[rnn] + ".csv");
 
-    if (status == 0) {
-        status = do_mkdir(path, mode);
-    }
+        int32_t current = rnn_job_start;
+        for (int32_t j = 0; j < (time_series_sets->get_number_series() / fold_size); j++) {
+            for (int32_t k = 0; k < repeats; k++) {
+                outfile << j << "," << k << "," << results[current].milliseconds << ","
+                        << results[current].training_mse << "," << results[current].training_mae << ","
+                        << results[current].test_mse << "," << results[current].test_mae << endl;
 
-    free(copypath);
-    return (status);
+                Log::debug(
+                    "%s, tested on series[%d], repeat: %d, result: %s\n", rnn_types[rnn].c_str(), j, k,
+                    result_to_string(results[current]).c_str()
+                );
+                current++;
+            }
+        }
+        outfile.close();
+    }
 }
 
-void master(int32_t max_rank) {
+void master(int32_t max_rank, bool resume) {
     if (output_directory != "") {
         Log::debug("creating directory: '%s'\n", output_directory.c_str());
         mkpath(output_directory.c_str(), 0777);
@@ -213,14 +272,27 @@ void master(int32_t max_rank) {
         mkdir(output_directory.c_str(), 0777);
     }
 
-    // initialize the results with -1 as the job so we can determine if a particular rnn type has completed
-    results = vector<ResultSet>(
-        rnn_types.size() * time_series_sets->get_number_series() * repeats, {-1, 0.0, 0.0, 0.0, 0.0, 0}
-    );
-
     int32_t terminates_sent = 0;
     int32_t current_job = 0;
     int32_t last_job = rnn_types.size() * (time_series_sets->get_number_series() / fold_size) * repeats;
+    int32_t jobs_per_rnn = (time_series_sets->get_number_series() / fold_size) * repeats;
+
+    // initialize the results with -1 as the job so we can determine if a particular rnn type has completed
+    results = vector<ResultSet>(last_job, {-1, 0.0, 0.0, 0.0, 0.0, 0});
+
+    string completed_jobs_filename = output_directory + "/completed_jobs.csv";
+    if (resume) {
+        int32_t number_completed = read_completed_jobs(completed_jobs_filename);
+        Log::info("resuming sweep, %d of %d jobs were already completed\n", number_completed, last_job);
+
+        for (int32_t rnn = 0; rnn < (int32_t) rnn_types.size(); rnn++) {
+            write_rnn_results(rnn);
+        }
+        completed_jobs_file = new ofstream(completed_jobs_filename, std::ios_base::app);
+    } else {
+        completed_jobs_file = new ofstream(completed_jobs_filename);
+    }
+    (*completed_jobs_file) << setprecision(17);
 
     while (true) {
         // wait for a incoming message
@@ -231,82 +303,51 @@ void master(int32_t max_rank) {
         int32_t tag = status.MPI_TAG;
         Log::debug("probe returned message from: %d with tag: %d\n", message_source, tag);
 
-        // if the message is a work request, send a genome
-
+        // if the message is a work request, send as many jobs as were requested which have not
+        // already been completed
         if (tag == WORK_REQUEST_TAG) {
-            receive_work_request_from(message_source);
+            int32_t number_jobs = receive_work_request_from(message_source);
+
+            vector<int32_t> jobs;
+            while ((int32_t) jobs.size() < number_jobs && current_job < last_job) {
+                if (results[current_job].job < 0) {
+                    jobs.push_back(current_job);
+                }
+                current_job++;
+            }
 
-            if (current_job >= last_job) {
-                // no more jobs to process if the current job is >= the result vector
-                // send terminate message
+            if (jobs.size() == 0) {
+                // no more jobs to process, send terminate message
                 Log::debug("terminating worker: %d\n", message_source);
                 send_terminate_to(message_source);
                 terminates_sent++;
 
                 Log::debug("sent: %d terminates of: %d\n", terminates_sent, (max_rank - 1));
                 if (terminates_sent >= max_rank - 1) {
-                    return;
+                    break;
                 }
 
             } else {
-                // send job
-                Log::debug("sending job to: %d\n", message_source);
-                send_job_to(message_source, current_job);
-
-                // increment the current job for the next worker
-                current_job++;
+                Log::debug("sending %d jobs to: %d\n", jobs.size(), message_source);
+                send_jobs_to(message_source, jobs);
             }
         } else if (tag == RESULT_TAG) {
-            Log::debug("receiving job from: %d\n", message_source);
-            ResultSet result = receive_result_from(message_source);
-            results[result.job] = result;
-
-            // TODO:
-            // check and see if this particular set of jobs for rnn_type has completed,
-            // then write the file for that type if it has
-            int32_t jobs_per_rnn = (time_series_sets->get_number_series() / fold_size) * repeats;
-
-            // get the particular rnn type this job was for, and which results should be there
-            int32_t rnn = result.job / jobs_per_rnn;
-            int32_t rnn_job_start = rnn * jobs_per_rnn;
-            int32_t rnn_job_end = (rnn + 1) * jobs_per_rnn;
-
-            bool rnn_finished = true;
-            Log::debug("testing finished for rnn: '%s'\n", rnn_types[rnn].c_str());
-            for (int32_t i = rnn_job_start; i < rnn_job_end; i++) {
-                if (i == rnn_job_start) {
-                    Log::debug(" %d", results[i].job);
-                } else {
-                    Log::debug_no_header(" %d", results[i].job);
-                }
+            Log::debug("receiving results from: %d\n", message_source);
+            vector<ResultSet> job_results = receive_results_from(message_source);
 
-                if (results[i].job < 0) {
-                    rnn_finished = false;
-                    break;
-                }
+            for (int32_t i = 0; i < (int32_t) job_results.size(); i++) {
+                results[job_results[i].job] = job_results[i];
+                write_completed_job(job_results[i]);
             }
-            Log::debug_no_header("\n");
-
-            Log::debug("rnn '%s' finished? %d\n", rnn_types[rnn].c_str(), rnn_finished);
-
-            if (rnn_finished) {
-                ofstream outfile(output_directory + "/combined_" + rnn_types[rnn] + ".csv");
-
-                int32_t current = rnn_job_start;
-                for (int32_t j = 0; j < (time_series_sets->get_number_series() / fold_size); j++) {
-                    for (int32_t k = 0; k < repeats; k++) {
-                        outfile << j << "," << k << "," << results[current].milliseconds << ","
-                                << results[current].training_mse << "," << results[current].training_mae << ","
-                                << results[current].test_mse << "," << results[current].test_mae << endl;
-
-                        Log::debug(
-                            "%s, tested on series[%d], repeat: %d, result: %s\n", rnn_types[rnn].c_str(), j, k,
-                            result_to_string(results[current]).c_str()
-                        );
-                        current++;
-                    }
+            completed_jobs_file->flush();
+
+            // check and see if the rnn types of these jobs have completed, and write the file for
+            // each type that has
+            for (int32_t i = 0; i < (int32_t) job_results.size(); i++) {
+                int32_t rnn = job_results[i].job / jobs_per_rnn;
+                if (i == 0 || rnn != job_results[i - 1].job / jobs_per_rnn) {
+                    write_rnn_results(rnn);
                 }
-                outfile.close();
             }
 
         } else {
@@ -314,10 +355,14 @@ void master(int32_t max_rank) {
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
     }
+
+    completed_jobs_file->close();
+    delete completed_jobs_file;
+    completed_jobs_file = NULL;
 }
 
-ResultSet handle_job(int32_t rank, int32_t current_job) {
-    int32_t jobs_per_rnn = (time_series_sets->get_number_series() / fold_size) * repeats;
+ResultSet handle_job(string worker_id, int32_t current_job) {
+    int32_t jobs_per_rnn = (shared_time_series->get_number_series() / fold_size) * repeats;
 
     // get rnn_type
     string rnn_type = rnn_types[current_job / jobs_per_rnn];
@@ -333,7 +378,7 @@ ResultSet handle_job(int32_t rank, int32_t current_job) {
     vector<int32_t> training_indexes;
     vector<int32_t> test_indexes;
 
-    for (int32_t k = 0; k < time_series_sets->get_number_series(); k += fold_size) {
+    for (int32_t k = 0; k < shared_time_series->get_number_series(); k += fold_size) {
         if (j == (k / fold_size)) {
             for (int32_t l = 0; l < fold_size; l++) {
                 test_indexes.push_back(k + l);
@@ -347,16 +392,15 @@ ResultSet handle_job(int32_t rank, int32_t current_job) {
 
     Log::debug("test_indexes.size(): %d, training_indexes.size(): %d\n", test_indexes.size(), training_indexes.size());
 
-    time_series_sets->set_training_indexes(training_indexes);
-    time_series_sets->set_test_indexes(test_indexes);
+    TimeSeriesWindows training_inputs;
+    TimeSeriesWindows training_outputs;
+    TimeSeriesWindows validation_inputs;
+    TimeSeriesWindows validation_outputs;
 
-    vector<vector<vector<double> > > training_inputs;
-    vector<vector<vector<double> > > training_outputs;
-    vector<vector<vector<double> > > validation_inputs;
-    vector<vector<vector<double> > > validation_outputs;
-
-    time_series_sets->export_training_series(time_offset, training_inputs, training_outputs);
-    time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
+    training_inputs.select_series(all_inputs, training_indexes);
+    training_outputs.select_series(all_outputs, training_indexes);
+    validation_inputs.select_series(all_inputs, test_indexes);
+    validation_outputs.select_series(all_outputs, test_indexes);
 
     vector<string> input_parameter_names = time_series_sets->get_input_parameter_names();
     vector<string> output_parameter_names = time_series_sets->get_output_parameter_names();
@@ -461,7 +505,7 @@ ResultSet handle_job(int32_t rank, int32_t current_job) {
     double test_mae = genome->get_mae(best_parameters, validation_inputs, validation_outputs);
 
     Log::release_id(backprop_log_id);
-    Log::set_id("worker_" + to_string(rank));
+    Log::set_id(worker_id);
 
     Log::debug("deleting genome and rnn.\n");
 
@@ -481,13 +525,49 @@ ResultSet handle_job(int32_t rank, int32_t current_job) {
     return result;
 }
 
+/**
+ * Runs the jobs with up to number_threads threads, each of which takes the next job which has not
+ * been started until there are none left.
+ */
+void handle_jobs(int32_t rank, const vector<int32_t>& jobs, vector<ResultSet>& job_results) {
+    job_results.resize(jobs.size());
+
+    if (number_threads <= 1 || jobs.size() == 1) {
+        for (int32_t i = 0; i < (int32_t) jobs.size(); i++) {
+            job_results[i] = handle_job("worker_" + to_string(rank), jobs[i]);
+        }
+        return;
+    }
+
+    atomic<int32_t> next_job(0);
+    auto job_thread = [&](int32_t thread_number) {
+        string worker_id = "worker_" + to_string(rank) + "_thread_" + to_string(thread_number);
+        Log::set_id(worker_id);
+
+        int32_t i;
+        while ((i = next_job++) < (int32_t) jobs.size()) {
+            job_results[i] = handle_job(worker_id, jobs[i]);
+        }
+
+        Log::release_id(worker_id);
+    };
+
+    vector<thread> threads;
+    for (int32_t i = 0; i < number_threads && i < (int32_t) jobs.size(); i++) {
+        threads.push_back(thread(job_thread, i));
+    }
+    for (int32_t i = 0; i < (int32_t) threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
 void worker(int32_t rank) {
     int32_t master_rank = 0;
     Log::set_id("worker_" + to_string(rank));
 
     while (true) {
         Log::debug("sending work request!\n");
-        send_work_request_to(master_rank);
+        send_work_request_to(master_rank, number_threads * jobs_per_message);
         Log::debug("sent work request!\n");
 
         MPI_Status status;
@@ -502,14 +582,17 @@ void worker(int32_t rank) {
             break;
 
         } else if (tag == JOB_TAG) {
-            Log::debug("received genome!\n");
-            int32_t current_job = receive_job_from(master_rank);
+            Log::debug("received jobs!\n");
+            vector<int32_t> jobs = receive_jobs_from(master_rank);
 
-            ResultSet result = handle_job(rank, current_job);
+            vector<ResultSet> job_results;
+            handle_jobs(rank, jobs, job_results);
 
-            Log::debug("calculated_result: %s\n", result_to_string(result).c_str());
+            for (int32_t i = 0; i < (int32_t) job_results.size(); i++) {
+                Log::debug("calculated_result: %s\n", result_to_string(job_results[i]).c_str());
+            }
 
-            send_result_to(master_rank, result);
+            send_results_to(master_rank, job_results);
 
         } else {
             Log::fatal("ERROR: received message with unknown tag: %d\n", tag);
@@ -523,7 +606,9 @@ void worker(int32_t rank) {
 int main(int argc, char** argv) {
     int32_t rank, max_rank;
 
-    MPI_Init(&argc, &argv);
+    // only the main thread of each rank makes mpi calls, the other threads just run jobs
+    int32_t thread_support;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
 
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &max_rank);
@@ -547,29 +632,43 @@ int main(int argc, char** argv) {
 
     get_argument(arguments, "--fold_size", true, fold_size);
 
+    get_argument(arguments, "--number_threads", false, number_threads);
+
+    get_argument(arguments, "--jobs_per_message", false, jobs_per_message);
+
+    bool resume = argument_exists(arguments, "--resume");
+
     weight_rules = new WeightRules();
     weight_rules->initialize_from_args(arguments);
 
     weight_update_method = new WeightUpdate();
     weight_update_method->generate_from_arguments(arguments);
 
-    if (rank == 0) {
-        // only print verbose info from the master process
-        time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    } else {
-        time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+    // only one rank on each node loads the time series, the rest use its copy in shared memory
+    shared_time_series = new SharedTimeSeries();
+    time_series_sets = shared_time_series->generate_time_series_sets(arguments);
+
+    if (shared_time_series->is_node_leader()) {
+        vector<int32_t> series_indexes;
+        for (int32_t i = 0; i < time_series_sets->get_number_series(); i++) {
+            series_indexes.push_back(i);
+        }
+        time_series_sets->export_time_series(series_indexes, time_offset, 0, 0, all_inputs, all_outputs);
     }
+    shared_time_series->share(all_inputs);
+    shared_time_series->share(all_outputs);
 
     // MPI_Barrier(MPI_COMM_WORLD);
 
     Log::clear_rank_restriction();
 
     if (rank == 0) {
-        master(max_rank);
+        master(max_rank, resume);
     } else {
         worker(rank);
     }
 
     Log::release_id("main_" + to_string(rank));
+    delete shared_time_series;
     MPI_Finalize();
 }
@@ -0,0 +1,201 @@
+#include <cstring>
+
+#include <map>
+using std::map;
+
+#include <sstream>
+using std::istream;
+using std::istringstream;
+using std::ostream;
+using std::ostringstream;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+#include "common/process_arguments.hxx"
+#include "mpi.h"
+#include "shared_time_series.hxx"
+
+static void write_bounds(ostream& out, const map<string, double>& bounds) {
+    int32_t size = bounds.size();
+    out.write((char*) &size, sizeof(int32_t));
+
+    for (auto iterator = bounds.begin(); iterator != bounds.end(); iterator++) {
+        int32_t length = iterator->first.size();
+        out.write((char*) &length, sizeof(int32_t));
+        out.write(iterator->first.c_str(), length);
+        out.write((char*) &iterator->second, sizeof(double));
+    }
+}
+
+static void read_bounds(istream& in, map<string, double>& bounds) {
+    int32_t size;
+    in.read((char*) &size, sizeof(int32_t));
+
+    bounds.clear();
+    for (int32_t i = 0; i < size; i++) {
+        int32_t length;
+        in.read((char*) &length, sizeof(int32_t));
+
+        string key(length, ' ');
+        in.read(&key[0], length);
+
+        double value;
+        in.read((char*) &value, sizeof(double));
+        bounds[key] = value;
+    }
+}
+
+static void broadcast_string(string& s, MPI_Comm communicator) {
+    int32_t length = s.size();
+    MPI_Bcast(&length, 1, MPI_INT, 0, communicator);
+
+    s.resize(length);
+    if (length > 0) {
+        MPI_Bcast(&s[0], length, MPI_CHAR, 0, communicator);
+    }
+}
+
+SharedTimeSeries::SharedTimeSeries() {
+    int32_t rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_communicator);
+    MPI_Comm_rank(node_communicator, &node_rank);
+    MPI_Comm_size(node_communicator, &node_size);
+
+    number_series = 0;
+}
+
+SharedTimeSeries::~SharedTimeSeries() {
+    for (int32_t i = 0; i < (int32_t) shared_windows.size(); i++) {
+        MPI_Win_free(&shared_windows[i]);
+    }
+    MPI_Comm_free(&node_communicator);
+}
+
+bool SharedTimeSeries::is_node_leader() const {
+    return node_rank == 0;
+}
+
+int32_t SharedTimeSeries::get_node_size() const {
+    return node_size;
+}
+
+int32_t SharedTimeSeries::get_number_series() const {
+    return number_series;
+}
+
+TimeSeriesSets* SharedTimeSeries::generate_time_series_sets(const vector<string>& arguments) {
+    TimeSeriesSets* time_series_sets = TimeSeriesSets::generate_from_arguments(arguments, is_node_leader());
+
+    string bounds;
+    if (is_node_leader()) {
+        number_series = time_series_sets->get_number_series();
+
+        ostringstream out;
+        write_bounds(out, time_series_sets->get_normalize_mins());
+        write_bounds(out, time_series_sets->get_normalize_maxs());
+        write_bounds(out, time_series_sets->get_normalize_avgs());
+        write_bounds(out, time_series_sets->get_normalize_std_devs());
+        bounds = out.str();
+    }
+
+    MPI_Bcast(&number_series, 1, MPI_INT, 0, node_communicator);
+    broadcast_string(bounds, node_communicator);
+
+    if (!is_node_leader()) {
+        map<string, double> normalize_mins, normalize_maxs, normalize_avgs, normalize_std_devs;
+
+        istringstream in(bounds);
+        read_bounds(in, normalize_mins);
+        read_bounds(in, normalize_maxs);
+        read_bounds(in, normalize_avgs);
+        read_bounds(in, normalize_std_devs);
+
+        time_series_sets->set_normalize_bounds(
+            time_series_sets->get_normalize_type(), normalize_mins, normalize_maxs, normalize_avgs, normalize_std_devs
+        );
+    }
+
+    return time_series_sets;
+}
+
+void SharedTimeSeries::share(TimeSeriesWindows& windows) {
+    // number of parameters, sequence length, stride and then the rows of each series
+    vector<int32_t> layout;
+    if (is_node_leader()) {
+        layout.push_back(windows.get_number_parameters());
+        layout.push_back(windows.get_sequence_length());
+        layout.push_back(windows.get_stride());
+
+        const vector<int32_t>& series_rows = windows.get_series_rows();
+        layout.insert(layout.end(), series_rows.begin(), series_rows.end());
+    }
+
+    int32_t layout_size = layout.size();
+    MPI_Bcast(&layout_size, 1, MPI_INT, 0, node_communicator);
+    layout.resize(layout_size);
+    MPI_Bcast(&layout[0], layout_size, MPI_INT, 0, node_communicator);
+
+    int32_t number_parameters = layout[0];
+    int32_t sequence_length = layout[1];
+    int32_t stride = layout[2];
+    vector<int32_t> series_rows(layout.begin() + 3, layout.end());
+
+    int64_t number_values = 0;
+    for (int32_t i = 0; i < (int32_t) series_rows.size(); i++) {
+        number_values += (int64_t) number_parameters * series_rows[i];
+    }
+
+    // only the leader allocates any memory, the other ranks map the leader's segment
+    MPI_Aint size = is_node_leader() ? number_values * sizeof(double) : 0;
+    double* values = NULL;
+    MPI_Win window;
+    MPI_Win_allocate_shared(size, sizeof(double), MPI_INFO_NULL, node_communicator, &values, &window);
+
+    if (!is_node_leader()) {
+        MPI_Aint leader_size;
+        int32_t displacement_unit;
+        MPI_Win_shared_query(window, 0, &leader_size, &displacement_unit, &values);
+    }
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+    if (is_node_leader() && number_values > 0) {
+        memcpy(values, windows.get_values(), size);
+    }
+    MPI_Win_sync(window);
+    MPI_Barrier(node_communicator);
+    MPI_Win_sync(window);
+    MPI_Win_unlock_all(window);
+
+    shared_windows.push_back(window);
+
+    windows.use_shared_values(number_parameters, series_rows, values);
+    windows.create_windows(sequence_length, stride);
+
+    Log::debug(
+        "sharing %ld time series values (%d series, %d windows) between %d ranks\n", number_values,
+        (int32_t) series_rows.size(), windows.size(), node_size
+    );
+}
+
+void SharedTimeSeries::get_train_validation_windows(
+    const vector<string>& arguments, TimeSeriesSets* time_series_sets, TimeSeriesWindows& train_inputs,
+    TimeSeriesWindows& train_outputs, TimeSeriesWindows& validation_inputs, TimeSeriesWindows& validation_outputs
+) {
+    if (is_node_leader()) {
+        ::get_train_validation_windows(
+            arguments, time_series_sets, train_inputs, train_outputs, validation_inputs, validation_outputs
+        );
+    }
+
+    share(train_inputs);
+    share(train_outputs);
+    share(validation_inputs);
+    share(validation_outputs);
+}
@@ -0,0 +1,67 @@
+#ifndef EXAMM_SHARED_TIME_SERIES_HXX
+#define EXAMM_SHARED_TIME_SERIES_HXX
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "mpi.h"
+#include "time_series/time_series.hxx"
+
+/**
+ * Shares the time series data between the ranks running on the same node. Only the first rank on
+ * each node (the node leader) loads and normalizes the time series, and the windows it exports are
+ * copied once into MPI shared memory which the other ranks on the node read from directly.
+ *
+ * All the methods are collective over the ranks on a node, and this must be deleted before
+ * MPI_Finalize is called.
+ */
+class SharedTimeSeries {
+   private:
+    MPI_Comm node_communicator;
+    int32_t node_rank;
+    int32_t node_size;
+
+    int32_t number_series;
+
+    vector<MPI_Win> shared_windows;
+
+   public:
+    SharedTimeSeries();
+    ~SharedTimeSeries();
+
+    bool is_node_leader() const;
+    int32_t get_node_size() const;
+
+    /**
+     * The node leader loads the time series from the arguments, the other ranks get sets with the
+     * same parameters and normalization bounds but without any series (which they should get from
+     * the shared windows).
+     */
+    TimeSeriesSets* generate_time_series_sets(const vector<string>& arguments);
+
+    /**
+     * The number of series the node leader loaded.
+     */
+    int32_t get_number_series() const;
+
+    /**
+     * Called after the node leader has exported the windows (the windows of the other ranks are
+     * ignored). The leader's values are copied into shared memory, and the windows of every rank
+     * on the node (including the leader's, whose own copy is freed) are replaced with the same
+     * windows over the shared memory.
+     */
+    void share(TimeSeriesWindows& windows);
+
+    /**
+     * The shared version of get_train_validation_windows (see common/process_arguments.hxx).
+     */
+    void get_train_validation_windows(
+        const vector<string>& arguments, TimeSeriesSets* time_series_sets, TimeSeriesWindows& train_inputs,
+        TimeSeriesWindows& train_outputs, TimeSeriesWindows& validation_inputs, TimeSeriesWindows& validation_outputs
+    );
+};
+
+#endif
@@ -2,6 +2,9 @@
 #include <condition_variable>
 using std::condition_variable;
 
+#include <functional>
+using std::cref;
+
 #include <iomanip>
 using std::setw;
 
@@ -26,16 +29,30 @@ using std::vector;
 #include "common/arguments.hxx"
 #include "image_tools/image_set.hxx"
 
+#ifdef _MYSQL_
+#include "cnn/database_exporter.hxx"
+#endif
+
 mutex exact_mutex;
 
 vector<string> arguments;
 
 EXACT* exact;
 
+#ifdef _MYSQL_
+// if --async_database_export is given, the search is exported without holding up the threads
+DatabaseExporter* database_exporter = NULL;
+#endif
+
 bool finished = false;
 
 int32_t images_resize;
 
+// if > 0, every profile_interval-th training epoch of each genome is profiled into
+// <output_directory>/profile_<generation id>.csv
+int profile_interval = 0;
+string profile_directory;
+
 void exact_thread(
     const Images& training_images, const Images& validation_images, const Images& testing_images, int32_t id
 ) {
@@ -50,6 +67,11 @@ void exact_thread(
 
         genome->set_name("thread_" + to_string(id));
         genome->initialize();
+        if (profile_interval > 0) {
+            genome->set_profile(
+                profile_directory + "/profile_" + to_string(genome->get_generation_id()) + ".csv", profile_interval
+            );
+        }
         genome->stochastic_backpropagation(training_images, images_resize, validation_images);
         genome->evaluate_test(testing_images);
 
@@ -106,6 +128,9 @@ int main(int argc, char** argv) {
 
     get_argument(arguments, "--images_resize", true, images_resize);
 
+    get_argument(arguments, "--profile_interval", false, profile_interval);
+    profile_directory = output_directory;
+
     Images training_images(training_filename, padding);
     Images validation_images(
         validation_filename, padding, training_images.get_average(), training_images.get_std_dev()
@@ -125,11 +150,19 @@ int main(int argc, char** argv) {
         );
 #ifdef _MYSQL_
     }
+
+    if (argument_exists(arguments, "--async_database_export")) {
+        int32_t rows_per_insert = 100;
+        get_argument(arguments, "--database_rows_per_insert", false, rows_per_insert);
+
+        database_exporter = new DatabaseExporter(new MySQLDatabaseConnection(), rows_per_insert);
+        exact->set_database_exporter(database_exporter);
+    }
 #endif
 
     vector<thread> threads;
     for (int32_t i = 0; i < number_threads; i++) {
-        threads.push_back(thread(exact_thread, training_images, validation_images, testing_images, i));
+        threads.push_back(thread(exact_thread, cref(training_images), cref(validation_images), cref(testing_images), i));
     }
 
     for (int32_t i = 0; i < number_threads; i++) {
@@ -138,6 +171,11 @@ int main(int argc, char** argv) {
 
     finished = true;
 
+#ifdef _MYSQL_
+    // waits for the exports which are still queued
+    delete database_exporter;
+#endif
+
     cout << "completed!" << endl;
 
     return 0;
@@ -18,6 +18,7 @@ using std::thread;
 using std::vector;
 
 #include "common/log.hxx"
+#include "common/metrics.hxx"
 #include "common/process_arguments.hxx"
 #include "examm/examm.hxx"
 #include "rnn/generate_nn.hxx"
@@ -35,14 +36,20 @@ WeightUpdate* weight_update_method;
 
 bool finished = false;
 
-vector<vector<vector<double> > > training_inputs;
-vector<vector<vector<double> > > training_outputs;
-vector<vector<vector<double> > > validation_inputs;
-vector<vector<vector<double> > > validation_outputs;
+TimeSeriesWindows training_inputs;
+TimeSeriesWindows training_outputs;
+TimeSeriesWindows validation_inputs;
+TimeSeriesWindows validation_outputs;
+
+void lock_examm() {
+    // time spent here is time the worker threads are blocked on each other
+    MetricTimer lock_timer("examm_lock_wait_seconds", "Time worker threads waited for the EXAMM lock.", "lock_wait");
+    examm_mutex.lock();
+}
 
 void examm_thread(int32_t id) {
     while (true) {
-        examm_mutex.lock();
+        lock_examm();
         Log::set_id("main");
         RNN_Genome* genome = examm->generate_genome();
         examm_mutex.unlock();
@@ -53,13 +60,15 @@ void examm_thread(int32_t id) {
 
         string log_id = "genome_" + to_string(genome->get_generation_id()) + "_thread_" + to_string(id);
         Log::set_id(log_id);
+        MetricTimer train_timer("examm_genome_train_seconds", "Time taken to train a genome.", "train_genome");
         // genome->backpropagate(training_inputs, training_outputs, validation_inputs, validation_outputs);
         genome->backpropagate_stochastic(
             training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method
         );
+        train_timer.stop();
         Log::release_id(log_id);
 
-        examm_mutex.lock();
+        lock_examm();
         Log::set_id("main");
         examm->insert_genome(genome);
         examm_mutex.unlock();
@@ -86,13 +95,14 @@ int main(int argc, char** argv) {
 
     Log::initialize(arguments);
     Log::set_id("main");
+    Metrics::initialize(arguments);
 
     int32_t number_threads;
     get_argument(arguments, "--number_threads", true, number_threads);
 
     TimeSeriesSets* time_series_sets = NULL;
     time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    get_train_validation_data(
+    get_train_validation_windows(
         arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
     );
 
@@ -116,6 +126,8 @@ int main(int argc, char** argv) {
     }
 
     finished = true;
+    // writes out the final checkpoint if checkpointing is enabled
+    delete examm;
 
     Log::info("completed!\n");
     Log::release_id("main");
@@ -162,6 +162,18 @@ void DNASNode::reset(int32_t series_length) {
     }
 }
 
+void DNASNode::shift_time(int32_t offset) {
+    RNN_Node_Interface::shift_time(offset);
+
+    if (counter >= CRYSTALLIZATION_THRESHOLD) {
+        nodes[maxi]->shift_time(offset);
+    } else {
+        for (auto node : nodes) {
+            node->shift_time(offset);
+        }
+    }
+}
+
 void DNASNode::input_fired(int32_t time, double incoming_output) {
     inputs_fired[time]++;
 
@@ -108,6 +108,7 @@ class DNASNode : public RNN_Node_Interface {
 
     virtual void get_gradients(vector<double>& gradients);
     virtual void reset(int32_t _series_length);
+    virtual void shift_time(int32_t offset);
     virtual void write_to_stream(ostream& out);
 
     virtual RNN_Node_Interface* copy() const;
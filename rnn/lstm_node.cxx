@@ -421,6 +421,12 @@ void LSTM_Node::reset(int32_t _series_length) {
     outputs_fired.assign(series_length, 0);
 }
 
+void LSTM_Node::shift_time(int32_t offset) {
+    RNN_Node_Interface::shift_time(offset);
+    // the next time step uses the previous cell value
+    shift_time_values(cell_values, offset, 0.0);
+}
+
 RNN_Node_Interface* LSTM_Node::copy() const {
     LSTM_Node* n = new LSTM_Node(innovation_number, layer_type, depth);
 
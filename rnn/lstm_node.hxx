@@ -93,6 +93,7 @@ class LSTM_Node : public RNN_Node_Interface {
     void get_gradients(vector<double>& gradients);
 
     void reset(int32_t _series_length);
+    void shift_time(int32_t offset);
 
     void write_to_stream(ostream& out);
 
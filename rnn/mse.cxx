@@ -1,4 +1,7 @@
 #include <cmath>
+#include <limits>
+using std::numeric_limits;
+
 #include <vector>
 using std::vector;
 
@@ -110,3 +113,84 @@ void get_mae(RNN* genome, const vector<vector<double> >& expected, double& mae_s
         }
     }
 }
+
+double get_squared_error(const double* outputs, const double* expected, double* errors, int32_t length) {
+    const double* __restrict__ o = outputs;
+    const double* __restrict__ e = expected;
+    double* __restrict__ d = errors;
+
+    double sum = 0.0;
+    for (int32_t j = 0; j < length; j++) {
+        double error = o[j] - e[j];
+        d[j] = error;
+        sum += error * error;
+    }
+    return sum;
+}
+
+double get_absolute_error(const double* outputs, const double* expected, double* errors, int32_t length) {
+    const double* __restrict__ o = outputs;
+    const double* __restrict__ e = expected;
+    double* __restrict__ d = errors;
+
+    double sum = 0.0;
+    for (int32_t j = 0; j < length; j++) {
+        double error = o[j] - e[j];
+        // the sign of the error, which is 0 when there is no error
+        d[j] = (double) (error > 0.0) - (double) (error < 0.0);
+        sum += fabs(error);
+    }
+    return sum;
+}
+
+double get_softmax_cross_entropy(
+    const vector<const double*>& outputs, const vector<const double*>& expected, const vector<double*>& errors,
+    int32_t length
+) {
+    int32_t number_outputs = outputs.size();
+
+    // the maximum output and then the log of the sum of the exps at each time step, with the
+    // reciprocal of the sum kept so the softmaxes are a multiply instead of another exp
+    vector<double> maximums(length, -numeric_limits<double>::infinity());
+    vector<double> log_sums(length, 0.0);
+    vector<double> inverse_sums(length);
+    double* __restrict__ m = maximums.data();
+    double* __restrict__ s = log_sums.data();
+    double* __restrict__ r = inverse_sums.data();
+
+    for (int32_t i = 0; i < number_outputs; i++) {
+        const double* __restrict__ o = outputs[i];
+        for (int32_t j = 0; j < length; j++) {
+            m[j] = fmax(m[j], o[j]);
+        }
+    }
+
+    // the errors hold each exp until the sums are known
+    for (int32_t i = 0; i < number_outputs; i++) {
+        const double* __restrict__ o = outputs[i];
+        double* __restrict__ d = errors[i];
+        for (int32_t j = 0; j < length; j++) {
+            d[j] = exp(o[j] - m[j]);
+            s[j] += d[j];
+        }
+    }
+
+    for (int32_t j = 0; j < length; j++) {
+        r[j] = 1.0 / s[j];
+        s[j] = log(s[j]);
+    }
+
+    double cross_entropy_sum = 0.0;
+    for (int32_t i = 0; i < number_outputs; i++) {
+        const double* __restrict__ o = outputs[i];
+        const double* __restrict__ e = expected[i];
+        double* __restrict__ d = errors[i];
+        for (int32_t j = 0; j < length; j++) {
+            double log_softmax = o[j] - m[j] - s[j];
+            d[j] = (d[j] * r[j]) - e[j];
+            cross_entropy_sum -= e[j] * log_softmax;
+        }
+    }
+
+    return cross_entropy_sum;
+}
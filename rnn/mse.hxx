@@ -12,4 +12,22 @@ void get_mse(RNN* genome, const vector<vector<double> >& expected, double& mse,
 void get_mae(const vector<double>& output_values, const vector<double>& expected, double& mae, vector<double>& deltas);
 void get_mae(RNN* genome, const vector<vector<double> >& expected, double& mae, vector<vector<double> >& deltas);
 
+/**
+ * Loss kernels over the length time steps of an output, which return the summed loss and set the
+ * derivative of the loss at each time step in errors. The outputs, expected values and errors are
+ * contiguous and do not overlap so each is a single pass without branches which can be vectorized.
+ */
+double get_squared_error(const double* outputs, const double* expected, double* errors, int32_t length);
+double get_absolute_error(const double* outputs, const double* expected, double* errors, int32_t length);
+
+/**
+ * The summed cross entropy of the softmax over all the outputs at each time step, where outputs[i],
+ * expected[i] and errors[i] are the length time steps of output i. The softmax is calculated with the
+ * log-sum-exp of each time step so there is one exp per value.
+ */
+double get_softmax_cross_entropy(
+    const vector<const double*>& outputs, const vector<const double*>& expected, const vector<double*>& errors,
+    int32_t length
+);
+
 #endif
@@ -146,6 +146,12 @@ void MULTIPLY_Node::reset(int32_t _series_length) {
     d_bias = 0.0;
 }
 
+void MULTIPLY_Node::shift_time(int32_t offset) {
+    RNN_Node_Interface::shift_time(offset);
+    // recurrent edges may have already fired inputs into later time steps
+    shift_time_values(ordered_input, offset, vector<double>());
+}
+
 void MULTIPLY_Node::get_gradients(vector<double>& gradients) {
     gradients.assign(1, d_bias);
 }
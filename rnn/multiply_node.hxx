@@ -38,6 +38,7 @@ class MULTIPLY_Node : public RNN_Node_Interface {
     void set_weights(int32_t& offset, const vector<double>& parameters);
 
     void reset(int32_t _series_length);
+    void shift_time(int32_t offset);
 
     void get_gradients(vector<double>& gradients);
 
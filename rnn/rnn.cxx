@@ -1,4 +1,5 @@
 #include <algorithm>
+using std::max;
 using std::sort;
 using std::upper_bound;
 
@@ -196,6 +197,9 @@ RNN::RNN(
 
     fix_parameter_orders(input_parameter_names, output_parameter_names);
     validate_parameters(input_parameter_names, output_parameter_names);
+
+    series_length = 0;
+    stream_time = -1;
 }
 
 RNN::RNN(
@@ -228,6 +232,9 @@ RNN::RNN(
     Log::trace(
         "got RNN with %d nodes, %d edges, %d recurrent edges\n", nodes.size(), edges.size(), recurrent_edges.size()
     );
+
+    series_length = 0;
+    stream_time = -1;
 }
 
 RNN::~RNN() {
@@ -348,15 +355,15 @@ int32_t RNN::get_number_weights() {
     return number_weights;
 }
 
-void RNN::forward_pass(
-    const vector<vector<double> >& series_data, bool using_dropout, bool training, double dropout_probability
-) {
+template <class Series>
+void RNN::forward_pass(const Series& series_data, bool using_dropout, bool training, double dropout_probability) {
     series_length = series_data[0].size();
+    stream_time = -1;
 
-    if (input_nodes.size() != series_data.size()) {
+    if ((int32_t) input_nodes.size() != (int32_t) series_data.size()) {
         Log::fatal(
-            "ERROR: number of input nodes (%d) != number of time series data input fields (%d)\n", input_nodes.size(),
-            series_data.size()
+            "ERROR: number of input nodes (%d) != number of time series data input fields (%d)\n",
+            (int32_t) input_nodes.size(), (int32_t) series_data.size()
         );
         for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
             Log::fatal(
@@ -420,6 +427,90 @@ void RNN::forward_pass(
     }
 }
 
+int32_t RNN::get_maximum_recurrent_depth() const {
+    int32_t maximum_recurrent_depth = 0;
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        maximum_recurrent_depth = max(maximum_recurrent_depth, recurrent_edges[i]->get_recurrent_depth());
+    }
+    return maximum_recurrent_depth;
+}
+
+void RNN::begin_stream() {
+    // a step needs the previous time step (for the node's memory) and the time steps up to the
+    // maximum recurrent depth after it (for the recurrent edges' outputs), twice that is kept so
+    // the state only needs to be shifted back every few steps
+    series_length = 2 * (get_maximum_recurrent_depth() + 2);
+    stream_time = 0;
+
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        nodes[i]->reset(series_length);
+    }
+
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        edges[i]->reset(series_length);
+    }
+
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        recurrent_edges[i]->reset(series_length);
+    }
+
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        if (recurrent_edges[i]->is_reachable()) {
+            recurrent_edges[i]->first_propagate_forward();
+        }
+    }
+}
+
+void RNN::step(const vector<double>& inputs, vector<double>& outputs) {
+    if (stream_time < 0) {
+        Log::fatal("ERROR: step called on an rnn without begin_stream being called first\n");
+        exit(1);
+    }
+
+    if (inputs.size() != input_nodes.size()) {
+        Log::fatal(
+            "ERROR: number of input nodes (%d) != number of stream inputs (%d)\n", input_nodes.size(), inputs.size()
+        );
+        exit(1);
+    }
+
+    if (stream_time > series_length / 2) {
+        // keep the previous time step and anything the recurrent edges have already fired forward,
+        // which is at most the maximum recurrent depth past it
+        int32_t offset = stream_time - 1;
+        for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+            nodes[i]->shift_time(offset);
+        }
+        stream_time -= offset;
+    }
+
+    for (int32_t i = 0; i < (int32_t) input_nodes.size(); i++) {
+        if (input_nodes[i]->is_reachable()) {
+            input_nodes[i]->input_fired(stream_time, inputs[i]);
+        }
+    }
+
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        if (edges[i]->is_reachable()) {
+            edges[i]->propagate_forward(stream_time);
+        }
+    }
+
+    // the series_length always leaves room for these to fire into later time steps
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        if (recurrent_edges[i]->is_reachable()) {
+            recurrent_edges[i]->propagate_forward(stream_time);
+        }
+    }
+
+    outputs.resize(output_nodes.size());
+    for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
+        outputs[i] = output_nodes[i]->output_values[stream_time];
+    }
+
+    stream_time++;
+}
+
 void RNN::backward_pass(double error, bool using_dropout, bool training, double dropout_probability) {
     // do a propagate forward for time == (series_length - 1) so that the
     //  output fired count on each node will be correct for the first pass
@@ -457,113 +548,82 @@ void RNN::backward_pass(double error, bool using_dropout, bool training, double
     }
 }
 
-double RNN::calculate_error_softmax(const vector<vector<double> >& expected_outputs) {
-    double cross_entropy_sum = 0.0;
-    double error;
-    double softmax = 0.0;
+template <class Series>
+double RNN::calculate_error_softmax(const Series& expected_outputs) {
+    int32_t length = expected_outputs[0].size();
 
+    vector<const double*> outputs(output_nodes.size());
+    vector<const double*> expected(output_nodes.size());
+    vector<double*> errors(output_nodes.size());
     for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
-        output_nodes[i]->error_values.resize(expected_outputs[i].size());
-    }
-
-    // for each time step j
-    for (int32_t j = 0; j < (int32_t) expected_outputs[0].size(); j++) {
-        double softmax_sum = 0.0;
-        double cross_entropy = 0.0;
-        // get sum of all the outputs of the timestep j from all output node i
-        for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
-            softmax_sum += exp(output_nodes[i]->output_values[j]);
-        }
-
-        // for each
-
-        for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
-            softmax = exp(output_nodes[i]->output_values[j]) / softmax_sum;
-            error = softmax - expected_outputs[i][j];
-            output_nodes[i]->error_values[j] = error;
-
-            // std::cout<<"softmax ::::: "<<error<<" "<<output_nodes[i]->output_values[j]<<"
-            // "<<expected_outputs[i][j]<<"\n"<<std::endl;
-            cross_entropy = -expected_outputs[i][j] * log(softmax);
-            // if(cross_entropy)std::cout<<"cross_entropy ::::: "<<cross_entropy<<"\n"<<std::endl;
+        output_nodes[i]->error_values.resize(length);
 
-            cross_entropy_sum += cross_entropy;
-        }
+        outputs[i] = output_nodes[i]->output_values.data();
+        expected[i] = expected_outputs[i].data();
+        errors[i] = output_nodes[i]->error_values.data();
     }
 
-    return cross_entropy_sum;
+    return get_softmax_cross_entropy(outputs, expected, errors, length);
 }
 
-double RNN::calculate_error_mse(const vector<vector<double> >& expected_outputs) {
+template <class Series>
+double RNN::calculate_error_mse(const Series& expected_outputs) {
     double mse_sum = 0.0;
-    double mse;
-    double error;
 
     for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
-        output_nodes[i]->error_values.resize(expected_outputs[i].size());
-
-        mse = 0.0;
-        for (int32_t j = 0; j < (int32_t) expected_outputs[i].size(); j++) {
-            error = output_nodes[i]->output_values[j] - expected_outputs[i][j];
-
-            // std::cout<<"why this  ???? mse ::::: "<<error<<" "<<output_nodes[i]->output_values[j]<<"
-            // "<<expected_outputs[i][j]<<std::endl;
+        int32_t length = expected_outputs[i].size();
+        output_nodes[i]->error_values.resize(length);
 
-            output_nodes[i]->error_values[j] = error;
-            mse += error * error;
-        }
-        mse_sum += mse / expected_outputs[i].size();
+        double mse = get_squared_error(
+            output_nodes[i]->output_values.data(), expected_outputs[i].data(), output_nodes[i]->error_values.data(),
+            length
+        );
+        mse_sum += mse / length;
     }
 
     return mse_sum;
 }
 
-double RNN::calculate_error_mae(const vector<vector<double> >& expected_outputs) {
+template <class Series>
+double RNN::calculate_error_mae(const Series& expected_outputs) {
     double mae_sum = 0.0;
-    double mae;
-    double error;
 
     for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
-        output_nodes[i]->error_values.resize(expected_outputs[i].size());
-
-        mae = 0.0;
-        for (int32_t j = 0; j < (int32_t) expected_outputs[i].size(); j++) {
-            error = fabs(output_nodes[i]->output_values[j] - expected_outputs[i][j]);
+        int32_t length = expected_outputs[i].size();
+        output_nodes[i]->error_values.resize(length);
 
-            mae += error;
-
-            if (error == 0) {
-                error = 0;
-            } else {
-                error = (output_nodes[i]->output_values[j] - expected_outputs[i][j]) / error;
-            }
-            output_nodes[i]->error_values[j] = error;
-        }
-        mae_sum += mae / expected_outputs[i].size();
+        double mae = get_absolute_error(
+            output_nodes[i]->output_values.data(), expected_outputs[i].data(), output_nodes[i]->error_values.data(),
+            length
+        );
+        mae_sum += mae / length;
     }
 
     return mae_sum;
 }
 
+template <class Series>
 double RNN::prediction_softmax(
-    const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-    bool training, double dropout_probability
+    const Series& series_data, const Series& expected_outputs, bool using_dropout, bool training,
+    double dropout_probability
 ) {
     forward_pass(series_data, using_dropout, training, dropout_probability);
     return calculate_error_softmax(expected_outputs);
 }
 
+template <class Series>
 double RNN::prediction_mse(
-    const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-    bool training, double dropout_probability
+    const Series& series_data, const Series& expected_outputs, bool using_dropout, bool training,
+    double dropout_probability
 ) {
     forward_pass(series_data, using_dropout, training, dropout_probability);
     return calculate_error_mse(expected_outputs);
 }
 
+template <class Series>
 double RNN::prediction_mae(
-    const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-    bool training, double dropout_probability
+    const Series& series_data, const Series& expected_outputs, bool using_dropout, bool training,
+    double dropout_probability
 ) {
     forward_pass(series_data, using_dropout, training, dropout_probability);
     return calculate_error_mae(expected_outputs);
@@ -649,10 +709,10 @@ void RNN::write_predictions(
     outfile.close();
 }
 
+template <class Series>
 void RNN::get_analytic_gradient(
-    const vector<double>& test_parameters, const vector<vector<double> >& inputs,
-    const vector<vector<double> >& outputs, double& mse, vector<double>& analytic_gradient, bool using_dropout,
-    bool training, double dropout_probability
+    const vector<double>& test_parameters, const Series& inputs, const Series& outputs, double& mse,
+    vector<double>& analytic_gradient, bool using_dropout, bool training, double dropout_probability
 ) {
     analytic_gradient.assign(test_parameters.size(), 0.0);
 
@@ -731,6 +791,30 @@ void RNN::get_empirical_gradient(
     mse = original_mse;
 }
 
+template void RNN::forward_pass(const vector<vector<double> >&, bool, bool, double);
+template void RNN::forward_pass(const TimeSeriesView&, bool, bool, double);
+template double RNN::calculate_error_softmax(const vector<vector<double> >&);
+template double RNN::calculate_error_softmax(const TimeSeriesView&);
+template double RNN::calculate_error_mse(const vector<vector<double> >&);
+template double RNN::calculate_error_mse(const TimeSeriesView&);
+template double RNN::calculate_error_mae(const vector<vector<double> >&);
+template double RNN::calculate_error_mae(const TimeSeriesView&);
+template double RNN::prediction_softmax(
+    const vector<vector<double> >&, const vector<vector<double> >&, bool, bool, double
+);
+template double RNN::prediction_softmax(const TimeSeriesView&, const TimeSeriesView&, bool, bool, double);
+template double RNN::prediction_mse(const vector<vector<double> >&, const vector<vector<double> >&, bool, bool, double);
+template double RNN::prediction_mse(const TimeSeriesView&, const TimeSeriesView&, bool, bool, double);
+template double RNN::prediction_mae(const vector<vector<double> >&, const vector<vector<double> >&, bool, bool, double);
+template double RNN::prediction_mae(const TimeSeriesView&, const TimeSeriesView&, bool, bool, double);
+template void RNN::get_analytic_gradient(
+    const vector<double>&, const vector<vector<double> >&, const vector<vector<double> >&, double&, vector<double>&,
+    bool, bool, double
+);
+template void RNN::get_analytic_gradient(
+    const vector<double>&, const TimeSeriesView&, const TimeSeriesView&, double&, vector<double>&, bool, bool, double
+);
+
 void RNN::initialize_randomly() {
     int32_t number_of_weights = get_number_weights();
     vector<double> parameters(number_of_weights, 0.0);
@@ -17,6 +17,10 @@ class RNN {
    private:
     int32_t series_length;
 
+    // the time step of the next input in a stream (within the series_length time steps of
+    // state which are kept), or -1 if a stream has not been started
+    int32_t stream_time;
+
     vector<RNN_Node_Interface*> input_nodes;
     vector<RNN_Node_Interface*> output_nodes;
 
@@ -42,26 +46,42 @@ class RNN {
     RNN_Node_Interface* get_node(int32_t i);
     RNN_Edge* get_edge(int32_t i);
 
-    void forward_pass(
-        const vector<vector<double> >& series_data, bool using_dropout, bool training, double dropout_probability
-    );
+    template <class Series>
+    void forward_pass(const Series& series_data, bool using_dropout, bool training, double dropout_probability);
     void backward_pass(double error, bool using_dropout, bool training, double dropout_probability);
 
-    double calculate_error_softmax(const vector<vector<double> >& expected_outputs);
-    double calculate_error_mse(const vector<vector<double> >& expected_outputs);
-    double calculate_error_mae(const vector<vector<double> >& expected_outputs);
-
+    int32_t get_maximum_recurrent_depth() const;
+
+    /**
+     * Starts a stream of inputs which are given to the rnn one time step at a time with step.
+     * The outputs of each step are the same as the outputs of a forward pass over all the inputs
+     * so far, but only enough time steps of state for the recurrent edges are kept so each step
+     * takes constant time. A forward pass ends the stream.
+     */
+    void begin_stream();
+    void step(const vector<double>& inputs, vector<double>& outputs);
+
+    template <class Series>
+    double calculate_error_softmax(const Series& expected_outputs);
+    template <class Series>
+    double calculate_error_mse(const Series& expected_outputs);
+    template <class Series>
+    double calculate_error_mae(const Series& expected_outputs);
+
+    template <class Series>
     double prediction_softmax(
-        const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-        bool training, double dropout_probability
+        const Series& series_data, const Series& expected_outputs, bool using_dropout, bool training,
+        double dropout_probability
     );
+    template <class Series>
     double prediction_mse(
-        const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-        bool training, double dropout_probability
+        const Series& series_data, const Series& expected_outputs, bool using_dropout, bool training,
+        double dropout_probability
     );
+    template <class Series>
     double prediction_mae(
-        const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-        bool training, double dropout_probability
+        const Series& series_data, const Series& expected_outputs, bool using_dropout, bool training,
+        double dropout_probability
     );
 
     vector<double> get_predictions(
@@ -82,10 +102,10 @@ class RNN {
 
     int32_t get_number_weights();
 
+    template <class Series>
     void get_analytic_gradient(
-        const vector<double>& test_parameters, const vector<vector<double> >& inputs,
-        const vector<vector<double> >& outputs, double& mse, vector<double>& analytic_gradient, bool using_dropout,
-        bool training, double dropout_probability
+        const vector<double>& test_parameters, const Series& inputs, const Series& outputs, double& mse,
+        vector<double>& analytic_gradient, bool using_dropout, bool training, double dropout_probability
     );
     void get_empirical_gradient(
         const vector<double>& test_parameters, const vector<vector<double> >& inputs,
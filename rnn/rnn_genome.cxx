@@ -16,6 +16,7 @@ using std::setw;
 #include <ios>
 using std::hex;
 using std::ios;
+using std::streampos;
 
 #include <iostream>
 using std::cout;
@@ -101,6 +102,9 @@ RNN_Genome::RNN_Genome(
     best_validation_mse = EXAMM_MAX_DOUBLE;
     best_validation_mae = EXAMM_MAX_DOUBLE;
 
+    best_optimizer_epoch = 0;
+    initial_optimizer_epoch = 0;
+
     nodes = _nodes;
     edges = _edges;
     recurrent_edges = _recurrent_edges;
@@ -207,6 +211,13 @@ RNN_Genome* RNN_Genome::copy() {
     other->best_validation_mae = best_validation_mae;
     other->best_parameters = best_parameters;
 
+    other->best_velocity = best_velocity;
+    other->best_prev_velocity = best_prev_velocity;
+    other->best_optimizer_epoch = best_optimizer_epoch;
+    other->initial_velocity = initial_velocity;
+    other->initial_prev_velocity = initial_prev_velocity;
+    other->initial_optimizer_epoch = initial_optimizer_epoch;
+
     other->input_parameter_names = input_parameter_names;
     other->output_parameter_names = output_parameter_names;
 
@@ -939,6 +950,85 @@ void RNN_Genome::set_initial_parameters(vector<double> parameters) {
     initial_parameters = parameters;
 }
 
+void RNN_Genome::get_weight_keys(vector<WeightKey>& keys) const {
+    keys.clear();
+
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        int32_t number_weights = nodes[i]->get_number_weights();
+        for (int32_t j = 0; j < number_weights; j++) {
+            keys.push_back(WeightKey(nodes[i]->get_innovation_number(), j));
+        }
+    }
+
+    // edges and recurrent edges get their innovation numbers from the same count
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        keys.push_back(WeightKey(edges[i]->get_innovation_number(), -1));
+    }
+
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        keys.push_back(WeightKey(recurrent_edges[i]->get_innovation_number(), -1));
+    }
+}
+
+void RNN_Genome::get_best_optimizer_state(map<WeightKey, WeightOptimizerState>& state) const {
+    vector<WeightKey> keys;
+    get_weight_keys(keys);
+
+    if (best_velocity.size() != keys.size() || best_prev_velocity.size() != keys.size()) {
+        return;
+    }
+
+    for (int32_t i = 0; i < (int32_t) keys.size(); i++) {
+        if (state.find(keys[i]) == state.end()) {
+            state[keys[i]] = WeightOptimizerState(best_velocity[i], best_prev_velocity[i]);
+        }
+    }
+}
+
+int32_t RNN_Genome::get_best_optimizer_epoch() const {
+    return best_optimizer_epoch;
+}
+
+void RNN_Genome::set_initial_optimizer_state(const map<WeightKey, WeightOptimizerState>& state, int32_t epoch) {
+    initial_velocity.clear();
+    initial_prev_velocity.clear();
+    initial_optimizer_epoch = 0;
+
+    if (state.size() == 0) {
+        return;
+    }
+
+    vector<WeightKey> keys;
+    get_weight_keys(keys);
+
+    int32_t inherited = 0;
+    initial_velocity.assign(keys.size(), 0.0);
+    initial_prev_velocity.assign(keys.size(), 0.0);
+    for (int32_t i = 0; i < (int32_t) keys.size(); i++) {
+        auto found = state.find(keys[i]);
+        if (found != state.end()) {
+            initial_velocity[i] = found->second.first;
+            initial_prev_velocity[i] = found->second.second;
+            inherited++;
+        }
+    }
+    initial_optimizer_epoch = epoch;
+
+    Log::debug(
+        "inherited the optimizer state of %d of %d weights at epoch %d\n", inherited, (int32_t) keys.size(), epoch
+    );
+}
+
+void RNN_Genome::clear_optimizer_state() {
+    best_velocity.clear();
+    best_prev_velocity.clear();
+    best_optimizer_epoch = 0;
+
+    initial_velocity.clear();
+    initial_prev_velocity.clear();
+    initial_optimizer_epoch = 0;
+}
+
 int32_t RNN_Genome::get_generation_id() const {
     return generation_id;
 }
@@ -1064,6 +1154,14 @@ void RNN_Genome::backpropagate(
     vector<double> parameters = initial_parameters;
     vector<double> velocity(n_parameters, 0.0);
     vector<double> prev_velocity(n_parameters, 0.0);
+    int32_t optimizer_epoch = 0;
+
+    // continue from the optimizer state inherited from the parent(s), if there is any
+    if ((int32_t) initial_velocity.size() == n_parameters && (int32_t) initial_prev_velocity.size() == n_parameters) {
+        velocity = initial_velocity;
+        prev_velocity = initial_prev_velocity;
+        optimizer_epoch = initial_optimizer_epoch;
+    }
     vector<double> analytic_gradient;
     vector<double> prev_gradient(n_parameters, 0.0);
 
@@ -1076,6 +1174,9 @@ void RNN_Genome::backpropagate(
     best_validation_mse = validation_mse;
     best_validation_mae = get_mae(parameters, validation_inputs, validation_outputs);
     best_parameters = parameters;
+    best_velocity = velocity;
+    best_prev_velocity = prev_velocity;
+    best_optimizer_epoch = optimizer_epoch;
 
     norm = weight_update_method->get_norm(analytic_gradient);
 
@@ -1090,23 +1191,18 @@ void RNN_Genome::backpropagate(
             best_validation_mse = validation_mse;
             best_validation_mae = get_mae(parameters, validation_inputs, validation_outputs);
             best_parameters = parameters;
-        }
-        norm = weight_update_method->get_norm(analytic_gradient);
+            best_velocity = velocity;
+            best_prev_velocity = prev_velocity;
+            best_optimizer_epoch = optimizer_epoch + iteration;
+        }
+        // the SHO hyperparameters are only used by the weight update if SHO is enabled
+        norm = weight_update_method->normalize_and_update_weights(
+            parameters, velocity, prev_velocity, analytic_gradient, optimizer_epoch + iteration, learning_rate,
+            epsilon, beta1, beta2
+        );
         if (output_log != NULL) {
             (*output_log) << iteration << " " << mse << " " << validation_mse << " " << best_validation_mse << endl;
         }
-        weight_update_method->norm_gradients(analytic_gradient, norm);
-        Log::debug("AT: SHO is used = %s\n",WeightUpdate::use_SHO?"true":"false");
-        if (WeightUpdate::use_SHO) {
-            // Adding SHO tuned hyperparameters to the backpropagate weight update process.
-            Log::debug("AT: backpropagate LR = %lg\n",learning_rate);
-            Log::debug("AT: backpropagate epsilon = %lg\n",epsilon);
-            Log::debug("AT: backpropagate beta1 = %lg\n",beta1);
-            Log::debug("AT: backpropagate beta2 = %lg\n",beta2);
-            weight_update_method->update_weights(parameters, velocity, prev_velocity, analytic_gradient, iteration, learning_rate, epsilon, beta1, beta2);
-        } else {
-            weight_update_method->update_weights(parameters, velocity, prev_velocity, analytic_gradient, iteration);
-        }
         Log::info(
             "iteration %10d, mse: %10lf, v_mse: %10lf, bv_mse: %10lf, norm: %lf", iteration, mse, validation_mse,
             best_validation_mse, norm
@@ -1123,10 +1219,10 @@ void RNN_Genome::backpropagate(
     this->set_weights(best_parameters);
 }
 
+template <class SeriesSet>
 void RNN_Genome::backpropagate_stochastic(
-    const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
-    const vector<vector<vector<double> > >& validation_inputs,
-    const vector<vector<vector<double> > >& validation_outputs, WeightUpdate* weight_update_method
+    const SeriesSet& inputs, const SeriesSet& outputs, const SeriesSet& validation_inputs,
+    const SeriesSet& validation_outputs, WeightUpdate* weight_update_method
 ) {
     int32_t n_parameters = this->get_number_weights();
     int32_t n_series = (int32_t) inputs.size();
@@ -1134,6 +1230,14 @@ void RNN_Genome::backpropagate_stochastic(
     vector<double> parameters = initial_parameters;
     vector<double> velocity(n_parameters, 0.0);
     vector<double> prev_velocity(n_parameters, 0.0);
+    int32_t optimizer_epoch = 0;
+
+    // continue from the optimizer state inherited from the parent(s), if there is any
+    if ((int32_t) initial_velocity.size() == n_parameters && (int32_t) initial_prev_velocity.size() == n_parameters) {
+        velocity = initial_velocity;
+        prev_velocity = initial_prev_velocity;
+        optimizer_epoch = initial_optimizer_epoch;
+    }
     vector<double> analytic_gradient;
     vector<double> prev_gradient(n_parameters, 0.0);
 
@@ -1164,6 +1268,9 @@ void RNN_Genome::backpropagate_stochastic(
     best_validation_mse = validation_mse;
     best_validation_mae = get_mae(parameters, validation_inputs, validation_outputs);
     best_parameters = parameters;
+    best_velocity = velocity;
+    best_prev_velocity = prev_velocity;
+    best_optimizer_epoch = optimizer_epoch;
 
     Log::trace("got initial mses.\n");
     Log::info("initial validation_mse: %lf, best validation mse: %lf\n", validation_mse, best_validation_mse);
@@ -1189,7 +1296,11 @@ void RNN_Genome::backpropagate_stochastic(
                 true, dropout_probability
             );
 
-            norm = weight_update_method->get_norm(analytic_gradient);
+            // the SHO hyperparameters are only used by the weight update if SHO is enabled
+            norm = weight_update_method->normalize_and_update_weights(
+                parameters, velocity, prev_velocity, analytic_gradient, optimizer_epoch + iteration, learning_rate,
+                epsilon, beta1, beta2
+            );
 
             if (isnan(norm) || isinf(norm)) {
                 // This genome is getting NANs for gradients so it is a
@@ -1198,24 +1309,13 @@ void RNN_Genome::backpropagate_stochastic(
                 // method to handle it.
                 delete rnn;
                 best_parameters = parameters;
+                clear_optimizer_state();
                 this->best_validation_mse = NAN;
                 this->best_validation_mae = NAN;
                 return;
             }
 
             avg_norm += norm;
-            weight_update_method->norm_gradients(analytic_gradient, norm);
-            Log::debug("AT: SHO is used = %s\n",WeightUpdate::use_SHO?"true":"false");
-            if (WeightUpdate::use_SHO) {
-                // Adding SHO tuned hyperparameters to the stochastic backpropagate weight update process.
-                Log::debug("AT: backpropagate_stochastic LR = %lg\n",learning_rate);
-                Log::debug("AT: backpropagate_stochastic epsilon = %lg\n",epsilon);
-                Log::debug("AT: backpropagate_stochastic beta1 = %lg\n",beta1);
-                Log::debug("AT: backpropagate_stochastic beta2 = %lg\n",beta2);
-                weight_update_method->update_weights(parameters, velocity, prev_velocity, analytic_gradient, iteration, learning_rate, epsilon, beta1, beta2);
-            } else {
-                weight_update_method->update_weights(parameters, velocity, prev_velocity, analytic_gradient, iteration);
-            }
         }
         this->set_weights(parameters);
         double training_mse = get_mse(parameters, inputs, outputs);
@@ -1225,6 +1325,9 @@ void RNN_Genome::backpropagate_stochastic(
             best_validation_mse = validation_mse;
             best_validation_mae = get_mae(parameters, validation_inputs, validation_outputs);
             best_parameters = parameters;
+            best_velocity = velocity;
+            best_prev_velocity = prev_velocity;
+            best_optimizer_epoch = optimizer_epoch + iteration + 1;
         }
         if (output_log != NULL) {
             std::chrono::time_point<std::chrono::system_clock> currentClock = std::chrono::system_clock::now();
@@ -1282,10 +1385,8 @@ void RNN_Genome::update_log_file(
                   << best_validation_mse << "," << best_validation_mae << "," << avg_norm << endl;
 }
 
-double RNN_Genome::get_softmax(
-    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-    const vector<vector<vector<double> > >& outputs
-) {
+template <class SeriesSet>
+double RNN_Genome::get_softmax(const vector<double>& parameters, const SeriesSet& inputs, const SeriesSet& outputs) {
     RNN* rnn = get_rnn();
     rnn->set_weights(parameters);
 
@@ -1307,10 +1408,8 @@ double RNN_Genome::get_softmax(
     return avg_softmax;
 }
 
-double RNN_Genome::get_mse(
-    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-    const vector<vector<vector<double> > >& outputs
-) {
+template <class SeriesSet>
+double RNN_Genome::get_mse(const vector<double>& parameters, const SeriesSet& inputs, const SeriesSet& outputs) {
     RNN* rnn = get_rnn();
     rnn->set_weights(parameters);
 
@@ -1332,10 +1431,8 @@ double RNN_Genome::get_mse(
     return avg_mse;
 }
 
-double RNN_Genome::get_mae(
-    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-    const vector<vector<vector<double> > >& outputs
-) {
+template <class SeriesSet>
+double RNN_Genome::get_mae(const vector<double>& parameters, const SeriesSet& inputs, const SeriesSet& outputs) {
     RNN* rnn = get_rnn();
     rnn->set_weights(parameters);
 
@@ -1357,6 +1454,27 @@ double RNN_Genome::get_mae(
     return avg_mae;
 }
 
+template void RNN_Genome::backpropagate_stochastic(
+    const vector<vector<vector<double> > >&, const vector<vector<vector<double> > >&,
+    const vector<vector<vector<double> > >&, const vector<vector<vector<double> > >&, WeightUpdate*
+);
+template void RNN_Genome::backpropagate_stochastic(
+    const TimeSeriesWindows&, const TimeSeriesWindows&, const TimeSeriesWindows&, const TimeSeriesWindows&,
+    WeightUpdate*
+);
+template double RNN_Genome::get_softmax(
+    const vector<double>&, const vector<vector<vector<double> > >&, const vector<vector<vector<double> > >&
+);
+template double RNN_Genome::get_softmax(const vector<double>&, const TimeSeriesWindows&, const TimeSeriesWindows&);
+template double RNN_Genome::get_mse(
+    const vector<double>&, const vector<vector<vector<double> > >&, const vector<vector<vector<double> > >&
+);
+template double RNN_Genome::get_mse(const vector<double>&, const TimeSeriesWindows&, const TimeSeriesWindows&);
+template double RNN_Genome::get_mae(
+    const vector<double>&, const vector<vector<vector<double> > >&, const vector<vector<vector<double> > >&
+);
+template double RNN_Genome::get_mae(const vector<double>&, const TimeSeriesWindows&, const TimeSeriesWindows&);
+
 vector<vector<double> > RNN_Genome::get_predictions(
     const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
     const vector<vector<vector<double> > >& outputs
@@ -3217,7 +3335,7 @@ void RNN_Genome::write_graphviz(string filename) {
 void read_map(istream& in, map<string, double>& m) {
     int32_t map_size;
     in >> map_size;
-    for (int32_t i = 0; i < map_size; i++) {
+    for (int32_t i = 0; i < map_size && in; i++) {
         string key;
         in >> key;
         double value;
@@ -3239,7 +3357,7 @@ void write_map(ostream& out, map<string, double>& m) {
 void read_map(istream& in, map<string, int32_t>& m) {
     int32_t map_size;
     in >> map_size;
-    for (int32_t i = 0; i < map_size; i++) {
+    for (int32_t i = 0; i < map_size && in; i++) {
         string key;
         in >> key;
         int32_t value;
@@ -3266,11 +3384,37 @@ void write_binary_string(ostream& out, string s, string name) {
     }
 }
 
+/**
+ * Checks a count read from a genome stream is not negative or more than the rest of the stream
+ * could hold, so a malformed genome can't cause a huge allocation.
+ */
+static bool valid_count(istream& in, int32_t count, size_t element_size) {
+    if (!in || count < 0) {
+        return false;
+    }
+
+    streampos position = in.tellg();
+    if (position < 0) {
+        return true;  // the stream can't be seeked so its size is unknown
+    }
+    in.seekg(0, ios::end);
+    streampos end = in.tellg();
+    in.seekg(position);
+
+    return (size_t) count * element_size <= (size_t) (end - position);
+}
+
 void read_binary_string(istream& in, string& s, string name) {
     int32_t n;
     in.read((char*) &n, sizeof(int32_t));
 
     Log::debug("reading %d %s characters.\n", n, name.c_str());
+    if (!valid_count(in, n, sizeof(char))) {
+        in.setstate(ios::failbit);
+        s.assign("");
+        return;
+    }
+
     if (n > 0) {
         char* s_v = new char[n];
         in.read((char*) s_v, sizeof(char) * n);
@@ -3283,6 +3427,32 @@ void read_binary_string(istream& in, string& s, string name) {
     Log::debug("read %d %s characters '%s'\n", n, name.c_str(), s.c_str());
 }
 
+void write_binary_vector(ostream& out, const vector<double>& v, string name) {
+    int32_t n = (int32_t) v.size();
+    Log::debug("writing %d %s values.\n", n, name.c_str());
+    out.write((char*) &n, sizeof(int32_t));
+    if (n > 0) {
+        out.write((char*) &v[0], sizeof(double) * v.size());
+    }
+}
+
+void read_binary_vector(istream& in, vector<double>& v, string name) {
+    int32_t n;
+    in.read((char*) &n, sizeof(int32_t));
+
+    Log::debug("reading %d %s values.\n", n, name.c_str());
+    if (!valid_count(in, n, sizeof(double))) {
+        in.setstate(ios::failbit);
+        v.clear();
+        return;
+    }
+
+    v.assign(n, 0.0);
+    if (n > 0) {
+        in.read((char*) &v[0], sizeof(double) * n);
+    }
+}
+
 RNN_Genome::RNN_Genome(string binary_filename) {
     ifstream bin_infile(binary_filename, ios::in | ios::binary);
 
@@ -3295,6 +3465,26 @@ RNN_Genome::RNN_Genome(string binary_filename) {
     bin_infile.close();
 }
 
+RNN_Genome::RNN_Genome() {
+}
+
+RNN_Genome* RNN_Genome::read_from_file(string binary_filename, string& error) {
+    ifstream bin_infile(binary_filename, ios::in | ios::binary);
+
+    if (!bin_infile.good()) {
+        error = "could not open genome file '" + binary_filename + "' for reading";
+        return NULL;
+    }
+
+    RNN_Genome* genome = new RNN_Genome();
+    if (!genome->read_from_stream(bin_infile, error)) {
+        error = "could not read genome file '" + binary_filename + "': " + error;
+        delete genome;
+        return NULL;
+    }
+    return genome;
+}
+
 RNN_Genome::RNN_Genome(char* array, int32_t length) {
     read_from_array(array, length);
 }
@@ -3313,7 +3503,7 @@ void RNN_Genome::read_from_array(char* array, int32_t length) {
     read_from_stream(iss);
 }
 
-RNN_Node_Interface* RNN_Genome::read_node_from_stream(istream& bin_istream) {
+RNN_Node_Interface* RNN_Genome::read_node_from_stream(istream& bin_istream, string& error) {
     int32_t innovation_number, layer_type, node_type;
     double depth;
     bool enabled;
@@ -3326,6 +3516,10 @@ RNN_Node_Interface* RNN_Genome::read_node_from_stream(istream& bin_istream) {
 
     string parameter_name;
     read_binary_string(bin_istream, parameter_name, "parameter_name");
+    if (!bin_istream) {
+        error = "the file ended in the middle of a node";
+        return NULL;
+    }
     Log::debug(
         "NODE: %d %d %d %lf %d '%s'\n", innovation_number, layer_type, node_type, depth, enabled, parameter_name.c_str()
     );
@@ -3360,12 +3554,22 @@ RNN_Node_Interface* RNN_Genome::read_node_from_stream(istream& bin_istream) {
 
         int32_t counter;
         bin_istream.read((char*) &counter, sizeof(int32_t));
+        if (!valid_count(bin_istream, n_nodes, sizeof(double))) {
+            error = "DNAS node " + to_string(innovation_number) + " has an invalid number of nodes";
+            return NULL;
+        }
         vector<double> pi(n_nodes, 0.0);
-        bin_istream.read((char*) &pi[0], sizeof(double) * n_nodes);
+        bin_istream.read((char*) pi.data(), sizeof(double) * n_nodes);
 
         vector<RNN_Node_Interface*> nodes(n_nodes, nullptr);
         for (int32_t i = 0; i < n_nodes; i++) {
-            nodes[i] = RNN_Genome::read_node_from_stream(bin_istream);
+            nodes[i] = RNN_Genome::read_node_from_stream(bin_istream, error);
+            if (nodes[i] == NULL) {
+                for (int32_t j = 0; j < i; j++) {
+                    delete nodes[j];
+                }
+                return NULL;
+            }
         }
 
         DNASNode* dnas_node = new DNASNode(move(nodes), innovation_number, layer_type, depth, counter);
@@ -3400,14 +3604,37 @@ RNN_Node_Interface* RNN_Genome::read_node_from_stream(istream& bin_istream) {
     } else if (node_type == SUM_NODE_GP) {
         node = new SUM_Node_GP(innovation_number, layer_type, depth);
     } else {
-        Log::fatal("Error reading node from stream, unknown node_type: %d\n", node_type);
-        exit(1);
+        error = "unknown node_type: " + to_string(node_type);
+        return NULL;
     }
 
     node->enabled = enabled;
     return node;
 }
+
+/**
+ * Edges are created from the innovation numbers of their nodes, which must match exactly one of
+ * the genome's nodes.
+ */
+static bool has_node(const vector<RNN_Node_Interface*>& nodes, int32_t innovation_number) {
+    int32_t count = 0;
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        if (nodes[i]->innovation_number == innovation_number) {
+            count++;
+        }
+    }
+    return count == 1;
+}
+
 void RNN_Genome::read_from_stream(istream& bin_istream) {
+    string error;
+    if (!read_from_stream(bin_istream, error)) {
+        Log::fatal("ERROR: could not read genome from stream: %s\n", error.c_str());
+        exit(1);
+    }
+}
+
+bool RNN_Genome::read_from_stream(istream& bin_istream, string& error) {
     Log::debug("READING GENOME FROM STREAM\n");
 
     bin_istream.read((char*) &generation_id, sizeof(int32_t));
@@ -3434,6 +3661,17 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
     bin_istream.read((char*) &weight_inheritance, sizeof(int32_t));
     bin_istream.read((char*) &mutated_component_weight, sizeof(int32_t));
 
+    if (!bin_istream) {
+        error = "the file ended before the genome's weight rules";
+        return false;
+    }
+    if (weight_initialize < NONE || weight_initialize >= NUM_WEIGHT_TYPES || weight_inheritance < NONE
+        || weight_inheritance >= NUM_WEIGHT_TYPES || mutated_component_weight < NONE
+        || mutated_component_weight >= NUM_WEIGHT_TYPES) {
+        error = "the genome has an unknown weight initialization, inheritance or mutated component weight method";
+        return false;
+    }
+
     weight_rules = new WeightRules();
     weight_rules->set_weight_initialize_method(weight_initialize);
     weight_rules->set_weight_inheritance_method(weight_inheritance);
@@ -3473,9 +3711,18 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
     bin_istream.read((char*) &best_validation_mse, sizeof(double));
     bin_istream.read((char*) &best_validation_mae, sizeof(double));
 
+    if (!bin_istream) {
+        error = "the file ended before the genome's parameters";
+        return false;
+    }
+
     int32_t n_initial_parameters;
     bin_istream.read((char*) &n_initial_parameters, sizeof(int32_t));
     Log::debug("reading %d initial parameters.\n", n_initial_parameters);
+    if (!valid_count(bin_istream, n_initial_parameters, sizeof(double))) {
+        error = "invalid number of initial parameters: " + to_string(n_initial_parameters);
+        return false;
+    }
     double* initial_parameters_v = new double[n_initial_parameters];
     bin_istream.read((char*) initial_parameters_v, sizeof(double) * n_initial_parameters);
     initial_parameters.assign(initial_parameters_v, initial_parameters_v + n_initial_parameters);
@@ -3484,6 +3731,10 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
     int32_t n_best_parameters;
     bin_istream.read((char*) &n_best_parameters, sizeof(int32_t));
     Log::debug("reading %d best parameters.\n", n_best_parameters);
+    if (!valid_count(bin_istream, n_best_parameters, sizeof(double))) {
+        error = "invalid number of best parameters: " + to_string(n_best_parameters);
+        return false;
+    }
     double* best_parameters_v = new double[n_best_parameters];
     bin_istream.read((char*) best_parameters_v, sizeof(double) * n_best_parameters);
     best_parameters.assign(best_parameters_v, best_parameters_v + n_best_parameters);
@@ -3493,6 +3744,10 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
     int32_t n_input_parameter_names;
     bin_istream.read((char*) &n_input_parameter_names, sizeof(int32_t));
     Log::debug("reading %d input parameter names.\n", n_input_parameter_names);
+    if (!valid_count(bin_istream, n_input_parameter_names, sizeof(int32_t))) {
+        error = "invalid number of input parameter names: " + to_string(n_input_parameter_names);
+        return false;
+    }
     for (int32_t i = 0; i < n_input_parameter_names; i++) {
         string input_parameter_name;
         read_binary_string(bin_istream, input_parameter_name, "input_parameter_names[" + std::to_string(i) + "]");
@@ -3503,24 +3758,45 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
     int32_t n_output_parameter_names;
     bin_istream.read((char*) &n_output_parameter_names, sizeof(int32_t));
     Log::debug("reading %d output parameter names.\n", n_output_parameter_names);
+    if (!valid_count(bin_istream, n_output_parameter_names, sizeof(int32_t))) {
+        error = "invalid number of output parameter names: " + to_string(n_output_parameter_names);
+        return false;
+    }
     for (int32_t i = 0; i < n_output_parameter_names; i++) {
         string output_parameter_name;
         read_binary_string(bin_istream, output_parameter_name, "output_parameter_names[" + std::to_string(i) + "]");
         output_parameter_names.push_back(output_parameter_name);
     }
 
+    if (!bin_istream) {
+        error = "the file ended in the genome's parameter names";
+        return false;
+    }
+
     int32_t n_nodes;
     bin_istream.read((char*) &n_nodes, sizeof(int32_t));
     Log::debug("reading %d nodes.\n", n_nodes);
+    if (!valid_count(bin_istream, n_nodes, 3 * sizeof(int32_t) + sizeof(double) + sizeof(bool) + sizeof(int32_t))) {
+        error = "invalid number of nodes: " + to_string(n_nodes);
+        return false;
+    }
 
     nodes.clear();
     for (int32_t i = 0; i < n_nodes; i++) {
-        nodes.push_back(RNN_Genome::read_node_from_stream(bin_istream));
+        RNN_Node_Interface* node = RNN_Genome::read_node_from_stream(bin_istream, error);
+        if (node == NULL) {
+            return false;
+        }
+        nodes.push_back(node);
     }
 
     int32_t n_edges;
     bin_istream.read((char*) &n_edges, sizeof(int32_t));
     Log::debug("reading %d edges.\n", n_edges);
+    if (!valid_count(bin_istream, n_edges, 3 * sizeof(int32_t) + sizeof(bool))) {
+        error = "invalid number of edges: " + to_string(n_edges);
+        return false;
+    }
 
     edges.clear();
     for (int32_t i = 0; i < n_edges; i++) {
@@ -3537,6 +3813,14 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
         Log::debug(
             "EDGE: %d %d %d %d\n", innovation_number, input_innovation_number, output_innovation_number, enabled
         );
+        if (!bin_istream) {
+            error = "the file ended in the middle of an edge";
+            return false;
+        }
+        if (!has_node(nodes, input_innovation_number) || !has_node(nodes, output_innovation_number)) {
+            error = "edge " + to_string(innovation_number) + " does not connect two of the genome's nodes";
+            return false;
+        }
 
         RNN_Edge* edge = new RNN_Edge(innovation_number, input_innovation_number, output_innovation_number, nodes);
         // innovation_list.push_back(innovation_number);
@@ -3547,6 +3831,10 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
     int32_t n_recurrent_edges;
     bin_istream.read((char*) &n_recurrent_edges, sizeof(int32_t));
     Log::debug("reading %d recurrent_edges.\n", n_recurrent_edges);
+    if (!valid_count(bin_istream, n_recurrent_edges, 4 * sizeof(int32_t) + sizeof(bool))) {
+        error = "invalid number of recurrent edges: " + to_string(n_recurrent_edges);
+        return false;
+    }
 
     recurrent_edges.clear();
     for (int32_t i = 0; i < n_recurrent_edges; i++) {
@@ -3566,6 +3854,15 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
             "RECURRENT EDGE: %d %d %d %d %d\n", innovation_number, recurrent_depth, input_innovation_number,
             output_innovation_number, enabled
         );
+        if (!bin_istream) {
+            error = "the file ended in the middle of a recurrent edge";
+            return false;
+        }
+        if (recurrent_depth <= 0 || !has_node(nodes, input_innovation_number)
+            || !has_node(nodes, output_innovation_number)) {
+            error = "recurrent edge " + to_string(innovation_number) + " does not have a valid depth and nodes";
+            return false;
+        }
 
         RNN_Recurrent_Edge* recurrent_edge = new RNN_Recurrent_Edge(
             innovation_number, recurrent_depth, input_innovation_number, output_innovation_number, nodes
@@ -3597,7 +3894,56 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
     istringstream normalize_std_devs_iss(normalize_std_devs_str);
     read_map(normalize_std_devs_iss, normalize_std_devs);
 
+    // the optimizer state is last, genomes written before it was added do not have it
+    if (bin_istream.peek() != EOF) {
+        bin_istream.read((char*) &best_optimizer_epoch, sizeof(int32_t));
+        read_binary_vector(bin_istream, best_velocity, "best_velocity");
+        read_binary_vector(bin_istream, best_prev_velocity, "best_prev_velocity");
+
+        bin_istream.read((char*) &initial_optimizer_epoch, sizeof(int32_t));
+        read_binary_vector(bin_istream, initial_velocity, "initial_velocity");
+        read_binary_vector(bin_istream, initial_prev_velocity, "initial_prev_velocity");
+    } else {
+        clear_optimizer_state();
+    }
+
+    if (!bin_istream) {
+        error = "the file ended before the genome's normalization and optimizer state";
+        return false;
+    }
+
     assign_reachability();
+    return true;
+}
+
+bool RNN_Genome::has_parameter_nodes(string& error) const {
+    // the same nodes an rnn takes as its inputs and outputs
+    vector<string> input_node_names;
+    vector<string> output_node_names;
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        if (nodes[i]->layer_type == INPUT_LAYER) {
+            input_node_names.push_back(nodes[i]->parameter_name);
+        } else if (nodes[i]->layer_type == OUTPUT_LAYER) {
+            output_node_names.push_back(nodes[i]->parameter_name);
+        }
+    }
+
+    vector<string> input_names = input_parameter_names;
+    sort(input_node_names.begin(), input_node_names.end());
+    sort(input_names.begin(), input_names.end());
+    if (input_node_names != input_names) {
+        error = "the genome's input nodes do not match its input parameter names";
+        return false;
+    }
+
+    vector<string> output_names = output_parameter_names;
+    sort(output_node_names.begin(), output_node_names.end());
+    sort(output_names.begin(), output_names.end());
+    if (output_node_names != output_names) {
+        error = "the genome's output nodes do not match its output parameter names";
+        return false;
+    }
+    return true;
 }
 
 void RNN_Genome::write_to_array(char** bytes, int32_t& length) {
@@ -3756,6 +4102,14 @@ void RNN_Genome::write_to_stream(ostream& bin_ostream) {
     write_map(normalize_std_devs_oss, normalize_std_devs);
     string normalize_std_devs_str = normalize_std_devs_oss.str();
     write_binary_string(bin_ostream, normalize_std_devs_str, "normalize_std_devs");
+
+    bin_ostream.write((char*) &best_optimizer_epoch, sizeof(int32_t));
+    write_binary_vector(bin_ostream, best_velocity, "best_velocity");
+    write_binary_vector(bin_ostream, best_prev_velocity, "best_prev_velocity");
+
+    bin_ostream.write((char*) &initial_optimizer_epoch, sizeof(int32_t));
+    write_binary_vector(bin_ostream, initial_velocity, "initial_velocity");
+    write_binary_vector(bin_ostream, initial_prev_velocity, "initial_prev_velocity");
 }
 
 void RNN_Genome::update_innovation_counts(int32_t& node_innovation_count, int32_t& edge_innovation_count) {
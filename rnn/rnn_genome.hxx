@@ -16,6 +16,9 @@ using std::mt19937;
 using std::uniform_int_distribution;
 using std::uniform_real_distribution;
 
+#include <utility>
+using std::pair;
+
 #include <vector>
 using std::vector;
 
@@ -36,6 +39,13 @@ extern vector<int32_t> dnas_node_types;
 
 string parse_fitness(double fitness);
 
+// identifies a weight by the innovation number of the node or edge it is in and its index in the
+// node (edges only have one weight, which has index -1)
+typedef pair<int32_t, int32_t> WeightKey;
+
+// the velocity and prev_velocity of the weight update for a weight
+typedef pair<double, double> WeightOptimizerState;
+
 class RNN_Genome {
    private:
     int32_t generation_id;
@@ -67,6 +77,18 @@ class RNN_Genome {
 
     vector<double> best_parameters;
 
+    // the optimizer state (the velocity and prev_velocity of the weight update) when the best
+    // parameters were found, and the number of weight updates it was accumulated over
+    vector<double> best_velocity;
+    vector<double> best_prev_velocity;
+    int32_t best_optimizer_epoch;
+
+    // the optimizer state inherited from the parent(s) which training starts from, if these are
+    // empty training starts with zeroed velocities
+    vector<double> initial_velocity;
+    vector<double> initial_prev_velocity;
+    int32_t initial_optimizer_epoch;
+
     minstd_rand0 generator;
 
     uniform_real_distribution<double> rng;
@@ -88,6 +110,9 @@ class RNN_Genome {
     map<string, double> normalize_avgs;
     map<string, double> normalize_std_devs;
 
+    // only used by read_from_file, which fills in the genome from a stream
+    RNN_Genome();
+
    public:
     void sort_nodes_by_depth();
     void sort_edges_by_depth();
@@ -109,7 +134,7 @@ class RNN_Genome {
     static string print_statistics_header();
     string print_statistics();
 
-    static RNN_Node_Interface* read_node_from_stream(istream& bin_istream);
+    static RNN_Node_Interface* read_node_from_stream(istream& bin_istream, string& error);
 
     void set_parameter_names(
         const vector<string>& _input_parameter_names, const vector<string>& _output_parameter_names
@@ -212,6 +237,27 @@ class RNN_Genome {
     void set_best_parameters(vector<double> parameters);     // INFO: ADDED BY ABDELRAHMAN TO USE FOR TRANSFER LEARNING
     void set_initial_parameters(vector<double> parameters);  // INFO: ADDED BY ABDELRAHMAN TO USE FOR TRANSFER LEARNING
 
+    /**
+     * Gets the key of each of the weights, in the same order as get_weights.
+     */
+    void get_weight_keys(vector<WeightKey>& keys) const;
+
+    /**
+     * Adds the optimizer state of each weight when the best parameters were found to the state map
+     * (weights already in the map are not replaced). Nothing is added if the genome has not been
+     * trained.
+     */
+    void get_best_optimizer_state(map<WeightKey, WeightOptimizerState>& state) const;
+    int32_t get_best_optimizer_epoch() const;
+
+    /**
+     * Sets the optimizer state training starts from, weights which are not in the state map start
+     * with zeroed velocities. The epoch is the number of weight updates the state was accumulated
+     * over, which training continues from (for the bias correction of adam).
+     */
+    void set_initial_optimizer_state(const map<WeightKey, WeightOptimizerState>& state, int32_t epoch);
+    void clear_optimizer_state();
+
     void get_analytic_gradient(
         vector<RNN*>& rnns, const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
         const vector<vector<vector<double> > >& outputs, double& mse, vector<double>& analytic_gradient, bool training
@@ -223,24 +269,18 @@ class RNN_Genome {
         const vector<vector<vector<double> > >& validation_outputs, WeightUpdate* weight_update_method
     );
 
+    template <class SeriesSet>
     void backpropagate_stochastic(
-        const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
-        const vector<vector<vector<double> > >& validation_inputs,
-        const vector<vector<vector<double> > >& validation_outputs, WeightUpdate* weight_update_method
+        const SeriesSet& inputs, const SeriesSet& outputs, const SeriesSet& validation_inputs,
+        const SeriesSet& validation_outputs, WeightUpdate* weight_update_method
     );
 
-    double get_softmax(
-        const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-        const vector<vector<vector<double> > >& outputs
-    );
-    double get_mse(
-        const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-        const vector<vector<vector<double> > >& outputs
-    );
-    double get_mae(
-        const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-        const vector<vector<vector<double> > >& outputs
-    );
+    template <class SeriesSet>
+    double get_softmax(const vector<double>& parameters, const SeriesSet& inputs, const SeriesSet& outputs);
+    template <class SeriesSet>
+    double get_mse(const vector<double>& parameters, const SeriesSet& inputs, const SeriesSet& outputs);
+    template <class SeriesSet>
+    double get_mae(const vector<double>& parameters, const SeriesSet& inputs, const SeriesSet& outputs);
 
     vector<vector<double> > get_predictions(
         const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
@@ -327,8 +367,21 @@ class RNN_Genome {
     RNN_Genome(char* array, int32_t length);
     RNN_Genome(istream& bin_infile);
 
+    /**
+     * Reads a genome from a binary file without exiting if the file is missing or malformed, so
+     * long running programs can reject a bad file. Returns NULL and sets error if it can't be read.
+     */
+    static RNN_Genome* read_from_file(string binary_filename, string& error);
+
     void read_from_array(char* array, int32_t length);
     void read_from_stream(istream& bin_istream);
+    bool read_from_stream(istream& bin_istream, string& error);
+
+    /**
+     * Checks the input and output nodes match the input and output parameter names, which creating
+     * an rnn from the genome requires. Returns false and sets error if they do not.
+     */
+    bool has_parameter_nodes(string& error) const;
 
     void write_to_array(char** array, int32_t& length);
     void write_to_file(string bin_filename);
@@ -391,7 +444,11 @@ struct sort_genomes_by_fitness {
     }
 };
 
+void write_map(ostream& out, map<string, int32_t>& m);
+void read_map(istream& in, map<string, int32_t>& m);
 void write_binary_string(ostream& out, string s, string name);
 void read_binary_string(istream& in, string& s, string name);
+void write_binary_vector(ostream& out, const vector<double>& v, string name);
+void read_binary_vector(istream& in, vector<double>& v, string name);
 
 #endif
@@ -206,6 +206,12 @@ bool RNN_Node_Interface::equals(RNN_Node_Interface* other) const {
     return false;
 }
 
+void RNN_Node_Interface::shift_time(int32_t offset) {
+    shift_time_values(input_values, offset, 0.0);
+    shift_time_values(output_values, offset, 0.0);
+    shift_time_values(inputs_fired, offset, 0);
+}
+
 void RNN_Node_Interface::write_to_stream(ostream& out) {
     out.write((char*) &innovation_number, sizeof(int32_t));
     out.write((char*) &layer_type, sizeof(int32_t));
@@ -1,6 +1,7 @@
 #ifndef EXAMM_RNN_NODE_INTERFACE_HXX
 #define EXAMM_RNN_NODE_INTERFACE_HXX
 
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 using std::ostream;
@@ -74,6 +75,19 @@ double identity_derivative();
 
 double bound(double value);
 
+/**
+ * Moves the value at each time t to time t - offset and sets the last offset values to empty.
+ */
+template <class T>
+void shift_time_values(vector<T>& values, int32_t offset, const T& empty) {
+    if (offset >= (int32_t) values.size()) {
+        std::fill(values.begin(), values.end(), empty);
+        return;
+    }
+    std::move(values.begin() + offset, values.end(), values.begin());
+    std::fill(values.end() - offset, values.end(), empty);
+}
+
 class RNN_Node_Interface {
    public:
     int32_t innovation_number;
@@ -132,6 +146,13 @@ class RNN_Node_Interface {
     virtual void set_weights(int32_t& offset, const vector<double>& parameters) = 0;
     virtual void reset(int32_t _series_length) = 0;
 
+    /**
+     * Moves the forward pass state at each time t to time t - offset so a stream of inputs can
+     * keep going past the series length (see RNN::step). Nodes which keep any state other than
+     * their input and output values from one time step to the next need to shift it as well.
+     */
+    virtual void shift_time(int32_t offset);
+
     virtual void get_gradients(vector<double>& gradients) = 0;
 
     virtual RNN_Node_Interface* copy() const = 0;
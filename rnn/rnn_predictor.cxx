@@ -0,0 +1,227 @@
+#include <cmath>
+
+#include <map>
+using std::map;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+#include "rnn_predictor.hxx"
+
+RNNPredictor::RNNPredictor(string _name, string genome_filename) : name(_name) {
+    genome = new RNN_Genome(genome_filename);
+
+    string error;
+    if (!initialize(error)) {
+        Log::fatal("ERROR: could not load genome '%s': %s\n", genome_filename.c_str(), error.c_str());
+        exit(1);
+    }
+}
+
+RNNPredictor::RNNPredictor(string _name, RNN_Genome* _genome) : name(_name), genome(_genome) {
+}
+
+RNNPredictor* RNNPredictor::load(string _name, string genome_filename, string& error) {
+    RNN_Genome* genome = RNN_Genome::read_from_file(genome_filename, error);
+    if (genome == NULL) {
+        return NULL;
+    }
+
+    RNNPredictor* predictor = new RNNPredictor(_name, genome);
+    if (!predictor->initialize(error)) {
+        delete predictor;
+        return NULL;
+    }
+    return predictor;
+}
+
+RNNPredictor::~RNNPredictor() {
+    delete genome;
+}
+
+/**
+ * Checks the genome can make predictions and resolves its normalization, returns false and sets
+ * error if it can't be used.
+ */
+bool RNNPredictor::initialize(string& error) {
+    parameters = genome->get_best_parameters();
+
+    if ((int32_t) parameters.size() != genome->get_number_weights()) {
+        error = "the genome has " + to_string(parameters.size()) + " best parameters but "
+                + to_string(genome->get_number_weights()) + " weights, was it trained?";
+        return false;
+    }
+
+    if (!genome->has_parameter_nodes(error)) {
+        return false;
+    }
+
+    input_parameter_names = genome->get_input_parameter_names();
+    output_parameter_names = genome->get_output_parameter_names();
+
+    input_offsets.resize(input_parameter_names.size());
+    input_scales.resize(input_parameter_names.size());
+    for (int32_t i = 0; i < (int32_t) input_parameter_names.size(); i++) {
+        if (!get_normalization(input_parameter_names[i], input_offsets[i], input_scales[i], error)) {
+            return false;
+        }
+    }
+
+    output_offsets.resize(output_parameter_names.size());
+    output_scales.resize(output_parameter_names.size());
+    for (int32_t i = 0; i < (int32_t) output_parameter_names.size(); i++) {
+        if (!get_normalization(output_parameter_names[i], output_offsets[i], output_scales[i], error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Gets the same normalization as TimeSeriesSets::normalize_min_max and normalize_avg_std_dev
+ * (and the inverse of TimeSeriesSets::denormalize).
+ */
+bool RNNPredictor::get_normalization(const string& parameter_name, double& offset, double& scale, string& error)
+    const {
+    string normalize_type = genome->get_normalize_type();
+
+    offset = 0.0;
+    scale = 1.0;
+    if (normalize_type.compare("") == 0 || normalize_type.compare("none") == 0) {
+        return true;
+    }
+
+    map<string, double> normalize_mins = genome->get_normalize_mins();
+    map<string, double> normalize_maxs = genome->get_normalize_maxs();
+    if (normalize_mins.count(parameter_name) == 0 || normalize_maxs.count(parameter_name) == 0) {
+        error = "the genome does not have normalization bounds for parameter '" + parameter_name + "'";
+        return false;
+    }
+    double min = normalize_mins[parameter_name];
+    double max = normalize_maxs[parameter_name];
+
+    if (normalize_type.compare("min_max") == 0) {
+        offset = min;
+        scale = 1.0 / (max - min);
+
+    } else if (normalize_type.compare("avg_std_dev") == 0) {
+        map<string, double> normalize_avgs = genome->get_normalize_avgs();
+        map<string, double> normalize_std_devs = genome->get_normalize_std_devs();
+        if (normalize_avgs.count(parameter_name) == 0 || normalize_std_devs.count(parameter_name) == 0) {
+            error = "the genome does not have an average and standard deviation for parameter '" + parameter_name
+                    + "'";
+            return false;
+        }
+        double avg = normalize_avgs[parameter_name];
+        double std_dev = normalize_std_devs[parameter_name];
+
+        double norm_min = (min - avg) / std_dev;
+        double norm_max = (max - avg) / std_dev;
+        norm_max = fmax(norm_min, norm_max);
+
+        offset = avg;
+        scale = 1.0 / (std_dev * norm_max);
+
+    } else {
+        error = "the genome has unknown normalize type '" + normalize_type + "'";
+        return false;
+    }
+    return true;
+}
+
+const string& RNNPredictor::get_name() const {
+    return name;
+}
+
+const vector<string>& RNNPredictor::get_input_parameter_names() const {
+    return input_parameter_names;
+}
+
+const vector<string>& RNNPredictor::get_output_parameter_names() const {
+    return output_parameter_names;
+}
+
+int32_t RNNPredictor::get_number_inputs() const {
+    return input_parameter_names.size();
+}
+
+int32_t RNNPredictor::get_number_outputs() const {
+    return output_parameter_names.size();
+}
+
+RNN* RNNPredictor::create_rnn() const {
+    lock_guard<mutex> lock(genome_mutex);
+
+    RNN* rnn = genome->get_rnn();
+    rnn->set_weights(parameters);
+    return rnn;
+}
+
+double RNNPredictor::normalize_input(int32_t input, double value) const {
+    return (value - input_offsets[input]) * input_scales[input];
+}
+
+double RNNPredictor::get_input_offset(int32_t input) const {
+    return input_offsets[input];
+}
+
+double RNNPredictor::get_input_scale(int32_t input) const {
+    return input_scales[input];
+}
+
+double RNNPredictor::denormalize_output(int32_t output, double value) const {
+    return (value / output_scales[output]) + output_offsets[output];
+}
+
+RNNPredictionStream::RNNPredictionStream(const RNNPredictor* _predictor) : predictor(_predictor) {
+    rnn = predictor->create_rnn();
+    rnn->begin_stream();
+    number_rows = 0;
+}
+
+RNNPredictionStream::~RNNPredictionStream() {
+    delete rnn;
+}
+
+const RNNPredictor* RNNPredictionStream::get_predictor() const {
+    return predictor;
+}
+
+int32_t RNNPredictionStream::get_number_rows() const {
+    return number_rows;
+}
+
+void RNNPredictionStream::predict(const vector<vector<double> >& rows, vector<vector<double> >& predictions) {
+    int32_t number_inputs = predictor->get_number_inputs();
+    int32_t number_outputs = predictor->get_number_outputs();
+
+    step_inputs.resize(number_inputs);
+    predictions.resize(rows.size());
+    for (int32_t i = 0; i < (int32_t) rows.size(); i++) {
+        for (int32_t j = 0; j < number_inputs; j++) {
+            step_inputs[j] = predictor->normalize_input(j, rows[i][j]);
+        }
+
+        rnn->step(step_inputs, step_outputs);
+
+        predictions[i].resize(number_outputs);
+        for (int32_t j = 0; j < number_outputs; j++) {
+            predictions[i][j] = predictor->denormalize_output(j, step_outputs[j]);
+        }
+        number_rows++;
+    }
+}
+
+void RNNPredictionStream::reset() {
+    rnn->begin_stream();
+    number_rows = 0;
+}
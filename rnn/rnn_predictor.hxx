@@ -0,0 +1,112 @@
+#ifndef EXAMM_RNN_PREDICTOR_HXX
+#define EXAMM_RNN_PREDICTOR_HXX
+
+#include <mutex>
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "rnn.hxx"
+#include "rnn_genome.hxx"
+
+/**
+ * A trained genome loaded for making predictions from raw (unnormalized) values. The genome's
+ * normalization bounds are resolved once for each input and output so rows can be normalized and
+ * predictions denormalized without any lookups.
+ *
+ * A predictor is not modified after it is loaded so it can be shared by multiple threads, each
+ * of which should make predictions with its own streams.
+ */
+class RNNPredictor {
+   private:
+    string name;
+    RNN_Genome* genome;
+    vector<double> parameters;
+
+    vector<string> input_parameter_names;
+    vector<string> output_parameter_names;
+
+    // normalized = (value - offset) * scale, and value = (normalized / scale) + offset
+    vector<double> input_offsets;
+    vector<double> input_scales;
+    vector<double> output_offsets;
+    vector<double> output_scales;
+
+    // the genome's nodes are copied to create rnns, which is done by one thread at a time
+    mutable mutex genome_mutex;
+
+    RNNPredictor(string _name, RNN_Genome* _genome);
+
+    bool initialize(string& error);
+    bool get_normalization(const string& parameter_name, double& offset, double& scale, string& error) const;
+
+   public:
+    RNNPredictor(string _name, string genome_filename);
+    ~RNNPredictor();
+
+    /**
+     * Loads a predictor without exiting if the genome can't be used (it is malformed, untrained or
+     * missing its normalization), so a long running server can reject it. Returns NULL and sets
+     * error if it can't be loaded.
+     */
+    static RNNPredictor* load(string _name, string genome_filename, string& error);
+
+    const string& get_name() const;
+    const vector<string>& get_input_parameter_names() const;
+    const vector<string>& get_output_parameter_names() const;
+    int32_t get_number_inputs() const;
+    int32_t get_number_outputs() const;
+
+    /**
+     * Creates a new rnn with the genome's best parameters, which the caller owns.
+     */
+    RNN* create_rnn() const;
+
+    double normalize_input(int32_t input, double value) const;
+    double get_input_offset(int32_t input) const;
+    double get_input_scale(int32_t input) const;
+    double denormalize_output(int32_t output, double value) const;
+};
+
+/**
+ * The predictions for one series whose rows arrive over time, so the recurrent state carries over
+ * from one call to the next. Each row is the raw values of the predictor's inputs at a time step,
+ * and the predictions are the raw values of its outputs time_offset steps later.
+ *
+ * Each stream has its own rnn so it must only be used by one thread at a time.
+ */
+class RNNPredictionStream {
+   private:
+    const RNNPredictor* predictor;
+    RNN* rnn;
+
+    int32_t number_rows;
+
+    // reused for the normalized inputs and outputs of each step
+    vector<double> step_inputs;
+    vector<double> step_outputs;
+
+   public:
+    explicit RNNPredictionStream(const RNNPredictor* _predictor);
+    ~RNNPredictionStream();
+
+    const RNNPredictor* get_predictor() const;
+    int32_t get_number_rows() const;
+
+    /**
+     * Adds the rows (rows[row][input]) to the series and sets predictions[row][output] for each of
+     * them.
+     */
+    void predict(const vector<vector<double> >& rows, vector<vector<double> >& predictions);
+
+    /**
+     * Starts a new series.
+     */
+    void reset();
+};
+
+#endif
@@ -0,0 +1,367 @@
+/**
+ * Benchmarks the throughput of RNN training: RNN::forward_pass, RNN::backward_pass (through
+ * RNN::get_analytic_gradient), RNN_Genome::get_mse and RNN_Genome::backpropagate_stochastic,
+ * on genomes generated with a controlled size and mix of node types.
+ *
+ * Results are written as CSV (to standard output, or --output_file) with a row for each
+ * benchmark of each genome size, e.g.:
+ *
+ *   ./rnn_benchmarks/rnn_throughput --node_types simple LSTM GRU --hidden_layers 1 2 --hidden_nodes 8 16
+ *
+ * uses synthetic series (--synthetic_inputs, --synthetic_outputs, --number_series, --series_length),
+ * or the bundled datasets when given the usual time series arguments, e.g.:
+ *
+ *   ./rnn_benchmarks/rnn_throughput --training_filenames ../datasets/2018_coal/burner_[0-1].csv
+ *       --test_filenames ../datasets/2018_coal/burner_2.csv --time_offset 1 --input_parameter_names ...
+ *       --output_parameter_names Main_Flm_Int
+ *
+ * in which case only the training series are used.
+ *
+ * backpropagate_stochastic is given only the first series as its validation set, so its
+ * validation MSE/MAE passes are small. Its time steps count the two passes over the training
+ * series in each epoch: the one computing the gradients and the one computing the training MSE.
+ * The validation passes are not counted.
+ */
+
+#include <atomic>
+using std::atomic;
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#include <fstream>
+using std::ofstream;
+
+#include <functional>
+using std::function;
+
+#include <iostream>
+using std::cout;
+using std::ostream;
+
+#include <random>
+using std::minstd_rand0;
+using std::uniform_real_distribution;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "rnn/generate_nn.hxx"
+#include "rnn/rnn.hxx"
+#include "rnn/rnn_genome.hxx"
+#include "rnn/rnn_node_interface.hxx"
+#include "time_series/time_series.hxx"
+#include "weights/weight_rules.hxx"
+#include "weights/weight_update.hxx"
+
+/**
+ * Every allocation made through new is counted, so the benchmarks can report how many
+ * allocations the engine makes per pass/epoch.
+ */
+static atomic<int64_t> allocations(0);
+
+// kept out of line, otherwise gcc sees free called on memory from operator new after inlining
+// the delete operators and warns they are mismatched
+__attribute__((noinline)) static void* counted_allocate(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* pointer = malloc(size == 0 ? 1 : size);
+    if (pointer == NULL) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+__attribute__((noinline)) static void counted_free(void* pointer) {
+    free(pointer);
+}
+
+void* operator new(size_t size) {
+    return counted_allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return counted_allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    counted_free(pointer);
+}
+
+class BenchmarkResult {
+   public:
+    double seconds;
+    int64_t allocations;
+};
+
+/**
+ * Runs the benchmark once to warm up and then times it repeats times.
+ */
+BenchmarkResult run_benchmark(int32_t repeats, function<void()> benchmark) {
+    benchmark();
+
+    int64_t start_allocations = allocations.load();
+    auto start_time = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < repeats; i++) {
+        benchmark();
+    }
+    auto end_time = std::chrono::steady_clock::now();
+
+    BenchmarkResult result;
+    result.seconds = std::chrono::duration<double>(end_time - start_time).count();
+    result.allocations = allocations.load() - start_allocations;
+    return result;
+}
+
+void generate_synthetic_series(
+    int32_t number_series, int32_t series_length, int32_t number_inputs, int32_t number_outputs,
+    minstd_rand0& generator, vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs
+) {
+    uniform_real_distribution<double> rng(0.0, 1.0);
+
+    inputs.assign(number_series, vector<vector<double> >(number_inputs, vector<double>(series_length)));
+    outputs.assign(number_series, vector<vector<double> >(number_outputs, vector<double>(series_length)));
+
+    // sine waves with random frequencies and phases plus noise, with each output predicting the
+    // next value of an input
+    for (int32_t i = 0; i < number_series; i++) {
+        for (int32_t j = 0; j < number_inputs; j++) {
+            double frequency = 0.01 + 0.1 * rng(generator);
+            double phase = 6.28318530718 * rng(generator);
+            for (int32_t k = 0; k < series_length; k++) {
+                inputs[i][j][k] = 0.5 + 0.4 * sin(frequency * k + phase) + 0.1 * rng(generator);
+            }
+        }
+
+        for (int32_t j = 0; j < number_outputs; j++) {
+            const vector<double>& predicted = inputs[i][j % number_inputs];
+            for (int32_t k = 0; k < series_length; k++) {
+                outputs[i][j][k] = predicted[k + 1 < series_length ? k + 1 : k];
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    // the benchmark output is the csv, so only log warnings by default
+    if (!argument_exists(arguments, "--std_message_level")) {
+        arguments.insert(arguments.end(), {"--std_message_level", "WARNING"});
+    }
+    if (!argument_exists(arguments, "--file_message_level")) {
+        arguments.insert(arguments.end(), {"--file_message_level", "NONE"});
+    }
+    if (!argument_exists(arguments, "--output_directory")) {
+        arguments.insert(arguments.end(), {"--output_directory", "./benchmark_logs"});
+    }
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    vector<string> node_type_names;
+    get_argument_vector(arguments, "--node_types", false, node_type_names);
+    if (node_type_names.size() == 0) {
+        node_type_names = {"simple", "UGRNN", "MGU", "GRU", "delta", "LSTM"};
+    }
+
+    vector<int32_t> node_types;
+    string node_types_label = "";
+    for (int32_t i = 0; i < (int32_t) node_type_names.size(); i++) {
+        node_types.push_back(node_type_from_string(node_type_names[i]));
+        node_types_label += (i > 0 ? "+" : "") + node_type_names[i];
+    }
+
+    vector<int32_t> hidden_layers;
+    get_argument_vector(arguments, "--hidden_layers", false, hidden_layers);
+    if (hidden_layers.size() == 0) {
+        hidden_layers = {1};
+    }
+
+    vector<int32_t> hidden_nodes;
+    get_argument_vector(arguments, "--hidden_nodes", false, hidden_nodes);
+    if (hidden_nodes.size() == 0) {
+        hidden_nodes = {8};
+    }
+
+    int32_t max_recurrent_depth = 3;
+    get_argument(arguments, "--max_recurrent_depth", false, max_recurrent_depth);
+
+    int32_t repeats = 5;
+    get_argument(arguments, "--repeats", false, repeats);
+
+    int32_t bp_epochs = 2;
+    get_argument(arguments, "--bp_epochs", false, bp_epochs);
+
+    int32_t seed = 1337;
+    get_argument(arguments, "--seed", false, seed);
+    minstd_rand0 generator(seed);
+
+    vector<vector<vector<double> > > inputs;
+    vector<vector<vector<double> > > outputs;
+    vector<string> input_parameter_names;
+    vector<string> output_parameter_names;
+    string dataset;
+
+    if (argument_exists(arguments, "--training_filenames") || argument_exists(arguments, "--filenames")) {
+        TimeSeriesSets* time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+
+        int32_t time_offset = 1;
+        get_argument(arguments, "--time_offset", false, time_offset);
+        time_series_sets->export_training_series(time_offset, inputs, outputs);
+
+        input_parameter_names = time_series_sets->get_input_parameter_names();
+        output_parameter_names = time_series_sets->get_output_parameter_names();
+        dataset = "files";
+        delete time_series_sets;
+    } else {
+        int32_t number_inputs = 8;
+        int32_t number_outputs = 1;
+        int32_t number_series = 4;
+        int32_t series_length = 1000;
+        get_argument(arguments, "--synthetic_inputs", false, number_inputs);
+        get_argument(arguments, "--synthetic_outputs", false, number_outputs);
+        get_argument(arguments, "--number_series", false, number_series);
+        get_argument(arguments, "--series_length", false, series_length);
+
+        generate_synthetic_series(
+            number_series, series_length, number_inputs, number_outputs, generator, inputs, outputs
+        );
+
+        for (int32_t i = 0; i < number_inputs; i++) {
+            input_parameter_names.push_back("input_" + to_string(i));
+        }
+        for (int32_t i = 0; i < number_outputs; i++) {
+            output_parameter_names.push_back("output_" + to_string(i));
+        }
+        dataset = "synthetic";
+    }
+
+    int64_t time_steps = 0;
+    for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
+        time_steps += inputs[i][0].size();
+    }
+
+    // a single validation series keeps the validation passes of backpropagate_stochastic small
+    vector<vector<vector<double> > > validation_inputs(inputs.begin(), inputs.begin() + 1);
+    vector<vector<vector<double> > > validation_outputs(outputs.begin(), outputs.begin() + 1);
+
+    ofstream* output_file = NULL;
+    string output_filename;
+    if (get_argument(arguments, "--output_file", false, output_filename)) {
+        output_file = new ofstream(output_filename);
+    }
+    ostream& output = output_file != NULL ? *output_file : cout;
+
+    output << "benchmark,dataset,node_types,hidden_layers,hidden_nodes,max_recurrent_depth,number_weights,"
+              "number_series,time_steps,repeats,seconds,time_steps_per_second,weights_updated_per_second,"
+              "allocations_per_repeat"
+           << std::endl;
+
+    WeightRules* weight_rules = new WeightRules();
+    weight_rules->initialize_from_args(arguments);
+
+    WeightUpdate* weight_update_method = new WeightUpdate();
+    weight_update_method->generate_from_arguments(arguments);
+
+    for (int32_t layers : hidden_layers) {
+        for (int32_t nodes : hidden_nodes) {
+            // cycle through the node types so each size has the same mix
+            int32_t next_node_type = 0;
+            auto make_node = [&](int32_t& innovation_counter, double depth) -> RNN_Node_Interface* {
+                int32_t node_type = node_types[next_node_type++ % node_types.size()];
+                return create_hidden_node(node_type, innovation_counter, depth);
+            };
+
+            RNN_Genome* genome = create_nn(
+                input_parameter_names, layers, nodes, output_parameter_names, max_recurrent_depth, make_node,
+                weight_rules
+            );
+            genome->initialize_randomly();
+
+            vector<double> parameters;
+            genome->get_weights(parameters);
+            int32_t number_weights = parameters.size();
+
+            RNN* rnn = genome->get_rnn();
+            rnn->set_weights(parameters);
+
+            auto write_result = [&](string benchmark, BenchmarkResult result, int64_t benchmark_time_steps,
+                                    int64_t weights_updated) {
+                output << benchmark << "," << dataset << "," << node_types_label << "," << layers << "," << nodes
+                       << "," << max_recurrent_depth << "," << number_weights << "," << inputs.size() << ","
+                       << benchmark_time_steps << "," << repeats << "," << result.seconds << ","
+                       << (benchmark_time_steps * repeats) / result.seconds << ","
+                       << (weights_updated * repeats) / result.seconds << ","
+                       << (double) result.allocations / repeats << std::endl;
+            };
+
+            BenchmarkResult forward_pass = run_benchmark(repeats, [&]() {
+                for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
+                    rnn->forward_pass(inputs[i], false, false, 0.0);
+                }
+            });
+            write_result("forward_pass", forward_pass, time_steps, 0);
+
+            double mse;
+            vector<double> gradient;
+            BenchmarkResult forward_backward_pass = run_benchmark(repeats, [&]() {
+                for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
+                    rnn->get_analytic_gradient(parameters, inputs[i], outputs[i], mse, gradient, false, true, 0.0);
+                }
+            });
+            write_result("forward_backward_pass", forward_backward_pass, time_steps, 0);
+
+            BenchmarkResult get_mse = run_benchmark(repeats, [&]() {
+                genome->get_mse(parameters, inputs, outputs);
+            });
+            write_result("get_mse", get_mse, time_steps, 0);
+
+            // each repeat trains from the same starting weights, a weight update is done for each series
+            genome->set_bp_iterations(bp_epochs);
+            BenchmarkResult backpropagate = run_benchmark(repeats, [&]() {
+                genome->set_weights(parameters);
+                genome->backpropagate_stochastic(
+                    inputs, outputs, validation_inputs, validation_outputs, weight_update_method
+                );
+            });
+            write_result(
+                "backpropagate_stochastic", backpropagate, 2 * time_steps * bp_epochs,
+                (int64_t) number_weights * inputs.size() * bp_epochs
+            );
+
+            delete rnn;
+            delete genome;
+        }
+    }
+
+    if (output_file != NULL) {
+        output_file->close();
+        delete output_file;
+    }
+
+    delete weight_update_method;
+    delete weight_rules;
+
+    Log::release_id("main");
+    return 0;
+}
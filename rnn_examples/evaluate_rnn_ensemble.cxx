@@ -0,0 +1,352 @@
+/**
+ * Evaluates an ensemble of genomes (e.g., the best genome of each island from a number of runs) on
+ * the same testing files, for example:
+ *
+ * ./rnn_examples/evaluate_rnn_ensemble --genome_files runs/run_{1..20}/global_best_genome_*.bin
+ * --testing_filenames datasets/2018_coal/burner_0.csv datasets/2018_coal/burner_1.csv --time_offset 1
+ * --number_threads 8 --output_directory ensemble_results
+ *
+ * The testing files are only read once, and each input column is only normalized once for all the
+ * genomes with the same normalization for it. The genomes are then evaluated concurrently and the
+ * ensemble's prediction is the average of their (denormalized) predictions, so all the genomes need
+ * to have the same outputs.
+ *
+ * The MSE and MAE of each genome and of the ensemble are written to ensemble_errors.csv, and are
+ * calculated on the denormalized values as the genomes may have been normalized differently. The
+ * predictions of each genome and the ensemble are written to <testing file>_ensemble_predictions.csv.
+ */
+
+#include <atomic>
+using std::atomic;
+
+#include <cmath>
+
+#include <fstream>
+using std::endl;
+using std::ofstream;
+
+#include <iomanip>
+using std::setprecision;
+
+#include <map>
+using std::map;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <thread>
+using std::thread;
+
+#include <utility>
+using std::make_pair;
+using std::pair;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "rnn/rnn.hxx"
+#include "rnn/rnn_predictor.hxx"
+#include "time_series/time_series.hxx"
+
+vector<string> arguments;
+
+int32_t time_offset = 1;
+
+vector<RNNPredictor*> predictors;
+
+// the raw values of every input and output parameter of any of the genomes, as
+// raw_inputs[series][parameter][row] and raw_outputs[series][parameter][row]
+vector<vector<vector<double> > > raw_inputs;
+vector<vector<vector<double> > > raw_outputs;
+
+// each input parameter normalized once for each different normalization of it, as
+// normalized_columns[column][series][row], and the column of each genome's inputs
+vector<vector<vector<double> > > normalized_columns;
+vector<vector<int32_t> > genome_columns;
+
+// the column of the raw outputs for each of the ensemble's outputs
+vector<int32_t> output_columns;
+
+// the denormalized predictions of each genome, as predictions[genome][series][output][row], where
+// the prediction for row is of the output at row + time_offset
+vector<vector<vector<vector<double> > > > predictions;
+
+atomic<int32_t> next_genome;
+
+int32_t get_index(vector<string>& names, const string& name) {
+    for (int32_t i = 0; i < (int32_t) names.size(); i++) {
+        if (names[i] == name) {
+            return i;
+        }
+    }
+    names.push_back(name);
+    return names.size() - 1;
+}
+
+void normalize_columns(const vector<string>& input_parameter_names) {
+    map<pair<string, pair<double, double> >, int32_t> column_indexes;
+
+    genome_columns.resize(predictors.size());
+    for (int32_t i = 0; i < (int32_t) predictors.size(); i++) {
+        const RNNPredictor* predictor = predictors[i];
+        const vector<string>& names = predictor->get_input_parameter_names();
+
+        for (int32_t j = 0; j < (int32_t) names.size(); j++) {
+            double offset = predictor->get_input_offset(j);
+            double scale = predictor->get_input_scale(j);
+            auto key = make_pair(names[j], make_pair(offset, scale));
+
+            if (column_indexes.count(key) == 0) {
+                int32_t parameter = -1;
+                for (int32_t k = 0; k < (int32_t) input_parameter_names.size(); k++) {
+                    if (input_parameter_names[k] == names[j]) {
+                        parameter = k;
+                    }
+                }
+
+                vector<vector<double> > column(raw_inputs.size());
+                for (int32_t series = 0; series < (int32_t) raw_inputs.size(); series++) {
+                    const vector<double>& raw_values = raw_inputs[series][parameter];
+                    column[series].resize(raw_values.size());
+                    for (int32_t row = 0; row < (int32_t) raw_values.size(); row++) {
+                        column[series][row] = (raw_values[row] - offset) * scale;
+                    }
+                }
+
+                column_indexes[key] = normalized_columns.size();
+                normalized_columns.push_back(column);
+            }
+            genome_columns[i].push_back(column_indexes[key]);
+        }
+    }
+
+    Log::info(
+        "normalized %d input columns for %d genomes\n", (int32_t) normalized_columns.size(), (int32_t) predictors.size()
+    );
+}
+
+/**
+ * Each thread takes the next genome which has not been evaluated until there are none left, and
+ * steps its rnn through each series.
+ */
+void evaluate_genomes() {
+    int32_t genome;
+    while ((genome = next_genome++) < (int32_t) predictors.size()) {
+        const RNNPredictor* predictor = predictors[genome];
+        RNN* rnn = predictor->create_rnn();
+
+        int32_t number_inputs = predictor->get_number_inputs();
+        int32_t number_outputs = predictor->get_number_outputs();
+        vector<double> step_inputs(number_inputs);
+        vector<double> step_outputs;
+
+        predictions[genome].resize(raw_inputs.size());
+        for (int32_t series = 0; series < (int32_t) raw_inputs.size(); series++) {
+            int32_t number_rows = raw_inputs[series][0].size() - time_offset;
+
+            vector<vector<double> >& series_predictions = predictions[genome][series];
+            series_predictions.assign(number_outputs, vector<double>(number_rows, 0.0));
+
+            rnn->begin_stream();
+            for (int32_t row = 0; row < number_rows; row++) {
+                for (int32_t i = 0; i < number_inputs; i++) {
+                    step_inputs[i] = normalized_columns[genome_columns[genome][i]][series][row];
+                }
+
+                rnn->step(step_inputs, step_outputs);
+
+                for (int32_t i = 0; i < number_outputs; i++) {
+                    series_predictions[i][row] = predictor->denormalize_output(i, step_outputs[i]);
+                }
+            }
+        }
+
+        delete rnn;
+    }
+}
+
+void get_errors(const vector<vector<vector<double> > >& series_predictions, double& mse, double& mae) {
+    mse = 0.0;
+    mae = 0.0;
+
+    int64_t count = 0;
+    for (int32_t series = 0; series < (int32_t) series_predictions.size(); series++) {
+        for (int32_t i = 0; i < (int32_t) output_columns.size(); i++) {
+            const vector<double>& expected = raw_outputs[series][output_columns[i]];
+            const vector<double>& predicted = series_predictions[series][i];
+
+            for (int32_t row = 0; row < (int32_t) predicted.size(); row++) {
+                double error = predicted[row] - expected[row + time_offset];
+                mse += error * error;
+                mae += fabs(error);
+                count++;
+            }
+        }
+    }
+
+    if (count > 0) {
+        mse /= count;
+        mae /= count;
+    }
+}
+
+int main(int argc, char** argv) {
+    arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    string output_directory;
+    get_argument(arguments, "--output_directory", true, output_directory);
+
+    vector<string> genome_filenames;
+    get_argument_vector(arguments, "--genome_files", true, genome_filenames);
+    if (genome_filenames.size() == 0) {
+        Log::fatal("ERROR: no genome files were given, usage: --genome_files <genome file> [<genome file> ...]\n");
+        exit(1);
+    }
+
+    vector<string> testing_filenames;
+    get_argument_vector(arguments, "--testing_filenames", true, testing_filenames);
+
+    get_argument(arguments, "--time_offset", false, time_offset);
+
+    int32_t number_threads = thread::hardware_concurrency();
+    get_argument(arguments, "--number_threads", false, number_threads);
+    if (number_threads < 1) {
+        number_threads = 1;
+    }
+
+    vector<string> input_parameter_names;
+    vector<string> output_parameter_names;
+
+    for (int32_t i = 0; i < (int32_t) genome_filenames.size(); i++) {
+        Log::info("reading genome %d: '%s'\n", i, genome_filenames[i].c_str());
+        predictors.push_back(new RNNPredictor("genome_" + to_string(i), genome_filenames[i]));
+
+        if (predictors[i]->get_output_parameter_names() != predictors[0]->get_output_parameter_names()) {
+            Log::fatal(
+                "ERROR: genome '%s' has different outputs than genome '%s', all genomes in an ensemble need the same "
+                "outputs\n",
+                genome_filenames[i].c_str(), genome_filenames[0].c_str()
+            );
+            exit(1);
+        }
+
+        for (const string& name : predictors[i]->get_input_parameter_names()) {
+            get_index(input_parameter_names, name);
+        }
+    }
+
+    for (const string& name : predictors[0]->get_output_parameter_names()) {
+        output_columns.push_back(get_index(output_parameter_names, name));
+    }
+
+    // the files are read once with every parameter of any genome, and left unnormalized
+    TimeSeriesSets* time_series_sets =
+        TimeSeriesSets::generate_test(testing_filenames, input_parameter_names, output_parameter_names);
+    time_series_sets->export_test_series(0, raw_inputs, raw_outputs);
+    delete time_series_sets;
+
+    for (int32_t series = 0; series < (int32_t) raw_inputs.size(); series++) {
+        if ((int32_t) raw_inputs[series][0].size() <= time_offset) {
+            Log::fatal(
+                "ERROR: testing file '%s' has %d rows, which is not more than the time offset %d\n",
+                testing_filenames[series].c_str(), (int32_t) raw_inputs[series][0].size(), time_offset
+            );
+            exit(1);
+        }
+    }
+
+    normalize_columns(input_parameter_names);
+
+    predictions.resize(predictors.size());
+    next_genome = 0;
+
+    Log::info("evaluating %d genomes with %d threads\n", (int32_t) predictors.size(), number_threads);
+    vector<thread> threads;
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads.push_back(thread(evaluate_genomes));
+    }
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads[i].join();
+    }
+
+    // the ensemble's predictions are the average of each genome's
+    int32_t number_outputs = output_columns.size();
+    vector<vector<vector<double> > > ensemble_predictions = predictions[0];
+    for (int32_t series = 0; series < (int32_t) ensemble_predictions.size(); series++) {
+        for (int32_t i = 0; i < number_outputs; i++) {
+            vector<double>& predicted = ensemble_predictions[series][i];
+            for (int32_t row = 0; row < (int32_t) predicted.size(); row++) {
+                for (int32_t genome = 1; genome < (int32_t) predictors.size(); genome++) {
+                    predicted[row] += predictions[genome][series][i][row];
+                }
+                predicted[row] /= predictors.size();
+            }
+        }
+    }
+
+    ofstream errors_file(output_directory + "/ensemble_errors.csv");
+    errors_file << "#genome,mse,mae" << endl;
+    errors_file << setprecision(12);
+
+    double mse, mae;
+    for (int32_t genome = 0; genome < (int32_t) predictors.size(); genome++) {
+        get_errors(predictions[genome], mse, mae);
+        Log::info("genome %d '%s' MSE: %lf, MAE: %lf\n", genome, genome_filenames[genome].c_str(), mse, mae);
+        errors_file << genome_filenames[genome] << "," << mse << "," << mae << endl;
+    }
+
+    get_errors(ensemble_predictions, mse, mae);
+    Log::info("ensemble of %d genomes MSE: %lf, MAE: %lf\n", (int32_t) predictors.size(), mse, mae);
+    errors_file << "ensemble," << mse << "," << mae << endl;
+    errors_file.close();
+
+    const vector<string>& ensemble_output_names = predictors[0]->get_output_parameter_names();
+    for (int32_t series = 0; series < (int32_t) testing_filenames.size(); series++) {
+        string filename = testing_filenames[series];
+        filename = filename.substr(filename.find_last_of("/") + 1);
+        filename = filename.substr(0, filename.find_last_of("."));
+        string output_filename = output_directory + "/" + filename + "_ensemble_predictions.csv";
+        Log::info("writing predictions to '%s'\n", output_filename.c_str());
+
+        ofstream outfile(output_filename);
+        outfile << "#";
+        for (int32_t i = 0; i < number_outputs; i++) {
+            if (i > 0) {
+                outfile << ",";
+            }
+            outfile << "expected_" << ensemble_output_names[i] << ",ensemble_" << ensemble_output_names[i];
+            for (int32_t genome = 0; genome < (int32_t) predictors.size(); genome++) {
+                outfile << ",genome_" << genome << "_" << ensemble_output_names[i];
+            }
+        }
+        outfile << endl;
+        outfile << setprecision(12);
+
+        for (int32_t row = 0; row < (int32_t) ensemble_predictions[series][0].size(); row++) {
+            for (int32_t i = 0; i < number_outputs; i++) {
+                if (i > 0) {
+                    outfile << ",";
+                }
+                outfile << raw_outputs[series][output_columns[i]][row + time_offset] << ","
+                        << ensemble_predictions[series][i][row];
+                for (int32_t genome = 0; genome < (int32_t) predictors.size(); genome++) {
+                    outfile << "," << predictions[genome][series][i][row];
+                }
+            }
+            outfile << endl;
+        }
+    }
+
+    for (int32_t i = 0; i < (int32_t) predictors.size(); i++) {
+        delete predictors[i];
+    }
+
+    Log::release_id("main");
+    return 0;
+}
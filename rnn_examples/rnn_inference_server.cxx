@@ -0,0 +1,596 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+#include <deque>
+using std::deque;
+
+#include <map>
+using std::map;
+
+#include <memory>
+using std::shared_ptr;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <sstream>
+using std::istringstream;
+using std::ostringstream;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "rnn/rnn_predictor.hxx"
+
+/**
+ * A long running server which keeps trained genomes loaded and makes predictions for series whose
+ * rows arrive over time. Requests are read a line at a time from stdin (with the responses written
+ * to stdout), or from each client connected to a unix socket if --socket is given:
+ *
+ *     load <model> <genome file>            loads a genome as <model>
+ *     models                                lists the loaded models
+ *     predict <model> <stream> <values>     predicts the outputs of the rows of the stream's series
+ *     reset <model> <stream>                starts a new series for the stream
+ *     quit                                  closes the connection (or exits if reading stdin)
+ *
+ * The values of a predict request are the raw values of the model's inputs for one or more rows,
+ * with the rows separated by ';'. The response is the line
+ *
+ *     prediction <model> <stream> <values>
+ *
+ * with the raw values of the model's outputs for each row (again separated by ';'). Each stream is
+ * a separate series with its own recurrent state, so responses for different streams may come back
+ * in a different order than their requests, but the requests for a stream are always done in order.
+ * Any request which fails gets the response "error <message>". When reading from stdin the log
+ * messages are written to stderr.
+ */
+
+vector<string> arguments;
+
+int32_t max_batch_size = 64;
+
+class Connection {
+   private:
+    int input_fd;
+    int output_fd;
+    mutex write_mutex;
+
+   public:
+    Connection(int _input_fd, int _output_fd) : input_fd(_input_fd), output_fd(_output_fd) {
+    }
+
+    ~Connection() {
+        if (input_fd != STDIN_FILENO) {
+            close(input_fd);
+        }
+    }
+
+    int get_input_fd() const {
+        return input_fd;
+    }
+
+    void send_line(const string& line) {
+        lock_guard<mutex> lock(write_mutex);
+
+        string message = line + "\n";
+        size_t written = 0;
+        while (written < message.size()) {
+            ssize_t result = write(output_fd, message.c_str() + written, message.size() - written);
+            if (result <= 0) {
+                return;  // the client has gone away
+            }
+            written += result;
+        }
+    }
+};
+
+enum InferenceRequestType { PREDICT_REQUEST = 0, RESET_REQUEST = 1 };
+
+class InferenceRequest {
+   public:
+    InferenceRequestType type;
+    shared_ptr<Connection> connection;
+    const RNNPredictor* predictor;
+    string stream_name;
+    vector<vector<double> > rows;
+};
+
+/**
+ * Each stream is always given to the same worker, which owns the stream and does its requests in
+ * the order they arrived. A worker takes all the requests waiting for it (up to max_batch_size) at
+ * once, and the consecutive predict requests for a stream in the batch are done together.
+ */
+class InferenceWorker {
+   private:
+    thread worker_thread;
+
+    mutex queue_mutex;
+    condition_variable queue_condition;
+    deque<InferenceRequest*> queue;
+    bool finished;
+
+    map<string, RNNPredictionStream*> streams;
+
+    RNNPredictionStream* get_stream(const InferenceRequest* request);
+    void predict(const vector<InferenceRequest*>& requests);
+    void run();
+
+   public:
+    InferenceWorker();
+    ~InferenceWorker();
+
+    void add_request(InferenceRequest* request);
+
+    /**
+     * Does all the requests already added and then stops the worker.
+     */
+    void finish();
+};
+
+InferenceWorker::InferenceWorker() {
+    finished = false;
+    worker_thread = thread(&InferenceWorker::run, this);
+}
+
+InferenceWorker::~InferenceWorker() {
+    finish();
+
+    for (auto iterator = streams.begin(); iterator != streams.end(); iterator++) {
+        delete iterator->second;
+    }
+}
+
+void InferenceWorker::add_request(InferenceRequest* request) {
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        queue.push_back(request);
+    }
+    queue_condition.notify_one();
+}
+
+void InferenceWorker::finish() {
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        finished = true;
+    }
+    queue_condition.notify_one();
+
+    if (worker_thread.joinable()) {
+        worker_thread.join();
+    }
+}
+
+static string get_stream_key(const RNNPredictor* predictor, const string& stream_name) {
+    return predictor->get_name() + "\n" + stream_name;
+}
+
+RNNPredictionStream* InferenceWorker::get_stream(const InferenceRequest* request) {
+    string key = get_stream_key(request->predictor, request->stream_name);
+
+    auto found = streams.find(key);
+    if (found != streams.end()) {
+        return found->second;
+    }
+
+    RNNPredictionStream* stream = new RNNPredictionStream(request->predictor);
+    streams[key] = stream;
+    return stream;
+}
+
+void InferenceWorker::predict(const vector<InferenceRequest*>& requests) {
+    RNNPredictionStream* stream = get_stream(requests[0]);
+
+    vector<vector<double> > rows;
+    for (int32_t i = 0; i < (int32_t) requests.size(); i++) {
+        rows.insert(rows.end(), requests[i]->rows.begin(), requests[i]->rows.end());
+    }
+
+    vector<vector<double> > predictions;
+    stream->predict(rows, predictions);
+
+    int32_t current = 0;
+    for (int32_t i = 0; i < (int32_t) requests.size(); i++) {
+        ostringstream response;
+        response.precision(12);
+        response << "prediction " << requests[i]->predictor->get_name() << " " << requests[i]->stream_name;
+
+        for (int32_t j = 0; j < (int32_t) requests[i]->rows.size(); j++, current++) {
+            if (j > 0) {
+                response << " ;";
+            }
+            for (int32_t k = 0; k < (int32_t) predictions[current].size(); k++) {
+                response << " " << predictions[current][k];
+            }
+        }
+
+        requests[i]->connection->send_line(response.str());
+    }
+}
+
+void InferenceWorker::run() {
+    while (true) {
+        vector<InferenceRequest*> batch;
+        {
+            unique_lock<mutex> lock(queue_mutex);
+            queue_condition.wait(lock, [this] { return finished || queue.size() > 0; });
+
+            if (queue.size() == 0) {
+                return;  // finished and everything has been done
+            }
+
+            while (queue.size() > 0 && (int32_t) batch.size() < max_batch_size) {
+                batch.push_back(queue.front());
+                queue.pop_front();
+            }
+        }
+
+        // group the requests by stream, keeping the order of each stream's requests
+        vector<string> stream_order;
+        map<string, vector<InferenceRequest*> > stream_requests;
+        for (int32_t i = 0; i < (int32_t) batch.size(); i++) {
+            string key = get_stream_key(batch[i]->predictor, batch[i]->stream_name);
+            if (stream_requests.count(key) == 0) {
+                stream_order.push_back(key);
+            }
+            stream_requests[key].push_back(batch[i]);
+        }
+
+        for (int32_t i = 0; i < (int32_t) stream_order.size(); i++) {
+            const vector<InferenceRequest*>& requests = stream_requests[stream_order[i]];
+
+            vector<InferenceRequest*> predict_requests;
+            for (int32_t j = 0; j < (int32_t) requests.size(); j++) {
+                if (requests[j]->type == PREDICT_REQUEST) {
+                    predict_requests.push_back(requests[j]);
+                    continue;
+                }
+
+                if (predict_requests.size() > 0) {
+                    predict(predict_requests);
+                    predict_requests.clear();
+                }
+                get_stream(requests[j])->reset();
+                requests[j]->connection->send_line(
+                    "reset " + requests[j]->predictor->get_name() + " " + requests[j]->stream_name
+                );
+            }
+
+            if (predict_requests.size() > 0) {
+                predict(predict_requests);
+            }
+        }
+
+        for (int32_t i = 0; i < (int32_t) batch.size(); i++) {
+            delete batch[i];
+        }
+    }
+}
+
+// models are only ever added, so the predictors stay valid while there are requests for them
+mutex predictors_mutex;
+map<string, RNNPredictor*> predictors;
+
+vector<InferenceWorker*> workers;
+
+static const RNNPredictor* get_predictor(const string& model_name) {
+    lock_guard<mutex> lock(predictors_mutex);
+
+    auto found = predictors.find(model_name);
+    if (found == predictors.end()) {
+        return NULL;
+    }
+    return found->second;
+}
+
+static string load_model(const string& model_name, const string& genome_filename) {
+    string error;
+    RNNPredictor* predictor = RNNPredictor::load(model_name, genome_filename, error);
+    if (predictor == NULL) {
+        return "error " + error;
+    }
+
+    {
+        lock_guard<mutex> lock(predictors_mutex);
+        if (predictors.count(model_name) > 0) {
+            delete predictor;
+            return "error model '" + model_name + "' is already loaded";
+        }
+        predictors[model_name] = predictor;
+    }
+    Log::info("loaded model '%s' from '%s'\n", model_name.c_str(), genome_filename.c_str());
+
+    ostringstream response;
+    response << "loaded " << model_name << " inputs " << predictor->get_number_inputs();
+    for (int32_t i = 0; i < predictor->get_number_inputs(); i++) {
+        response << " " << predictor->get_input_parameter_names()[i];
+    }
+    response << " outputs " << predictor->get_number_outputs();
+    for (int32_t i = 0; i < predictor->get_number_outputs(); i++) {
+        response << " " << predictor->get_output_parameter_names()[i];
+    }
+    return response.str();
+}
+
+static string list_models() {
+    lock_guard<mutex> lock(predictors_mutex);
+
+    string response = "models " + to_string(predictors.size());
+    for (auto iterator = predictors.begin(); iterator != predictors.end(); iterator++) {
+        response += " " + iterator->first;
+    }
+    return response;
+}
+
+/**
+ * Parses the rows of a predict request, returns an error response if they are not valid.
+ */
+static string parse_rows(istringstream& line, int32_t number_inputs, vector<vector<double> >& rows) {
+    rows.assign(1, vector<double>());
+
+    string token;
+    while (line >> token) {
+        if (token.compare(";") == 0) {
+            rows.push_back(vector<double>());
+            continue;
+        }
+
+        char* end;
+        double value = strtod(token.c_str(), &end);
+        if (end == token.c_str() || *end != '\0') {
+            return "error could not parse value '" + token + "'";
+        }
+        rows.back().push_back(value);
+    }
+
+    for (int32_t i = 0; i < (int32_t) rows.size(); i++) {
+        if ((int32_t) rows[i].size() != number_inputs) {
+            return "error row " + to_string(i) + " has " + to_string(rows[i].size()) + " values but the model has "
+                   + to_string(number_inputs) + " inputs";
+        }
+    }
+    return "";
+}
+
+static InferenceWorker* get_worker(const RNNPredictor* predictor, const string& stream_name) {
+    size_t hash = std::hash<string>()(get_stream_key(predictor, stream_name));
+    return workers[hash % workers.size()];
+}
+
+/**
+ * Handles a request line, returns false if the connection should be closed.
+ */
+static bool handle_request(const shared_ptr<Connection>& connection, const string& request_line) {
+    // allow the values of a row to be separated by commas as well as whitespace, and the rows
+    // to be separated by ';' without any whitespace around it
+    string line;
+    for (int32_t i = 0; i < (int32_t) request_line.size(); i++) {
+        char c = request_line[i];
+        if (c == ',' || c == '\r') {
+            line.push_back(' ');
+        } else if (c == ';') {
+            line += " ; ";
+        } else {
+            line.push_back(c);
+        }
+    }
+
+    istringstream tokens(line);
+    string command;
+    if (!(tokens >> command)) {
+        return true;  // blank line
+    }
+
+    if (command.compare("quit") == 0) {
+        return false;
+
+    } else if (command.compare("models") == 0) {
+        connection->send_line(list_models());
+
+    } else if (command.compare("load") == 0) {
+        string model_name, genome_filename;
+        if (!(tokens >> model_name >> genome_filename)) {
+            connection->send_line("error usage: load <model> <genome file>");
+        } else {
+            connection->send_line(load_model(model_name, genome_filename));
+        }
+
+    } else if (command.compare("predict") == 0 || command.compare("reset") == 0) {
+        string model_name, stream_name;
+        if (!(tokens >> model_name >> stream_name)) {
+            connection->send_line("error usage: " + command + " <model> <stream> ...");
+            return true;
+        }
+
+        const RNNPredictor* predictor = get_predictor(model_name);
+        if (predictor == NULL) {
+            connection->send_line("error unknown model '" + model_name + "'");
+            return true;
+        }
+
+        InferenceRequest* request = new InferenceRequest();
+        request->connection = connection;
+        request->predictor = predictor;
+        request->stream_name = stream_name;
+
+        if (command.compare("reset") == 0) {
+            request->type = RESET_REQUEST;
+        } else {
+            request->type = PREDICT_REQUEST;
+
+            string error = parse_rows(tokens, predictor->get_number_inputs(), request->rows);
+            if (error.size() > 0) {
+                connection->send_line(error);
+                delete request;
+                return true;
+            }
+        }
+
+        get_worker(predictor, stream_name)->add_request(request);
+
+    } else {
+        connection->send_line("error unknown command '" + command + "'");
+    }
+
+    return true;
+}
+
+/**
+ * Reads and handles request lines until the connection is closed (or sends quit).
+ */
+static void serve_connection(shared_ptr<Connection> connection) {
+    string buffer;
+    char read_buffer[65536];
+
+    while (true) {
+        size_t end_of_line = buffer.find('\n');
+        if (end_of_line != string::npos) {
+            string line = buffer.substr(0, end_of_line);
+            buffer.erase(0, end_of_line + 1);
+
+            if (!handle_request(connection, line)) {
+                return;
+            }
+            continue;
+        }
+
+        ssize_t bytes_read = read(connection->get_input_fd(), read_buffer, sizeof(read_buffer));
+        if (bytes_read <= 0) {
+            if (buffer.size() > 0) {
+                handle_request(connection, buffer);
+            }
+            return;
+        }
+        buffer.append(read_buffer, bytes_read);
+    }
+}
+
+static void serve_socket(const string& socket_path) {
+    int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        Log::fatal("ERROR: could not create socket: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        Log::fatal("ERROR: socket path '%s' is too long\n", socket_path.c_str());
+        exit(1);
+    }
+    strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    unlink(socket_path.c_str());
+    if (bind(server_fd, (struct sockaddr*) &address, sizeof(address)) < 0) {
+        Log::fatal("ERROR: could not bind socket '%s': %s\n", socket_path.c_str(), strerror(errno));
+        exit(1);
+    }
+
+    if (listen(server_fd, 64) < 0) {
+        Log::fatal("ERROR: could not listen on socket '%s': %s\n", socket_path.c_str(), strerror(errno));
+        exit(1);
+    }
+    Log::info("listening on '%s'\n", socket_path.c_str());
+
+    while (true) {
+        int client_fd = accept(server_fd, NULL, NULL);
+        if (client_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Log::fatal("ERROR: could not accept connection: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        shared_ptr<Connection> connection(new Connection(client_fd, client_fd));
+        thread(serve_connection, connection).detach();
+    }
+}
+
+int main(int argc, char** argv) {
+    arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    // writing to a client which has gone away should fail rather than kill the server
+    signal(SIGPIPE, SIG_IGN);
+
+    // when serving stdin the responses are the only thing written to stdout, the log messages go
+    // to stderr instead
+    string socket_path;
+    bool use_socket = get_argument(arguments, "--socket", false, socket_path);
+    int response_fd = STDOUT_FILENO;
+    if (!use_socket) {
+        response_fd = dup(STDOUT_FILENO);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+
+    int32_t number_threads = 1;
+    get_argument(arguments, "--number_threads", false, number_threads);
+    get_argument(arguments, "--max_batch_size", false, max_batch_size);
+
+    if (number_threads < 1) {
+        Log::fatal("ERROR: --number_threads must be at least 1, it was %d\n", number_threads);
+        exit(1);
+    }
+    if (max_batch_size < 1) {
+        Log::fatal("ERROR: --max_batch_size must be at least 1, it was %d\n", max_batch_size);
+        exit(1);
+    }
+
+    for (int32_t i = 0; i < number_threads; i++) {
+        workers.push_back(new InferenceWorker());
+    }
+
+    // genomes loaded at startup are named by their filenames without the directory or extension
+    vector<string> genome_filenames;
+    get_argument_vector(arguments, "--genome_files", false, genome_filenames);
+    for (int32_t i = 0; i < (int32_t) genome_filenames.size(); i++) {
+        string model_name = genome_filenames[i].substr(genome_filenames[i].find_last_of('/') + 1);
+        model_name = model_name.substr(0, model_name.find_last_of('.'));
+
+        string response = load_model(model_name, genome_filenames[i]);
+        if (response.compare(0, 5, "error") == 0) {
+            Log::fatal("ERROR: could not load '%s': %s\n", genome_filenames[i].c_str(), response.c_str());
+            exit(1);
+        }
+    }
+
+    if (use_socket) {
+        serve_socket(socket_path);
+    } else {
+        serve_connection(shared_ptr<Connection>(new Connection(STDIN_FILENO, response_fd)));
+    }
+
+    // do any requests which are still waiting before exiting
+    for (int32_t i = 0; i < (int32_t) workers.size(); i++) {
+        delete workers[i];
+    }
+
+    for (auto iterator = predictors.begin(); iterator != predictors.end(); iterator++) {
+        delete iterator->second;
+    }
+
+    Log::release_id("main");
+    return 0;
+}
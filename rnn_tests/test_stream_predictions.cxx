@@ -0,0 +1,163 @@
+#include <cmath>
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "gradient_test.hxx"
+#include "rnn/generate_nn.hxx"
+#include "rnn/rnn.hxx"
+#include "rnn/rnn_genome.hxx"
+#include "weights/weight_rules.hxx"
+
+/**
+ * Checks that stepping through the inputs one time step at a time gives the same outputs as a
+ * forward pass over all of them, twice so starting a second stream is tested as well.
+ */
+bool stream_test(string name, RNN_Genome* genome, const vector<vector<double> >& inputs) {
+    genome->set_stochastic(false);
+    genome->initialize_randomly();
+    RNN* rnn = genome->get_rnn();
+
+    vector<vector<double> > no_expected_outputs;
+    vector<double> predictions = rnn->get_predictions(inputs, no_expected_outputs, false, 0.0);
+
+    int32_t number_inputs = inputs.size();
+    int32_t number_outputs = predictions.size() / inputs[0].size();
+
+    bool failed = false;
+    vector<double> step_inputs(number_inputs);
+    vector<double> step_outputs;
+
+    for (int32_t stream = 0; stream < 2; stream++) {
+        rnn->begin_stream();
+
+        for (int32_t time = 0; time < (int32_t) inputs[0].size(); time++) {
+            for (int32_t i = 0; i < number_inputs; i++) {
+                step_inputs[i] = inputs[i][time];
+            }
+            rnn->step(step_inputs, step_outputs);
+
+            for (int32_t i = 0; i < number_outputs; i++) {
+                double difference = step_outputs[i] - predictions[(time * number_outputs) + i];
+                if (fabs(difference) > 10e-10) {
+                    failed = true;
+                    Log::info(
+                        "\t\tFAILED stream %d time %d output %d: step: %lf, forward pass: %lf, difference: %lf\n",
+                        stream, time, i, step_outputs[i], predictions[(time * number_outputs) + i], difference
+                    );
+                }
+            }
+        }
+    }
+
+    delete rnn;
+
+    if (!failed) {
+        Log::info("\tPASSED '%s'\n", name.c_str());
+    } else {
+        Log::info("\tFAILED '%s'\n", name.c_str());
+    }
+    return failed;
+}
+
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    initialize_generator();
+
+    Log::info("TESTING STREAM PREDICTIONS\n");
+
+    // long enough that the stream's state is shifted back a number of times
+    int input_length = 50;
+    get_argument(arguments, "--input_length", false, input_length);
+
+    WeightRules* weight_rules = new WeightRules();
+    weight_rules->initialize_from_args(arguments);
+
+    vector<string> input_parameter_names{"input 1", "input 2"};
+    vector<string> output_parameter_names{"output 1", "output 2"};
+
+    vector<vector<double> > inputs(input_parameter_names.size());
+    for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
+        generate_random_vector(input_length, inputs[i]);
+    }
+
+    vector<int32_t> node_types = {SIMPLE_NODE, LSTM_NODE, GRU_NODE, MGU_NODE, JORDAN_NODE, ELMAN_NODE, DELTA_NODE};
+
+    bool failed = false;
+    for (int32_t max_recurrent_depth = 1; max_recurrent_depth <= 5; max_recurrent_depth++) {
+        Log::info("testing with max recurrent depth: %d\n", max_recurrent_depth);
+
+        vector<RNN_Genome*> genomes;
+        vector<string> names;
+
+        genomes.push_back(
+            create_ff(input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, weight_rules)
+        );
+        names.push_back("FF");
+        genomes.push_back(
+            create_elman(input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, weight_rules)
+        );
+        names.push_back("ELMAN");
+        genomes.push_back(
+            create_jordan(input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, weight_rules)
+        );
+        names.push_back("JORDAN");
+        genomes.push_back(
+            create_lstm(input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, weight_rules)
+        );
+        names.push_back("LSTM");
+        genomes.push_back(
+            create_gru(input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, weight_rules)
+        );
+        names.push_back("GRU");
+        genomes.push_back(
+            create_mgu(input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, weight_rules)
+        );
+        names.push_back("MGU");
+        genomes.push_back(
+            create_ugrnn(input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, weight_rules)
+        );
+        names.push_back("UGRNN");
+        genomes.push_back(
+            create_delta(input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, weight_rules)
+        );
+        names.push_back("DELTA");
+        genomes.push_back(
+            create_enarc(input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, weight_rules)
+        );
+        names.push_back("ENARC");
+        genomes.push_back(
+            create_multiply(input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, weight_rules)
+        );
+        names.push_back("MULTIPLY");
+        genomes.push_back(create_dnas_nn(
+            input_parameter_names, 2, 3, output_parameter_names, max_recurrent_depth, node_types, weight_rules
+        ));
+        names.push_back("DNAS");
+
+        for (int32_t i = 0; i < (int32_t) genomes.size(); i++) {
+            if (stream_test(names[i], genomes[i], inputs)) {
+                failed = true;
+            }
+            delete genomes[i];
+        }
+    }
+
+    delete weight_rules;
+
+    if (!failed) {
+        Log::info("ALL PASSED!\n");
+    } else {
+        Log::info("SOME FAILED!\n");
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+#!/bin/bash
+# Measures how examm_mt and examm_mpi scale with the number of workers, by running the same
+# fixed seed, fixed genome budget search on the coal dataset with each number of workers.
+#
+# Run from the root of the repository after building, e.g.:
+#
+#    WORKER_COUNTS="1 2 4 8" MAX_GENOMES=200 ./scripts/benchmarks/examm_scaling.sh
+#
+# Each run uses --metrics, and the results (one row per version and number of workers) are
+# written as CSV to $OUTPUT_DIRECTORY/scaling.csv:
+#
+#    genomes_evaluated     genomes inserted, rejected or discarded (for a NaN fitness) by EXAMM
+#    genomes_per_hour      evaluated genomes per hour of wall time
+#    master_utilization    the fraction of the wall time the master was busy: for examm_mpi the
+#                          time master() ran without waiting for messages (so not startup or
+#                          loading the data), for examm_mt the time a thread held the EXAMM
+#                          lock to insert or generate a genome
+#    lock_wait_seconds     the total time threads waited for the EXAMM lock (examm_mt only)
+#    worker_idle_seconds   the total time workers waited for the master to send them a genome
+#                          (examm_mpi only, for examm_mt this is the lock wait)
+#    worker_idle_fraction  the fraction of the workers' wall time not spent training genomes
+#
+# Only EXAMM's own random number generator is seeded, so with more than one worker the genomes
+# evaluated depend on the order they finish in; the genome budget keeps the amount of work the same.
+#
+# Environment variables:
+#    BUILD_DIRECTORY      where examm_mt and examm_mpi were built (default: build)
+#    OUTPUT_DIRECTORY     where the runs and scaling.csv are written (default: test_output/examm_scaling)
+#    VERSIONS             which versions to run (default: "mt mpi")
+#    WORKER_COUNTS        the numbers of threads/worker ranks (default: "1 2 4")
+#    MAX_GENOMES          the genome budget of each run (default: 200)
+#    SEED                 the seed for EXAMM (default: 1337)
+#    MPIRUN               the command used to start examm_mpi (default: "mpirun --oversubscribe"),
+#                         e.g., add --allow-run-as-root when running in a container
+
+BUILD_DIRECTORY=${BUILD_DIRECTORY:-build}
+OUTPUT_DIRECTORY=${OUTPUT_DIRECTORY:-test_output/examm_scaling}
+VERSIONS=${VERSIONS:-"mt mpi"}
+WORKER_COUNTS=${WORKER_COUNTS:-"1 2 4"}
+MAX_GENOMES=${MAX_GENOMES:-200}
+SEED=${SEED:-1337}
+MPIRUN=${MPIRUN:-"mpirun --oversubscribe"}
+
+INPUT_PARAMETERS="Conditioner_Inlet_Temp Conditioner_Outlet_Temp Coal_Feeder_Rate Primary_Air_Flow Primary_Air_Split System_Secondary_Air_Flow_Total Secondary_Air_Flow Secondary_Air_Split Tertiary_Air_Split Total_Comb_Air_Flow Supp_Fuel_Flow Main_Flm_Int"
+OUTPUT_PARAMETERS="Main_Flm_Int"
+
+mkdir -p $OUTPUT_DIRECTORY
+RESULTS=$OUTPUT_DIRECTORY/scaling.csv
+echo "version,workers,max_genomes,seed,seconds,genomes_evaluated,genomes_per_hour,master_utilization,lock_wait_seconds,worker_idle_seconds,worker_idle_fraction" > $RESULTS
+
+# sums a counter, or the _sum of a histogram, over the metrics files of every process in a run
+metric_sum() {
+    cat $1/metrics*.prom 2> /dev/null | awk -v name=$2 '$1 == name { sum += $2 } END { printf "%.6f\n", sum }'
+}
+
+for version in $VERSIONS; do
+    for workers in $WORKER_COUNTS; do
+        run_directory=$OUTPUT_DIRECTORY/${version}_${workers}
+        rm -rf $run_directory
+        mkdir -p $run_directory
+
+        ARGUMENTS="--training_filenames datasets/2018_coal/burner_[0-9].csv \
+            --test_filenames datasets/2018_coal/burner_1[0-1].csv \
+            --time_offset 1 \
+            --input_parameter_names $INPUT_PARAMETERS \
+            --output_parameter_names $OUTPUT_PARAMETERS \
+            --number_islands 10 \
+            --island_size 10 \
+            --max_genomes $MAX_GENOMES \
+            --bp_iterations 5 \
+            --num_mutations 2 \
+            --possible_node_types simple UGRNN MGU GRU delta LSTM \
+            --seed $SEED \
+            --metrics \
+            --metrics_interval 3600 \
+            --output_directory $run_directory \
+            --std_message_level WARNING \
+            --file_message_level NONE"
+
+        echo "running examm_$version with $workers workers, writing to $run_directory"
+
+        start_time=$(date +%s.%N)
+        if [ "$version" = "mt" ]; then
+            $BUILD_DIRECTORY/multithreaded/examm_mt --number_threads $workers $ARGUMENTS > $run_directory/stdout.txt 2>&1
+        else
+            # the first rank is the master
+            $MPIRUN -np $((workers + 1)) $BUILD_DIRECTORY/mpi/examm_mpi $ARGUMENTS > $run_directory/stdout.txt 2>&1
+        fi
+        status=$?
+        end_time=$(date +%s.%N)
+
+        if [ $status -ne 0 ]; then
+            echo "examm_$version with $workers workers failed, see $run_directory/stdout.txt"
+            continue
+        fi
+
+        inserted=$(metric_sum $run_directory examm_genomes_inserted_total)
+        discarded=$(metric_sum $run_directory examm_genomes_discarded_total)
+        rejected=$(metric_sum $run_directory examm_genomes_rejected_total)
+        train=$(metric_sum $run_directory examm_genome_train_seconds_sum)
+        lock_wait=$(metric_sum $run_directory examm_lock_wait_seconds_sum)
+
+        if [ "$version" = "mt" ]; then
+            insert=$(metric_sum $run_directory examm_insert_genome_seconds_sum)
+            generate=$(metric_sum $run_directory examm_generate_genome_seconds_sum)
+            master_seconds=""
+            master_idle=""
+            worker_idle=$lock_wait
+        else
+            insert=""
+            generate=""
+            master_seconds=$(metric_sum $run_directory examm_master_seconds_sum)
+            master_idle=$(metric_sum $run_directory examm_master_idle_seconds_sum)
+            worker_idle=$(metric_sum $run_directory examm_worker_idle_seconds_sum)
+        fi
+
+        awk -v version=$version -v workers=$workers -v max_genomes=$MAX_GENOMES -v seed=$SEED \
+            -v start_time=$start_time -v end_time=$end_time -v inserted=$inserted -v discarded=$discarded -v rejected=$rejected \
+            -v train=$train -v lock_wait=$lock_wait -v insert=$insert -v generate=$generate \
+            -v master_seconds=$master_seconds -v master_idle=$master_idle -v worker_idle=$worker_idle 'BEGIN {
+                seconds = end_time - start_time
+                genomes = inserted + rejected + discarded
+                if (version == "mt") {
+                    master_busy = insert + generate
+                } else {
+                    master_busy = master_seconds - master_idle
+                }
+                printf "%s,%d,%d,%d,%.3f,%d,%.2f,%.4f,%.3f,%.3f,%.4f\n", version, workers, max_genomes, seed,
+                    seconds, genomes, genomes * 3600 / seconds, master_busy / seconds, lock_wait, worker_idle,
+                    1 - train / (workers * seconds)
+            }' >> $RESULTS
+    done
+done
+
+echo "results written to $RESULTS"
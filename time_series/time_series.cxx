@@ -3,7 +3,6 @@
 using std::find;
 
 #include <fstream>
-using std::ifstream;
 
 #include <iomanip>
 using std::setw;
@@ -15,21 +14,19 @@ using std::ostream;
 #include <limits>
 using std::numeric_limits;
 
-#include <sstream>
-using std::stringstream;
-
-#include <stdexcept>
-using std::invalid_argument;
-
 #include <string>
 using std::string;
 
+#include <thread>
+using std::thread;
+
 #include <vector>
 using std::vector;
 
 #include "common/arguments.hxx"
 #include "common/log.hxx"
 #include "time_series.hxx"
+#include "time_series_reader.hxx"
 
 TimeSeries::TimeSeries(string _name) {
     name = _name;
@@ -39,6 +36,10 @@ void TimeSeries::add_value(double value) {
     values.push_back(value);
 }
 
+void TimeSeries::set_values(vector<double>& _values) {
+    values.swap(_values);
+}
+
 double TimeSeries::get_value(int32_t i) {
     return values[i];
 }
@@ -217,16 +218,6 @@ void TimeSeries::copy_values(vector<double>& series) {
     series = values;
 }
 
-void string_split(const string& s, char delim, vector<string>& result) {
-    stringstream ss;
-    ss.str(s);
-
-    string item;
-    while (getline(ss, item, delim)) {
-        result.push_back(item);
-    }
-}
-
 void TimeSeriesSet::add_time_series(string name) {
     if (time_series.count(name) == 0) {
         time_series[name] = new TimeSeries(name);
@@ -239,103 +230,38 @@ void TimeSeriesSet::add_time_series(string name) {
 }
 
 TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string>& _fields) {
-    filename = _filename;
-    fields = _fields;
+    TimeSeriesColumns columns(_filename, _fields);
+    read_time_series_columns(columns, false);
 
-    ifstream ts_file(filename);
+    initialize(columns);
+}
 
-    string line;
-    if (!getline(ts_file, line)) {
-        Log::error("ERROR! Could not get headers from the CSV file. File potentially empty!\n");
-        exit(1);
-    }
+TimeSeriesSet::TimeSeriesSet(TimeSeriesColumns& columns) {
+    initialize(columns);
+}
 
-    vector<string> file_fields;
-    string_split(line, ',', file_fields);
-    for (int32_t i = 0; i < (int32_t) file_fields.size(); i++) {
-        // get rid of carriage returns (sometimes windows messes this up)
-        file_fields[i].erase(std::remove(file_fields[i].begin(), file_fields[i].end(), '\r'), file_fields[i].end());
-    }
+void TimeSeriesSet::initialize(TimeSeriesColumns& columns) {
+    filename = columns.filename;
+    fields = columns.fields;
 
-    // check to see that all the specified fields are in the file
-    for (int32_t i = 0; i < (int32_t) fields.size(); i++) {
-        if (find(file_fields.begin(), file_fields.end(), fields[i]) == file_fields.end()) {
-            // one of the given fields didn't exist in the time series file
-            Log::fatal(
-                "ERROR: could not find specified field '%s' in time series file: '%s'\n", fields[i].c_str(),
-                _filename.c_str()
-            );
-            Log::fatal("file's fields:\n");
-            for (int32_t j = 0; j < (int32_t) file_fields.size(); j++) {
-                Log::fatal("'%s'\n", file_fields[j].c_str());
-            }
-            exit(1);
-        }
+    // the columns may have been read by another thread, so any problems are only logged here
+    for (int32_t i = 0; i < (int32_t) columns.warnings.size(); i++) {
+        Log::warning("WARNING: %s\n", columns.warnings[i].c_str());
     }
 
-    Log::debug("fields.size(): %d, file_fields.size(): %d\n", fields.size(), file_fields.size());
-
-    // specify which of the file fields (columns) are used
-    vector<bool> file_fields_used(file_fields.size(), true);
-    for (int32_t i = 0; i < (int32_t) file_fields.size(); i++) {
-        Log::debug(
-            "\tchecking to see if '%s' was in specified fields, file_fields_used[%d]: %d", file_fields[i].c_str(), i,
-            file_fields_used[i]
-        );
+    for (int32_t i = 0; i < (int32_t) columns.errors.size(); i++) {
+        Log::error("%s\n", columns.errors[i].c_str());
+    }
 
-        if (find(fields.begin(), fields.end(), file_fields[i]) == fields.end()) {
-            // the ith file field wasn't found in the specified fields
-            Log::debug_no_header(" -- field was not found!\n");
-            file_fields_used[i] = false;
-        } else {
-            Log::debug_no_header(" -- Field was found!\n");
-            file_fields_used[i] = true;
-        }
+    if (!columns.fatal_error.empty()) {
+        Log::fatal("ERROR! %s\n", columns.fatal_error.c_str());
+        exit(1);
     }
 
     Log::debug("number fields: %d\n", fields.size());
     for (int32_t i = 0; i < (int32_t) fields.size(); i++) {
-        Log::debug("\t%s used: %d\n", fields[i].c_str(), file_fields_used[i]);
-
         add_time_series(fields[i]);
-    }
-
-    int32_t row = 1;
-    while (getline(ts_file, line)) {
-        if (line.size() == 0 || line[0] == '#' || row < 0) {
-            row++;
-            continue;
-        }
-
-        vector<string> parts;
-        string_split(line, ',', parts);
-
-        if (parts.size() != file_fields.size()) {
-            Log::fatal(
-                "ERROR! number of values in row %d was %d, but there were %d fields in the header.\n", row,
-                parts.size(), file_fields.size()
-            );
-            exit(1);
-        }
-
-        for (int32_t i = 0; i < (int32_t) parts.size(); i++) {
-            if (!file_fields_used[i]) {
-                continue;
-            }
-
-            Log::trace("parts[%d]: %s being added to '%s'\n", i, parts[i].c_str(), file_fields[i].c_str());
-
-            try {
-                time_series[file_fields[i]]->add_value(stod(parts[i]));
-            } catch (const invalid_argument& ia) {
-                Log::error(
-                    "file: '%s' -- invalid argument: '%s' on row %d and column %d: '%s', value: '%s'\n",
-                    filename.c_str(), ia.what(), row, i, file_fields[i].c_str(), parts[i].c_str()
-                );
-            }
-        }
-
-        row++;
+        time_series[fields[i]]->set_values(columns.columns[i]);
     }
 
     number_rows = time_series.begin()->second->get_number_values();
@@ -366,7 +292,10 @@ TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string>& _fields) {
         }
     }
 
-    Log::info("read time series '%s' with number rows: %d\n", filename.c_str(), number_rows);
+    Log::info(
+        "read time series '%s' with number rows: %d%s\n", filename.c_str(), number_rows,
+        columns.read_from_cache ? " (from cache)" : ""
+    );
 }
 
 TimeSeriesSet::~TimeSeriesSet() {
@@ -452,55 +381,71 @@ void TimeSeriesSet::export_time_series(
     Log::debug("clearing data\n");
     data.clear();
 
+    Log::debug(
+        "resizing '%s' (number rows: %d, time offset: %d)  to %d by %d\n", filename.c_str(), number_rows, time_offset,
+        requested_fields.size(), get_number_exported_rows(time_offset)
+    );
+
+    data.resize(requested_fields.size(), vector<double>(get_number_exported_rows(time_offset), 0.0));
+
+    Log::debug("resized! time_offset = %d\n", time_offset);
+
+    for (int32_t i = 0; i < (int32_t) requested_fields.size(); i++) {
+        bool shift = find(shift_fields.begin(), shift_fields.end(), requested_fields[i]) != shift_fields.end();
+        export_field(&data[i][0], requested_fields[i], shift, time_offset);
+    }
+}
+
+/**
+ *  Exports the requested fields into a single contiguous buffer, each field is stored as
+ *  get_number_exported_rows(time_offset) values after the previous one.
+ */
+void TimeSeriesSet::export_time_series(
+    double* data, const vector<string>& requested_fields, const vector<string>& shift_fields, int32_t time_offset
+) {
+    int32_t exported_rows = get_number_exported_rows(time_offset);
+
+    for (int32_t i = 0; i < (int32_t) requested_fields.size(); i++) {
+        bool shift = find(shift_fields.begin(), shift_fields.end(), requested_fields[i]) != shift_fields.end();
+        export_field(data + ((int64_t) i * exported_rows), requested_fields[i], shift, time_offset);
+    }
+}
+
+int32_t TimeSeriesSet::get_number_exported_rows(int32_t time_offset) const {
     // for some reason fabs is not working right
     int32_t abs_time_offset = time_offset;
     if (abs_time_offset < 0) {
         abs_time_offset *= -1;
     }
 
-    Log::debug(
-        "resizing '%s' (number rows: %d, time offset: %d)  to %d by %d\n", filename.c_str(), number_rows, time_offset,
-        requested_fields.size(), number_rows - abs_time_offset
-    );
-    Log::debug("time offset: %d\n", time_offset);
-    Log::debug("abs_time_offset: %d\n", abs_time_offset);
-
-    data.resize(requested_fields.size(), vector<double>(number_rows - abs_time_offset, 0.0));
+    return number_rows - abs_time_offset;
+}
 
-    Log::debug("resized! time_offset = %d\n", time_offset);
+void TimeSeriesSet::export_field(double* values, string field, bool shift, int32_t time_offset) {
+    TimeSeries* series = time_series[field];
 
     if (time_offset == 0) {
-        for (int32_t i = 0; i < (int32_t) requested_fields.size(); i++) {
-            for (int32_t j = 0; j < number_rows; j++) {
-                data[i][j] = time_series[requested_fields[i]]->get_value(j);
-            }
+        for (int32_t j = 0; j < number_rows; j++) {
+            values[j] = series->get_value(j);
         }
 
     } else if (time_offset > 0) {
         // output data, ignore the first N values
-        for (int32_t i = 0; i < (int32_t) requested_fields.size(); i++) {
-            for (int32_t j = time_offset; j < number_rows; j++) {
-                data[i][j - time_offset] = time_series[requested_fields[i]]->get_value(j);
-            }
+        for (int32_t j = time_offset; j < number_rows; j++) {
+            values[j - time_offset] = series->get_value(j);
+        }
+
+    } else if (shift) {
+        // input data, shift the shifted fields to the same as the output, not the input
+        Log::debug("doing shift for field: '%s'\n", field.c_str());
+        for (int32_t j = -time_offset; j < number_rows; j++) {
+            values[j + time_offset] = series->get_value(j);
         }
 
-    } else if (time_offset < 0) {
+    } else {
         // input data, ignore the last N values
-        for (int32_t i = 0; i < (int32_t) requested_fields.size(); i++) {
-            Log::debug("exporting for field: '%s'\n", requested_fields[i].c_str());
-            if (find(shift_fields.begin(), shift_fields.end(), requested_fields[i]) != shift_fields.end()) {
-                Log::debug("doing shift for field: '%s'\n", requested_fields[i].c_str());
-                // shift the shifted fields to the same as the output, not the input
-                for (int32_t j = -time_offset; j < number_rows; j++) {
-                    data[i][j + time_offset] = time_series[requested_fields[i]]->get_value(j);
-                    // Log::info("\tdata[%d][%d]: %lf\n", i, j + time_offset, data[i][j + time_offset]);
-                }
-            } else {
-                Log::debug("not doing shift for field: '%s'\n", requested_fields[i].c_str());
-                for (int32_t j = 0; j < number_rows + time_offset; j++) {
-                    data[i][j] = time_series[requested_fields[i]]->get_value(j);
-                }
-            }
+        for (int32_t j = 0; j < number_rows + time_offset; j++) {
+            values[j] = series->get_value(j);
         }
     }
 }
@@ -611,6 +556,16 @@ void TimeSeriesSets::help_message() {
     );
     Log::info("\t\t\t\tThe settings string requires at one of 'i' or 'o'.\n");
 
+    Log::info("\tLoading:\n");
+    Log::info(
+        "\t\t--time_series_cache : (optional) write a binary cache of the parsed columns next to each CSV file (as "
+        "<filename>.cache) and use it instead of the CSV file while the CSV file is unchanged.\n"
+    );
+    Log::info(
+        "\t\t--time_series_threads <int> : (optional) the number of threads used to read the files, defaults to the "
+        "number of hardware threads.\n"
+    );
+
     Log::info("\tNormalization:\n");
     Log::info(
         "\t\t--normalize <type>: (optional) normalize the data. Types can be 'min_max' or 'avg_std_dev'. 'min_max' "
@@ -621,6 +576,8 @@ void TimeSeriesSets::help_message() {
 }
 
 TimeSeriesSets::TimeSeriesSets() : normalize_type("none") {
+    use_cache = false;
+    loading_threads = thread::hardware_concurrency();
 }
 
 TimeSeriesSets::~TimeSeriesSets() {
@@ -731,10 +688,18 @@ void TimeSeriesSets::load_time_series() {
         Log::debug("got time series filenames:\n");
     }
 
+    // the files are parsed in parallel, then the time series sets are created (and any problems
+    // are logged) on this thread in order
+    vector<TimeSeriesColumns> columns;
+    for (int32_t i = 0; i < (int32_t) filenames.size(); i++) {
+        columns.push_back(TimeSeriesColumns(filenames[i], all_parameter_names));
+    }
+    read_time_series_columns(columns, use_cache, loading_threads);
+
     for (int32_t i = 0; i < (int32_t) filenames.size(); i++) {
         Log::info("\t%s\n", filenames[i].c_str());
 
-        TimeSeriesSet* ts = new TimeSeriesSet(filenames[i], all_parameter_names);
+        TimeSeriesSet* ts = new TimeSeriesSet(columns[i]);
         time_series.push_back(ts);
 
         rows += ts->get_number_rows();
@@ -742,7 +707,7 @@ void TimeSeriesSets::load_time_series() {
     Log::debug("number of time series files: %d, total rows: %d\n", filenames.size(), rows);
 }
 
-TimeSeriesSets* TimeSeriesSets::generate_from_arguments(const vector<string>& arguments) {
+TimeSeriesSets* TimeSeriesSets::generate_from_arguments(const vector<string>& arguments, bool load_series) {
     Log::info("Generating time series data for EXAMM\n");
     TimeSeriesSets* tss = new TimeSeriesSets();
 
@@ -831,7 +796,8 @@ TimeSeriesSets* TimeSeriesSets::generate_from_arguments(const vector<string>& ar
         exit(1);
     }
 
-    tss->load_time_series();
+    tss->use_cache = argument_exists(arguments, "--time_series_cache");
+    get_argument(arguments, "--time_series_threads", false, tss->loading_threads);
 
     tss->normalize_type = "";
     if (get_argument(arguments, "--normalize", false, tss->normalize_type)) {
@@ -839,6 +805,13 @@ TimeSeriesSets* TimeSeriesSets::generate_from_arguments(const vector<string>& ar
         tss->normalize_type = "none";
     }
 
+    if (!load_series) {
+        // the normalization bounds come from wherever the series were loaded (see set_normalize_bounds)
+        return tss;
+    }
+
+    tss->load_time_series();
+
     if (tss->normalize_type.compare("none") == 0) {
         Log::debug("not normalizing time series.\n");
     } else if (tss->normalize_type.compare("min_max") == 0) {
@@ -1183,6 +1156,31 @@ void TimeSeriesSets::export_time_series(
     }
 }
 
+/**
+ * Exports the series into a single contiguous store for each of the inputs and outputs, and creates
+ * windows of sequence_length rows every stride rows over them (see TimeSeriesWindows::create_windows).
+ */
+void TimeSeriesSets::export_time_series(
+    const vector<int>& series_indexes, int32_t time_offset, int32_t sequence_length, int32_t stride,
+    TimeSeriesWindows& inputs, TimeSeriesWindows& outputs
+) {
+    inputs.clear(input_parameter_names.size());
+    outputs.clear(output_parameter_names.size());
+
+    for (int32_t i = 0; i < (int32_t) series_indexes.size(); i++) {
+        TimeSeriesSet* series = time_series[series_indexes[i]];
+
+        double* input_values = inputs.add_series(series->get_number_exported_rows(-time_offset));
+        series->export_time_series(input_values, input_parameter_names, shift_parameter_names, -time_offset);
+
+        double* output_values = outputs.add_series(series->get_number_exported_rows(time_offset));
+        series->export_time_series(output_values, output_parameter_names, shift_parameter_names, time_offset);
+    }
+
+    inputs.create_windows(sequence_length, stride);
+    outputs.create_windows(sequence_length, stride);
+}
+
 /**
  * This exports the time series marked as training series by the training_indexes vector.
  */
@@ -1213,6 +1211,30 @@ void TimeSeriesSets::export_test_series(
     export_time_series(test_indexes, time_offset, inputs, outputs);
 }
 
+void TimeSeriesSets::export_training_series(
+    int32_t time_offset, int32_t sequence_length, int32_t stride, TimeSeriesWindows& inputs, TimeSeriesWindows& outputs
+) {
+    if (training_indexes.size() == 0) {
+        Log::fatal(
+            "ERROR: attempting to export training time series, however the training_indexes were not specified.\n"
+        );
+        exit(1);
+    }
+
+    export_time_series(training_indexes, time_offset, sequence_length, stride, inputs, outputs);
+}
+
+void TimeSeriesSets::export_test_series(
+    int32_t time_offset, int32_t sequence_length, int32_t stride, TimeSeriesWindows& inputs, TimeSeriesWindows& outputs
+) {
+    if (test_indexes.size() == 0) {
+        Log::fatal("ERROR: attempting to export test time series, however the test_indexes were not specified.\n");
+        exit(1);
+    }
+
+    export_time_series(test_indexes, time_offset, sequence_length, stride, inputs, outputs);
+}
+
 /**
  * This exports from all the loaded time series a particular column
  */
@@ -1274,6 +1296,17 @@ void TimeSeriesSets::split_all(int32_t number_slices) {
     }
 }
 
+void TimeSeriesSets::set_normalize_bounds(
+    string _normalize_type, const map<string, double>& _normalize_mins, const map<string, double>& _normalize_maxs,
+    const map<string, double>& _normalize_avgs, const map<string, double>& _normalize_std_devs
+) {
+    normalize_type = _normalize_type;
+    normalize_mins = _normalize_mins;
+    normalize_maxs = _normalize_maxs;
+    normalize_avgs = _normalize_avgs;
+    normalize_std_devs = _normalize_std_devs;
+}
+
 string TimeSeriesSets::get_normalize_type() const {
     return normalize_type;
 }
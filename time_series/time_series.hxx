@@ -13,6 +13,9 @@ using std::map;
 #include <vector>
 using std::vector;
 
+#include "time_series_reader.hxx"
+#include "time_series_view.hxx"
+
 class TimeSeries {
    private:
     string name;
@@ -33,6 +36,8 @@ class TimeSeries {
     TimeSeries(string _name);
 
     void add_value(double value);
+    // takes the values, leaving _values empty
+    void set_values(vector<double>& _values);
     double get_value(int32_t i);
 
     void calculate_statistics();
@@ -71,8 +76,13 @@ class TimeSeriesSet {
 
     TimeSeriesSet();
 
+    void initialize(TimeSeriesColumns& columns);
+    void export_field(double* values, string field, bool shift, int32_t time_offset);
+
    public:
     TimeSeriesSet(string _filename, const vector<string>& _fields);
+    // takes the values of the already read columns
+    TimeSeriesSet(TimeSeriesColumns& columns);
     ~TimeSeriesSet();
     void add_time_series(string name);
 
@@ -103,6 +113,10 @@ class TimeSeriesSet {
         vector<vector<double> >& data, const vector<string>& requested_fields, const vector<string>& shift_fields,
         int32_t time_offset
     );
+    void export_time_series(
+        double* data, const vector<string>& requested_fields, const vector<string>& shift_fields, int32_t time_offset
+    );
+    int32_t get_number_exported_rows(int32_t time_offset) const;
 
     TimeSeriesSet* copy();
 
@@ -135,6 +149,9 @@ class TimeSeriesSets {
     map<string, double> normalize_avgs;
     map<string, double> normalize_std_devs;
 
+    bool use_cache;
+    int32_t loading_threads;
+
     void parse_parameters_string(const vector<string>& p);
     void load_time_series();
 
@@ -143,7 +160,12 @@ class TimeSeriesSets {
 
     TimeSeriesSets();
     ~TimeSeriesSets();
-    static TimeSeriesSets* generate_from_arguments(const vector<string>& arguments);
+    /**
+     * If load_series is false only the parameters are read from the arguments, the series are not
+     * loaded (or normalized) so the sets can only be used for their parameter names and
+     * normalization bounds.
+     */
+    static TimeSeriesSets* generate_from_arguments(const vector<string>& arguments, bool load_series = true);
     static TimeSeriesSets* generate_test(
         const vector<string>& _test_filenames, const vector<string>& _input_parameter_names,
         const vector<string>& _output_parameter_names
@@ -168,6 +190,11 @@ class TimeSeriesSets {
         vector<vector<vector<double> > >& outputs
     );
 
+    void export_time_series(
+        const vector<int>& series_indexes, int32_t time_offset, int32_t sequence_length, int32_t stride,
+        TimeSeriesWindows& inputs, TimeSeriesWindows& outputs
+    );
+
     void export_training_series(
         int32_t time_offset, vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs
     );
@@ -176,10 +203,24 @@ class TimeSeriesSets {
         int32_t time_offset, vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs
     );
 
+    void export_training_series(
+        int32_t time_offset, int32_t sequence_length, int32_t stride, TimeSeriesWindows& inputs,
+        TimeSeriesWindows& outputs
+    );
+    void export_test_series(
+        int32_t time_offset, int32_t sequence_length, int32_t stride, TimeSeriesWindows& inputs,
+        TimeSeriesWindows& outputs
+    );
+
     void export_series_by_name(string field_name, vector<vector<double> >& exported_series);
 
     double denormalize(string field_name, double value);
 
+    void set_normalize_bounds(
+        string _normalize_type, const map<string, double>& _normalize_mins, const map<string, double>& _normalize_maxs,
+        const map<string, double>& _normalize_avgs, const map<string, double>& _normalize_std_devs
+    );
+
     string get_normalize_type() const;
     map<string, double> get_normalize_mins() const;
     map<string, double> get_normalize_maxs() const;
@@ -0,0 +1,364 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+using std::find;
+using std::min;
+
+#include <atomic>
+using std::atomic;
+
+#include <charconv>
+using std::from_chars;
+
+#include <cstdio>
+#include <cstring>
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <system_error>
+using std::errc;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "time_series_reader.hxx"
+
+TimeSeriesColumns::TimeSeriesColumns(string _filename, const vector<string>& _fields) {
+    filename = _filename;
+    fields = _fields;
+    read_from_cache = false;
+}
+
+static bool get_source_stats(const string& filename, int64_t& source_size, int64_t& source_modified) {
+    struct stat file_stat;
+    if (stat(filename.c_str(), &file_stat) != 0) {
+        return false;
+    }
+
+    source_size = file_stat.st_size;
+    source_modified = ((int64_t) file_stat.st_mtim.tv_sec * 1000000000) + file_stat.st_mtim.tv_nsec;
+    return true;
+}
+
+static bool read_cache(TimeSeriesColumns& result, int64_t source_size, int64_t source_modified) {
+    string cache_filename = result.filename + ".cache";
+    FILE* cache_file = fopen(cache_filename.c_str(), "rb");
+    if (cache_file == NULL) {
+        return false;
+    }
+
+    // the counts read from the cache are checked against its size, so a truncated or corrupt cache
+    // is rebuilt instead of causing a huge allocation or a short read
+    struct stat cache_stat;
+    if (fstat(fileno(cache_file), &cache_stat) != 0) {
+        fclose(cache_file);
+        return false;
+    }
+    int64_t cache_size = cache_stat.st_size;
+
+    char magic[8];
+    uint32_t version, number_fields;
+    int64_t cached_size, cached_modified, number_rows;
+
+    bool valid = fread(magic, sizeof(magic), 1, cache_file) == 1
+                 && memcmp(magic, TIME_SERIES_CACHE_MAGIC, sizeof(magic)) == 0
+                 && fread(&version, sizeof(uint32_t), 1, cache_file) == 1 && version == TIME_SERIES_CACHE_VERSION
+                 && fread(&number_fields, sizeof(uint32_t), 1, cache_file) == 1
+                 && fread(&cached_size, sizeof(int64_t), 1, cache_file) == 1
+                 && fread(&cached_modified, sizeof(int64_t), 1, cache_file) == 1
+                 && fread(&number_rows, sizeof(int64_t), 1, cache_file) == 1 && cached_size == source_size
+                 && cached_modified == source_modified;
+
+    vector<string> cached_fields;
+    for (uint32_t i = 0; valid && i < number_fields; i++) {
+        uint32_t name_length;
+        if (fread(&name_length, sizeof(uint32_t), 1, cache_file) != 1) {
+            valid = false;
+            break;
+        }
+
+        if ((int64_t) name_length > cache_size - ftell(cache_file)) {
+            valid = false;
+            break;
+        }
+
+        string name(name_length, ' ');
+        if (name_length > 0 && fread(&name[0], 1, name_length, cache_file) != name_length) {
+            valid = false;
+            break;
+        }
+        cached_fields.push_back(name);
+    }
+
+    long data_offset = ftell(cache_file);
+    if (valid) {
+        // every cached column must fit in the rest of the file
+        int64_t data_size = cache_size - data_offset;
+        int64_t row_size = (int64_t) number_fields * (int64_t) sizeof(double);
+        valid = number_rows >= 0 && (number_fields == 0 || number_rows <= data_size / row_size);
+    }
+
+    if (valid) {
+        result.columns.assign(result.fields.size(), vector<double>(number_rows));
+        for (uint32_t i = 0; valid && i < result.fields.size(); i++) {
+            auto position = find(cached_fields.begin(), cached_fields.end(), result.fields[i]);
+            if (position == cached_fields.end()) {
+                valid = false;
+                break;
+            }
+
+            long column_offset = data_offset + ((position - cached_fields.begin()) * number_rows * sizeof(double));
+            valid = fseek(cache_file, column_offset, SEEK_SET) == 0
+                    && (number_rows == 0
+                        || fread(&result.columns[i][0], sizeof(double), number_rows, cache_file)
+                               == (size_t) number_rows);
+        }
+    }
+
+    fclose(cache_file);
+
+    if (!valid) {
+        result.columns.clear();
+    }
+    return valid;
+}
+
+static void write_cache(TimeSeriesColumns& result, int64_t source_size, int64_t source_modified) {
+    string cache_filename = result.filename + ".cache";
+    // write to a temporary file and rename it, so processes reading the same files at the same
+    // time never see a partially written cache
+    string temporary_filename = cache_filename + ".tmp." + to_string(getpid());
+
+    FILE* cache_file = fopen(temporary_filename.c_str(), "wb");
+    if (cache_file == NULL) {
+        result.warnings.push_back("could not open time series cache '" + temporary_filename + "' for writing");
+        return;
+    }
+
+    uint32_t version = TIME_SERIES_CACHE_VERSION;
+    uint32_t number_fields = result.fields.size();
+    int64_t number_rows = result.columns.size() > 0 ? result.columns[0].size() : 0;
+
+    bool written = fwrite(TIME_SERIES_CACHE_MAGIC, 8, 1, cache_file) == 1
+                   && fwrite(&version, sizeof(uint32_t), 1, cache_file) == 1
+                   && fwrite(&number_fields, sizeof(uint32_t), 1, cache_file) == 1
+                   && fwrite(&source_size, sizeof(int64_t), 1, cache_file) == 1
+                   && fwrite(&source_modified, sizeof(int64_t), 1, cache_file) == 1
+                   && fwrite(&number_rows, sizeof(int64_t), 1, cache_file) == 1;
+
+    for (uint32_t i = 0; written && i < number_fields; i++) {
+        uint32_t name_length = result.fields[i].size();
+        written = fwrite(&name_length, sizeof(uint32_t), 1, cache_file) == 1
+                  && fwrite(result.fields[i].c_str(), 1, name_length, cache_file) == name_length;
+    }
+
+    for (uint32_t i = 0; written && i < number_fields; i++) {
+        // columns with invalid values are shorter, these files are not cached
+        written = (int64_t) result.columns[i].size() == number_rows
+                  && fwrite(&result.columns[i][0], sizeof(double), number_rows, cache_file) == (size_t) number_rows;
+    }
+
+    written = (fclose(cache_file) == 0) && written;
+
+    if (!written || rename(temporary_filename.c_str(), cache_filename.c_str()) != 0) {
+        unlink(temporary_filename.c_str());
+        result.warnings.push_back("could not write time series cache '" + cache_filename + "'");
+    }
+}
+
+static bool read_file(const string& filename, string& contents) {
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    contents.resize(size);
+    bool success = size == 0 || fread(&contents[0], 1, size, file) == (size_t) size;
+    fclose(file);
+
+    return success;
+}
+
+static void parse_csv(TimeSeriesColumns& result) {
+    string contents;
+    if (!read_file(result.filename, contents)) {
+        result.fatal_error = "could not read time series file: '" + result.filename + "'";
+        return;
+    }
+
+    const char* current = contents.data();
+    const char* end = current + contents.size();
+
+    const char* line_end = (const char*) memchr(current, '\n', end - current);
+    if (line_end == NULL) {
+        line_end = end;
+    }
+
+    if (line_end == current) {
+        result.fatal_error = "Could not get headers from the CSV file. File potentially empty!";
+        return;
+    }
+
+    vector<string> file_fields;
+    const char* field_start = current;
+    for (const char* c = current; c <= line_end; c++) {
+        if (c == line_end || *c == ',') {
+            string field(field_start, c - field_start);
+            // get rid of carriage returns (sometimes windows messes this up)
+            field.erase(std::remove(field.begin(), field.end(), '\r'), field.end());
+            file_fields.push_back(field);
+            field_start = c + 1;
+        }
+    }
+
+    // check to see that all the specified fields are in the file
+    for (int32_t i = 0; i < (int32_t) result.fields.size(); i++) {
+        if (find(file_fields.begin(), file_fields.end(), result.fields[i]) == file_fields.end()) {
+            result.fatal_error = "could not find specified field '" + result.fields[i]
+                                 + "' in time series file: '" + result.filename + "', file's fields:";
+            for (int32_t j = 0; j < (int32_t) file_fields.size(); j++) {
+                result.fatal_error += " '" + file_fields[j] + "'";
+            }
+            return;
+        }
+    }
+
+    // which of the requested fields (columns) each file field is read into, or -1 if it is not used
+    vector<int32_t> file_field_columns(file_fields.size(), -1);
+    for (int32_t i = 0; i < (int32_t) file_fields.size(); i++) {
+        auto position = find(result.fields.begin(), result.fields.end(), file_fields[i]);
+        if (position != result.fields.end()) {
+            file_field_columns[i] = position - result.fields.begin();
+        }
+    }
+
+    int64_t estimated_rows = std::count(line_end, end, '\n');
+    result.columns.assign(result.fields.size(), vector<double>());
+    for (int32_t i = 0; i < (int32_t) result.columns.size(); i++) {
+        result.columns[i].reserve(estimated_rows);
+    }
+
+    int32_t number_file_fields = file_fields.size();
+
+    int32_t row = 1;
+    current = line_end + 1;
+    while (current < end) {
+        line_end = (const char*) memchr(current, '\n', end - current);
+        if (line_end == NULL) {
+            line_end = end;
+        }
+
+        const char* line_start = current;
+        current = line_end + 1;
+
+        // windows line endings leave a carriage return at the end of each line
+        if (line_end > line_start && *(line_end - 1) == '\r') {
+            line_end--;
+        }
+
+        if (line_end == line_start || *line_start == '#') {
+            row++;
+            continue;
+        }
+
+        // like splitting with getline, a trailing delimiter does not start another value
+        int32_t number_values = std::count(line_start, line_end, ',') + 1;
+        if (*(line_end - 1) == ',') {
+            number_values--;
+        }
+
+        if (number_values != number_file_fields) {
+            result.fatal_error = "number of values in row " + to_string(row) + " was " + to_string(number_values)
+                                 + ", but there were " + to_string(number_file_fields) + " fields in the header";
+            return;
+        }
+
+        const char* value_start = line_start;
+        for (int32_t i = 0; i < number_file_fields; i++) {
+            const char* value_end = (const char*) memchr(value_start, ',', line_end - value_start);
+            if (value_end == NULL) {
+                value_end = line_end;
+            }
+
+            int32_t column = file_field_columns[i];
+            if (column >= 0) {
+                // skip what stod would have: leading whitespace and a leading plus sign
+                const char* number_start = value_start;
+                while (number_start < value_end && (*number_start == ' ' || *number_start == '\t')) {
+                    number_start++;
+                }
+                if (number_start < value_end && *number_start == '+') {
+                    number_start++;
+                }
+
+                double value;
+                auto [parse_end, error] = from_chars(number_start, value_end, value);
+                if (error == errc()) {
+                    result.columns[column].push_back(value);
+                } else {
+                    result.errors.push_back(
+                        "file: '" + result.filename + "' -- invalid argument on row " + to_string(row) + " and column "
+                        + to_string(i) + ": '" + file_fields[i] + "', value: '" + string(value_start, value_end) + "'"
+                    );
+                }
+            }
+
+            value_start = value_end + 1;
+        }
+
+        row++;
+    }
+}
+
+void read_time_series_columns(TimeSeriesColumns& result, bool use_cache) {
+    int64_t source_size = 0, source_modified = 0;
+    bool has_stats = use_cache && get_source_stats(result.filename, source_size, source_modified);
+
+    if (has_stats && read_cache(result, source_size, source_modified)) {
+        result.read_from_cache = true;
+        return;
+    }
+
+    parse_csv(result);
+
+    if (has_stats && result.fatal_error.empty() && result.errors.empty()) {
+        write_cache(result, source_size, source_modified);
+    }
+}
+
+void read_time_series_columns(vector<TimeSeriesColumns>& results, bool use_cache, int32_t number_threads) {
+    number_threads = min(number_threads, (int32_t) results.size());
+    if (number_threads <= 1) {
+        for (int32_t i = 0; i < (int32_t) results.size(); i++) {
+            read_time_series_columns(results[i], use_cache);
+        }
+        return;
+    }
+
+    atomic<int32_t> next_file(0);
+    auto read_files = [&]() {
+        int32_t i;
+        while ((i = next_file++) < (int32_t) results.size()) {
+            read_time_series_columns(results[i], use_cache);
+        }
+    };
+
+    vector<thread> threads;
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads.push_back(thread(read_files));
+    }
+
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads[i].join();
+    }
+}
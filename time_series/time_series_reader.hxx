@@ -0,0 +1,66 @@
+#ifndef EXAMM_TIME_SERIES_READER_HXX
+#define EXAMM_TIME_SERIES_READER_HXX
+
+#include <cstdint>
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+/**
+ * Version 1 of the columnar time series cache (all values are native endian):
+ *
+ *     char magic[8]
+ *     uint32_t version, number_fields
+ *     int64_t source_size, source_modified, number_rows
+ *     (uint32_t name_length, char name[name_length]) for each field
+ *     double values[number_rows] for each field
+ *
+ * The cache is written next to the CSV file (as <csv filename>.cache) and is only used if the
+ * CSV file has the same size and modification time and the cache has all the requested fields.
+ */
+#define TIME_SERIES_CACHE_MAGIC "EXAMMTSC"
+#define TIME_SERIES_CACHE_VERSION 1
+
+/**
+ * The requested columns of a time series file. These are read without logging so they can be
+ * read by worker threads, any problems are stored and logged later by the caller.
+ */
+class TimeSeriesColumns {
+   public:
+    string filename;
+    vector<string> fields;
+
+    // one column of values for each of the fields
+    vector<vector<double> > columns;
+
+    // problems which did not stop the file from being read (the values are skipped as before)
+    vector<string> errors;
+
+    // problems with the cache, which do not affect the values read
+    vector<string> warnings;
+
+    // if not empty, the file could not be read
+    string fatal_error;
+
+    bool read_from_cache;
+
+    TimeSeriesColumns(string _filename, const vector<string>& _fields);
+};
+
+/**
+ * Reads the columns from the CSV file, or from its cache if use_cache is true and the cache is
+ * up to date. If use_cache is true and the cache could not be used, it is rewritten after the
+ * CSV file is parsed.
+ */
+void read_time_series_columns(TimeSeriesColumns& result, bool use_cache);
+
+/**
+ * Reads the columns of multiple files using up to number_threads threads (one file per thread
+ * at a time).
+ */
+void read_time_series_columns(vector<TimeSeriesColumns>& results, bool use_cache, int32_t number_threads);
+
+#endif
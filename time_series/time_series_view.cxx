@@ -0,0 +1,148 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+using std::vector;
+
+#include "time_series_view.hxx"
+
+TimeSeriesWindows::TimeSeriesWindows() {
+    number_parameters = 0;
+    sequence_length = 0;
+    stride = 0;
+    shared_values = NULL;
+}
+
+void TimeSeriesWindows::clear(int32_t _number_parameters) {
+    number_parameters = _number_parameters;
+    sequence_length = 0;
+    stride = 0;
+
+    values.clear();
+    shared_values = NULL;
+    series_offsets.clear();
+    series_rows.clear();
+
+    window_offsets.clear();
+    window_series_rows.clear();
+    window_lengths.clear();
+}
+
+double* TimeSeriesWindows::add_series(int32_t number_rows) {
+    int64_t offset = values.size();
+
+    series_offsets.push_back(offset);
+    series_rows.push_back(number_rows);
+    values.resize(offset + ((int64_t) number_parameters * number_rows), 0.0);
+
+    // each series starts out as a single window
+    window_offsets.push_back(offset);
+    window_series_rows.push_back(number_rows);
+    window_lengths.push_back(number_rows);
+
+    return &values[offset];
+}
+
+void TimeSeriesWindows::create_windows(int32_t _sequence_length, int32_t _stride) {
+    sequence_length = _sequence_length;
+    stride = _stride;
+
+    window_offsets.clear();
+    window_series_rows.clear();
+    window_lengths.clear();
+
+    int32_t window_stride = stride <= 0 ? sequence_length : stride;
+
+    for (int32_t i = 0; i < (int32_t) series_offsets.size(); i++) {
+        if (sequence_length <= 0) {
+            window_offsets.push_back(series_offsets[i]);
+            window_series_rows.push_back(series_rows[i]);
+            window_lengths.push_back(series_rows[i]);
+            continue;
+        }
+
+        for (int32_t start = 0; start + sequence_length <= series_rows[i]; start += window_stride) {
+            window_offsets.push_back(series_offsets[i] + start);
+            window_series_rows.push_back(series_rows[i]);
+            window_lengths.push_back(sequence_length);
+        }
+    }
+}
+
+void TimeSeriesWindows::use_shared_values(
+    int32_t _number_parameters, const vector<int32_t>& _series_rows, const double* _values
+) {
+    clear(_number_parameters);
+    // release the memory of any values this owned
+    vector<double>().swap(values);
+
+    shared_values = _values;
+
+    int64_t offset = 0;
+    for (int32_t i = 0; i < (int32_t) _series_rows.size(); i++) {
+        series_offsets.push_back(offset);
+        series_rows.push_back(_series_rows[i]);
+        offset += (int64_t) number_parameters * _series_rows[i];
+    }
+
+    create_windows(0, 0);
+}
+
+void TimeSeriesWindows::select_series(const TimeSeriesWindows& source, const vector<int32_t>& series_indexes) {
+    clear(source.number_parameters);
+    vector<double>().swap(values);
+
+    shared_values = source.get_values();
+
+    for (int32_t i = 0; i < (int32_t) series_indexes.size(); i++) {
+        series_offsets.push_back(source.series_offsets[series_indexes[i]]);
+        series_rows.push_back(source.series_rows[series_indexes[i]]);
+    }
+
+    create_windows(0, 0);
+}
+
+int32_t TimeSeriesWindows::size() const {
+    return window_offsets.size();
+}
+
+int32_t TimeSeriesWindows::get_number_series() const {
+    return series_offsets.size();
+}
+
+int32_t TimeSeriesWindows::get_number_parameters() const {
+    return number_parameters;
+}
+
+int32_t TimeSeriesWindows::get_sequence_length() const {
+    return sequence_length;
+}
+
+int32_t TimeSeriesWindows::get_stride() const {
+    return stride;
+}
+
+const vector<int32_t>& TimeSeriesWindows::get_series_rows() const {
+    return series_rows;
+}
+
+int64_t TimeSeriesWindows::get_number_values() const {
+    int64_t number_values = 0;
+    for (int32_t i = 0; i < (int32_t) series_rows.size(); i++) {
+        number_values += (int64_t) number_parameters * series_rows[i];
+    }
+    return number_values;
+}
+
+const double* TimeSeriesWindows::get_values() const {
+    if (shared_values != NULL) {
+        return shared_values;
+    }
+    return values.data();
+}
+
+TimeSeriesView TimeSeriesWindows::operator[](int32_t window) const {
+    return TimeSeriesView(
+        get_values() + window_offsets[window], window_series_rows[window], number_parameters, window_lengths[window]
+    );
+}
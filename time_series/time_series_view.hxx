@@ -0,0 +1,135 @@
+#ifndef EXAMM_TIME_SERIES_VIEW_HXX
+#define EXAMM_TIME_SERIES_VIEW_HXX
+
+#include <cstdint>
+
+#include <vector>
+using std::vector;
+
+/**
+ * The values of one parameter over a window of a time series. Indexed the same way as a
+ * vector<double> so the RNN can read either.
+ */
+class TimeSeriesParameterView {
+   private:
+    const double* values;
+    int32_t length;
+
+   public:
+    TimeSeriesParameterView(const double* _values, int32_t _length) : values(_values), length(_length) {
+    }
+
+    int32_t size() const {
+        return length;
+    }
+
+    double operator[](int32_t time) const {
+        return values[time];
+    }
+
+    const double* data() const {
+        return values;
+    }
+};
+
+/**
+ * A window of a time series stored column major: parameter p starts parameter_stride values
+ * after parameter p - 1. Indexed the same way as a vector<vector<double> > (view[parameter][time]).
+ */
+class TimeSeriesView {
+   private:
+    const double* data;
+    int64_t parameter_stride;
+    int32_t number_parameters;
+    int32_t length;
+
+   public:
+    TimeSeriesView(const double* _data, int64_t _parameter_stride, int32_t _number_parameters, int32_t _length)
+        : data(_data), parameter_stride(_parameter_stride), number_parameters(_number_parameters), length(_length) {
+    }
+
+    int32_t size() const {
+        return number_parameters;
+    }
+
+    int32_t get_length() const {
+        return length;
+    }
+
+    TimeSeriesParameterView operator[](int32_t parameter) const {
+        return TimeSeriesParameterView(data + (parameter * parameter_stride), length);
+    }
+};
+
+/**
+ * A set of windows over time series which are stored once in a single contiguous column store.
+ * Windows may overlap (if the stride is less than the window length), and none of the values are
+ * copied when the windows are created, so an input set and an output set built with the same
+ * series lengths, window length and stride have matching windows.
+ *
+ * Indexed the same way as a vector<vector<vector<double> > > (windows[window][parameter][time]).
+ */
+class TimeSeriesWindows {
+   private:
+    int32_t number_parameters;
+    int32_t sequence_length;
+    int32_t stride;
+
+    // the values of each series, each stored as number_parameters columns of its rows. if
+    // shared_values is not NULL the values are stored there instead (and are not owned)
+    vector<double> values;
+    const double* shared_values;
+    vector<int64_t> series_offsets;
+    vector<int32_t> series_rows;
+
+    // the start of each window in values, the rows of the series it is in and its length
+    vector<int64_t> window_offsets;
+    vector<int32_t> window_series_rows;
+    vector<int32_t> window_lengths;
+
+   public:
+    TimeSeriesWindows();
+
+    void clear(int32_t _number_parameters);
+
+    /**
+     * Adds space for a series with the given number of rows and returns where its values should
+     * be written (as number_parameters columns of number_rows values). The pointer is only valid
+     * until the next series is added.
+     */
+    double* add_series(int32_t number_rows);
+
+    /**
+     * Replaces the windows with windows of sequence_length rows starting every stride rows of
+     * each series (a partial window at the end of a series is dropped). A sequence_length of
+     * 0 uses each whole series as a single window, and a stride of 0 makes the windows adjacent.
+     */
+    void create_windows(int32_t _sequence_length, int32_t _stride);
+
+    /**
+     * Uses values stored elsewhere (e.g., in shared memory) laid out as add_series would have
+     * for series with the given numbers of rows, and frees any values this owned. The values are
+     * not copied so they must outlive these windows. Each series starts out as a single window.
+     */
+    void use_shared_values(int32_t _number_parameters, const vector<int32_t>& _series_rows, const double* _values);
+
+    /**
+     * Makes these windows the whole series selected from another set of windows, without copying
+     * any values (so the other windows must outlive these).
+     */
+    void select_series(const TimeSeriesWindows& source, const vector<int32_t>& series_indexes);
+
+    int32_t size() const;
+    int32_t get_number_series() const;
+    int32_t get_number_parameters() const;
+    int32_t get_sequence_length() const;
+    int32_t get_stride() const;
+
+    const vector<int32_t>& get_series_rows() const;
+    int64_t get_number_values() const;
+    const double* get_values() const;
+
+    TimeSeriesView operator[](int32_t window) const;
+};
+
+#endif
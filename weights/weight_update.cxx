@@ -1,6 +1,12 @@
 #include "weight_update.hxx"
 
+#include <algorithm>
+using std::max;
+using std::min;
+
 #include <cmath>
+using std::isinf;
+using std::isnan;
 
 #include "common/arguments.hxx"
 #include "common/log.hxx"
@@ -131,155 +137,184 @@ void WeightUpdate::update_weights(
     vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
     int32_t epoch, double _learning_rate, double _epsilon, double _beta1, double _beta2
 ) {
-    if (weight_update_method == VANILLA) {
-        vanilla_weight_update(parameters, velocity, prev_velocity, gradient, epoch, _learning_rate);
-    } else if (weight_update_method == MOMENTUM) {
-        momentum_weight_update(parameters, velocity, prev_velocity, gradient, epoch, _learning_rate);
-    } else if (weight_update_method == NESTEROV) {
-        nesterov_weight_update(parameters, velocity, prev_velocity, gradient, epoch, _learning_rate);
-    } else if (weight_update_method == ADAGRAD) {
-        adagrad_weight_update(parameters, velocity, prev_velocity, gradient, epoch, _learning_rate);
-    } else if (weight_update_method == RMSPROP) {
-        rmsprop_weight_update(parameters, velocity, prev_velocity, gradient, epoch, _learning_rate);
-    } else if (weight_update_method == ADAM) {
-        adam_weight_update(parameters, velocity, prev_velocity, gradient, epoch, _learning_rate, _epsilon, _beta1, _beta2);
-    } else if (weight_update_method == ADAM_BIAS) {
-        adam_bias_weight_update(parameters, velocity, prev_velocity, gradient, epoch, _learning_rate);
-    } else {
+    if (weight_update_method < VANILLA || weight_update_method > ADAM_BIAS) {
         Log::fatal(
             "Unrecognized weight update method's enom number: %d, this should never happen!\n", weight_update_method
         );
         exit(1);
     }
+
+    fused_update(
+        weight_update_method, parameters, velocity, prev_velocity, gradient, 1.0, epoch, _learning_rate, _epsilon,
+        _beta1, _beta2
+    );
+}
+
+double WeightUpdate::normalize_and_update_weights(
+    vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, const vector<double>& gradient,
+    int32_t epoch, double _learning_rate, double _epsilon, double _beta1, double _beta2
+) {
+    double norm = get_norm(gradient);
+
+    if (isnan(norm) || isinf(norm)) {
+        return norm;
+    }
+
+    // the same scaling as norm_gradients, applied as the gradient is read
+    double gradient_scale = 1.0;
+    if (use_high_norm && norm > high_threshold) {
+        gradient_scale = high_threshold / norm;
+    } else if (use_low_norm && norm < low_threshold) {
+        gradient_scale = low_threshold / norm;
+    }
+
+    fused_update(
+        weight_update_method, parameters, velocity, prev_velocity, gradient, gradient_scale, epoch, _learning_rate,
+        _epsilon, _beta1, _beta2
+    );
+
+    return norm;
+}
+
+static inline double clip_parameter(double parameter) {
+    return min(max(parameter, -10.0), 10.0);
+}
+
+void WeightUpdate::fused_update(
+    WeightUpdateMethod method, vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity,
+    const vector<double>& gradient, double gradient_scale, int32_t epoch, double _learning_rate, double _epsilon,
+    double _beta1, double _beta2
+) {
+    // the SHO hyperparameters replace the learning rate (and epsilon and the betas for adam) when SHO is used
+    const double lr = use_SHO ? _learning_rate : learning_rate;
+    const double adam_epsilon = use_SHO ? _epsilon : epsilon;
+    const double adam_beta1 = use_SHO ? _beta1 : beta1;
+    const double adam_beta2 = use_SHO ? _beta2 : beta2;
+
+    const int32_t n = parameters.size();
+    double* __restrict__ p = parameters.data();
+    double* __restrict__ v = velocity.data();
+    double* __restrict__ m = prev_velocity.data();
+    const double* __restrict__ g = gradient.data();
+
+    switch (method) {
+        case VANILLA:
+            for (int32_t i = 0; i < n; i++) {
+                p[i] = clip_parameter(p[i] - lr * (gradient_scale * g[i]));
+            }
+            break;
+
+        case MOMENTUM:
+            for (int32_t i = 0; i < n; i++) {
+                v[i] = momentum * v[i] - lr * (gradient_scale * g[i]);
+                p[i] = clip_parameter(p[i] + v[i]);
+            }
+            break;
+
+        case NESTEROV:
+            for (int32_t i = 0; i < n; i++) {
+                m[i] = v[i];
+                v[i] = momentum * v[i] - lr * (gradient_scale * g[i]);
+                p[i] = clip_parameter(p[i] + (-momentum * m[i] + (1 + momentum) * v[i]));
+            }
+            break;
+
+        case ADAGRAD:
+            // here the velocity is the "cache" in Adagrad
+            for (int32_t i = 0; i < n; i++) {
+                double gi = gradient_scale * g[i];
+                v[i] += gi * gi;
+                p[i] = clip_parameter(p[i] + (-lr * gi / (sqrt(v[i]) + epsilon)));
+            }
+            break;
+
+        case RMSPROP:
+            // here the velocity is the "cache" in RMSProp
+            for (int32_t i = 0; i < n; i++) {
+                double gi = gradient_scale * g[i];
+                v[i] = decay_rate * v[i] + (1 - decay_rate) * gi * gi;
+                p[i] = clip_parameter(p[i] + (-lr * gi / (sqrt(v[i]) + epsilon)));
+            }
+            break;
+
+        case ADAM:
+            // here the velocity is the "v" in adam, the prev_velocity is "m" in adam
+            for (int32_t i = 0; i < n; i++) {
+                double gi = gradient_scale * g[i];
+                m[i] = adam_beta1 * m[i] + (1 - adam_beta1) * gi;
+                v[i] = adam_beta2 * v[i] + (1 - adam_beta2) * (gi * gi);
+                p[i] = clip_parameter(p[i] + (-lr * m[i] / (sqrt(v[i]) + adam_epsilon)));
+            }
+            break;
+
+        case ADAM_BIAS: {
+            // local copies of the members so the loop can be vectorized
+            const double b1 = beta1, b2 = beta2, eps = epsilon;
+            // epochs start at 0, so this is the epoch + 1th update (otherwise the first correction divides by 0)
+            const double m_correction = 1.0 / (1 - pow(b1, epoch + 1));
+            const double v_correction = 1.0 / (1 - pow(b2, epoch + 1));
+            for (int32_t i = 0; i < n; i++) {
+                double gi = gradient_scale * g[i];
+                m[i] = b1 * m[i] + (1 - b1) * gi;
+                v[i] = b2 * v[i] + (1 - b2) * (gi * gi);
+                double mt = m[i] * m_correction;
+                double vt = v[i] * v_correction;
+                p[i] = clip_parameter(p[i] + (-lr * mt / (sqrt(vt) + eps)));
+            }
+            break;
+        }
+    }
 }
 
 void WeightUpdate::vanilla_weight_update(
     vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
     int32_t epoch, double _learning_rate
 ) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        Log::debug("AT: SHO is used = %s\n",WeightUpdate::use_SHO?"true":"false");
-        if (WeightUpdate::use_SHO) {
-            parameters[i] -= _learning_rate * gradient[i];
-        } else {
-            parameters[i] -= learning_rate * gradient[i];
-        }
-        gradient_clip(parameters[i]);
-    }
+    fused_update(VANILLA, parameters, velocity, prev_velocity, gradient, 1.0, epoch, _learning_rate, 0.0, 0.0, 0.0);
 }
 
 void WeightUpdate::momentum_weight_update(
     vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
     int32_t epoch, double _learning_rate
 ) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        Log::debug("AT: SHO is used = %s\n",WeightUpdate::use_SHO?"true":"false");
-        if (WeightUpdate::use_SHO) {
-            velocity[i] = momentum * velocity[i] - _learning_rate * gradient[i];    
-        } else {
-            velocity[i] = momentum * velocity[i] - learning_rate * gradient[i];
-        }
-        parameters[i] += velocity[i];
-        gradient_clip(parameters[i]);
-    }
+    fused_update(MOMENTUM, parameters, velocity, prev_velocity, gradient, 1.0, epoch, _learning_rate, 0.0, 0.0, 0.0);
 }
 
 void WeightUpdate::nesterov_weight_update(
     vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
     int32_t epoch, double _learning_rate
 ) {
-    Log::info("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        prev_velocity[i] = velocity[i];
-        Log::debug("AT: SHO is used = %s\n",WeightUpdate::use_SHO?"true":"false");
-        if (WeightUpdate::use_SHO) {
-            velocity[i] = momentum * velocity[i] - _learning_rate * gradient[i];
-        } else {
-            velocity[i] = momentum * velocity[i] - learning_rate * gradient[i];
-        }
-        parameters[i] += -momentum * prev_velocity[i] + (1 + momentum) * velocity[i];
-        gradient_clip(parameters[i]);
-    }
+    fused_update(NESTEROV, parameters, velocity, prev_velocity, gradient, 1.0, epoch, _learning_rate, 0.0, 0.0, 0.0);
 }
 
 void WeightUpdate::adagrad_weight_update(
     vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
     int32_t epoch, double _learning_rate
 ) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        // here the velocity is the "cache" in Adagrad
-        velocity[i] += gradient[i] * gradient[i];
-        Log::debug("AT: SHO is used = %s\n",WeightUpdate::use_SHO?"true":"false");
-        if (WeightUpdate::use_SHO) {
-            parameters[i] += -_learning_rate * gradient[i] / (sqrt(velocity[i]) + epsilon);
-        } else {
-            parameters[i] += -learning_rate * gradient[i] / (sqrt(velocity[i]) + epsilon);
-        }
-        gradient_clip(parameters[i]);
-    }
+    fused_update(ADAGRAD, parameters, velocity, prev_velocity, gradient, 1.0, epoch, _learning_rate, 0.0, 0.0, 0.0);
 }
 
 void WeightUpdate::rmsprop_weight_update(
     vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
     int32_t epoch, double _learning_rate
 ) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        // here the velocity is the "cache" in RMSProp
-        velocity[i] = decay_rate * velocity[i] + (1 - decay_rate) * gradient[i] * gradient[i];
-        Log::debug("AT: SHO is used = %s\n",WeightUpdate::use_SHO?"true":"false");
-        if (WeightUpdate::use_SHO) {
-            parameters[i] += -_learning_rate * gradient[i] / (sqrt(velocity[i]) + epsilon);
-        } else {
-            parameters[i] += -learning_rate * gradient[i] / (sqrt(velocity[i]) + epsilon);
-        }
-        gradient_clip(parameters[i]);
-    }
+    fused_update(RMSPROP, parameters, velocity, prev_velocity, gradient, 1.0, epoch, _learning_rate, 0.0, 0.0, 0.0);
 }
 
 void WeightUpdate::adam_weight_update(
     vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
     int32_t epoch, double _learning_rate, double _epsilon, double _beta1, double _beta2
 ) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        // here the velocity is the "v" in adam, the prev_velocity is "m" in adam
-        Log::debug("AT: SHO is used = %s\n",WeightUpdate::use_SHO?"true":"false");
-        if (WeightUpdate::use_SHO) {
-            prev_velocity[i] = _beta1 * prev_velocity[i] + (1 - _beta1) * gradient[i];
-            velocity[i] = _beta2 * velocity[i] + (1 - _beta2) * (gradient[i] * gradient[i]);
-            parameters[i] += -_learning_rate * prev_velocity[i] / (sqrt(velocity[i]) + _epsilon);
-        } else {
-            prev_velocity[i] = beta1 * prev_velocity[i] + (1 - beta1) * gradient[i];
-            velocity[i] = beta2 * velocity[i] + (1 - beta2) * (gradient[i] * gradient[i]);
-            parameters[i] += -learning_rate * prev_velocity[i] / (sqrt(velocity[i]) + epsilon);
-        }
-        gradient_clip(parameters[i]);
-    }
+    fused_update(
+        ADAM, parameters, velocity, prev_velocity, gradient, 1.0, epoch, _learning_rate, _epsilon, _beta1, _beta2
+    );
 }
 
 void WeightUpdate::adam_bias_weight_update(
     vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
     int32_t epoch, double _learning_rate
 ) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        // here the velocity is the "v" in adam, the prev_velocity is "m" in adam
-        prev_velocity[i] = beta1 * prev_velocity[i] + (1 - beta1) * gradient[i];
-        double mt = prev_velocity[i] / (1 - pow(beta1, epoch));
-        velocity[i] = beta2 * velocity[i] + (1 - beta2) * (gradient[i] * gradient[i]);
-        double vt = velocity[i] / (1 - pow(beta2, epoch));
-        Log::debug("AT: SHO is used = %s\n",WeightUpdate::use_SHO?"true":"false");
-        if (WeightUpdate::use_SHO) {
-            parameters[i] += -_learning_rate * mt / (sqrt(vt) + epsilon);
-        } else {
-            parameters[i] += -learning_rate * mt / (sqrt(vt) + epsilon);
-        }        
-        gradient_clip(parameters[i]);
-    }
+    fused_update(ADAM_BIAS, parameters, velocity, prev_velocity, gradient, 1.0, epoch, _learning_rate, 0.0, 0.0, 0.0);
 }
 
 void WeightUpdate::gradient_clip(double& parameter) {
@@ -350,7 +385,7 @@ void WeightUpdate::enable_low_threshold(double _low_threshold) {
     low_threshold = _low_threshold;
 }
 
-double WeightUpdate::get_norm(vector<double>& analytic_gradient) {
+double WeightUpdate::get_norm(const vector<double>& analytic_gradient) {
     double norm = 0.0;
     for (int32_t i = 0; i < (int32_t) analytic_gradient.size(); i++) {
         norm += analytic_gradient[i] * analytic_gradient[i];
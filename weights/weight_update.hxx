@@ -88,6 +88,16 @@ class WeightUpdate {
     double initial_beta2_min;
     double initial_beta2_max;
 
+    /**
+     * Updates the parameters (and the velocities) with the given method in a single pass, with the
+     * gradient multiplied by gradient_scale as it is read.
+     */
+    void fused_update(
+        WeightUpdateMethod method, vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity,
+        const vector<double>& gradient, double gradient_scale, int32_t epoch, double _learning_rate, double _epsilon,
+        double _beta1, double _beta2
+    );
+
    public:
     static bool use_SHO;
     WeightUpdate();
@@ -100,6 +110,17 @@ class WeightUpdate {
         int32_t epoch, double _learning_rate=NULL, double _epsilon=NULL, double _beta1=NULL, double _beta2=NULL
     );
 
+    /**
+     * Does get_norm, norm_gradients and update_weights together, in one pass over the gradient to
+     * get its norm and one pass to scale it and update the weights (the gradient is not modified).
+     * Returns the norm of the gradient, if it is NaN or infinite the weights are not updated.
+     */
+    double normalize_and_update_weights(
+        vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity,
+        const vector<double>& gradient, int32_t epoch, double _learning_rate = 0.0, double _epsilon = 0.0,
+        double _beta1 = 0.0, double _beta2 = 0.0
+    );
+
     void vanilla_weight_update(
         vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
         int32_t epoch, double _learning_rate
@@ -151,7 +172,7 @@ class WeightUpdate {
     double get_low_threshold();
     double get_high_threshold();
 
-    double get_norm(vector<double>& analytic_gradient);
+    double get_norm(const vector<double>& analytic_gradient);
     void norm_gradients(vector<double>& analytic_gradient, double norm);
     
     // Declaration of functions for generating SHO tuned hyperparameters